@@ -1,5 +1,6 @@
 #include "Utils.hlsl"
 #include "Packing.hlsl"
+#include "RenderView.hlsl"
 
 // VetexID = 0, 1, 2, 2, 3, 0
 static const float4 Quad[] =
@@ -17,13 +18,6 @@ struct InterpolantsVSToPS
     nointerpolation float4 Color : COLOR;
 };
 
-// 256 byte aligned
-struct SceneConstantBuffer
-{
-    float4x4 WorldToClip;
-    float4x4 CameraToWorld;
-};
-
 struct PackedDebugPointInstanceData
 {
 	float3 Translation;
@@ -32,8 +26,6 @@ struct PackedDebugPointInstanceData
 	uint Padding[3];
 };
 
-// 256 byte aligned
-ConstantBuffer<SceneConstantBuffer> SceneBuffer : register(b0);
 // 16 byte aligned
 StructuredBuffer<PackedDebugPointInstanceData> PointsBuffer : register(t0);
 
@@ -46,11 +38,11 @@ InterpolantsVSToPS VSMainPoints(uint vertexId : SV_VertexID, uint instanceId : S
     //const float3 worldPosition = (localPosition.xyz * instanceData.Scale) + instanceData.Translation;
 
     // Camera aligned    
-    const float4 cameraRight = mul(float4(1.f, 0.f, 0.f, 0.f), SceneBuffer.CameraToWorld);
-    const float4 cameraUp = mul(float4(0.f, 1.f, 0.f, 0.f), SceneBuffer.CameraToWorld);
+    const float4 cameraRight = mul(float4(1.f, 0.f, 0.f, 0.f), RenderView.ViewToWorld);
+    const float4 cameraUp = mul(float4(0.f, 1.f, 0.f, 0.f), RenderView.ViewToWorld);
     const float3 worldPosition = ((cameraRight.xyz * localPosition.x) + (cameraUp.xyz * localPosition.y)) * instanceData.Scale + instanceData.Translation;
 
-    const float4 clipPos = mul(float4(worldPosition, 1.f), SceneBuffer.WorldToClip);
+    const float4 clipPos = mul(float4(worldPosition, 1.f), RenderView.JitteredWorldToClip);
 
     InterpolantsVSToPS result;
     result.Position = clipPos;
@@ -79,7 +71,7 @@ InterpolantsVSToPS VSMainLines(uint vertexId : SV_VertexID, uint instanceId : SV
     const PackedDebugLineInstanceData instanceData = LinesBuffer[instanceId];
     const float4 position = float4(instanceData.Position[vertexId], 1.f);
 
-    const float4 clipPos = mul(position, SceneBuffer.WorldToClip);
+    const float4 clipPos = mul(position, RenderView.JitteredWorldToClip);
 
     InterpolantsVSToPS result;
     result.Position = clipPos;
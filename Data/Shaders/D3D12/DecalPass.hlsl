@@ -1,4 +1,5 @@
 #include "Utils.hlsl"
+#include "RenderView.hlsl"
 
 #define TILE_SIZE 16
 
@@ -16,20 +17,14 @@ StructuredBuffer<ShaderDecal> DecalBuffer : register(t0, space100);
 ByteAddressBuffer BinningBuffer : register(t1, space100);
 Texture2D GBufferDepth : register(t2, space100);
 
-// 256 byte aligned
-struct DecalConstantBuffer
+// Root constants, the view comes from the RenderView
+struct DecalConstants
 {
-    float4x4 Projection;
-    float4x4 View;
-	float4x4 InvViewProj;
 	uint NumDecals;
 	uint2 NumWorkGroups;
-
-	float Padding[13];
 };
 
-// 256 byte aligned
-ConstantBuffer<DecalConstantBuffer> ConstBuffer : register(b0);
+ConstantBuffer<DecalConstants> ConstBuffer : register(b0);
 
 SamplerState g_sampler : register(s0);
 
@@ -79,7 +74,7 @@ void CSMain(in uint3 DispatchID : SV_DispatchThreadID, in uint GroupIndex : SV_G
 		const float2 UV = TexelSize * (pixelPos + 0.5f);
 		const float clipDepth = GBufferDepth[pixelPos].r;
 
-		//float linearizedDepth = SceneBuffer.Projection._43 / (clipDepth - SceneBuffer.Projection._33); 
+		//float linearizedDepth = RenderView.ViewToClip._43 / (clipDepth - RenderView.ViewToClip._33); 
 
 		float2 clipCoord = UV * 2.f - 1.f;
 		float4 clipPos = float4(clipCoord, clipDepth, 1.f);
@@ -87,7 +82,7 @@ void CSMain(in uint3 DispatchID : SV_DispatchThreadID, in uint GroupIndex : SV_G
 		//https://learn.microsoft.com/en-us/windows/win32/direct3d10/d3d10-graphics-programming-guide-resources-coordinates
 		clipPos.y *= -1.f; // Pixel coordinates(not NDC) for D3D start from upper left corner, so X stays the same but Y is flipped
 
-		const float4 worldPosHom = mul(clipPos, ConstBuffer.InvViewProj);
+		const float4 worldPosHom = mul(clipPos, RenderView.JitteredClipToWorld);
 		const float4 worldPos = worldPosHom / worldPosHom.w;	
 	
 		//OutputAlbedo[pixelPos] = worldPos;
@@ -1,3 +1,4 @@
+#include "RenderView.hlsl"
 
 struct PSInput
 {
@@ -10,20 +11,6 @@ struct PSOutput
     float4 Color : SV_TARGET0;
 };
 
-// 256 byte aligned
-struct LightingConstantBuffer
-{
-	float4x4 ViewInv;
-	float4x4 ProjInv;
-	float4x4 Proj;
-
-    float4 ViewPos;
-    float4 LightDir;
-    float Padding[8];
-};
-
-ConstantBuffer<LightingConstantBuffer> ConstBuffer : register(b0);
-
 Texture2D GBufferAlbedo : register(t0);
 Texture2D GBufferNormal : register(t1);
 Texture2D GBufferRoughness : register(t2);
@@ -127,15 +114,13 @@ PSOutput PSMain(PSInput input)
 	float2 clipCoord = uv * 2.f - 1.f;
 	float4 clipLoc = float4(clipCoord, depth, 1.f);
 	
-	float4 viewSpacePos = mul(clipLoc, ConstBuffer.ProjInv);
-	viewSpacePos /= viewSpacePos.w;
-	
-	const float4 worldSpacePos = mul(viewSpacePos, ConstBuffer.ViewInv);
+	float4 worldSpacePos = mul(clipLoc, RenderView.JitteredClipToWorld);
+	worldSpacePos /= worldSpacePos.w;
 
 	float3 wsNormal0to1 = GBufferNormal.Sample(g_sampler, uv).xyz;
 	float3 wsNormal = wsNormal0to1 * 2.f - 1.f;
 
-	const float3 viewToFrag = normalize(worldSpacePos.xyz - ConstBuffer.ViewPos.xyz);
+	const float3 viewToFrag = normalize(worldSpacePos.xyz - RenderView.CameraPosition.xyz);
 	const float3 fragToViewW = -viewToFrag;
 
 	const float metalness = GBufferRoughness.Sample(g_sampler, uv).r;
@@ -150,7 +135,7 @@ PSOutput PSMain(PSInput input)
 		float3 V = fragToViewW;
 
 		// Direction towards the light source
-		float3 L = -ConstBuffer.LightDir.xyz;
+		float3 L = -RenderView.LightDirection.xyz;
 
 		// Halfway vector
 		float3 H = normalize(V + L);
@@ -217,7 +202,7 @@ PSOutput PSMain(PSInput input)
 
 	// Same as above, mathematically derived pre-projection z out of 
 	// the operations that happen with z when multiplied with the projection
-	//float3 linearizedDepth = ConstBuffer.Proj._43 / (depth - ConstBuffer.Proj._33); 
+	//float3 linearizedDepth = RenderView.ViewToClip._43 / (depth - RenderView.ViewToClip._33); 
 	//linearizedDepth = linearizedDepth / 50;
 
 	//output.Color = float4(linearizedDepth, 1.f);
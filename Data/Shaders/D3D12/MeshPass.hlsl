@@ -1,5 +1,7 @@
 #include "DescriptorTables.hlsl"
 #include "Utils.hlsl"
+#include "SceneInstances.hlsl"
+#include "RenderView.hlsl"
 
 struct PSInput
 {
@@ -10,6 +12,7 @@ struct PSInput
     float3 VertexBitangentWS : VERTEX_BITANGENT;
     float3x3 TangentToWorld : TANGENT_TO_WORLD;
     float4 clipSpacePos : CLIP_POS;
+    nointerpolation uint MaterialIndex : MATERIAL_INDEX;
 };
 
 struct PSOutput
@@ -28,30 +31,26 @@ struct ShaderMaterial
 
 StructuredBuffer<ShaderMaterial> MaterialsBuffer : register(t0, space100);
 
-// 256 byte aligned
-struct SceneConstantBuffer
+// Instances of a draw start at FirstInstance, SV_InstanceID counts from 0 in every draw
+struct DrawConstants
 {
-    float4x4 LocalToClip;
-    float4x4 LocalToWorldRotationOnly;
-    uint Padding[32];
+    uint FirstInstance;
 };
 
-struct MatIndexBuffer
-{
-    uint ShaderMaterialIdx;
-};
+ConstantBuffer<DrawConstants> DrawBuffer : register(b1);
 
-// 256 byte aligned
-ConstantBuffer<SceneConstantBuffer> SceneBuffer : register(b0);
-ConstantBuffer<MatIndexBuffer> MatIndex : register(b0);
+// Persistent data of every scene mesh, and the slots of the instances drawn by the pass
+StructuredBuffer<SceneInstance> SceneInstances : register(t0, space101);
+StructuredBuffer<uint> InstanceSlots : register(t1, space101);
 
 SamplerState g_sampler : register(s0);
 
-PSInput VSMain(float4 position : POSITION, float3 VertexNormal : NORMAL, float2 uv : TEXCOORD, float3 tangent : TANGENT, float3 bitangent : BITANGENT)
+PSInput VSMain(float4 position : POSITION, float3 VertexNormal : NORMAL, float2 uv : TEXCOORD, float3 tangent : TANGENT, float3 bitangent : BITANGENT, uint instanceID : SV_InstanceID)
 {
-    const float4 clipPos = mul(position, SceneBuffer.LocalToClip);
-    
-    const float3x3 LocalToWorldRotationOnly3x3 = ToFloat3x3(SceneBuffer.LocalToWorldRotationOnly);
+    const SceneInstance instance = SceneInstances[InstanceSlots[DrawBuffer.FirstInstance + instanceID]];
+
+    const float3 worldPos = InstanceLocalToWorld(instance, position.xyz);
+    const float4 clipPos = mul(float4(worldPos, 1.f), RenderView.JitteredWorldToClip);
 
     float3 n = normalize(VertexNormal);
     float3 b = normalize(bitangent);
@@ -61,8 +60,8 @@ PSInput VSMain(float4 position : POSITION, float3 VertexNormal : NORMAL, float2
 
     b = normalize(cross(n, t));
 
-    float3 vertexNormalWS = normalize(mul(n, LocalToWorldRotationOnly3x3)).xyz;
-    float3 tangentWS = normalize(mul(t, LocalToWorldRotationOnly3x3)).xyz;
+    float3 vertexNormalWS = normalize(InstanceNormalToWorld(instance, n));
+    float3 tangentWS = normalize(InstanceDirectionToWorld(instance, t));
 
     //float3 bitangentWS = normalize(mul(b, LocalToWorldRotationOnly3x3)).xyz;
 
@@ -96,6 +95,8 @@ PSInput VSMain(float4 position : POSITION, float3 VertexNormal : NORMAL, float2
     result.VertexTangentWS = tangentWS;
     result.VertexBitangentWS = bitangentWS;
 
+    result.MaterialIndex = instance.MaterialIndex;
+
     return result;
 }
 
@@ -109,7 +110,7 @@ PSOutput PSMain(PSInput input)
 
     //float3x3 perPixelTangentToWorld = float3x3(tangentWS, bitangentWS, normalWS);
 
-    ShaderMaterial mat = MaterialsBuffer[MatIndex.ShaderMaterialIdx];
+    ShaderMaterial mat = MaterialsBuffer[input.MaterialIndex];
 
     //Texture2D AlbedoMap = Tex2DTable[NonUniformResourceIndex(mat.AlbedoMapIndex)];
 
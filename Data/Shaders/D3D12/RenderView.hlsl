@@ -0,0 +1,38 @@
+// Per frame view constants shared by every pass, matches RenderViewConstants
+#define MAX_NUM_CASCADES 3
+
+struct RenderViewConstants
+{
+    float4x4 WorldToView;
+    float4x4 ViewToClip;
+    float4x4 WorldToClip;
+    float4x4 ViewToWorld;
+    float4x4 ClipToView;
+    float4x4 ClipToWorld;
+
+    // What gets rasterized, equal to the ones above when jitter is off
+    float4x4 JitteredViewToClip;
+    float4x4 JitteredWorldToClip;
+    float4x4 JitteredClipToWorld;
+
+    // Left, Right, Bottom, Top, Near, Far, normals point inwards
+    float4 FrustumPlanes[6];
+
+    // Near in w
+    float4 CameraPosition;
+    // Far in w
+    float4 CameraForward;
+    // Size in xy, inverse size in zw
+    float4 ViewportSize;
+    // Clip space offset of the jittered projection in xy
+    float4 Jitter;
+
+    float4x4 CascadeWorldToClip[MAX_NUM_CASCADES];
+    // View depth each cascade ends at
+    float4 CascadeSplits;
+    // Number of cascades in w
+    float4 LightDirection;
+};
+
+// 256 byte aligned
+ConstantBuffer<RenderViewConstants> RenderView : register(b0, space100);
@@ -0,0 +1,31 @@
+// Per renderable data of the persistent instance buffer, matches GPUSceneInstance
+struct SceneInstance
+{
+    // Rows of the local to world affine transform
+    float4 LocalToWorld[3];
+
+    // Rows of the inverse transpose of its upper 3x3
+    float3 NormalToWorld0;
+    uint MaterialIndex;
+    float3 NormalToWorld1;
+    uint Padding0;
+    float3 NormalToWorld2;
+    uint Padding1;
+};
+
+float3 InstanceLocalToWorld(SceneInstance inInstance, float3 inPosition)
+{
+    const float4 position = float4(inPosition, 1.f);
+    return float3(dot(inInstance.LocalToWorld[0], position), dot(inInstance.LocalToWorld[1], position), dot(inInstance.LocalToWorld[2], position));
+}
+
+// Directions along the surface, like tangents, follow the transform itself
+float3 InstanceDirectionToWorld(SceneInstance inInstance, float3 inDirection)
+{
+    return float3(dot(inInstance.LocalToWorld[0].xyz, inDirection), dot(inInstance.LocalToWorld[1].xyz, inDirection), dot(inInstance.LocalToWorld[2].xyz, inDirection));
+}
+
+float3 InstanceNormalToWorld(SceneInstance inInstance, float3 inNormal)
+{
+    return float3(dot(inInstance.NormalToWorld0, inNormal), dot(inInstance.NormalToWorld1, inNormal), dot(inInstance.NormalToWorld2, inNormal));
+}
@@ -0,0 +1,28 @@
+#include "SceneInstances.hlsl"
+
+#define SCATTER_GROUP_SIZE 64
+
+StructuredBuffer<uint> DirtySlots : register(t0);
+StructuredBuffer<SceneInstance> NewInstances : register(t1);
+
+RWStructuredBuffer<SceneInstance> SceneInstances : register(u0);
+
+struct ScatterConstants
+{
+    uint NumDirty;
+};
+
+ConstantBuffer<ScatterConstants> Constants : register(b0);
+
+// One thread per changed slot, the slots are unique so no two threads write the same instance
+[numthreads(SCATTER_GROUP_SIZE, 1, 1)]
+void CSMain(uint3 dispatchThreadID : SV_DispatchThreadID)
+{
+    const uint index = dispatchThreadID.x;
+    if (index >= Constants.NumDirty)
+    {
+        return;
+    }
+
+    SceneInstances[DirtySlots[index]] = NewInstances[index];
+}
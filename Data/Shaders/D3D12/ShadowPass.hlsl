@@ -1,17 +1,24 @@
+#include "SceneInstances.hlsl"
+#include "RenderView.hlsl"
 
-// 256 byte aligned
-struct SceneConstantBuffer
+// Instances of a draw start at FirstInstance, SV_InstanceID counts from 0 in every draw
+struct DrawConstants
 {
-    float4x4 LocalToClip;
-	float4 Test;
-	float Padding[43];
+    uint FirstInstance;
+    uint CascadeIndex;
 };
 
-ConstantBuffer<SceneConstantBuffer> SceneBuffer : register(b0);
+ConstantBuffer<DrawConstants> DrawBuffer : register(b1);
 
-float4 VSMain(float4 position : POSITION, float3 VertexNormal : NORMAL, float2 uv : TEXCOORD, float3 tangent : TANGENT, float3 bitangent : BITANGENT) : SV_POSITION
+// Persistent data of every scene mesh, and the slots of the instances drawn by the pass
+StructuredBuffer<SceneInstance> SceneInstances : register(t0);
+StructuredBuffer<uint> InstanceSlots : register(t1);
+
+float4 VSMain(float4 position : POSITION, float3 VertexNormal : NORMAL, float2 uv : TEXCOORD, float3 tangent : TANGENT, float3 bitangent : BITANGENT, uint instanceID : SV_InstanceID) : SV_POSITION
 {
-    float4 clipPos = mul(position, SceneBuffer.LocalToClip);
+    const SceneInstance instance = SceneInstances[InstanceSlots[DrawBuffer.FirstInstance + instanceID]];
+
+    float4 clipPos = mul(float4(InstanceLocalToWorld(instance, position.xyz), 1.f), RenderView.CascadeWorldToClip[DrawBuffer.CascadeIndex]);
 
 
     if (clipPos.z < 0)
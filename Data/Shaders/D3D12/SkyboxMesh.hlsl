@@ -1,4 +1,5 @@
 #include "Utils.hlsl"
+#include "RenderView.hlsl"
 
 struct PSInput
 {
@@ -11,24 +12,13 @@ struct PSOutput
     float4 Color : SV_TARGET0;
 };
 
-// 256 byte aligned
-struct SkyboxConstantBuffer
-{
-    float4x4 Projection;
-    float4x4 View;
-    float SkyOnlyExposure;
-};
-
-// 256 byte aligned
-ConstantBuffer<SkyboxConstantBuffer> SceneBuffer : register(b0);
-
-struct CubemapIndexBuffer
+struct SkyboxConstants
 {
     uint CubemapIdx;
+    float SkyOnlyExposure;
 };
 
-// 256 byte aligned
-ConstantBuffer<CubemapIndexBuffer> CubemapIdxContainer : register(b0, space1);
+ConstantBuffer<SkyboxConstants> SkyboxBuffer : register(b0, space1);
 
 static const float FP16Scale = 0.0009765625f;
 static const float FP16Max = 65000.0f;
@@ -39,10 +29,10 @@ SamplerState g_sampler : register(s0);
 PSInput VSMain(float4 position : POSITION)
 {
     // Use just rotation of View Matrix
-    float4 clipPos = mul(float4(position.xyz, 0.f), SceneBuffer.View);
+    float4 clipPos = mul(float4(position.xyz, 0.f), RenderView.WorldToView);
 
     // Project to clip space
-    clipPos = mul(float4(clipPos.xyz, 1.f), SceneBuffer.Projection);
+    clipPos = mul(float4(clipPos.xyz, 1.f), RenderView.JitteredViewToClip);
     
     // Make sure that this is always at the far plane after the divide
     PSInput result;
@@ -89,9 +79,9 @@ PSOutput PSMain(PSInput input)
     }
 #endif
 
-    TextureCube cubeMap = ResourceDescriptorHeap[CubemapIdxContainer.CubemapIdx];
+    TextureCube cubeMap = ResourceDescriptorHeap[SkyboxBuffer.CubemapIdx];
     float3 color = cubeMap.Sample(g_sampler, normalize(input.CubemapUV)).xyz;
-    color *= exp2(SceneBuffer.SkyOnlyExposure);
+    color *= exp2(SkyboxBuffer.SkyOnlyExposure);
 
     // reinhard tone mapping
     //color = color / (color + 1.f);
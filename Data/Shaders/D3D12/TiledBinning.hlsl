@@ -1,4 +1,5 @@
 #include "Utils.hlsl"
+#include "RenderView.hlsl"
 
 #define TILE_SIZE 16
 
@@ -15,23 +16,17 @@ struct ShaderDecal
 StructuredBuffer<ShaderDecal> DecalBuffer : register(t0, space0);
 Texture2D GBufferDepth : register(t1, space0);
 
-// 256 byte aligned
-struct DecalTilingConstantBuffer
+// Root constants, the view comes from the RenderView
+struct DecalTilingConstants
 {
-    float4x4 Projection;
-    float4x4 View;
-	float4x4 InvViewProj;
 	uint NumDecals;
 	uint2 NumWorkGroups;
 	uint DebugFlag;
 	float4 DebugValue;
 	float4 DebugQuat;
-
-	float Padding[4];
 };
 
-// 256 byte aligned
-ConstantBuffer<DecalTilingConstantBuffer> ConstBuffer : register(b0);
+ConstantBuffer<DecalTilingConstants> ConstBuffer : register(b0);
 
 SamplerState g_sampler : register(s0);
 
@@ -93,10 +88,10 @@ void CSMain(in uint3 DispatchID : SV_DispatchThreadID, in uint GroupIndex : SV_G
 	//float2 clipCoord = UV * 2.f - 1.f;
 	//float4 clipPos = float4(clipCoord, clipDepth, 1.f);
 	//clipPos.y *= -1.f; // Pixel coordinates(not NDC) for D3D start from upper left corner, so X stays the same but Y is flipped
-	//const float4 worldPosHom = mul(clipPos, ConstBuffer.InvViewProj);
+	//const float4 worldPosHom = mul(clipPos, RenderView.JitteredClipToWorld);
 	//const float4 worldPos = worldPosHom / worldPosHom.w;
 
-	//float linearizedDepth = ConstBuffer.Projection._43 / (clipDepth - ConstBuffer.Projection._33); 
+	//float linearizedDepth = RenderView.ViewToClip._43 / (clipDepth - RenderView.ViewToClip._33); 
 	//uint depthUint = asuint(linearizedDepth);
 	 
 	uint depthUint = asuint(clipDepth);
@@ -114,7 +109,7 @@ void CSMain(in uint3 DispatchID : SV_DispatchThreadID, in uint GroupIndex : SV_G
 	const float maxDepth = asfloat(maxDepthUint);
 	const float minDepth = asfloat(minDepthUint); 
 
-	const float4x4 viewProj = mul(ConstBuffer.View, ConstBuffer.Projection);
+	const float4x4 viewProj = RenderView.JitteredWorldToClip;
 
 	// Calculate frustum planes
 	if (GroupIndex == 0)
@@ -6,6 +6,8 @@
 #include "Window/WindowProperties.h"
 #include "Window/WindowsWindow.h"
 #include "Math/MathUtils.h"
+#include "Scene/Scene.h"
+#include "Scene/SceneManager.h"
 
 Camera::Camera()
 	: Entity("Camera") 
@@ -48,7 +50,7 @@ void Camera::Move(EMovementDirection inDirection, const float inSpeed)
 	front *= MouseMoveSensitivity;
 	right *= MouseMoveSensitivity;
 
-	if (TransformObjPtr parentShared = Parent.lock())
+	if (TransformObject* parent = Parent)
 	{
 		glm::vec3 movementVector(0.f);
 
@@ -76,11 +78,62 @@ void Camera::Move(EMovementDirection inDirection, const float inSpeed)
 			break;
 		}
 
-		parentShared->Move(movementVector);
+		if (bCollisionEnabled)
+		{
+			movementVector = ResolveMovementCollision(movementVector);
+		}
+
+		parent->Move(movementVector);
 	}
 }
 
 
+glm::vec3 Camera::ResolveMovementCollision(const glm::vec3& inMovement) const
+{
+	// Distance kept from surfaces so the next sweep doesn't start touching them
+	constexpr float collisionSkin = 0.01f;
+
+	const SceneQueries& queries = SceneManager::Get().GetCurrentScene().GetQueries();
+	const glm::vec3 startPosition = GetAbsoluteTransform().Translation;
+
+	glm::vec3 resolved = glm::vec3(0.f);
+	glm::vec3 remaining = inMovement;
+
+	// A few slide iterations are enough for corners
+	for (int32_t iteration = 0; iteration < 3; ++iteration)
+	{
+		const float remainingLength = glm::length(remaining);
+		if (remainingLength < 1e-5f)
+		{
+			break;
+		}
+
+		SphereSweep sweep;
+		sweep.Start = startPosition + resolved;
+		sweep.Direction = remaining / remainingLength;
+		sweep.MaxDistance = remainingLength;
+		sweep.Radius = CollisionRadius;
+
+		SceneSweepHit hit;
+		if (!queries.SweepSphere(sweep, hit))
+		{
+			resolved += remaining;
+			break;
+		}
+
+		// Starting inside of a surface only hits it when moving deeper, at distance 0, and the slide below keeps the part of
+		// the move along it. Leaving the surface is swept against everything else like any other move.
+		const float travelled = glm::max(hit.Distance - collisionSkin, 0.f);
+		resolved += sweep.Direction * travelled;
+
+		// Slide what's left along the surface
+		remaining -= sweep.Direction * travelled;
+		remaining -= hit.Normal * glm::dot(remaining, hit.Normal);
+	}
+
+	return resolved;
+}
+
 void Camera::SetMovementDelegates(ControllerBase& inController)
 {
 	inController.OnMouseMoved().BindRaw(this, &Camera::OnMousePosChanged);
@@ -117,10 +170,10 @@ void Camera::OnMousePosChanged(const float inNewYaw, const float inNewPitch)
 // 	LOG_INFO("Mouse yaw offset %f", yawOffset);
 // 	LOG_INFO("Mouse yaw %f", inNewYaw);
 
- 	if (TransformObjPtr parentShared = Parent.lock())
+ 	if (TransformObject* parent = Parent)
  	{
- 		//parentShared->Rotate(-yawOffset, glm::vec3(0.f, 1.f, 0.f)); // For OpenGl
- 		parentShared->Rotate(yawOffset, glm::vec3(0.f, 1.f, 0.f));
+ 		//parent->Rotate(-yawOffset, glm::vec3(0.f, 1.f, 0.f)); // For OpenGl
+ 		parent->Rotate(yawOffset, glm::vec3(0.f, 1.f, 0.f));
  	}
 
 	//Rotate(pitchOffset, glm::vec3(1.f, 0.f, 0.f));// For OpenGl
@@ -157,3 +210,22 @@ float Camera::GetFOV() const
 	return CAMERA_FOV;
 }
 
+PathTracingRay Camera::ScreenPointToRay(const glm::vec2& inScreenPos, const glm::vec2& inViewportSize)
+{
+	// Pixels to NDC, y goes up in NDC
+	const glm::vec2 ndc = glm::vec2((inScreenPos.x / inViewportSize.x) * 2.f - 1.f, 1.f - (inScreenPos.y / inViewportSize.y) * 2.f);
+
+	const glm::mat4 invViewProj = glm::inverse(ProjMatCache * GetLookAt());
+
+	// Projection is zero to one depth
+	glm::vec4 nearPoint = invViewProj * glm::vec4(ndc, 0.f, 1.f);
+	glm::vec4 farPoint = invViewProj * glm::vec4(ndc, 1.f, 1.f);
+	nearPoint /= nearPoint.w;
+	farPoint /= farPoint.w;
+
+	PathTracingRay ray;
+	ray.Origin = glm::vec3(nearPoint);
+	ray.Direction = glm::normalize(glm::vec3(farPoint) - glm::vec3(nearPoint));
+
+	return ray;
+}
@@ -1,6 +1,7 @@
 #pragma once
 #include "Entity/Entity.h"
 #include "EASTL/shared_ptr.h"
+#include "Math/PathTracing.h"
 
 enum class EMovementDirection
 {
@@ -30,8 +31,16 @@ public:
 	float GetFar() const;
 	float GetFOV() const;
 
+	// World space ray through a point in pixels, origin on the near plane
+	PathTracingRay ScreenPointToRay(const glm::vec2& inScreenPos, const glm::vec2& inViewportSize);
+
+	// When enabled, movement is swept as a sphere against the scene and slides along what it hits
+	inline void SetCollisionEnabled(const bool inEnabled) { bCollisionEnabled = inEnabled; }
+	inline bool IsCollisionEnabled() const { return bCollisionEnabled; }
+
 private:
 	void OnMousePosChanged(const float inNewYaw, const float inNewPitch);
+	glm::vec3 ResolveMovementCollision(const glm::vec3& inMovement) const;
 	
 private:
 	bool FirstMouse{true};
@@ -42,7 +51,6 @@ private:
 	float MouseLookSensitivity{ 0.5f };
 	float MouseMoveSensitivity{ 1.0f };
 	glm::mat4 ProjMatCache;
+	bool bCollisionEnabled{ false };
+	float CollisionRadius{ 0.2f };
 };
-
-
-// TODO: Implement raycasts
@@ -5,6 +5,7 @@
 #include "Scene/SceneManager.h"
 #include "Scene/Scene.h"
 #include "Entity/Entity.h"
+#include "Entity/TransformSystem.h"
 #include "Core/AppModeBase.h"
 #include "Timer/TimersManager.h"
 #include "Window/WindowsWindow.h"
@@ -148,7 +149,13 @@ void AppCore::Run()
 
 		GEditor->Tick(CurrentDeltaT);
 
+		SceneManager::Get().GetCurrentScene().TickObjects(CurrentDeltaT);
 		CurrentApp->Tick(CurrentDeltaT);
+
+		// Propagate every transform changed by this frame's tick once, before the passes read them
+		TransformSystem::Get().UpdateWorldTransforms();
+		SceneManager::Get().GetCurrentScene().UpdateSpatialIndex();
+
 		CurrentApp->ExecutePasses();
 
 		// Tick plugins
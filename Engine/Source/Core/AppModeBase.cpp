@@ -1,5 +1,6 @@
 #include "Core/AppModeBase.h"
 #include "EngineUtils.h"
+#include "Core/EngineChecks.h"
 #include "Renderer/RHI/D3D12/D3D12RHI.h"
 #include "imgui.h"
 #include "backends/imgui_impl_win32.h"
@@ -14,6 +15,7 @@
 #include "glm/ext/matrix_transform.hpp"
 #include "Scene/SceneManager.h"
 #include "Scene/Scene.h"
+#include "Entity/SystemScheduler.h"
 #include "Camera/Camera.h"
 #include "Utils/Utils.h"
 #include "Utils/PerfUtils.h"
@@ -28,6 +30,13 @@
 #include "Renderer/DrawDebugHelpers.h"
 #include "Renderer/RenderPasses/ShadowPass.h"
 #include "Renderer/RenderPasses/DebugTexturesPass.h"
+#include "Renderer/RenderPasses/SceneInstancesPass.h"
+#include "Renderer/RenderView.h"
+#include "Renderer/Visibility/ViewVisibility.h"
+#include "Renderer/Baking/BakingScene.h"
+#include "Renderer/Baking/ProbeVolume.h"
+#include "Renderer/Baking/AmbientOcclusionBaker.h"
+#include "Renderer/Baking/PotentiallyVisibleSet.h"
 
 // Windows includes
 #ifndef WIN32_LEAN_AND_MEAN
@@ -85,6 +94,29 @@ BindlessDecalsPass BindlessDecalsPassCommmand;
 DeferredLightingPass DeferredLightingPassCommand;
 SkyboxPass SkyboxPassCommand;
 DebugTexturePass DebugTexturesPassCommand;
+SceneInstancesPass SceneInstancesPassCommand;
+
+// Camera data shared by all passes, rebuilt once per frame
+RenderView MainView;
+
+// Draw lists of every view in the frame, computed together before the passes execute
+ViewVisibility FrameVisibility;
+
+// Offline baking data, built on demand from the Baking window
+BakingScene SceneBakingData;
+ProbeVolume SceneProbeVolume;
+PotentiallyVisibleSet ScenePVS;
+
+// The snapshot is kept between bakes and only built again once meshes were added, removed or moved
+static bool UpdateSceneBakingData(const Scene& inScene)
+{
+	if (!SceneBakingData.IsValid() || SceneBakingData.SceneGeometryVersion != inScene.GetGeometryVersion())
+	{
+		SceneBakingData.Build(inScene);
+	}
+
+	return SceneBakingData.IsValid();
+}
 
 void AppModeBase::Init()
 {
@@ -113,6 +145,7 @@ void AppModeBase::CreateInitialResources()
 	DeferredLightingPassCommand.Init(DeferredBasePassCommand.GBufferTextures);
 	SkyboxPassCommand.Init();
 	DebugTexturesPassCommand.Init();
+	SceneInstancesPassCommand.Init();
 
 	D3D12Globals::GlobalMaterialsBuffer.Init(1024, sizeof(ShaderMaterial));
 
@@ -186,7 +219,7 @@ void AppModeBase::CreateInitialResources()
 
 	//currentScene.GetCurrentCamera()->Move(EMovementDirection::Back, 3.f);
 
-	eastl::shared_ptr<TransformObject> cameraParent = currentScene.GetCurrentCamera()->GetParent().lock();
+	TransformObject* cameraParent = currentScene.GetCurrentCamera()->GetParent();
 	cameraParent->SetRelativeLocation(glm::vec3(0.683f, 1.537f, 5.061f));
 	cameraParent->SetRotationDegrees(glm::vec3(-180.f, 28.480f, -180.f));
 	currentScene.GetCurrentCamera()->SetRotationDegrees(glm::vec3(25.f, 0.f, 0.f));
@@ -334,10 +367,33 @@ void AppModeBase::ExecutePasses()
 
 
 	const glm::vec3 normLightDir = glm::normalize(LightDir);
-	ShadowDepthsPass.Execute(D3D12Globals::GraphicsCmdList, normLightDir);
-	DeferredBasePassCommand.Execute(D3D12Globals::GraphicsCmdList);
 
-	BindlessDecalsPassCommmand.Execute(D3D12Globals::GraphicsCmdList, DeferredBasePassCommand.GBufferTextures);
+	// Sub pixel jitter, off by default as nothing resolves it over frames yet
+	static bool bJitterProjection = false;
+	ImGui::Checkbox("Jitter Projection", &bJitterProjection);
+
+	{
+		const WindowProperties& props = GEngine->GetMainWindow().GetProperties();
+		const glm::vec2 jitter = bJitterProjection ? RenderView::GetHaltonJitter(CurrentCPUFrame) : glm::vec2(0.f);
+
+		MainView.Build(*SceneManager::Get().GetCurrentScene().GetCurrentCamera(), props.Width, props.Height, jitter);
+		// Fat bounds of every mesh, they only grow or shrink when a mesh moves far enough to be reinserted in the tree
+		const AABB casterBounds = SceneManager::Get().GetCurrentScene().GetMeshBoundsTree().GetRootBounds();
+		MainView.BuildCascades(normLightDir, ShadowDepthsPass.GetCascadeSettings(), casterBounds);
+		ShadowDepthsPass.ScheduleCascades(MainView, CurrentCPUFrame);
+		MainView.Upload();
+	}
+
+	FrameVisibility.Reset();
+	DeferredBasePassCommand.AddVisibilityViews(FrameVisibility, MainView);
+	ShadowDepthsPass.AddVisibilityViews(FrameVisibility, MainView);
+	FrameVisibility.Compute(SceneManager::Get().GetCurrentScene().GetMeshRenderables());
+
+	SceneInstancesPassCommand.Execute(D3D12Globals::GraphicsCmdList);
+	ShadowDepthsPass.Execute(D3D12Globals::GraphicsCmdList, MainView, FrameVisibility, SceneInstancesPassCommand);
+	DeferredBasePassCommand.Execute(D3D12Globals::GraphicsCmdList, MainView, FrameVisibility, SceneInstancesPassCommand);
+
+	BindlessDecalsPassCommmand.Execute(D3D12Globals::GraphicsCmdList, DeferredBasePassCommand.GBufferTextures, MainView);
 
 
 	{
@@ -346,12 +402,12 @@ void AppModeBase::ExecutePasses()
 		SceneTextures& sceneTextures = DeferredBasePassCommand.GBufferTextures;
 
 
-		DeferredLightingPassCommand.Execute(D3D12Globals::GraphicsCmdList, DeferredBasePassCommand.GBufferTextures, *LightingTarget, normLightDir);
+		DeferredLightingPassCommand.Execute(D3D12Globals::GraphicsCmdList, DeferredBasePassCommand.GBufferTextures, *LightingTarget, MainView);
 	}
 
-	SkyboxPassCommand.Execute(D3D12Globals::GraphicsCmdList, *LightingTarget, DeferredBasePassCommand.GBufferTextures);
+	SkyboxPassCommand.Execute(D3D12Globals::GraphicsCmdList, *LightingTarget, DeferredBasePassCommand.GBufferTextures, MainView);
 
-	DebugPrimitivesPassCommand.Execute(D3D12Globals::GraphicsCmdList, *DeferredBasePassCommand.GBufferTextures.MainDepthBuffer, *LightingTarget);
+	DebugPrimitivesPassCommand.Execute(D3D12Globals::GraphicsCmdList, *DeferredBasePassCommand.GBufferTextures.MainDepthBuffer, *LightingTarget, MainView);
 	DebugTexturesPassCommand.Execute(D3D12Globals::GraphicsCmdList, *LightingTarget);
 
 	// Copy lighting output to backbuffer
@@ -385,6 +441,113 @@ void AppModeBase::ExecutePasses()
 
 		ImGui::Begin("D3D12 Settings");
 		ImGui::End();
+
+		ImGui::Begin("Baking");
+
+		static ProbeVolumeSettings probeSettings;
+		static bool bDrawProbes = false;
+		static double probeLookupTimeNs = 0.0;
+
+		ImGui::DragScalarN("Probe Count", ImGuiDataType_U32, &probeSettings.ProbeCount.x, 3, 0.1f);
+		ImGui::DragScalar("Rays Per Probe", ImGuiDataType_U32, &probeSettings.RaysPerProbe, 1.f);
+
+		if (ImGui::Button("Bake Probe Volume"))
+		{
+			if (UpdateSceneBakingData(currentScene))
+			{
+				probeSettings.SunDirection = normLightDir;
+				SceneProbeVolume.Bake(SceneBakingData, probeSettings);
+				probeLookupTimeNs = SceneProbeVolume.BenchmarkLookups(100000);
+			}
+		}
+
+		static AmbientOcclusionSettings aoSettings;
+		ImGui::DragScalar("AO Rays", ImGuiDataType_U32, &aoSettings.NumRays, 1.f);
+		ImGui::DragFloat("AO Max Distance", &aoSettings.MaxDistance, 0.05f, 0.01f, 100.f);
+
+		if (ImGui::Button("Bake Vertex AO"))
+		{
+			if (UpdateSceneBakingData(currentScene))
+			{
+				AmbientOcclusionBaker::BakeVertexAO(SceneBakingData, aoSettings);
+			}
+		}
+
+		static PVSSettings pvsSettings;
+		static bool bUsePVS = true;
+		ImGui::DragFloat3("PVS Cell Size", &pvsSettings.CellSize.x, 0.1f, 0.1f, 100.f);
+		ImGui::DragScalar("PVS Samples Per Cell", ImGuiDataType_U32, &pvsSettings.SamplesPerCell, 1.f);
+		ImGui::DragScalar("PVS Rays Per Sample", ImGuiDataType_U32, &pvsSettings.RaysPerSample, 1.f);
+		ImGui::Checkbox("PVS Dilate", &pvsSettings.bDilate);
+
+		if (ImGui::Button("Bake PVS"))
+		{
+			if (UpdateSceneBakingData(currentScene))
+			{
+				ScenePVS.Bake(SceneBakingData, pvsSettings);
+			}
+		}
+
+		if (ScenePVS.IsValid())
+		{
+			ImGui::Text("PVS: %u cells, %.2f ms, %u KB, %.1f%% visible on average", ScenePVS.GetNumCells(), ScenePVS.GetLastBakeTimeMs(), static_cast<uint32_t>(ScenePVS.GetMemorySize() / 1024), ScenePVS.GetAverageVisibleFraction() * 100.f);
+			ImGui::Checkbox("Use PVS", &bUsePVS);
+		}
+
+		DeferredBasePassCommand.VisibilitySet = bUsePVS && ScenePVS.IsValid() ? &ScenePVS : nullptr;
+		ImGui::Text("Meshes drawn: %llu", static_cast<unsigned long long>(DeferredBasePassCommand.GetNumMeshesDrawn()));
+
+		if (SceneProbeVolume.IsValid())
+		{
+			ImGui::Text("Bake: %.2f ms, Lookup: %.1f ns", SceneProbeVolume.GetLastBakeTimeMs(), probeLookupTimeNs);
+			ImGui::Checkbox("Draw Probes", &bDrawProbes);
+
+			if (bDrawProbes)
+			{
+				SceneProbeVolume.DebugDraw();
+			}
+		}
+
+		ImGui::End();
+
+		ImGui::Begin("Scene Queries");
+
+		bool bCameraCollision = currentScene.GetCurrentCamera()->IsCollisionEnabled();
+		if (ImGui::Checkbox("Camera Collision", &bCameraCollision))
+		{
+			currentScene.GetCurrentCamera()->SetCollisionEnabled(bCameraCollision);
+		}
+
+		if (ImGui::Button("Rebuild Queries"))
+		{
+			currentScene.MarkQueriesDirty();
+		}
+
+		if (ImGui::Button("Benchmark Shape Queries"))
+		{
+			currentScene.GetQueries().BenchmarkShapeQueries(10000);
+		}
+
+		if (ImGui::Button("Check Shape Queries"))
+		{
+			currentScene.GetQueries().RunChecks(currentScene, 10000);
+		}
+
+		ImGui::End();
+
+		ImGui::Begin("Engine Checks");
+
+		if (ImGui::Button("Run Engine Checks"))
+		{
+			EngineChecks::RunAll(true);
+		}
+
+		if (ImGui::Button("Benchmark Entity Systems"))
+		{
+			SystemScheduler::Benchmark(100000, 60);
+		}
+
+		ImGui::End();
 	}
 
 }
@@ -0,0 +1,48 @@
+#include "Core/EngineChecks.h"
+#include "Core/EngineUtils.h"
+#include "Utils/TestUtils.h"
+#include "Utils/SlotMap.h"
+#include "Entity/EntityRegistry.h"
+#include "Entity/SystemScheduler.h"
+#include "Math/CollisionTests.h"
+#include "Math/DynamicAABBTree.h"
+#include "Renderer/DrawPacket.h"
+#include "Renderer/ShadowAtlas.h"
+#include "Renderer/Visibility/FrustumCuller.h"
+#include "Renderer/Visibility/OcclusionCuller.h"
+#include "Renderer/Visibility/ViewVisibility.h"
+#include "Renderer/Visibility/ClusteredBinning.h"
+
+uint32_t EngineChecks::RunAll(const bool inBreakOnFailure)
+{
+	LOG_INFO("Running engine checks.");
+
+	TestUtils::SetBreakOnFailure(inBreakOnFailure);
+	const uint32_t numFailedBefore = TestUtils::GetNumFailedCases();
+
+	RunSlotMapChecks();
+	EntityRegistry::RunChecks();
+	SystemScheduler::RunChecks();
+	CollisionTests::RunChecks();
+	DynamicAABBTree::RunChecks();
+	FrustumCuller::RunChecks();
+	OcclusionCuller::RunChecks();
+	ViewVisibility::RunChecks();
+	DrawPacketList::RunChecks();
+	ShadowAtlas::RunChecks();
+	ClusteredBinning::RunChecks();
+
+	const uint32_t numFailed = TestUtils::GetNumFailedCases() - numFailedBefore;
+	TestUtils::SetBreakOnFailure(true);
+
+	if (numFailed == 0)
+	{
+		LOG_INFO("Engine checks passed.");
+	}
+	else
+	{
+		LOG_ERROR("Engine checks: %u cases failed.", numFailed);
+	}
+
+	return numFailed;
+}
@@ -0,0 +1,10 @@
+#pragma once
+#include <stdint.h>
+
+// Correctness checks of the engine systems that don't need a scene or the renderer. Run them headless by starting the engine
+// with -checks, the process then exits with an error instead of breaking into the debugger when a check fails.
+namespace EngineChecks
+{
+	// Returns the number of failed cases
+	uint32_t RunAll(const bool inBreakOnFailure);
+}
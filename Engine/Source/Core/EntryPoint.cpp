@@ -1,8 +1,16 @@
 #include "AppModeBase.h"
 #include "AppCore.h"
+#include "Core/EngineChecks.h"
+#include <string.h>
 
 int main(int argc, char** argv)
 {
+	// Checks only, without creating the window or the renderer
+	if (argc > 1 && strcmp(argv[1], "-checks") == 0)
+	{
+		return EngineChecks::RunAll(false) == 0 ? 0 : 1;
+	}
+
 	AppCore::Init();
 	GEngine->Run();
 }
\ No newline at end of file
@@ -0,0 +1,166 @@
+#include "Core/TaskSystem.h"
+#include "Core/EngineUtils.h"
+#include "Math/MathUtils.h"
+
+// Set on worker threads and on the calling thread while it executes batches, used to run nested calls serially
+static thread_local bool bInsideTask = false;
+
+TaskSystem& TaskSystem::Get()
+{
+	static TaskSystem Instance;
+
+	return Instance;
+}
+
+bool TaskSystem::IsInsideTask()
+{
+	return bInsideTask;
+}
+
+TaskSystem::TaskSystem()
+{
+	const uint32_t hardwareThreads = glm::max(std::thread::hardware_concurrency(), 1u);
+	const uint32_t numBackgroundWorkers = hardwareThreads - 1;
+
+	Workers.reserve(numBackgroundWorkers);
+	for (uint32_t i = 0; i < numBackgroundWorkers; ++i)
+	{
+		// Worker 0 is the thread calling ParallelFor
+		Workers.push_back(std::thread(&TaskSystem::WorkerLoop, this, i + 1));
+	}
+
+	LOG_INFO("Task System started with %u workers.", GetNumWorkers());
+}
+
+TaskSystem::~TaskSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(JobMutex);
+		bShutdown = true;
+	}
+
+	JobCondition.notify_all();
+
+	for (std::thread& worker : Workers)
+	{
+		worker.join();
+	}
+}
+
+void TaskSystem::ExecuteBatches(const BatchFunc inFunc, void* inContext, const uint32_t inCount, const uint32_t inBatchSize, const uint32_t inNumBatches, const uint32_t inWorkerIdx)
+{
+	uint32_t batchIdx = NextBatch.fetch_add(1, std::memory_order_relaxed);
+
+	while (batchIdx < inNumBatches)
+	{
+		const uint32_t begin = batchIdx * inBatchSize;
+		const uint32_t end = glm::min(begin + inBatchSize, inCount);
+
+		inFunc(inContext, begin, end, inWorkerIdx);
+
+		const uint32_t completed = CompletedBatches.fetch_add(1, std::memory_order_acq_rel) + 1;
+		if (completed == inNumBatches)
+		{
+			std::lock_guard<std::mutex> lock(JobMutex);
+			DoneCondition.notify_all();
+		}
+
+		batchIdx = NextBatch.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+void TaskSystem::WorkerLoop(const uint32_t inWorkerIdx)
+{
+	bInsideTask = true;
+	uint64_t lastGeneration = 0;
+
+	while (true)
+	{
+		BatchFunc func = nullptr;
+		void* context = nullptr;
+		uint32_t count = 0;
+		uint32_t batchSize = 0;
+		uint32_t numBatches = 0;
+
+		{
+			std::unique_lock<std::mutex> lock(JobMutex);
+			JobCondition.wait(lock, [&]() { return bShutdown || JobGeneration != lastGeneration; });
+
+			if (bShutdown)
+			{
+				return;
+			}
+
+			// Copy the job while holding the lock, the dispatcher does not touch it until ActiveWorkers drops to 0
+			lastGeneration = JobGeneration;
+			func = JobFunc;
+			context = JobContext;
+			count = JobCount;
+			batchSize = JobBatchSize;
+			numBatches = JobNumBatches;
+			++ActiveWorkers;
+		}
+
+		ExecuteBatches(func, context, count, batchSize, numBatches, inWorkerIdx);
+
+		{
+			std::lock_guard<std::mutex> lock(JobMutex);
+			--ActiveWorkers;
+		}
+
+		DoneCondition.notify_all();
+	}
+}
+
+void TaskSystem::ParallelForInternal(const uint32_t inCount, const uint32_t inBatchSize, BatchFunc inFunc, void* inContext)
+{
+	if (inCount == 0)
+	{
+		return;
+	}
+
+	const uint32_t batchSize = glm::max(inBatchSize, 1u);
+	const uint32_t numBatches = MathUtils::DivideAndRoundUp(inCount, batchSize);
+
+	// Nothing to gain from waking workers, or already inside a parallel section
+	const bool bRunSerially = numBatches == 1 || Workers.empty() || bInsideTask;
+	if (bRunSerially || !DispatchMutex.try_lock())
+	{
+		for (uint32_t i = 0; i < numBatches; ++i)
+		{
+			const uint32_t begin = i * batchSize;
+			inFunc(inContext, begin, glm::min(begin + batchSize, inCount), 0);
+		}
+
+		return;
+	}
+
+	{
+		std::unique_lock<std::mutex> lock(JobMutex);
+
+		// Workers that were late to the previous job might still hold a copy of it
+		DoneCondition.wait(lock, [&]() { return ActiveWorkers == 0; });
+
+		JobFunc = inFunc;
+		JobContext = inContext;
+		JobCount = inCount;
+		JobBatchSize = batchSize;
+		JobNumBatches = numBatches;
+		NextBatch.store(0, std::memory_order_relaxed);
+		CompletedBatches.store(0, std::memory_order_relaxed);
+		++JobGeneration;
+	}
+
+	JobCondition.notify_all();
+
+	bInsideTask = true;
+	ExecuteBatches(inFunc, inContext, inCount, batchSize, numBatches, 0);
+	bInsideTask = false;
+
+	{
+		std::unique_lock<std::mutex> lock(JobMutex);
+		DoneCondition.wait(lock, [&]() { return CompletedBatches.load(std::memory_order_acquire) == numBatches; });
+	}
+
+	DispatchMutex.unlock();
+}
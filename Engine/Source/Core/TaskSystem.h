@@ -0,0 +1,73 @@
+#pragma once
+#include <stdint.h>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <type_traits>
+#include "EASTL/vector.h"
+
+/**
+ * Small persistent worker pool used by the CPU side systems(baking, culling, hierarchy updates).
+ * ParallelFor splits a range in batches that the workers and the calling thread pull from a shared counter.
+ * Worker index 0 is always the calling thread, so per worker scratch data can be sized with GetNumWorkers().
+ * Nested or concurrent ParallelFor calls from inside a batch are executed serially on the calling thread.
+ */
+class TaskSystem
+{
+public:
+	static TaskSystem& Get();
+
+	// Func signature: void(const uint32_t inBegin, const uint32_t inEnd, const uint32_t inWorkerIdx)
+	template<typename Func>
+	void ParallelFor(const uint32_t inCount, const uint32_t inBatchSize, Func&& inFunc);
+
+	inline uint32_t GetNumWorkers() const { return static_cast<uint32_t>(Workers.size()) + 1; }
+
+	// True on any thread executing batches of a ParallelFor that was spread over the workers
+	static bool IsInsideTask();
+
+private:
+	using BatchFunc = void(*)(void* inContext, const uint32_t inBegin, const uint32_t inEnd, const uint32_t inWorkerIdx);
+
+	TaskSystem();
+	~TaskSystem();
+
+	void ParallelForInternal(const uint32_t inCount, const uint32_t inBatchSize, BatchFunc inFunc, void* inContext);
+	void WorkerLoop(const uint32_t inWorkerIdx);
+	void ExecuteBatches(const BatchFunc inFunc, void* inContext, const uint32_t inCount, const uint32_t inBatchSize, const uint32_t inNumBatches, const uint32_t inWorkerIdx);
+
+private:
+	eastl::vector<std::thread> Workers;
+
+	std::mutex JobMutex;
+	std::mutex DispatchMutex;
+	std::condition_variable JobCondition;
+	std::condition_variable DoneCondition;
+
+	// Current job, only written with JobMutex held and no active workers
+	BatchFunc JobFunc = nullptr;
+	void* JobContext = nullptr;
+	uint32_t JobCount = 0;
+	uint32_t JobBatchSize = 0;
+	uint32_t JobNumBatches = 0;
+	uint64_t JobGeneration = 0;
+
+	std::atomic<uint32_t> NextBatch = 0;
+	std::atomic<uint32_t> CompletedBatches = 0;
+	uint32_t ActiveWorkers = 0;
+	bool bShutdown = false;
+};
+
+template<typename Func>
+void TaskSystem::ParallelFor(const uint32_t inCount, const uint32_t inBatchSize, Func&& inFunc)
+{
+	using FuncType = typename std::remove_reference<Func>::type;
+
+	BatchFunc batchFunc = [](void* inContext, const uint32_t inBegin, const uint32_t inEnd, const uint32_t inWorkerIdx)
+	{
+		(*static_cast<FuncType*>(inContext))(inBegin, inEnd, inWorkerIdx);
+	};
+
+	ParallelForInternal(inCount, inBatchSize, batchFunc, const_cast<void*>(static_cast<const void*>(&inFunc)));
+}
@@ -5,6 +5,13 @@
 #include "Scene/Scene.h"
 #include "Camera/Camera.h"
 #include "Core/AppModeBase.h"
+#include "Core/AppCore.h"
+#include "Renderer/Model/3D/Model3D.h"
+#include "Renderer/Drawable/Drawable.h"
+#include "Window/WindowsWindow.h"
+#include "Window/WindowProperties.h"
+#include "EASTL/string.h"
+#include "Utils/PerfUtils.h"
 #include "imgui.h"
 
 Editor* GEditor = nullptr;
@@ -104,6 +111,13 @@ void Editor::Internal_Init()
 		OnKeyAction action = { mouseRightPressedDel, mouseRightReleasedDel, key, true };
 		Controller->AddListener(action);
 	}
+
+	{
+		KeyActionDelegate del = KeyActionDelegate::CreateRaw(this, &Editor::OnMouseLeftPressed);
+		EInputKey key = EInputKey::MouseLeft;
+		OnKeyAction action = { del, {}, key, true };
+		Controller->AddListener(action);
+	}
 }
 
 float CameraSpeed = 0.1f;
@@ -195,6 +209,49 @@ void Editor::OnMouseRightReleased()
 	LOG_INFO("Viewport navigate mode OFF.");
 }
 
+void Editor::OnMouseLeftPressed()
+{
+	// Clicks on ImGui windows are not meant for the viewport
+	if (InViewportNavigateMode || ImGui::GetIO().WantCaptureMouse)
+	{
+		return;
+	}
+
+	const WindowProperties& props = GEngine->GetMainWindow().GetProperties();
+	const ImVec2 mousePos = ImGui::GetIO().MousePos;
+
+	Scene& currentScene = SceneManager::Get().GetCurrentScene();
+	SceneQueries& queries = currentScene.GetQueries();
+
+	SceneRaycastHit hit;
+	bool bHit = false;
+	DecalObject* decal = nullptr;
+	float decalDistance = 0.f;
+	int64_t pickTimeUs = 0;
+	{
+		Utils::BenchmarkCode bench(&pickTimeUs);
+		bHit = queries.RaycastFromScreen(*ViewportCamera, glm::vec2(mousePos.x, mousePos.y), glm::vec2(props.Width, props.Height), hit);
+
+		// Decals are projected on the surface the ray hit, so only the ones whose box is entered before it are visible there
+		PathTracingRay ray = ViewportCamera->ScreenPointToRay(glm::vec2(mousePos.x, mousePos.y), glm::vec2(props.Width, props.Height));
+		ray.MaxDistance = bHit ? hit.Distance : ViewportCamera->GetFar();
+		currentScene.RaycastDecals(ray, decal, decalDistance);
+	}
+
+	if (decal)
+	{
+		LOG_INFO("Picked decal %s at distance %f, took %lld us.", decal->Name.c_str(), decalDistance, (long long)pickTimeUs);
+	}
+	else if (bHit)
+	{
+		LOG_INFO("Picked %s at distance %f, took %lld us.", hit.Mesh->Name.c_str(), hit.Distance, (long long)pickTimeUs);
+	}
+	else
+	{
+		LOG_INFO("Picked nothing, took %lld us.", (long long)pickTimeUs);
+	}
+}
+
 ControllerBase& Editor::GetController()
 {
 	return *Controller;
@@ -29,6 +29,7 @@
      void BoostCameraSpeed();
      void OnMouseRightPressed();
      void OnMouseRightReleased();
+     void OnMouseLeftPressed();
 
 
  private:
@@ -0,0 +1,497 @@
+#include "Entity/EntityRegistry.h"
+#include <atomic>
+#include <mutex>
+#include "EASTL/algorithm.h"
+#include "Utils/TestUtils.h"
+
+// Chunks are sized so that small components fit a few hundred entities in one allocation
+static constexpr uint32_t TargetChunkByteSize = 16 * 1024;
+static constexpr uint32_t ChunkAlignment = 64;
+
+static ComponentTypeInfo RegisteredTypes[MaxComponentTypes];
+static uint32_t NumRegisteredTypes = 0;
+
+ComponentTypeId ComponentTypes::Register(const ComponentTypeInfo& inInfo)
+{
+	// First use of a type can happen from any worker
+	static std::mutex RegisterMutex;
+	std::lock_guard<std::mutex> lock(RegisterMutex);
+
+	ASSERT(NumRegisteredTypes < MaxComponentTypes);
+
+	RegisteredTypes[NumRegisteredTypes] = inInfo;
+	return NumRegisteredTypes++;
+}
+
+const ComponentTypeInfo& ComponentTypes::GetInfo(const ComponentTypeId inId)
+{
+	return RegisteredTypes[inId];
+}
+
+static inline uint32_t AlignUp(const uint32_t inValue, const uint32_t inAlignment)
+{
+	return (inValue + inAlignment - 1) & ~(inAlignment - 1);
+}
+
+Archetype::Archetype(const ComponentMask inMask)
+	: Mask{ inMask }
+{
+	uint32_t entityByteSize = sizeof(EntityHandle);
+	for (ComponentTypeId type = 0; type < MaxComponentTypes; ++type)
+	{
+		if (inMask & (ComponentMask(1) << type))
+		{
+			Types.push_back(type);
+			Infos.push_back(ComponentTypes::GetInfo(type));
+			entityByteSize += Infos.back().Size;
+		}
+	}
+
+	Offsets.resize(Types.size());
+
+	// Shrink the capacity until the aligned arrays fit the target size, a chunk always holds at least one entity
+	ChunkCapacity = entityByteSize < TargetChunkByteSize ? TargetChunkByteSize / entityByteSize : 1;
+	while (true)
+	{
+		uint32_t offset = sizeof(EntityHandle) * ChunkCapacity;
+		for (uint32_t slot = 0; slot < Types.size(); ++slot)
+		{
+			offset = AlignUp(offset, Infos[slot].Alignment);
+			Offsets[slot] = offset;
+			offset += Infos[slot].Size * ChunkCapacity;
+		}
+
+		ChunkByteSize = offset;
+		if (ChunkByteSize <= TargetChunkByteSize || ChunkCapacity == 1)
+		{
+			break;
+		}
+
+		--ChunkCapacity;
+	}
+}
+
+Archetype::~Archetype()
+{
+	for (ArchetypeChunk& chunk : Chunks)
+	{
+		for (uint32_t slot = 0; slot < Types.size(); ++slot)
+		{
+			for (uint32_t row = 0; row < chunk.Count; ++row)
+			{
+				Infos[slot].Destroy(chunk.Data + Offsets[slot] + row * Infos[slot].Size);
+			}
+		}
+
+		::operator delete(chunk.Data, std::align_val_t(ChunkAlignment));
+	}
+}
+
+int32_t Archetype::GetTypeSlot(const ComponentTypeId inType) const
+{
+	for (uint32_t slot = 0; slot < Types.size(); ++slot)
+	{
+		if (Types[slot] == inType)
+		{
+			return static_cast<int32_t>(slot);
+		}
+	}
+
+	return -1;
+}
+
+void Archetype::PushRow(const EntityHandle inEntity, uint32_t& outChunk, uint32_t& outRow)
+{
+	if (Chunks.empty() || Chunks.back().Count == ChunkCapacity)
+	{
+		ArchetypeChunk newChunk;
+		newChunk.Data = static_cast<uint8_t*>(::operator new(ChunkByteSize, std::align_val_t(ChunkAlignment)));
+		Chunks.push_back(newChunk);
+	}
+
+	ArchetypeChunk& chunk = Chunks.back();
+	outChunk = static_cast<uint32_t>(Chunks.size()) - 1;
+	outRow = chunk.Count++;
+
+	chunk.GetEntities()[outRow] = inEntity;
+	++NumEntities;
+}
+
+EntityHandle Archetype::RemoveRow(const uint32_t inChunk, const uint32_t inRow, const bool inDestroyComponents)
+{
+	if (inDestroyComponents)
+	{
+		for (uint32_t slot = 0; slot < Types.size(); ++slot)
+		{
+			Infos[slot].Destroy(GetComponent(inChunk, inRow, slot));
+		}
+	}
+
+	const uint32_t lastChunkIdx = static_cast<uint32_t>(Chunks.size()) - 1;
+	ArchetypeChunk& lastChunk = Chunks[lastChunkIdx];
+	const uint32_t lastRow = lastChunk.Count - 1;
+
+	EntityHandle movedEntity;
+	if (inChunk != lastChunkIdx || inRow != lastRow)
+	{
+		for (uint32_t slot = 0; slot < Types.size(); ++slot)
+		{
+			Infos[slot].Relocate(GetComponent(inChunk, inRow, slot), GetComponent(lastChunkIdx, lastRow, slot));
+		}
+
+		movedEntity = lastChunk.GetEntities()[lastRow];
+		Chunks[inChunk].GetEntities()[inRow] = movedEntity;
+	}
+
+	--lastChunk.Count;
+	--NumEntities;
+
+	if (lastChunk.Count == 0)
+	{
+		::operator delete(lastChunk.Data, std::align_val_t(ChunkAlignment));
+		Chunks.pop_back();
+	}
+
+	return movedEntity;
+}
+
+EntityRegistry& EntityRegistry::Get()
+{
+	static EntityRegistry Instance;
+	return Instance;
+}
+
+Archetype& EntityRegistry::GetOrCreateArchetype(const ComponentMask inMask)
+{
+	for (const eastl::unique_ptr<Archetype>& arch : Archetypes)
+	{
+		if (arch->GetMask() == inMask)
+		{
+			return *arch;
+		}
+	}
+
+	Archetypes.push_back(eastl::make_unique<Archetype>(inMask));
+	return *Archetypes.back();
+}
+
+EntityHandle EntityRegistry::AllocateHandle()
+{
+	EntityHandle handle;
+	if (!FreeIndices.empty())
+	{
+		handle.Index = FreeIndices.back();
+		FreeIndices.pop_back();
+	}
+	else
+	{
+		handle.Index = static_cast<uint32_t>(Records.size());
+		Records.push_back(EntityRecord());
+	}
+
+	handle.Generation = Records[handle.Index].Generation;
+	++NumEntities;
+
+	return handle;
+}
+
+bool EntityRegistry::IsAlive(const EntityHandle inEntity) const
+{
+	return inEntity.Index < Records.size() && Records[inEntity.Index].Arch && Records[inEntity.Index].Generation == inEntity.Generation;
+}
+
+void EntityRegistry::DestroyEntity(const EntityHandle inEntity)
+{
+	if (!IsAlive(inEntity))
+	{
+		return;
+	}
+
+	RemoveFromArchetype(inEntity, true);
+
+	EntityRecord& record = Records[inEntity.Index];
+	record.Arch = nullptr;
+	++record.Generation;
+
+	FreeIndices.push_back(inEntity.Index);
+	--NumEntities;
+}
+
+void EntityRegistry::RemoveFromArchetype(const EntityHandle inEntity, const bool inDestroyComponents)
+{
+	const EntityRecord& record = Records[inEntity.Index];
+	const EntityHandle movedEntity = record.Arch->RemoveRow(record.Chunk, record.Row, inDestroyComponents);
+
+	if (movedEntity.IsValid())
+	{
+		Records[movedEntity.Index].Chunk = record.Chunk;
+		Records[movedEntity.Index].Row = record.Row;
+	}
+}
+
+void EntityRegistry::MoveEntity(const EntityHandle inEntity, const ComponentMask inNewMask)
+{
+	EntityRecord& record = Records[inEntity.Index];
+	Archetype& source = *record.Arch;
+	Archetype& dest = GetOrCreateArchetype(inNewMask);
+
+	uint32_t destChunk = 0;
+	uint32_t destRow = 0;
+	dest.PushRow(inEntity, destChunk, destRow);
+
+	for (uint32_t slot = 0; slot < source.GetNumTypes(); ++slot)
+	{
+		void* component = source.GetComponent(record.Chunk, record.Row, slot);
+
+		const int32_t destSlot = dest.GetTypeSlot(source.GetType(slot));
+		if (destSlot >= 0)
+		{
+			source.GetTypeInfo(slot).Relocate(dest.GetComponent(destChunk, destRow, destSlot), component);
+		}
+		else
+		{
+			source.GetTypeInfo(slot).Destroy(component);
+		}
+	}
+
+	// Components were all moved out or destroyed, only the row is released
+	RemoveFromArchetype(inEntity, false);
+
+	record.Arch = &dest;
+	record.Chunk = destChunk;
+	record.Row = destRow;
+}
+
+void* EntityRegistry::GetComponentRaw(const EntityHandle inEntity, const ComponentTypeId inType) const
+{
+	if (!IsAlive(inEntity))
+	{
+		return nullptr;
+	}
+
+	const EntityRecord& record = Records[inEntity.Index];
+	const int32_t slot = record.Arch->GetTypeSlot(inType);
+
+	return slot >= 0 ? record.Arch->GetComponent(record.Chunk, record.Row, slot) : nullptr;
+}
+
+// Components of the checks, the tracked one counts its live instances to catch components moved between archetypes
+// without being destroyed, or destroyed twice
+struct CheckValueA
+{
+	uint32_t Value = 0;
+};
+
+struct CheckValueB
+{
+	uint64_t Value = 0;
+};
+
+static int32_t NumTrackedAlive = 0;
+
+struct CheckTracked
+{
+	CheckTracked(const uint32_t inValue) : Value{ inValue } { ++NumTrackedAlive; }
+	CheckTracked(CheckTracked&& inOther) : Value{ inOther.Value } { ++NumTrackedAlive; }
+	CheckTracked& operator=(CheckTracked&& inOther) = default;
+	~CheckTracked() { --NumTrackedAlive; }
+
+	uint32_t Value = 0;
+};
+
+// What the registry should hold for each entity created by the checks
+struct MirrorEntity
+{
+	EntityHandle Handle;
+	bool bAlive = false;
+
+	// Zero when the entity doesn't have the component, values are never zero otherwise
+	uint32_t ValueA = 0;
+	uint64_t ValueB = 0;
+	uint32_t Tracked = 0;
+};
+
+static bool MatchesMirror(const EntityRegistry& inRegistry, const MirrorEntity& inMirror)
+{
+	if (inRegistry.IsAlive(inMirror.Handle) != inMirror.bAlive)
+	{
+		return false;
+	}
+
+	if (!inMirror.bAlive)
+	{
+		return !inRegistry.GetComponent<CheckValueA>(inMirror.Handle) && !inRegistry.HasComponent<CheckValueA>(inMirror.Handle);
+	}
+
+	const CheckValueA* valueA = inRegistry.GetComponent<CheckValueA>(inMirror.Handle);
+	const CheckValueB* valueB = inRegistry.GetComponent<CheckValueB>(inMirror.Handle);
+	const CheckTracked* tracked = inRegistry.GetComponent<CheckTracked>(inMirror.Handle);
+
+	return (valueA ? valueA->Value : 0) == inMirror.ValueA && (valueB ? valueB->Value : 0) == inMirror.ValueB
+		&& (tracked ? tracked->Value : 0) == inMirror.Tracked && inRegistry.HasComponent<CheckValueB>(inMirror.Handle) == (inMirror.ValueB != 0);
+}
+
+void EntityRegistry::RunChecks()
+{
+	constexpr uint32_t numOperations = 20000;
+
+	TestUtils::TestRandom random;
+
+	{
+		EntityRegistry registry;
+		eastl::vector<MirrorEntity> mirror;
+		eastl::vector<uint32_t> aliveIndices;
+		uint32_t nextValue = 1;
+
+		const auto pickAlive = [&]() -> MirrorEntity&
+		{
+			return mirror[aliveIndices[static_cast<uint32_t>(random.Next() * aliveIndices.size())]];
+		};
+
+		for (uint32_t op = 0; op < numOperations; ++op)
+		{
+			const float choice = random.Next();
+			const uint32_t component = static_cast<uint32_t>(random.Next() * 3.f);
+			const uint32_t value = nextValue++;
+
+			if (choice < 0.35f || aliveIndices.empty())
+			{
+				// A few archetypes to start from, the component changes spread entities over the others
+				MirrorEntity entity;
+				entity.bAlive = true;
+				switch (component)
+				{
+				case 0:
+					entity.Handle = registry.CreateEntity(CheckValueA{ value });
+					entity.ValueA = value;
+					break;
+				case 1:
+					entity.Handle = registry.CreateEntity(CheckValueA{ value }, CheckValueB{ value });
+					entity.ValueA = value;
+					entity.ValueB = value;
+					break;
+				default:
+					entity.Handle = registry.CreateEntity(CheckValueB{ value }, CheckTracked(value));
+					entity.ValueB = value;
+					entity.Tracked = value;
+					break;
+				}
+
+				aliveIndices.push_back(static_cast<uint32_t>(mirror.size()));
+				mirror.push_back(entity);
+			}
+			else if (choice < 0.55f)
+			{
+				MirrorEntity& entity = pickAlive();
+				registry.DestroyEntity(entity.Handle);
+				entity = { entity.Handle, false };
+
+				aliveIndices.erase(eastl::find(aliveIndices.begin(), aliveIndices.end(), static_cast<uint32_t>(&entity - mirror.data())));
+			}
+			else if (choice < 0.8f)
+			{
+				// Replaces the value if the entity already has the component
+				MirrorEntity& entity = pickAlive();
+				switch (component)
+				{
+				case 0: registry.AddComponent(entity.Handle, CheckValueA{ value }); entity.ValueA = value; break;
+				case 1: registry.AddComponent(entity.Handle, CheckValueB{ value }); entity.ValueB = value; break;
+				default: registry.AddComponent(entity.Handle, CheckTracked(value)); entity.Tracked = value; break;
+				}
+			}
+			else
+			{
+				// Can leave an entity without any component, which is still alive
+				MirrorEntity& entity = pickAlive();
+				switch (component)
+				{
+				case 0: registry.RemoveComponent<CheckValueA>(entity.Handle); entity.ValueA = 0; break;
+				case 1: registry.RemoveComponent<CheckValueB>(entity.Handle); entity.ValueB = 0; break;
+				default: registry.RemoveComponent<CheckTracked>(entity.Handle); entity.Tracked = 0; break;
+				}
+			}
+		}
+
+		{
+			TestUtils::CheckScope check("Entity registry components against a mirror");
+			check.Expect(registry.GetNumEntities() == aliveIndices.size());
+
+			// Destroyed handles stay dead once their index is reused by a new entity
+			for (const MirrorEntity& entity : mirror)
+			{
+				check.Expect(MatchesMirror(registry, entity));
+			}
+		}
+
+		{
+			TestUtils::CheckScope check("Entity registry queries visit each matching entity once");
+
+			uint32_t numA = 0;
+			uint64_t sumA = 0;
+			uint32_t numAB = 0;
+			uint64_t sumAB = 0;
+			for (const uint32_t index : aliveIndices)
+			{
+				const MirrorEntity& entity = mirror[index];
+				numA += entity.ValueA != 0 ? 1 : 0;
+				sumA += entity.ValueA;
+				numAB += entity.ValueA != 0 && entity.ValueB != 0 ? 1 : 0;
+				sumAB += entity.ValueA != 0 && entity.ValueB != 0 ? entity.ValueB : 0;
+			}
+
+			uint32_t numVisited = 0;
+			uint64_t sumVisited = 0;
+			registry.ForEach<const CheckValueA>([&](const CheckValueA& inValue)
+			{
+				++numVisited;
+				sumVisited += inValue.Value;
+			});
+			check.Expect(numVisited == numA && sumVisited == sumA);
+
+			// Chunk handles lead back to the components of the same row
+			numVisited = 0;
+			sumVisited = 0;
+			bool bHandlesMatch = true;
+			registry.ForEachChunk<const CheckValueA, const CheckValueB>([&](const uint32_t inCount, const EntityHandle* inEntities, const CheckValueA* inValuesA,
+				const CheckValueB* inValuesB)
+			{
+				for (uint32_t i = 0; i < inCount; ++i)
+				{
+					bHandlesMatch &= registry.GetComponent<CheckValueB>(inEntities[i]) == &inValuesB[i];
+					bHandlesMatch &= registry.GetComponent<CheckValueA>(inEntities[i]) == &inValuesA[i];
+					sumVisited += inValuesB[i].Value;
+				}
+
+				numVisited += inCount;
+			});
+			check.Expect(bHandlesMatch);
+			check.Expect(numVisited == numAB && sumVisited == sumAB);
+
+			std::atomic<uint32_t> numParallelVisited = 0;
+			std::atomic<uint64_t> sumParallelVisited = 0;
+			registry.ParallelForEachChunk<const CheckValueA, const CheckValueB>([&](const uint32_t inCount, const EntityHandle* inEntities, const CheckValueA* inValuesA,
+				const CheckValueB* inValuesB)
+			{
+				uint64_t sum = 0;
+				for (uint32_t i = 0; i < inCount; ++i)
+				{
+					sum += inValuesB[i].Value;
+				}
+
+				numParallelVisited += inCount;
+				sumParallelVisited += sum;
+			});
+			check.Expect(numParallelVisited == numAB && sumParallelVisited == sumAB);
+		}
+
+		for (uint32_t i = 0; i < aliveIndices.size(); i += 2)
+		{
+			registry.DestroyEntity(mirror[aliveIndices[i]].Handle);
+		}
+	}
+
+	{
+		TestUtils::CheckScope check("Entity registry destroys every component");
+		check.Expect(NumTrackedAlive == 0);
+	}
+}
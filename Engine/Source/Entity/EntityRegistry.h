@@ -0,0 +1,365 @@
+#pragma once
+#include <stdint.h>
+#include <bit>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include "EASTL/vector.h"
+#include "EASTL/unique_ptr.h"
+#include "EASTL/utility.h"
+#include "Core/EngineUtils.h"
+#include "Core/TaskSystem.h"
+
+using ComponentTypeId = uint32_t;
+
+// One bit per component type, a query or archetype is described by the set of its components
+using ComponentMask = uint64_t;
+
+static constexpr uint32_t MaxComponentTypes = 64;
+static constexpr ComponentMask AllComponents = ~ComponentMask(0);
+
+struct ComponentTypeInfo
+{
+	uint32_t Size = 0;
+	uint32_t Alignment = 0;
+
+	// Moves the source into uninitialized memory and destroys the source
+	void(*Relocate)(void* inDest, void* inSource) = nullptr;
+	void(*Destroy)(void* inComponent) = nullptr;
+};
+
+/**
+ * Registry of the component types, ids are handed out the first time a type is used.
+ * Any default constructible and movable struct can be a component.
+ */
+class ComponentTypes
+{
+public:
+	template<typename T>
+	static ComponentTypeId GetId();
+
+	static const ComponentTypeInfo& GetInfo(const ComponentTypeId inId);
+
+private:
+	static ComponentTypeId Register(const ComponentTypeInfo& inInfo);
+};
+
+template<typename T>
+ComponentTypeId ComponentTypes::GetId()
+{
+	if constexpr (std::is_const_v<T>)
+	{
+		// Same id for the const qualified type used by read only queries
+		return GetId<std::remove_const_t<T>>();
+	}
+	else
+	{
+		static const ComponentTypeId Id = Register({ static_cast<uint32_t>(sizeof(T)), static_cast<uint32_t>(alignof(T)),
+			[](void* inDest, void* inSource)
+			{
+				new (inDest) T(std::move(*static_cast<T*>(inSource)));
+				static_cast<T*>(inSource)->~T();
+			},
+			[](void* inComponent)
+			{
+				static_cast<T*>(inComponent)->~T();
+			} });
+
+		return Id;
+	}
+}
+
+template<typename... Ts>
+ComponentMask MakeComponentMask()
+{
+	return ((ComponentMask(1) << ComponentTypes::GetId<Ts>()) | ... | ComponentMask(0));
+}
+
+// Access sets of a query, const components are read and the others written
+template<typename... Ts>
+ComponentMask MakeReadMask()
+{
+	return ((std::is_const_v<Ts> ? (ComponentMask(1) << ComponentTypes::GetId<Ts>()) : ComponentMask(0)) | ... | ComponentMask(0));
+}
+
+template<typename... Ts>
+ComponentMask MakeWriteMask()
+{
+	return ((!std::is_const_v<Ts> ? (ComponentMask(1) << ComponentTypes::GetId<Ts>()) : ComponentMask(0)) | ... | ComponentMask(0));
+}
+
+struct EntityHandle
+{
+	uint32_t Index = ~0u;
+	uint32_t Generation = 0;
+
+	inline bool IsValid() const { return Index != ~0u; }
+	inline bool operator==(const EntityHandle& inOther) const { return Index == inOther.Index && Generation == inOther.Generation; }
+};
+
+struct ArchetypeChunk
+{
+	// Handles first, then one array per component at the archetype's offsets
+	uint8_t* Data = nullptr;
+	uint32_t Count = 0;
+
+	inline EntityHandle* GetEntities() const { return reinterpret_cast<EntityHandle*>(Data); }
+};
+
+/**
+ * All entities having exactly the same set of components.
+ * They are packed in fixed size chunks, each holding a contiguous array per component, and removals move the last
+ * entity in the hole so every chunk but the last one stays full.
+ */
+class Archetype
+{
+public:
+	Archetype(const ComponentMask inMask);
+	~Archetype();
+
+	Archetype(const Archetype&) = delete;
+	Archetype& operator=(const Archetype&) = delete;
+
+	// Index of the type in this archetype's arrays, -1 if it does not have it
+	int32_t GetTypeSlot(const ComponentTypeId inType) const;
+
+	inline void* GetComponentArray(const uint32_t inChunk, const uint32_t inSlot) const { return Chunks[inChunk].Data + Offsets[inSlot]; }
+	inline void* GetComponent(const uint32_t inChunk, const uint32_t inRow, const uint32_t inSlot) const { return Chunks[inChunk].Data + Offsets[inSlot] + inRow * Infos[inSlot].Size; }
+
+	// Reserves a row at the end, components are left uninitialized
+	void PushRow(const EntityHandle inEntity, uint32_t& outChunk, uint32_t& outRow);
+
+	// Moves the last row in the given one and returns the handle of the moved entity, invalid if the row was the last
+	EntityHandle RemoveRow(const uint32_t inChunk, const uint32_t inRow, const bool inDestroyComponents);
+
+	inline ComponentMask GetMask() const { return Mask; }
+	inline uint32_t GetNumChunks() const { return static_cast<uint32_t>(Chunks.size()); }
+	inline const ArchetypeChunk& GetChunk(const uint32_t inChunk) const { return Chunks[inChunk]; }
+	inline uint32_t GetNumTypes() const { return static_cast<uint32_t>(Types.size()); }
+	inline ComponentTypeId GetType(const uint32_t inSlot) const { return Types[inSlot]; }
+	inline const ComponentTypeInfo& GetTypeInfo(const uint32_t inSlot) const { return Infos[inSlot]; }
+	inline uint32_t GetNumEntities() const { return NumEntities; }
+
+private:
+	ComponentMask Mask = 0;
+	eastl::vector<ComponentTypeId> Types;
+	eastl::vector<ComponentTypeInfo> Infos;
+	eastl::vector<uint32_t> Offsets;
+
+	uint32_t ChunkCapacity = 0;
+	uint32_t ChunkByteSize = 0;
+	uint32_t NumEntities = 0;
+	eastl::vector<ArchetypeChunk> Chunks;
+};
+
+/**
+ * Archetype based storage for entities made only of data, updated by systems iterating over the matching chunks linearly.
+ * Structural changes(create, destroy, add or remove component) move data between archetypes and must not happen while
+ * a query or the systems are running.
+ */
+class EntityRegistry
+{
+public:
+	// The engine uses the one from Get, separate registries are for the checks and benchmarks
+	EntityRegistry() = default;
+	~EntityRegistry() = default;
+
+	EntityRegistry(const EntityRegistry&) = delete;
+	EntityRegistry& operator=(const EntityRegistry&) = delete;
+
+	static EntityRegistry& Get();
+
+	template<typename... Ts>
+	EntityHandle CreateEntity(Ts&&... inComponents);
+
+	void DestroyEntity(const EntityHandle inEntity);
+	bool IsAlive(const EntityHandle inEntity) const;
+
+	template<typename T>
+	T* GetComponent(const EntityHandle inEntity) const;
+
+	template<typename T>
+	bool HasComponent(const EntityHandle inEntity) const;
+
+	template<typename T>
+	T& AddComponent(const EntityHandle inEntity, T&& inComponent);
+
+	template<typename T>
+	void RemoveComponent(const EntityHandle inEntity);
+
+	// Func signature: void(const uint32_t inCount, const EntityHandle* inEntities, Ts*... inComponentArrays)
+	template<typename... Ts, typename Func>
+	void ForEachChunk(Func&& inFunc) const;
+
+	// Same as ForEachChunk with the chunks spread over the task system workers
+	template<typename... Ts, typename Func>
+	void ParallelForEachChunk(Func&& inFunc) const;
+
+	// Func signature: void(Ts&... inComponents)
+	template<typename... Ts, typename Func>
+	void ForEach(Func&& inFunc) const;
+
+	inline uint32_t GetNumEntities() const { return NumEntities; }
+	inline uint32_t GetNumArchetypes() const { return static_cast<uint32_t>(Archetypes.size()); }
+
+	// Asserts random creations, destructions and component changes keep every entity's components, for a mirror of them
+	// kept next to the registry, and that queries visit each matching entity once
+	static void RunChecks();
+
+private:
+	struct EntityRecord
+	{
+		Archetype* Arch = nullptr;
+		uint32_t Chunk = 0;
+		uint32_t Row = 0;
+		uint32_t Generation = 0;
+	};
+
+	Archetype& GetOrCreateArchetype(const ComponentMask inMask);
+	EntityHandle AllocateHandle();
+	void RemoveFromArchetype(const EntityHandle inEntity, const bool inDestroyComponents);
+
+	// Moves the entity to the archetype of the new mask, components missing from it are destroyed and new ones left uninitialized
+	void MoveEntity(const EntityHandle inEntity, const ComponentMask inNewMask);
+
+	void* GetComponentRaw(const EntityHandle inEntity, const ComponentTypeId inType) const;
+
+	template<typename... Ts>
+	void GatherChunks(eastl::vector<eastl::pair<const Archetype*, uint32_t>>& outChunks) const;
+
+private:
+	eastl::vector<eastl::unique_ptr<Archetype>> Archetypes;
+	eastl::vector<EntityRecord> Records;
+	eastl::vector<uint32_t> FreeIndices;
+	uint32_t NumEntities = 0;
+};
+
+template<typename... Ts>
+EntityHandle EntityRegistry::CreateEntity(Ts&&... inComponents)
+{
+	const ComponentMask mask = MakeComponentMask<std::decay_t<Ts>...>();
+	// Each component type only once per entity
+	ASSERT(std::popcount(mask) == sizeof...(Ts));
+
+	Archetype& arch = GetOrCreateArchetype(mask);
+	const EntityHandle entity = AllocateHandle();
+
+	EntityRecord& record = Records[entity.Index];
+	record.Arch = &arch;
+	arch.PushRow(entity, record.Chunk, record.Row);
+
+	((new (arch.GetComponent(record.Chunk, record.Row, arch.GetTypeSlot(ComponentTypes::GetId<std::decay_t<Ts>>()))) std::decay_t<Ts>(std::forward<Ts>(inComponents))), ...);
+
+	return entity;
+}
+
+template<typename T>
+T* EntityRegistry::GetComponent(const EntityHandle inEntity) const
+{
+	return static_cast<T*>(GetComponentRaw(inEntity, ComponentTypes::GetId<T>()));
+}
+
+template<typename T>
+bool EntityRegistry::HasComponent(const EntityHandle inEntity) const
+{
+	return IsAlive(inEntity) && (Records[inEntity.Index].Arch->GetMask() & MakeComponentMask<T>()) != 0;
+}
+
+template<typename T>
+T& EntityRegistry::AddComponent(const EntityHandle inEntity, T&& inComponent)
+{
+	using Type = std::decay_t<T>;
+	ASSERT(IsAlive(inEntity));
+
+	const ComponentTypeId type = ComponentTypes::GetId<Type>();
+	const EntityRecord& record = Records[inEntity.Index];
+
+	if (Type* existing = GetComponent<Type>(inEntity))
+	{
+		*existing = std::forward<T>(inComponent);
+		return *existing;
+	}
+
+	MoveEntity(inEntity, record.Arch->GetMask() | MakeComponentMask<Type>());
+
+	void* component = record.Arch->GetComponent(record.Chunk, record.Row, record.Arch->GetTypeSlot(type));
+	return *(new (component) Type(std::forward<T>(inComponent)));
+}
+
+template<typename T>
+void EntityRegistry::RemoveComponent(const EntityHandle inEntity)
+{
+	if (HasComponent<T>(inEntity))
+	{
+		MoveEntity(inEntity, Records[inEntity.Index].Arch->GetMask() & ~MakeComponentMask<T>());
+	}
+}
+
+template<typename... Ts, typename Func>
+void EntityRegistry::ForEachChunk(Func&& inFunc) const
+{
+	const ComponentMask queryMask = MakeComponentMask<Ts...>();
+
+	for (const eastl::unique_ptr<Archetype>& arch : Archetypes)
+	{
+		if ((arch->GetMask() & queryMask) != queryMask)
+		{
+			continue;
+		}
+
+		for (uint32_t chunkIdx = 0; chunkIdx < arch->GetNumChunks(); ++chunkIdx)
+		{
+			const ArchetypeChunk& chunk = arch->GetChunk(chunkIdx);
+
+			inFunc(chunk.Count, chunk.GetEntities(), static_cast<Ts*>(arch->GetComponentArray(chunkIdx, arch->GetTypeSlot(ComponentTypes::GetId<Ts>())))...);
+		}
+	}
+}
+
+template<typename... Ts>
+void EntityRegistry::GatherChunks(eastl::vector<eastl::pair<const Archetype*, uint32_t>>& outChunks) const
+{
+	const ComponentMask queryMask = MakeComponentMask<Ts...>();
+
+	for (const eastl::unique_ptr<Archetype>& arch : Archetypes)
+	{
+		if ((arch->GetMask() & queryMask) == queryMask)
+		{
+			for (uint32_t chunkIdx = 0; chunkIdx < arch->GetNumChunks(); ++chunkIdx)
+			{
+				outChunks.push_back(eastl::make_pair(arch.get(), chunkIdx));
+			}
+		}
+	}
+}
+
+template<typename... Ts, typename Func>
+void EntityRegistry::ParallelForEachChunk(Func&& inFunc) const
+{
+	eastl::vector<eastl::pair<const Archetype*, uint32_t>> chunks;
+	GatherChunks<Ts...>(chunks);
+
+	TaskSystem::Get().ParallelFor(static_cast<uint32_t>(chunks.size()), 1, [&](const uint32_t inBegin, const uint32_t inEnd, const uint32_t inWorkerIdx)
+	{
+		for (uint32_t i = inBegin; i < inEnd; ++i)
+		{
+			const Archetype* arch = chunks[i].first;
+			const uint32_t chunkIdx = chunks[i].second;
+			const ArchetypeChunk& chunk = arch->GetChunk(chunkIdx);
+
+			inFunc(chunk.Count, chunk.GetEntities(), static_cast<Ts*>(arch->GetComponentArray(chunkIdx, arch->GetTypeSlot(ComponentTypes::GetId<Ts>())))...);
+		}
+	});
+}
+
+template<typename... Ts, typename Func>
+void EntityRegistry::ForEach(Func&& inFunc) const
+{
+	ForEachChunk<Ts...>([&inFunc](const uint32_t inCount, const EntityHandle* inEntities, Ts*... inComponentArrays)
+	{
+		for (uint32_t i = 0; i < inCount; ++i)
+		{
+			inFunc(inComponentArrays[i]...);
+		}
+	});
+}
@@ -0,0 +1,276 @@
+#include "Entity/SystemScheduler.h"
+#include "glm/glm.hpp"
+#include "Utils/PerfUtils.h"
+#include "Utils/TestUtils.h"
+
+void SystemScheduler::AddSystem(const eastl::string& inName, const ComponentMask inReads, const ComponentMask inWrites, SystemDelegate inSystem)
+{
+	SystemEntry entry;
+	entry.Name = inName;
+	entry.Reads = inReads;
+	entry.Writes = inWrites;
+	entry.System = inSystem;
+
+	Systems.push_back(entry);
+	bStagesDirty = true;
+}
+
+static bool SystemsConflict(const ComponentMask inReadsA, const ComponentMask inWritesA, const ComponentMask inReadsB, const ComponentMask inWritesB)
+{
+	return (inWritesA & (inReadsB | inWritesB)) != 0 || (inWritesB & inReadsA) != 0;
+}
+
+void SystemScheduler::BuildStages()
+{
+	Stages.clear();
+
+	// A system joins the last stage only if it is independent of everything in it, so the declared order is kept
+	// between systems that depend on each other
+	ComponentMask stageReads = 0;
+	ComponentMask stageWrites = 0;
+
+	for (uint32_t i = 0; i < Systems.size(); ++i)
+	{
+		const SystemEntry& entry = Systems[i];
+
+		if (Stages.empty() || SystemsConflict(entry.Reads, entry.Writes, stageReads, stageWrites))
+		{
+			Stages.emplace_back();
+			stageReads = 0;
+			stageWrites = 0;
+		}
+
+		Stages.back().push_back(i);
+		stageReads |= entry.Reads;
+		stageWrites |= entry.Writes;
+	}
+
+	bStagesDirty = false;
+}
+
+void SystemScheduler::Run(EntityRegistry& inRegistry, const float inDeltaT)
+{
+	if (bStagesDirty)
+	{
+		BuildStages();
+	}
+
+	for (const eastl::vector<uint32_t>& stage : Stages)
+	{
+		if (stage.size() == 1)
+		{
+			// Alone in its stage, the system can spread its own work over the workers
+			Systems[stage[0]].System.Execute(inRegistry, inDeltaT);
+			continue;
+		}
+
+		TaskSystem::Get().ParallelFor(static_cast<uint32_t>(stage.size()), 1, [&](const uint32_t inBegin, const uint32_t inEnd, const uint32_t inWorkerIdx)
+		{
+			for (uint32_t i = inBegin; i < inEnd; ++i)
+			{
+				Systems[stage[i]].System.Execute(inRegistry, inDeltaT);
+			}
+		});
+	}
+}
+
+struct BenchPosition
+{
+	glm::vec3 Value = glm::vec3(0.f);
+};
+
+struct BenchVelocity
+{
+	glm::vec3 Value = glm::vec3(0.f);
+};
+
+struct BenchLifetime
+{
+	float Value = 0.f;
+};
+
+static void MoveSystem(EntityRegistry& inRegistry, const float inDeltaT)
+{
+	inRegistry.ParallelForEachChunk<const BenchVelocity, BenchPosition>([inDeltaT](const uint32_t inCount, const EntityHandle* inEntities,
+		const BenchVelocity* inVelocities, BenchPosition* outPositions)
+	{
+		for (uint32_t i = 0; i < inCount; ++i)
+		{
+			outPositions[i].Value += inVelocities[i].Value * inDeltaT;
+		}
+	});
+}
+
+static void AgeSystem(EntityRegistry& inRegistry, const float inDeltaT)
+{
+	inRegistry.ParallelForEachChunk<BenchLifetime>([inDeltaT](const uint32_t inCount, const EntityHandle* inEntities, BenchLifetime* outLifetimes)
+	{
+		for (uint32_t i = 0; i < inCount; ++i)
+		{
+			outLifetimes[i].Value += inDeltaT;
+		}
+	});
+}
+
+// Reads the velocities the move system reads, so it goes in the next stage
+static void GravitySystem(EntityRegistry& inRegistry, const float inDeltaT)
+{
+	inRegistry.ParallelForEachChunk<BenchVelocity>([inDeltaT](const uint32_t inCount, const EntityHandle* inEntities, BenchVelocity* outVelocities)
+	{
+		for (uint32_t i = 0; i < inCount; ++i)
+		{
+			outVelocities[i].Value.y -= 9.8f * inDeltaT;
+		}
+	});
+}
+
+static void AddBenchSystems(SystemScheduler& outScheduler)
+{
+	outScheduler.AddSystem<const BenchVelocity, BenchPosition>("Move", SystemDelegate::CreateStatic(&MoveSystem));
+	outScheduler.AddSystem<BenchLifetime>("Age", SystemDelegate::CreateStatic(&AgeSystem));
+	outScheduler.AddSystem<BenchVelocity>("Gravity", SystemDelegate::CreateStatic(&GravitySystem));
+}
+
+// Moving props, some of them with a lifetime, and static ones the movement systems skip
+static EntityHandle CreateBenchEntity(EntityRegistry& inRegistry, const uint32_t inIndex, TestUtils::TestRandom& inRandom)
+{
+	const glm::vec3 position = inRandom.NextVec3() * 100.f;
+	const glm::vec3 velocity = inRandom.NextVec3() * 2.f - 1.f;
+
+	switch (inIndex % 4)
+	{
+	case 0:
+		return inRegistry.CreateEntity(BenchPosition{ position });
+	case 1:
+		return inRegistry.CreateEntity(BenchPosition{ position }, BenchVelocity{ velocity }, BenchLifetime{ 0.f });
+	default:
+		return inRegistry.CreateEntity(BenchPosition{ position }, BenchVelocity{ velocity });
+	}
+}
+
+void SystemScheduler::Benchmark(const uint32_t inNumEntities, const uint32_t inNumFrames)
+{
+	if (inNumEntities == 0 || inNumFrames == 0)
+	{
+		return;
+	}
+
+	TestUtils::TestRandom random;
+	EntityRegistry registry;
+	SystemScheduler scheduler;
+	AddBenchSystems(scheduler);
+
+	eastl::vector<EntityHandle> entities(inNumEntities);
+
+	int64_t createUs = 0;
+	{
+		Utils::BenchmarkCode bench(&createUs);
+		for (uint32_t i = 0; i < inNumEntities; ++i)
+		{
+			entities[i] = CreateBenchEntity(registry, i, random);
+		}
+	}
+
+	int64_t runUs = 0;
+	{
+		Utils::BenchmarkCode bench(&runUs);
+		for (uint32_t frame = 0; frame < inNumFrames; ++frame)
+		{
+			scheduler.Run(registry, 1.f / 60.f);
+		}
+	}
+
+	// Every other entity, so most removals move the last entity of an archetype in the hole
+	int64_t destroyUs = 0;
+	{
+		Utils::BenchmarkCode bench(&destroyUs);
+		for (uint32_t i = 0; i < inNumEntities; i += 2)
+		{
+			registry.DestroyEntity(entities[i]);
+		}
+	}
+
+	LOG_INFO("Entity systems(%u entities, %u archetypes, %u stages): create %f ms, frame %f ms, destroy half %f ms.",
+		inNumEntities, registry.GetNumArchetypes(), scheduler.GetNumStages(), createUs * 1e-3, glm::max(double(runUs), 1.0) * 1e-3 / inNumFrames,
+		destroyUs * 1e-3);
+}
+
+static uint32_t NumExclusiveRuns = 0;
+
+static void ExclusiveSystem(EntityRegistry& inRegistry, const float inDeltaT)
+{
+	++NumExclusiveRuns;
+}
+
+void SystemScheduler::RunChecks()
+{
+	constexpr uint32_t numEntities = 5000;
+	constexpr uint32_t numFrames = 3;
+	constexpr float deltaT = 1.f / 30.f;
+
+	TestUtils::TestRandom random;
+	EntityRegistry registry;
+
+	eastl::vector<EntityHandle> entities(numEntities);
+	for (uint32_t i = 0; i < numEntities; ++i)
+	{
+		entities[i] = CreateBenchEntity(registry, i, random);
+	}
+
+	// Expected components, updated serially in the declared order of the systems
+	eastl::vector<BenchPosition> positions(numEntities);
+	eastl::vector<BenchVelocity> velocities(numEntities);
+	eastl::vector<BenchLifetime> lifetimes(numEntities);
+	for (uint32_t i = 0; i < numEntities; ++i)
+	{
+		positions[i] = *registry.GetComponent<BenchPosition>(entities[i]);
+		if (const BenchVelocity* velocity = registry.GetComponent<BenchVelocity>(entities[i]))
+		{
+			velocities[i] = *velocity;
+		}
+	}
+
+	SystemScheduler scheduler;
+	AddBenchSystems(scheduler);
+	scheduler.AddSystem("Exclusive", AllComponents, AllComponents, SystemDelegate::CreateStatic(&ExclusiveSystem));
+	NumExclusiveRuns = 0;
+
+	for (uint32_t frame = 0; frame < numFrames; ++frame)
+	{
+		scheduler.Run(registry, deltaT);
+
+		for (uint32_t i = 0; i < numEntities; ++i)
+		{
+			if (registry.HasComponent<BenchVelocity>(entities[i]))
+			{
+				positions[i].Value += velocities[i].Value * deltaT;
+				velocities[i].Value.y -= 9.8f * deltaT;
+			}
+
+			if (registry.HasComponent<BenchLifetime>(entities[i]))
+			{
+				lifetimes[i].Value += deltaT;
+			}
+		}
+	}
+
+	{
+		TestUtils::CheckScope check("System scheduler stages");
+
+		// Move and Age share a stage, Gravity waits for Move to read the velocities, Exclusive runs alone
+		check.Expect(scheduler.GetNumStages() == 3);
+		check.Expect(NumExclusiveRuns == numFrames);
+	}
+
+	{
+		TestUtils::CheckScope check("System scheduler results against serial updates");
+		for (uint32_t i = 0; i < numEntities; ++i)
+		{
+			const BenchVelocity* velocity = registry.GetComponent<BenchVelocity>(entities[i]);
+			const BenchLifetime* lifetime = registry.GetComponent<BenchLifetime>(entities[i]);
+
+			check.Expect(registry.GetComponent<BenchPosition>(entities[i])->Value == positions[i].Value
+				&& (!velocity || velocity->Value == velocities[i].Value) && (!lifetime || lifetime->Value == lifetimes[i].Value));
+		}
+	}
+}
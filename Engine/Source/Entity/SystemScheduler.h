@@ -0,0 +1,54 @@
+#pragma once
+#include "EASTL/vector.h"
+#include "EASTL/string.h"
+#include "EventSystem/EventSystem.h"
+#include "Entity/EntityRegistry.h"
+
+using SystemDelegate = Delegate<void, EntityRegistry&, const float>;
+
+/**
+ * Runs the systems updating the EntityRegistry each frame.
+ * Every system declares the components it reads and writes. Systems are grouped, in the order they were added, in stages
+ * where no system writes what another one reads or writes, and the systems of a stage run in parallel on the task system.
+ * A system touching state outside of the registry should declare AllComponents as written, which makes it run alone.
+ */
+class SystemScheduler
+{
+public:
+	void AddSystem(const eastl::string& inName, const ComponentMask inReads, const ComponentMask inWrites, SystemDelegate inSystem);
+
+	// Access sets deduced from the component list, const components are read and the others written
+	template<typename... Ts>
+	void AddSystem(const eastl::string& inName, SystemDelegate inSystem)
+	{
+		AddSystem(inName, MakeReadMask<Ts...>(), MakeWriteMask<Ts...>(), inSystem);
+	}
+
+	void Run(EntityRegistry& inRegistry, const float inDeltaT);
+
+	inline uint32_t GetNumStages() const { return static_cast<uint32_t>(Stages.size()); }
+
+	// Logs the cost of creating the entities, of a frame of movement systems over them and of destroying them
+	static void Benchmark(const uint32_t inNumEntities, const uint32_t inNumFrames);
+
+	// Asserts systems are staged by their access sets and that the ones depending on each other see the results in order
+	static void RunChecks();
+
+private:
+	void BuildStages();
+
+private:
+	struct SystemEntry
+	{
+		eastl::string Name;
+		ComponentMask Reads = 0;
+		ComponentMask Writes = 0;
+		SystemDelegate System;
+	};
+
+	eastl::vector<SystemEntry> Systems;
+
+	// Indices into Systems
+	eastl::vector<eastl::vector<uint32_t>> Stages;
+	bool bStagesDirty = false;
+};
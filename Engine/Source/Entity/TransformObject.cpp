@@ -3,53 +3,63 @@
 
 TransformObject::TransformObject(const eastl::string& inName)
 	: Name{inName}
-{}
+{
+	TransformIndex = TransformSystem::Get().Allocate(this);
+}
+
+TransformObject::~TransformObject()
+{
+	// Children still referenced elsewhere become roots
+	for (const TransformObjPtr& child : Children)
+	{
+		child->Parent = nullptr;
+	}
 
-TransformObject::~TransformObject() = default;
+	TransformSystem::Get().Free(TransformIndex);
+}
 
-void TransformObject::SetParent(TransformObjPtr& inParent)
+void TransformObject::AddChild(TransformObjPtr inTransfObj)
 {
-	Parent = inParent;
+	inTransfObj->Parent = this;
+	TransformSystem::Get().SetParent(inTransfObj->TransformIndex, TransformIndex);
 
-	inParent->Children.push_back(shared_from_this());
+	Children.push_back(eastl::move(inTransfObj));
 }
 
-const Transform TransformObject::GetRelativeTransform() const
+void TransformObject::SetParent(TransformObjPtr& inParent)
 {
-	Transform newTransform;
-	newTransform.Translation = Location;
-	newTransform.Rotation = glm::radians(Rotation);
-	newTransform.Scale = Scale;
+	inParent->AddChild(shared_from_this());
+}
 
-	return newTransform;
+const Transform TransformObject::GetRelativeTransform() const
+{
+	return TransformSystem::Get().GetLocalTransform(TransformIndex);
 }
 
-const Transform& TransformObject::GetAbsoluteTransform() const
+Transform TransformObject::GetAbsoluteTransform() const
 {
-	if (TransfDirty)
-	{
-		CalculateAbsTransform();
-	}
+	return TransformSystem::Get().GetWorldTransform(TransformIndex);
+}
 
-	return AbsoluteTranfs;
+glm::mat4 TransformObject::GetAbsoluteMatrix() const
+{
+	return TransformSystem::Get().GetWorldMatrix(TransformIndex);
 }
 
-void TransformObject::CalculateAbsTransform() const
+Transform TransformObject::CalculateAbsTransform() const
 {
 	Transform result = GetRelativeTransform();
-	if (const TransformObjPtr parentShared = Parent.lock())
+	if (Parent)
 	{
-		result = result * parentShared->GetAbsoluteTransform();
+		result = result * Parent->CalculateAbsTransform();
 	}
 
-	AbsoluteTranfs = result;
-
-	CleanTranfsDirty();
+	return result;
 }
 
 void TransformObject::Move(const glm::vec3 inMoveVector)
 {
-	Location += inMoveVector;
+	TransformSystem::Get().LocalLocations[TransformIndex] += inMoveVector;
 
 	MakeTransfDirty();
 }
@@ -58,45 +68,64 @@ void TransformObject::Rotate(const float inAmount, const glm::vec3 inAxis)
 {
 	const float radians = glm::radians(inAmount);
 	const glm::quat additiveRotation = glm::angleAxis(radians, inAxis);
-	const glm::quat currentRotation(glm::radians(Rotation));
 
-	const glm::quat newRotation = currentRotation * additiveRotation;
-	const glm::vec3 newRotationEulerRadians = glm::eulerAngles(newRotation);
-
-	SetRotationRadians(newRotationEulerRadians);
+	// Renormalized so rounding does not build up over many small rotations
+	SetRotation(glm::normalize(GetRelRotation() * additiveRotation));
+}
 
-	glm::mat4 mat = GetAbsoluteTransform().GetMatrix();
+void TransformObject::SetRotation(const glm::quat& inNewRotation)
+{
+	TransformSystem& transforms = TransformSystem::Get();
+	transforms.LocalRotations[TransformIndex] = inNewRotation;
+	transforms.EditorEulerValid[TransformIndex] = 0;
+	MakeTransfDirty();
 }
 
 void TransformObject::SetRotationDegrees(const glm::vec3 inNewRotation)
 {
-	Rotation = inNewRotation;
+	TransformSystem& transforms = TransformSystem::Get();
+	transforms.LocalRotations[TransformIndex] = glm::quat(glm::radians(inNewRotation));
+	transforms.EditorEulerDegrees[TransformIndex] = inNewRotation;
+	transforms.EditorEulerValid[TransformIndex] = 1;
 	MakeTransfDirty();
 }
 
 void TransformObject::SetRotationRadians(const glm::vec3 inNewRotation)
 {
-	Rotation = glm::degrees(inNewRotation);
-	MakeTransfDirty();
+	SetRotationDegrees(glm::degrees(inNewRotation));
+}
+
+glm::vec3 TransformObject::GetRelRotationDegrees() const
+{
+	TransformSystem& transforms = TransformSystem::Get();
+	if (!transforms.EditorEulerValid[TransformIndex])
+	{
+		transforms.EditorEulerDegrees[TransformIndex] = glm::degrees(glm::eulerAngles(transforms.LocalRotations[TransformIndex]));
+		transforms.EditorEulerValid[TransformIndex] = 1;
+	}
+
+	return transforms.EditorEulerDegrees[TransformIndex];
 }
 
 void TransformObject::SetRelTransform(const Transform& inNewTransf)
 {
-	Location = inNewTransf.Translation;
-	Rotation =  glm::degrees(glm::eulerAngles(inNewTransf.Rotation));
-	Scale = inNewTransf.Scale;
+	TransformSystem& transforms = TransformSystem::Get();
+	transforms.LocalLocations[TransformIndex] = inNewTransf.Translation;
+	transforms.LocalRotations[TransformIndex] = inNewTransf.Rotation;
+	transforms.LocalScales[TransformIndex] = inNewTransf.Scale;
+	transforms.EditorEulerValid[TransformIndex] = 0;
 	MakeTransfDirty();
 }
 
 void TransformObject::SetRelativeLocation(const glm::vec3 inRelLoc)
 {
-	Location = inRelLoc;
+	TransformSystem::Get().LocalLocations[TransformIndex] = inRelLoc;
 	MakeTransfDirty();
 }
 
 void TransformObject::SetScale(const glm::vec3 inScale)
 {
-	Scale = inScale;
+	TransformSystem::Get().LocalScales[TransformIndex] = inScale;
 	MakeTransfDirty();
 }
 
@@ -108,24 +137,7 @@ void TransformObject::LookAt(const glm::vec3 inTarget)
 	const glm::vec3 x_axis = glm::normalize(glm::cross(upVec, z_axis));
 	const glm::vec3 y_axis = glm::normalize(glm::cross(z_axis, x_axis));
 
-	const glm::mat4 rotationMatrix(
-		glm::vec4(x_axis, 0),
-		glm::vec4(y_axis, 0),
-		glm::vec4(z_axis, 0),
-		glm::vec4(0, 0, 0, 1));
-
-	const glm::quat q = glm::quat_cast(rotationMatrix);
-	const glm::vec3 angles = glm::eulerAngles(q);
-
-	SetRotationRadians(angles);
-}
-
-void TransformObject::MakeTransfDirty() const
-{
-	for (const TransformObjPtr& child : Children)
-	{
-		child->MakeTransfDirty();
-	}
+	const glm::mat3 rotationMatrix(x_axis, y_axis, z_axis);
 
-	TransfDirty = true;
+	SetRotation(glm::quat_cast(rotationMatrix));
 }
@@ -1,5 +1,7 @@
 #pragma once
 #include "Math/Transform.h"
+#include "Entity/TransformSystem.h"
+#include "Utils/SlotMap.h"
 #include "EASTL/shared_ptr.h"
 #include "EASTL/vector.h"
 #include "EASTL/string.h"
@@ -15,23 +17,29 @@ public:
 	TransformObject(const eastl::string& inName);
 	virtual ~TransformObject();
 
-	inline void AddChild(TransformObjPtr inTransfObj) { 
-		TransformObjPtr thisShared = shared_from_this();
-		inTransfObj->SetParent(thisShared); }
-	inline glm::vec3 GetLocation() { return Location; }
+	void AddChild(TransformObjPtr inTransfObj);
+	inline glm::vec3 GetLocation() const { return TransformSystem::Get().LocalLocations[TransformIndex]; }
 	inline const eastl::vector<TransformObjPtr>& GetChildren() const { return Children; }
 	void SetParent(TransformObjPtr& inParent);
-	inline eastl::weak_ptr<TransformObject>& GetParent() { return Parent; }
+	inline TransformObject* GetParent() const { return Parent; }
 
 	const Transform GetRelativeTransform() const;
-	const Transform& GetAbsoluteTransform() const;
+	// Copies of the world state, safe to keep while transforms are added and to read from parallel tasks
+	Transform GetAbsoluteTransform() const;
+	glm::mat4 GetAbsoluteMatrix() const;
+	inline uint32_t GetWorldVersion() const { return TransformSystem::Get().GetWorldVersion(TransformIndex); }
 
 	// Utility Methods
 	void Move(const glm::vec3 inMoveVector);
 	void Rotate(const float inAmount, const glm::vec3 inAxis);
+	void SetRotation(const glm::quat& inNewRotation);
 	void SetRotationDegrees(const glm::vec3 inNewRotation);
 	void SetRotationRadians(const glm::vec3 inNewRotation);
-	inline glm::vec3 GetRelRotation() const { return Rotation; }
+	inline glm::quat GetRelRotation() const { return TransformSystem::Get().LocalRotations[TransformIndex]; }
+
+	// Euler angles for display and editing only, derived from the rotation when it was not set from Euler angles
+	glm::vec3 GetRelRotationDegrees() const;
+	inline glm::vec3 GetRelScale() const { return TransformSystem::Get().LocalScales[TransformIndex]; }
 	void SetRelTransform(const Transform& inNewTransf);
 	void SetRelativeLocation(const glm::vec3 inRelLoc);
 	void SetScale(const glm::vec3 inScale);
@@ -48,22 +56,24 @@ public:
 		}
 	}
 
+	// Walks the parent chain without touching the cached world transforms, reference for the TransformSystem results
+	Transform CalculateAbsTransform() const;
+
 protected:
-	void CalculateAbsTransform() const;
-	void MakeTransfDirty() const;
-	inline bool IsTranfsDirty() const { return TransfDirty; }
-	inline void CleanTranfsDirty() const { TransfDirty = false; }
+	inline void MakeTransfDirty() const { TransformSystem::Get().MarkDirty(TransformIndex); }
 
 protected:
-	glm::vec3 Location	= { 0.f, 0.f, 0.f };
-	glm::vec3 Rotation	= { 0.f, 0.f, 0.f };
-	glm::vec3 Scale		= { 1.f, 1.f, 1.f };
-	mutable Transform AbsoluteTranfs;
-	mutable bool TransfDirty = true;
-	eastl::weak_ptr<TransformObject> Parent;
+	// Location, rotation and scale live in the TransformSystem, this is updated when it reorders its storage
+	uint32_t TransformIndex = 0;
+	// Children are owned by their parent, which clears this when it is destroyed first
+	TransformObject* Parent = nullptr;
 	eastl::vector<TransformObjPtr> Children;
 
+	// Entry in the Scene list matching the object kind, stale when the object is not part of a scene
+	SlotHandle SceneHandle;
+
 	eastl::string Name;
 
 	friend class Scene;
+	friend class TransformSystem;
 };
\ No newline at end of file
@@ -0,0 +1,479 @@
+#include "Entity/TransformSystem.h"
+#include "Entity/TransformObject.h"
+#include "Core/EngineUtils.h"
+#include "Core/TaskSystem.h"
+#include "EASTL/string.h"
+#include "Utils/PerfUtils.h"
+#include <string.h>
+#include <xmmintrin.h>
+
+// Below this many nodes in the dirty range the update stays on the calling thread
+static constexpr uint32_t ParallelUpdateThreshold = 4096;
+
+// Target node count of the subtrees given to the workers
+static constexpr uint32_t SubtreeTaskSize = 1024;
+
+TransformSystem& TransformSystem::Get()
+{
+	static TransformSystem Instance;
+	return Instance;
+}
+
+uint32_t TransformSystem::Allocate(TransformObject* inOwner)
+{
+	const uint32_t index = static_cast<uint32_t>(Owners.size());
+
+	LocalLocations.push_back(glm::vec3(0.f));
+	LocalRotations.push_back(glm::quat(1.f, 0.f, 0.f, 0.f));
+	LocalScales.push_back(glm::vec3(1.f));
+	EditorEulerDegrees.push_back(glm::vec3(0.f));
+	EditorEulerValid.push_back(1);
+	WorldTransforms.push_back(Transform());
+	WorldMatrices.push_back(glm::mat4(1.f));
+	ParentIndices.push_back(-1);
+	SubtreeSizes.push_back(1);
+	Owners.push_back(inOwner);
+	LocalDirty.push_back(1);
+	WorldVersions.push_back(0);
+	ParentVersionsSeen.push_back(0);
+
+	// New nodes are roots at the end, which keeps the depth first order valid
+	MarkDirty(index);
+
+	return index;
+}
+
+void TransformSystem::Free(const uint32_t inIndex)
+{
+	// Slot is dropped on the next sort, children left without a parent become roots like before
+	Owners[inIndex] = nullptr;
+	bNeedsSort = true;
+	bAllClean = false;
+}
+
+void TransformSystem::SetParent(const uint32_t inChild, const uint32_t inParent)
+{
+	ParentIndices[inChild] = static_cast<int32_t>(inParent);
+	LocalDirty[inChild] = 1;
+
+	bNeedsSort = true;
+	bAllClean = false;
+}
+
+void TransformSystem::MarkDirty(const uint32_t inIndex)
+{
+	LocalDirty[inIndex] = 1;
+	bAllClean = false;
+
+	// The whole storage is walked after a sort anyway
+	if (bNeedsSort)
+	{
+		return;
+	}
+
+	const uint32_t subtreeEnd = inIndex + SubtreeSizes[inIndex];
+	if (DirtyBegin >= DirtyEnd)
+	{
+		DirtyBegin = inIndex;
+		DirtyEnd = subtreeEnd;
+	}
+	else
+	{
+		DirtyBegin = glm::min(DirtyBegin, inIndex);
+		DirtyEnd = glm::max(DirtyEnd, subtreeEnd);
+	}
+}
+
+Transform TransformSystem::GetLocalTransform(const uint32_t inIndex) const
+{
+	Transform local;
+	local.Translation = LocalLocations[inIndex];
+	local.Rotation = LocalRotations[inIndex];
+	local.Scale = LocalScales[inIndex];
+
+	return local;
+}
+
+Transform TransformSystem::GetWorldTransform(const uint32_t inIndex)
+{
+	// Resolving writes shared state, workers reading at the same time would race with it
+	if (!bAllClean && !TaskSystem::IsInsideTask())
+	{
+		EnsureWorldTransform(inIndex);
+	}
+
+	return WorldTransforms[inIndex];
+}
+
+glm::mat4 TransformSystem::GetWorldMatrix(const uint32_t inIndex)
+{
+	if (!bAllClean && !TaskSystem::IsInsideTask())
+	{
+		EnsureWorldTransform(inIndex);
+	}
+
+	return WorldMatrices[inIndex];
+}
+
+static inline int32_t GetLiveParent(const eastl::vector<int32_t>& inParentIndices, const eastl::vector<TransformObject*>& inOwners, const uint32_t inIndex)
+{
+	const int32_t parent = inParentIndices[inIndex];
+	return (parent >= 0 && inOwners[parent]) ? parent : -1;
+}
+
+bool TransformSystem::NeedsUpdate(const uint32_t inIndex) const
+{
+	const int32_t parent = GetLiveParent(ParentIndices, Owners, inIndex);
+
+	return LocalDirty[inIndex] || (parent >= 0 && ParentVersionsSeen[inIndex] != WorldVersions[parent]);
+}
+
+/**
+ * Same result as Transform::GetMatrix, translate(1, T) * mat4_cast(R) followed by scale(S), with every column computed 4 wide.
+ * Products and sums are done in the same order as glm's scalar code, so the matrices are identical and the Transform's own
+ * cache can be filled with it.
+ */
+static void ComputeWorldMatrix(const Transform& inTransform, glm::mat4& outMatrix)
+{
+	const __m128 axisX = _mm_setr_ps(1.f, 0.f, 0.f, 0.f);
+	const __m128 axisY = _mm_setr_ps(0.f, 1.f, 0.f, 0.f);
+	const __m128 axisZ = _mm_setr_ps(0.f, 0.f, 1.f, 0.f);
+	const __m128 axisW = _mm_setr_ps(0.f, 0.f, 0.f, 1.f);
+
+	// glm::translate(identity, T)
+	__m128 translation = _mm_mul_ps(axisX, _mm_set1_ps(inTransform.Translation.x));
+	translation = _mm_add_ps(translation, _mm_mul_ps(axisY, _mm_set1_ps(inTransform.Translation.y)));
+	translation = _mm_add_ps(translation, _mm_mul_ps(axisZ, _mm_set1_ps(inTransform.Translation.z)));
+	translation = _mm_add_ps(translation, axisW);
+
+	const glm::mat4 rotation = glm::mat4_cast(inTransform.Rotation);
+
+	for (int32_t column = 0; column < 4; ++column)
+	{
+		const glm::vec4& rotationColumn = rotation[column];
+
+		__m128 result = _mm_mul_ps(axisX, _mm_set1_ps(rotationColumn.x));
+		result = _mm_add_ps(result, _mm_mul_ps(axisY, _mm_set1_ps(rotationColumn.y)));
+		result = _mm_add_ps(result, _mm_mul_ps(axisZ, _mm_set1_ps(rotationColumn.z)));
+		result = _mm_add_ps(result, _mm_mul_ps(translation, _mm_set1_ps(rotationColumn.w)));
+
+		if (column < 3)
+		{
+			result = _mm_mul_ps(result, _mm_set1_ps(inTransform.Scale[column]));
+		}
+
+		_mm_storeu_ps(&outMatrix[column].x, result);
+	}
+
+	inTransform.MatrixCache = outMatrix;
+	inTransform.bDirty = false;
+}
+
+void TransformSystem::ComputeWorldTransform(const uint32_t inIndex)
+{
+	const int32_t parent = GetLiveParent(ParentIndices, Owners, inIndex);
+
+	// Same composition order as the recursive TransformObject::CalculateAbsTransform
+	Transform& world = WorldTransforms[inIndex];
+	world = GetLocalTransform(inIndex);
+	if (parent >= 0)
+	{
+		world = world * WorldTransforms[parent];
+		ParentVersionsSeen[inIndex] = WorldVersions[parent];
+	}
+
+	ComputeWorldMatrix(world, WorldMatrices[inIndex]);
+
+	LocalDirty[inIndex] = 0;
+	++WorldVersions[inIndex];
+}
+
+void TransformSystem::EnsureWorldTransform(const uint32_t inIndex)
+{
+	const int32_t parent = GetLiveParent(ParentIndices, Owners, inIndex);
+	if (parent >= 0)
+	{
+		EnsureWorldTransform(parent);
+	}
+
+	if (NeedsUpdate(inIndex))
+	{
+		ComputeWorldTransform(inIndex);
+	}
+}
+
+template<typename T>
+static void PermuteArray(eastl::vector<T>& ioArray, const eastl::vector<uint32_t>& inNewToOld)
+{
+	eastl::vector<T> permuted;
+	permuted.reserve(inNewToOld.size());
+
+	for (const uint32_t oldIndex : inNewToOld)
+	{
+		permuted.push_back(ioArray[oldIndex]);
+	}
+
+	ioArray = eastl::move(permuted);
+}
+
+void TransformSystem::SortHierarchy()
+{
+	const uint32_t numSlots = static_cast<uint32_t>(Owners.size());
+
+	// Child lists of the live nodes, built backwards so siblings keep their current relative order
+	eastl::vector<int32_t> firstChild(numSlots, -1);
+	eastl::vector<int32_t> nextSibling(numSlots, -1);
+
+	for (int32_t i = static_cast<int32_t>(numSlots) - 1; i >= 0; --i)
+	{
+		if (!Owners[i])
+		{
+			continue;
+		}
+
+		const int32_t parent = GetLiveParent(ParentIndices, Owners, i);
+		if (parent >= 0)
+		{
+			nextSibling[i] = firstChild[parent];
+			firstChild[parent] = i;
+		}
+		else if (ParentIndices[i] >= 0)
+		{
+			// Parent was destroyed
+			LocalDirty[i] = 1;
+		}
+	}
+
+	// Depth first, pre order
+	eastl::vector<uint32_t> newToOld;
+	newToOld.reserve(numSlots);
+
+	eastl::vector<uint32_t> stack;
+	eastl::vector<uint32_t> children;
+
+	for (uint32_t root = 0; root < numSlots; ++root)
+	{
+		if (!Owners[root] || GetLiveParent(ParentIndices, Owners, root) >= 0)
+		{
+			continue;
+		}
+
+		stack.push_back(root);
+		while (!stack.empty())
+		{
+			const uint32_t node = stack.back();
+			stack.pop_back();
+			newToOld.push_back(node);
+
+			children.clear();
+			for (int32_t child = firstChild[node]; child >= 0; child = nextSibling[child])
+			{
+				children.push_back(child);
+			}
+
+			for (auto it = children.rbegin(); it != children.rend(); ++it)
+			{
+				stack.push_back(*it);
+			}
+		}
+	}
+
+	const uint32_t numNodes = static_cast<uint32_t>(newToOld.size());
+
+	eastl::vector<int32_t> oldToNew(numSlots, -1);
+	for (uint32_t newIndex = 0; newIndex < numNodes; ++newIndex)
+	{
+		oldToNew[newToOld[newIndex]] = static_cast<int32_t>(newIndex);
+	}
+
+	eastl::vector<int32_t> newParents(numNodes, -1);
+	for (uint32_t newIndex = 0; newIndex < numNodes; ++newIndex)
+	{
+		const int32_t oldParent = GetLiveParent(ParentIndices, Owners, newToOld[newIndex]);
+		newParents[newIndex] = oldParent >= 0 ? oldToNew[oldParent] : -1;
+	}
+
+	PermuteArray(LocalLocations, newToOld);
+	PermuteArray(LocalRotations, newToOld);
+	PermuteArray(LocalScales, newToOld);
+	PermuteArray(EditorEulerDegrees, newToOld);
+	PermuteArray(EditorEulerValid, newToOld);
+	PermuteArray(WorldTransforms, newToOld);
+	PermuteArray(WorldMatrices, newToOld);
+	PermuteArray(Owners, newToOld);
+	PermuteArray(LocalDirty, newToOld);
+	PermuteArray(WorldVersions, newToOld);
+	PermuteArray(ParentVersionsSeen, newToOld);
+	ParentIndices = eastl::move(newParents);
+
+	// Parents come first, so walking backwards accumulates complete subtrees
+	SubtreeSizes.assign(numNodes, 1);
+	for (int32_t i = static_cast<int32_t>(numNodes) - 1; i >= 0; --i)
+	{
+		if (ParentIndices[i] >= 0)
+		{
+			SubtreeSizes[ParentIndices[i]] += SubtreeSizes[i];
+		}
+	}
+
+	for (uint32_t i = 0; i < numNodes; ++i)
+	{
+		Owners[i]->TransformIndex = i;
+	}
+
+	DirtyBegin = 0;
+	DirtyEnd = numNodes;
+	bNeedsSort = false;
+}
+
+uint32_t TransformSystem::UpdateRange(const uint32_t inBegin, const uint32_t inEnd)
+{
+	uint32_t numUpdated = 0;
+	for (uint32_t i = inBegin; i < inEnd; ++i)
+	{
+		if (NeedsUpdate(i))
+		{
+			ComputeWorldTransform(i);
+			++numUpdated;
+		}
+	}
+
+	return numUpdated;
+}
+
+uint32_t TransformSystem::UpdateRangeParallel(const uint32_t inBegin, const uint32_t inEnd)
+{
+	// Split the range in subtrees of about SubtreeTaskSize nodes, descending into the bigger ones.
+	// The nodes descended through are the only ones shared between tasks, they come before their subtrees in the storage
+	// so updating them serially in order first leaves the tasks fully independent.
+	SharedAncestors.clear();
+	SubtreeTasks.clear();
+
+	uint32_t node = inBegin;
+	while (node < inEnd)
+	{
+		const uint32_t subtreeEnd = glm::min(node + SubtreeSizes[node], inEnd);
+		if (subtreeEnd - node <= SubtreeTaskSize)
+		{
+			// Merge neighbouring small subtrees in one task
+			if (!SubtreeTasks.empty() && SubtreeTasks.back().y == node && subtreeEnd - SubtreeTasks.back().x <= SubtreeTaskSize)
+			{
+				SubtreeTasks.back().y = subtreeEnd;
+			}
+			else
+			{
+				SubtreeTasks.push_back(glm::uvec2(node, subtreeEnd));
+			}
+
+			node = subtreeEnd;
+		}
+		else
+		{
+			SharedAncestors.push_back(node);
+			++node;
+		}
+	}
+
+	uint32_t numUpdated = 0;
+	for (const uint32_t ancestor : SharedAncestors)
+	{
+		numUpdated += UpdateRange(ancestor, ancestor + 1);
+	}
+
+	TaskSystem& tasks = TaskSystem::Get();
+	WorkerNumUpdated.assign(tasks.GetNumWorkers(), 0);
+
+	tasks.ParallelFor(static_cast<uint32_t>(SubtreeTasks.size()), 1, [this](const uint32_t inTaskBegin, const uint32_t inTaskEnd, const uint32_t inWorkerIdx)
+	{
+		for (uint32_t task = inTaskBegin; task < inTaskEnd; ++task)
+		{
+			WorkerNumUpdated[inWorkerIdx] += UpdateRange(SubtreeTasks[task].x, SubtreeTasks[task].y);
+		}
+	});
+
+	for (const uint32_t workerUpdated : WorkerNumUpdated)
+	{
+		numUpdated += workerUpdated;
+	}
+
+	return numUpdated;
+}
+
+void TransformSystem::UpdateWorldTransforms(const bool inAllowParallel)
+{
+	if (bNeedsSort)
+	{
+		SortHierarchy();
+	}
+
+	if (inAllowParallel && DirtyEnd - DirtyBegin >= ParallelUpdateThreshold)
+	{
+		LastNumUpdated = UpdateRangeParallel(DirtyBegin, DirtyEnd);
+	}
+	else
+	{
+		LastNumUpdated = UpdateRange(DirtyBegin, DirtyEnd);
+	}
+
+	DirtyBegin = 0;
+	DirtyEnd = 0;
+	bAllClean = true;
+}
+
+void TransformSystem::BenchmarkWorldTransforms(const uint32_t inNumIterations)
+{
+	UpdateWorldTransforms();
+
+	const uint32_t numNodes = GetNumNodes();
+	if (numNodes == 0 || inNumIterations == 0)
+	{
+		return;
+	}
+
+	const auto timeUpdates = [&](const bool inParallel)
+	{
+		int64_t totalUs = 0;
+		for (uint32_t iteration = 0; iteration < inNumIterations; ++iteration)
+		{
+			for (uint32_t i = 0; i < numNodes; ++i)
+			{
+				LocalDirty[i] = 1;
+			}
+
+			DirtyBegin = 0;
+			DirtyEnd = numNodes;
+			bAllClean = false;
+
+			int64_t updateUs = 0;
+			{
+				Utils::BenchmarkCode bench(&updateUs);
+				UpdateWorldTransforms(inParallel);
+			}
+
+			totalUs += updateUs;
+		}
+
+		return double(numNodes) * double(inNumIterations) / (glm::max(double(totalUs), 1.0) * 1e-6);
+	};
+
+	const double serialNodesPerSecond = timeUpdates(false);
+	const double parallelNodesPerSecond = timeUpdates(true);
+
+	uint32_t numMismatches = 0;
+	for (uint32_t i = 0; i < numNodes; ++i)
+	{
+		const Transform reference = Owners[i]->CalculateAbsTransform();
+		const Transform& world = WorldTransforms[i];
+		const glm::mat4 referenceMatrix = reference.GetMatrix();
+
+		const bool bSame = memcmp(&reference.Translation, &world.Translation, sizeof(glm::vec3)) == 0
+			&& memcmp(&reference.Rotation, &world.Rotation, sizeof(glm::quat)) == 0
+			&& memcmp(&reference.Scale, &world.Scale, sizeof(glm::vec3)) == 0
+			&& memcmp(&referenceMatrix, &WorldMatrices[i], sizeof(glm::mat4)) == 0;
+
+		numMismatches += bSame ? 0 : 1;
+	}
+
+	LOG_INFO("World transforms(%u nodes, %u workers): serial %f Mnodes/s, parallel %f Mnodes/s, %u nodes differ from the recursive evaluation.",
+		numNodes, TaskSystem::Get().GetNumWorkers(), serialNodesPerSecond * 1e-6, parallelNodesPerSecond * 1e-6, numMismatches);
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include <stdint.h>
+#include "EASTL/vector.h"
+#include "Math/Transform.h"
+
+/**
+ * Flat storage for the transforms of every TransformObject, which only keeps an index into it.
+ * Each field lives in its own contiguous array and nodes are kept in depth first order, so parents always come
+ * before their children and a subtree is the contiguous range [Index, Index + SubtreeSize).
+ * Mutations only flag the node, world transforms are brought up to date by one linear pass per frame over the dirty range.
+ * Large ranges are split in independent subtrees that the task system workers update in parallel, after their common
+ * ancestors have been updated serially.
+ * Reading a world transform between mutations and that pass evaluates just the node's parent chain, on the main thread.
+ * Parallel tasks never write the storage, they read the world transforms of the last pass.
+ */
+class TransformSystem
+{
+public:
+	static TransformSystem& Get();
+
+	uint32_t Allocate(class TransformObject* inOwner);
+	void Free(const uint32_t inIndex);
+
+	// Structural changes reorder the storage on the next update, indices held outside of TransformObject become invalid
+	void SetParent(const uint32_t inChild, const uint32_t inParent);
+
+	void MarkDirty(const uint32_t inIndex);
+
+	// Copies, the storage moves on Allocate and is rewritten by every update. Inside of parallel tasks changes made since
+	// the last UpdateWorldTransforms are not resolved and only show up after the next one.
+	Transform GetWorldTransform(const uint32_t inIndex);
+	glm::mat4 GetWorldMatrix(const uint32_t inIndex);
+
+	// Local transform built the same way the world transforms are composed
+	Transform GetLocalTransform(const uint32_t inIndex) const;
+
+	// The per frame pass, recomputes every node in the dirty range whose local transform or parent changed
+	void UpdateWorldTransforms(const bool inAllowParallel = true);
+
+	// Times full serial and parallel updates, logs nodes/s and the number of nodes differing from TransformObject::CalculateAbsTransform
+	void BenchmarkWorldTransforms(const uint32_t inNumIterations);
+
+	// Bumped each time the world transform is recomputed, compare against a stored value to detect moves after UpdateWorldTransforms
+	inline uint32_t GetWorldVersion(const uint32_t inIndex) const { return WorldVersions[inIndex]; }
+
+	inline uint32_t GetNumNodes() const { return static_cast<uint32_t>(Owners.size()); }
+	inline uint32_t GetLastNumUpdated() const { return LastNumUpdated; }
+
+public:
+	// Local state
+	eastl::vector<glm::vec3> LocalLocations;
+	eastl::vector<glm::quat> LocalRotations;
+	eastl::vector<glm::vec3> LocalScales;
+
+	// Euler degrees last shown or typed in the editor, so dragging a value does not flip between equivalent angles.
+	// Only valid while the rotation is not changed through another path.
+	eastl::vector<glm::vec3> EditorEulerDegrees;
+	eastl::vector<uint8_t> EditorEulerValid;
+
+private:
+	TransformSystem() = default;
+	~TransformSystem() = default;
+
+	void SortHierarchy();
+	void EnsureWorldTransform(const uint32_t inIndex);
+	void ComputeWorldTransform(const uint32_t inIndex);
+	bool NeedsUpdate(const uint32_t inIndex) const;
+	uint32_t UpdateRange(const uint32_t inBegin, const uint32_t inEnd);
+	uint32_t UpdateRangeParallel(const uint32_t inBegin, const uint32_t inEnd);
+
+private:
+	eastl::vector<Transform> WorldTransforms;
+	eastl::vector<glm::mat4> WorldMatrices;
+	eastl::vector<int32_t> ParentIndices;
+	eastl::vector<uint32_t> SubtreeSizes;
+	eastl::vector<class TransformObject*> Owners;
+
+	// A node is stale if its local transform changed or its parent was recomputed since it last read it
+	eastl::vector<uint8_t> LocalDirty;
+	eastl::vector<uint32_t> WorldVersions;
+	eastl::vector<uint32_t> ParentVersionsSeen;
+
+	// Range that the next update has to walk, empty when Begin >= End
+	uint32_t DirtyBegin = 0;
+	uint32_t DirtyEnd = 0;
+
+	// Scratch for the parallel update, ancestors updated first and the [Begin, End) subtree ranges handed to the workers
+	eastl::vector<uint32_t> SharedAncestors;
+	eastl::vector<glm::uvec2> SubtreeTasks;
+	eastl::vector<uint32_t> WorkerNumUpdated;
+
+	bool bNeedsSort = false;
+	bool bAllClean = true;
+	uint32_t LastNumUpdated = 0;
+};
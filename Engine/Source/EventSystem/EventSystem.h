@@ -29,6 +29,11 @@ public:
 		return Func(std::forward<inParamTypes>(inParams)...);
 	}
 
+	virtual bool IsBound() const override
+	{
+		return !!Func;
+	}
+
 	FreeFunctionType Func;
 };
 
@@ -1,5 +1,6 @@
 #include "Math/AABB.h"
 #include "Renderer/DrawDebugHelpers.h"
+#include "glm/common.hpp"
 
 AABB& AABB::operator+=(const glm::vec3& inVec)
 {
@@ -30,6 +31,17 @@ AABB& AABB::operator+=(const AABB& inAABB)
 	return *this;
 }
 
+AABB AABB::Transformed(const glm::mat4& inMatrix) const
+{
+	glm::vec3 center, extent;
+	GetCenterAndExtent(center, extent);
+
+	const glm::vec3 newCenter = glm::vec3(inMatrix * glm::vec4(center, 1.f));
+	const glm::vec3 newExtent = glm::abs(glm::vec3(inMatrix[0])) * extent.x + glm::abs(glm::vec3(inMatrix[1])) * extent.y + glm::abs(glm::vec3(inMatrix[2])) * extent.z;
+
+	return AABB(newCenter - newExtent, newCenter + newExtent);
+}
+
 vectorInline<glm::vec3, 8> AABB::GetVertices() const
 {
 	// Use a unit cube
@@ -4,16 +4,38 @@
 #include "EASTL/array.h"
 #include "EASTL/vector.h"
 #include "glm/ext/vector_float3.hpp"
+#include "glm/ext/matrix_float4x4.hpp"
 #include "Utils/InlineVector.h"
 
 struct AABB
 {
+	AABB() = default;
+	AABB(const glm::vec3& inMin, const glm::vec3& inMax)
+		: Min{ inMin }, Max{ inMax }, IsInitialized{ true } {}
+
 	glm::vec3 Min;
 	glm::vec3 Max;
 
 	AABB& operator +=(const AABB& inAABB);
 	AABB& operator +=(const glm::vec3& inVec);
 
+	inline bool IsValid() const { return IsInitialized; }
+
+	inline bool Contains(const AABB& inOther) const
+	{
+		return Min.x <= inOther.Min.x && Min.y <= inOther.Min.y && Min.z <= inOther.Min.z &&
+			Max.x >= inOther.Max.x && Max.y >= inOther.Max.y && Max.z >= inOther.Max.z;
+	}
+
+	inline float GetSurfaceArea() const
+	{
+		const glm::vec3 size = Max - Min;
+		return 2.f * (size.x * size.y + size.y * size.z + size.z * size.x);
+	}
+
+	// Box enclosing this one after an affine transform, from the transformed center and the extent projected on the new axes
+	AABB Transformed(const glm::mat4& inMatrix) const;
+
 	inline glm::vec3 GetExtent() const
 	{
 		return 0.5f * (Max - Min);
@@ -6,7 +6,8 @@ BVHNode::BVHNode() = default;
 
 BVHNode::~BVHNode()
 {
-	delete LeftNode, RightNode;
+	delete LeftNode;
+	delete RightNode;
 }
 
 void BVHNode::DebugDraw() const
@@ -31,6 +32,12 @@ BVH::~BVH()
 	delete Root;
 }
 
+void BVH::Clear()
+{
+	delete Root;
+	Root = nullptr;
+}
+
 #define TERMINATION_SIZE 2
 
 void RecursivelyBuildBVH(BVHNode& inNode, const eastl::vector<PathTraceTriangle>& inTriangles, bool& continueRecursion)
@@ -60,6 +67,7 @@ void RecursivelyBuildBVH(BVHNode& inNode, const eastl::vector<PathTraceTriangle>
 	{
 		leftSideTriangles.clear();
 		rightSideTriangles.clear();
+		triangleCenters.clear();
 		glm::vec3 combinedCenter = glm::vec3(0.f, 0.f, 0.f);
 		AABB comparisonAABB;
 		inNode.BoundingBox = AABB();
@@ -154,6 +162,7 @@ void RecursivelyBuildBVH(BVHNode& inNode, const eastl::vector<PathTraceTriangle>
 		}
 
 		validSplit = leftSideTriangles.size() != inTriangles.size() && rightSideTriangles.size() != inTriangles.size();
+		++tries;
 
 		//if (!validSplit)
 		//{
@@ -183,6 +192,13 @@ void RecursivelyBuildBVH(BVHNode& inNode, const eastl::vector<PathTraceTriangle>
 	if (!continueRecursion)
 		return;
 
+	// Both partitions failed(eg. all centers are the same), keep everything in this node instead of recursing forever
+	if (!validSplit)
+	{
+		inNode.Triangles = inTriangles;
+		return;
+	}
+
 	inNode.LeftNode = new BVHNode();
 	RecursivelyBuildBVH(*inNode.LeftNode, leftSideTriangles, continueRecursion);
 
@@ -194,22 +210,21 @@ void RecursivelyBuildBVH(BVHNode& inNode, const eastl::vector<PathTraceTriangle>
 }
 
 
+// Not logged, scene queries build one per mesh again whenever a mesh moves
 void BVH::Build(const eastl::vector<PathTraceTriangle>& inTriangles)
 {
-	LOG_INFO("Building BVH.");
-
+	Clear();
 	Root = new BVHNode();
 
 	bool recurse = true;
 	RecursivelyBuildBVH(*Root, inTriangles, recurse);
-
-	LOG_INFO("BVH Building done.");
 }
 
 
 // Slab Method
 // https://tavianator.com/2011/ray_box.html
-bool RayIntersectsAABB(const PathTracingRay& inRay, const AABB& inAABB)
+// Outputs the distance at which the ray enters the box, 0 if the origin is inside
+bool RayIntersectsAABB(const PathTracingRay& inRay, const AABB& inAABB, OUT float& outEntryDistance)
 {
 	const float inv_direction_x = 1.0f / inRay.Direction.x;
 	const float inv_direction_y = 1.0f / inRay.Direction.y;
@@ -237,6 +252,14 @@ bool RayIntersectsAABB(const PathTracingRay& inRay, const AABB& inAABB)
 
 	if ((tmin > tzmax) || (tzmin > tmax)) return false;
 
+	if (tzmin > tmin) tmin = tzmin;
+	if (tzmax < tmax) tmax = tzmax;
+
+	// Box is behind the ray or further than what the ray can reach
+	if (tmax < 0.f || tmin > inRay.MaxDistance) return false;
+
+	outEntryDistance = glm::max(tmin, 0.f);
+
 	return true;
 }
 
@@ -248,7 +271,8 @@ bool BVH::Intersects(const PathTracingRay& inRay) const
 
 bool BVHNode::Intersects(const PathTracingRay& inRay) const
 {
-	if (RayIntersectsAABB(inRay, BoundingBox))
+	float entryDistance = 0.f;
+	if (RayIntersectsAABB(inRay, BoundingBox, entryDistance))
 	{
 		if(LeftNode)
 		{
@@ -273,52 +297,45 @@ bool BVHNode::Intersects(const PathTracingRay& inRay) const
 
 bool BVHNode::Trace(const PathTracingRay& inRay, PathTracePayload& outPayload) const
 {
-	if (RayIntersectsAABB(inRay, BoundingBox))
+	// Skip nodes that start further away than the closest hit found so far
+	float entryDistance = 0.f;
+	if (!RayIntersectsAABB(inRay, BoundingBox, entryDistance) || entryDistance > outPayload.Distance)
 	{
-		if (LeftNode)
-		{
-			PathTracePayload leftPayload;
-			const bool leftHit = LeftNode->Trace(inRay, outPayload);
+		return false;
+	}
+
+	if (LeftNode)
+	{
+		// Visit the child closer along the ray first, its hits let the other one get pruned by distance
+		const glm::vec3 leftCenter = (LeftNode->BoundingBox.Min + LeftNode->BoundingBox.Max) * 0.5f;
+		const glm::vec3 rightCenter = (RightNode->BoundingBox.Min + RightNode->BoundingBox.Max) * 0.5f;
+		const bool bLeftFirst = glm::dot(leftCenter - rightCenter, inRay.Direction) <= 0.f;
 
-			PathTracePayload rightPayload;
-			const bool rightHit = RightNode->Trace(inRay, rightPayload);
+		const BVHNode* firstNode = bLeftFirst ? LeftNode : RightNode;
+		const BVHNode* secondNode = bLeftFirst ? RightNode : LeftNode;
 
-			if (leftHit && leftPayload.Distance < outPayload.Distance)
-			{
-				outPayload = leftPayload;
-			}
+		// Children only report hits closer than the payload they receive
+		const bool firstHit = firstNode->Trace(inRay, outPayload);
+		const bool secondHit = secondNode->Trace(inRay, outPayload);
 
-			if (rightHit && rightPayload.Distance < outPayload.Distance)
-			{
-				outPayload = rightPayload;
-			}
+		return firstHit || secondHit;
+	}
 
-			return leftHit || rightHit;
-		}
-		else
+	bool bHit = false;
+	for (const PathTraceTriangle& triangle : Triangles)
+	{
+		PathTracePayload currPayload;
+		if (TraceTriangle(inRay, triangle, currPayload) && currPayload.Distance < outPayload.Distance)
 		{
-			bool bHit = false;
-			for (const PathTraceTriangle& triangle : Triangles)
-			{
-				PathTracePayload currPayload;
-				if (TraceTriangle(inRay, triangle, currPayload))
-				{
-					bHit = true;
-					if (currPayload.Distance < outPayload.Distance)
-					{
-						outPayload = currPayload;
-					}
-				}
-			}
-
-			return bHit;
+			bHit = true;
+			outPayload = currPayload;
 		}
 	}
 
-	return false;
+	return bHit;
 }
 
-float BVH::Trace(const PathTracingRay& inRay, PathTracePayload& outPayload) const
+bool BVH::Trace(const PathTracingRay& inRay, PathTracePayload& outPayload) const
 {
 	return Root->Trace(inRay, outPayload);
 }
@@ -18,6 +18,7 @@ struct BVHNode
 
 	eastl::vector<PathTraceTriangle> Triangles;
 
+	// Any hit, cheaper than Trace as it stops at the first triangle found
 	bool Intersects(const PathTracingRay& inRay) const;
 	bool Trace(const PathTracingRay& inRay, PathTracePayload& outPayload) const;
 
@@ -26,17 +27,25 @@ struct BVHNode
 
 };
 
+// Slab test, outputs the distance at which the ray enters the box, 0 if the origin is inside
+bool RayIntersectsAABB(const PathTracingRay& inRay, const AABB& inAABB, OUT float& outEntryDistance);
+
 struct BVH
 {
 	BVH();
 	~BVH();
+	BVH(const BVH&) = delete;
+	BVH& operator=(const BVH&) = delete;
 
 	void Build(const eastl::vector<PathTraceTriangle>& inTriangles);
 
 	bool Intersects(const PathTracingRay& inRay) const;
-	float Trace(const PathTracingRay& inRay, PathTracePayload& outPayload) const;
+	// Closest hit, returns false if nothing closer than the distance already in the payload was found
+	bool Trace(const PathTracingRay& inRay, PathTracePayload& outPayload) const;
+
+	void Clear();
 
-	inline bool IsValid() { return Root != nullptr; }
+	inline bool IsValid() const { return Root != nullptr; }
 
 	BVHNode* Root = nullptr;
 };
\ No newline at end of file
@@ -0,0 +1,498 @@
+#include "Math/CollisionTests.h"
+#include "Utils/TestUtils.h"
+#include <utility>
+
+namespace
+{
+	// Moves this close to parallel with a surface the sphere starts in are sliding along it rather than going deeper
+	constexpr float SeparatingMoveEpsilon = 1e-3f;
+
+	// Ray against a sphere, only entering hits count as overlaps at the start are handled by the callers
+	bool RayIntersectsSphere(const glm::vec3& inOrigin, const glm::vec3& inDirection, const glm::vec3& inCenter, const float inRadius, const float inMaxDistance, OUT float& outDistance)
+	{
+		const glm::vec3 m = inOrigin - inCenter;
+		const float b = glm::dot(m, inDirection);
+		const float c = glm::dot(m, m) - inRadius * inRadius;
+
+		if (c > 0.f && b > 0.f)
+		{
+			return false;
+		}
+
+		const float discriminant = b * b - c;
+		if (discriminant < 0.f)
+		{
+			return false;
+		}
+
+		const float t = -b - glm::sqrt(discriminant);
+		if (t < 0.f || t > inMaxDistance)
+		{
+			return false;
+		}
+
+		outDistance = t;
+		return true;
+	}
+
+	// Ray against the side of the cylinder around a segment, caps excluded
+	// Real-Time Collision Detection 5.3.7
+	bool RayIntersectsSegmentCylinder(const glm::vec3& inOrigin, const glm::vec3& inDirection, const glm::vec3& inA, const glm::vec3& inB, const float inRadius, const float inMaxDistance, OUT float& outDistance)
+	{
+		const glm::vec3 ab = inB - inA;
+		const glm::vec3 ao = inOrigin - inA;
+
+		const float abDotAb = glm::dot(ab, ab);
+		const float abDotDir = glm::dot(ab, inDirection);
+		const float abDotAo = glm::dot(ab, ao);
+
+		const float a = abDotAb - abDotDir * abDotDir;
+
+		// Moving parallel to the segment, only the end spheres can be hit
+		if (a < 1e-8f * abDotAb)
+		{
+			return false;
+		}
+
+		const float b = abDotAb * glm::dot(ao, inDirection) - abDotAo * abDotDir;
+		const float c = abDotAb * glm::dot(ao, ao) - abDotAo * abDotAo - inRadius * inRadius * abDotAb;
+
+		const float discriminant = b * b - a * c;
+		if (discriminant < 0.f)
+		{
+			return false;
+		}
+
+		const float t = (-b - glm::sqrt(discriminant)) / a;
+		if (t < 0.f || t > inMaxDistance)
+		{
+			return false;
+		}
+
+		// Hit has to be between the two end caps
+		const float s = abDotAo + t * abDotDir;
+		if (s < 0.f || s > abDotAb)
+		{
+			return false;
+		}
+
+		outDistance = t;
+		return true;
+	}
+
+	glm::vec3 ClosestPointOnSegment(const glm::vec3& inPoint, const glm::vec3& inA, const glm::vec3& inB)
+	{
+		const glm::vec3 ab = inB - inA;
+		const float t = glm::clamp(glm::dot(inPoint - inA, ab) / glm::max(glm::dot(ab, ab), 1e-12f), 0.f, 1.f);
+
+		return inA + ab * t;
+	}
+
+	bool IsPointInTriangle(const glm::vec3& inPoint, const PathTraceTriangle& inTri)
+	{
+		// Point is assumed to be on the triangle plane
+		const glm::vec3& n = inTri.WSNormal;
+
+		return glm::dot(glm::cross(inTri.V[1] - inTri.V[0], inPoint - inTri.V[0]), n) >= 0.f
+			&& glm::dot(glm::cross(inTri.V[2] - inTri.V[1], inPoint - inTri.V[1]), n) >= 0.f
+			&& glm::dot(glm::cross(inTri.V[0] - inTri.V[2], inPoint - inTri.V[2]), n) >= 0.f;
+	}
+
+	// Box moving by inMotion, finds the fraction of the motion at which it first touches the triangle.
+	// A zero motion turns this into the static overlap test.
+	bool BoxTriangleSAT(const glm::vec3& inCenter, const glm::vec3& inHalfExtent, const glm::vec3& inMotion, const PathTraceTriangle& inTri,
+		OUT float& outFraction, OUT glm::vec3& outAxis)
+	{
+		// Everything relative to the box center at the start
+		const glm::vec3 v0 = inTri.V[0] - inCenter;
+		const glm::vec3 v1 = inTri.V[1] - inCenter;
+		const glm::vec3 v2 = inTri.V[2] - inCenter;
+
+		const glm::vec3 edges[3] = { v1 - v0, v2 - v1, v0 - v2 };
+
+		glm::vec3 axes[13];
+		axes[0] = inTri.WSNormal;
+		axes[1] = glm::vec3(1.f, 0.f, 0.f);
+		axes[2] = glm::vec3(0.f, 1.f, 0.f);
+		axes[3] = glm::vec3(0.f, 0.f, 1.f);
+
+		// Cross products of the box axes with the triangle edges
+		for (int32_t i = 0; i < 3; ++i)
+		{
+			axes[4 + i * 3 + 0] = glm::vec3(0.f, -edges[i].z, edges[i].y);
+			axes[4 + i * 3 + 1] = glm::vec3(edges[i].z, 0.f, -edges[i].x);
+			axes[4 + i * 3 + 2] = glm::vec3(-edges[i].y, edges[i].x, 0.f);
+		}
+
+		float firstFraction = 0.f;
+		float lastFraction = 1.f;
+		glm::vec3 firstAxis = glm::vec3(0.f);
+
+		for (const glm::vec3& axis : axes)
+		{
+			// Edge parallel to a box axis gives a null axis, covered by the others
+			if (glm::dot(axis, axis) < 1e-12f)
+			{
+				continue;
+			}
+
+			const float p0 = glm::dot(v0, axis);
+			const float p1 = glm::dot(v1, axis);
+			const float p2 = glm::dot(v2, axis);
+			const float triMin = glm::min(p0, glm::min(p1, p2));
+			const float triMax = glm::max(p0, glm::max(p1, p2));
+
+			const float boxRadius = inHalfExtent.x * glm::abs(axis.x) + inHalfExtent.y * glm::abs(axis.y) + inHalfExtent.z * glm::abs(axis.z);
+			const float speed = glm::dot(inMotion, axis);
+
+			if (glm::abs(speed) < 1e-12f)
+			{
+				if (boxRadius < triMin || -boxRadius > triMax)
+				{
+					return false;
+				}
+
+				continue;
+			}
+
+			// Projections overlap while -r + speed * t <= triMax and r + speed * t >= triMin
+			float enter = (triMin - boxRadius) / speed;
+			float exit = (triMax + boxRadius) / speed;
+			if (enter > exit)
+			{
+				std::swap(enter, exit);
+			}
+
+			if (enter > firstFraction)
+			{
+				firstFraction = enter;
+				firstAxis = speed > 0.f ? -axis : axis;
+			}
+
+			lastFraction = glm::min(lastFraction, exit);
+
+			if (firstFraction > lastFraction)
+			{
+				return false;
+			}
+		}
+
+		outFraction = firstFraction;
+		outAxis = firstAxis;
+
+		return true;
+	}
+}
+
+namespace CollisionTests
+{
+	// Real-Time Collision Detection 5.1.5
+	glm::vec3 ClosestPointOnTriangle(const glm::vec3& inPoint, const PathTraceTriangle& inTri)
+	{
+		const glm::vec3& a = inTri.V[0];
+		const glm::vec3& b = inTri.V[1];
+		const glm::vec3& c = inTri.V[2];
+
+		const glm::vec3 ab = b - a;
+		const glm::vec3 ac = c - a;
+		const glm::vec3 ap = inPoint - a;
+
+		const float d1 = glm::dot(ab, ap);
+		const float d2 = glm::dot(ac, ap);
+		if (d1 <= 0.f && d2 <= 0.f)
+		{
+			return a;
+		}
+
+		const glm::vec3 bp = inPoint - b;
+		const float d3 = glm::dot(ab, bp);
+		const float d4 = glm::dot(ac, bp);
+		if (d3 >= 0.f && d4 <= d3)
+		{
+			return b;
+		}
+
+		const float vc = d1 * d4 - d3 * d2;
+		if (vc <= 0.f && d1 >= 0.f && d3 <= 0.f)
+		{
+			return a + ab * (d1 / (d1 - d3));
+		}
+
+		const glm::vec3 cp = inPoint - c;
+		const float d5 = glm::dot(ab, cp);
+		const float d6 = glm::dot(ac, cp);
+		if (d6 >= 0.f && d5 <= d6)
+		{
+			return c;
+		}
+
+		const float vb = d5 * d2 - d1 * d6;
+		if (vb <= 0.f && d2 >= 0.f && d6 <= 0.f)
+		{
+			return a + ac * (d2 / (d2 - d6));
+		}
+
+		const float va = d3 * d6 - d5 * d4;
+		if (va <= 0.f && (d4 - d3) >= 0.f && (d5 - d6) >= 0.f)
+		{
+			return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+		}
+
+		const float denom = 1.f / (va + vb + vc);
+		return a + ab * (vb * denom) + ac * (vc * denom);
+	}
+
+	bool SphereIntersectsTriangle(const glm::vec3& inCenter, const float inRadius, const PathTraceTriangle& inTri)
+	{
+		const glm::vec3 toCenter = inCenter - ClosestPointOnTriangle(inCenter, inTri);
+
+		return glm::dot(toCenter, toCenter) <= inRadius * inRadius;
+	}
+
+	bool SphereIntersectsAABB(const glm::vec3& inCenter, const float inRadius, const AABB& inAABB)
+	{
+		const glm::vec3 toCenter = inCenter - glm::clamp(inCenter, inAABB.Min, inAABB.Max);
+
+		return glm::dot(toCenter, toCenter) <= inRadius * inRadius;
+	}
+
+	bool BoxIntersectsTriangle(const glm::vec3& inCenter, const glm::vec3& inHalfExtent, const PathTraceTriangle& inTri)
+	{
+		float fraction = 0.f;
+		glm::vec3 axis;
+
+		return BoxTriangleSAT(inCenter, inHalfExtent, glm::vec3(0.f), inTri, fraction, axis);
+	}
+
+	bool AABBIntersectsAABB(const AABB& inA, const AABB& inB)
+	{
+		return glm::all(glm::lessThanEqual(inA.Min, inB.Max)) && glm::all(glm::greaterThanEqual(inA.Max, inB.Min));
+	}
+
+	bool SweepSphereTriangle(const glm::vec3& inStart, const float inRadius, const glm::vec3& inDirection, const float inMaxDistance, const PathTraceTriangle& inTri,
+		OUT float& outDistance, OUT glm::vec3& outNormal)
+	{
+		// Overlapping from the start is only a hit when moving deeper, so a sphere resting on a surface can still slide
+		// along it or leave it. Moving away, its distance to the triangle only grows and there is nothing else to find.
+		const glm::vec3 toCenter = inStart - ClosestPointOnTriangle(inStart, inTri);
+		const float centerDistanceSq = glm::dot(toCenter, toCenter);
+		if (centerDistanceSq <= inRadius * inRadius)
+		{
+			// Center on the triangle, pushed back to the side it comes from
+			const glm::vec3 pushOut = centerDistanceSq > 1e-12f ? toCenter / glm::sqrt(centerDistanceSq)
+				: inTri.WSNormalNormalized * (glm::dot(inDirection, inTri.WSNormalNormalized) > 0.f ? -1.f : 1.f);
+
+			if (glm::dot(inDirection, pushOut) >= -SeparatingMoveEpsilon)
+			{
+				return false;
+			}
+
+			outDistance = 0.f;
+			outNormal = pushOut;
+			return true;
+		}
+
+		float closestDistance = inMaxDistance;
+		bool bHit = false;
+
+		// Face, the sphere touches the plane with its point closest to it
+		const glm::vec3& normal = inTri.WSNormalNormalized;
+		const float startPlaneDistance = glm::dot(inStart - inTri.V[0], normal);
+		const float side = startPlaneDistance >= 0.f ? 1.f : -1.f;
+		const float approachSpeed = -glm::dot(inDirection, normal) * side;
+
+		if (approachSpeed > 0.f)
+		{
+			const float t = (glm::abs(startPlaneDistance) - inRadius) / approachSpeed;
+			if (t >= 0.f && t <= closestDistance)
+			{
+				const glm::vec3 contact = inStart + inDirection * t - normal * (side * inRadius);
+				if (IsPointInTriangle(contact, inTri))
+				{
+					closestDistance = t;
+					outNormal = normal * side;
+					bHit = true;
+				}
+			}
+		}
+
+		// Edges and vertices, the swept sphere against the capsules around the edges
+		for (int32_t i = 0; i < 3; ++i)
+		{
+			const glm::vec3& a = inTri.V[i];
+			const glm::vec3& b = inTri.V[(i + 1) % 3];
+
+			// Each vertex sphere is tested once, as the start of its edge
+			float t = 0.f;
+			const bool bEdgeHit = RayIntersectsSegmentCylinder(inStart, inDirection, a, b, inRadius, closestDistance, t);
+			if (bEdgeHit)
+			{
+				closestDistance = t;
+			}
+
+			const bool bVertexHit = RayIntersectsSphere(inStart, inDirection, a, inRadius, closestDistance, t);
+			if (bVertexHit)
+			{
+				closestDistance = t;
+			}
+
+			if (bEdgeHit || bVertexHit)
+			{
+				const glm::vec3 center = inStart + inDirection * closestDistance;
+				outNormal = glm::normalize(center - ClosestPointOnSegment(center, a, b));
+				bHit = true;
+			}
+		}
+
+		if (bHit)
+		{
+			outDistance = closestDistance;
+		}
+
+		return bHit;
+	}
+
+	bool SweepBoxTriangle(const glm::vec3& inStart, const glm::vec3& inHalfExtent, const glm::vec3& inDirection, const float inMaxDistance, const PathTraceTriangle& inTri,
+		OUT float& outDistance, OUT glm::vec3& outNormal)
+	{
+		float fraction = 0.f;
+		glm::vec3 axis;
+		if (!BoxTriangleSAT(inStart, inHalfExtent, inDirection * inMaxDistance, inTri, fraction, axis))
+		{
+			return false;
+		}
+
+		outDistance = fraction * inMaxDistance;
+
+		// No separating axis entered during the motion, the box overlapped from the start
+		outNormal = fraction > 0.f ? glm::normalize(axis) : -inDirection;
+
+		return true;
+	}
+
+	void RunChecks()
+	{
+		// Right triangle in the XZ plane, edges along +X and +Z from the origin and the hypotenuse x + z = 4
+		glm::vec3 vertices[3] = { glm::vec3(0.f), glm::vec3(4.f, 0.f, 0.f), glm::vec3(0.f, 0.f, 4.f) };
+		const PathTraceTriangle tri(vertices);
+
+		const glm::vec3 up = glm::vec3(0.f, 1.f, 0.f);
+		const glm::vec3 down = -up;
+		const glm::vec3 forward = glm::vec3(0.f, 0.f, 1.f);
+		const glm::vec3 diagonal = glm::normalize(glm::vec3(1.f, 0.f, 1.f));
+
+		struct SweepCase
+		{
+			const char* Name;
+			glm::vec3 Start;
+			glm::vec3 Direction;
+			float MaxDistance;
+			bool bExpectedHit;
+			float ExpectedDistance;
+
+			// Zero when several features are touched at once and any of their normals is right
+			glm::vec3 ExpectedNormal;
+		};
+
+		const auto isExpectedHit = [](const SweepCase& inCase, const bool inHit, const float inDistance, const glm::vec3& inNormal)
+		{
+			if (inHit != inCase.bExpectedHit)
+			{
+				return false;
+			}
+
+			if (!inHit)
+			{
+				return true;
+			}
+
+			const bool bNormalValid = inCase.ExpectedNormal == glm::vec3(0.f) ? glm::dot(inNormal, inCase.Direction) < 0.f : glm::dot(inNormal, inCase.ExpectedNormal) > 0.999f;
+			return glm::abs(inDistance - inCase.ExpectedDistance) < 1e-4f && bNormalValid;
+		};
+
+		// Unit radius spheres
+		const SweepCase sphereCases[] =
+		{
+			{ "Sphere onto the face from above", glm::vec3(1.f, 5.f, 1.f), down, 10.f, true, 4.f, up },
+			{ "Sphere onto the face from below", glm::vec3(1.f, -5.f, 1.f), up, 10.f, true, 4.f, down },
+			{ "Sphere stopping short of the face", glm::vec3(1.f, 5.f, 1.f), down, 3.9f, false, 0.f, glm::vec3(0.f) },
+			{ "Sphere onto the X edge", glm::vec3(2.f, 0.f, -5.f), forward, 10.f, true, 4.f, -forward },
+			{ "Sphere onto the corner at the origin", glm::vec3(-5.f, 0.f, -5.f), diagonal, 10.f, true, glm::sqrt(50.f) - 1.f, -diagonal },
+			{ "Sphere starting inside moving deeper", glm::vec3(1.f, 0.5f, 1.f), down, 10.f, true, 0.f, up },
+			{ "Sphere starting inside moving away", glm::vec3(1.f, 0.5f, 1.f), up, 10.f, false, 0.f, glm::vec3(0.f) },
+			{ "Sphere grazing over the face", glm::vec3(2.f, 1.01f, -5.f), forward, 20.f, false, 0.f, glm::vec3(0.f) },
+			{ "Sphere grazing past the Z edge", glm::vec3(-1.01f, 0.f, -5.f), forward, 20.f, false, 0.f, glm::vec3(0.f) },
+		};
+
+		{
+			TestUtils::CheckScope check("Sphere sweeps against a triangle");
+			for (const SweepCase& sweepCase : sphereCases)
+			{
+				float distance = 0.f;
+				glm::vec3 normal = glm::vec3(0.f);
+				const bool bHit = SweepSphereTriangle(sweepCase.Start, 1.f, sweepCase.Direction, sweepCase.MaxDistance, tri, distance, normal);
+				if (!check.Expect(isExpectedHit(sweepCase, bHit, distance, normal)))
+				{
+					LOG_ERROR("%s: hit %d at %f, normal %f %f %f.", sweepCase.Name, bHit ? 1 : 0, distance, normal.x, normal.y, normal.z);
+				}
+			}
+		}
+
+		// Unit half extent boxes
+		const SweepCase boxCases[] =
+		{
+			{ "Box onto the face from above", glm::vec3(1.f, 5.f, 1.f), down, 10.f, true, 4.f, up },
+			{ "Box stopping short of the face", glm::vec3(1.f, 5.f, 1.f), down, 3.9f, false, 0.f, glm::vec3(0.f) },
+			{ "Box onto the X edge", glm::vec3(2.f, 0.f, -5.f), forward, 10.f, true, 4.f, -forward },
+			{ "Box onto the corner at the origin", glm::vec3(-5.f, 0.f, -5.f), diagonal, 10.f, true, 4.f * glm::sqrt(2.f), glm::vec3(0.f) },
+			{ "Box starting inside", glm::vec3(1.f, 0.5f, 1.f), down, 10.f, true, 0.f, up },
+			{ "Box grazing over the face", glm::vec3(2.f, 1.01f, -5.f), forward, 20.f, false, 0.f, glm::vec3(0.f) },
+			{ "Box grazing past the Z edge", glm::vec3(-1.01f, 0.f, -5.f), forward, 20.f, false, 0.f, glm::vec3(0.f) },
+		};
+
+		{
+			TestUtils::CheckScope check("Box sweeps against a triangle");
+			for (const SweepCase& sweepCase : boxCases)
+			{
+				float distance = 0.f;
+				glm::vec3 normal = glm::vec3(0.f);
+				const bool bHit = SweepBoxTriangle(sweepCase.Start, glm::vec3(1.f), sweepCase.Direction, sweepCase.MaxDistance, tri, distance, normal);
+				if (!check.Expect(isExpectedHit(sweepCase, bHit, distance, normal)))
+				{
+					LOG_ERROR("%s: hit %d at %f, normal %f %f %f.", sweepCase.Name, bHit ? 1 : 0, distance, normal.x, normal.y, normal.z);
+				}
+			}
+		}
+
+		struct OverlapCase
+		{
+			const char* Name;
+			glm::vec3 Center;
+			glm::vec3 HalfExtent;
+			bool bExpectedOverlap;
+		};
+
+		const OverlapCase overlapCases[] =
+		{
+			{ "Box through the face", glm::vec3(1.f, 0.5f, 1.f), glm::vec3(1.f), true },
+			{ "Box just above the face", glm::vec3(1.f, 1.01f, 1.f), glm::vec3(1.f), false },
+			{ "Box across the Z edge", glm::vec3(-0.99f, 0.f, 1.f), glm::vec3(1.f), true },
+			{ "Box just beside the Z edge", glm::vec3(-1.01f, 0.f, 1.f), glm::vec3(1.f), false },
+			{ "Box across the hypotenuse", glm::vec3(2.2f, 0.f, 2.2f), glm::vec3(0.5f), true },
+
+			// Inside the triangle bounds, only the axes crossing the hypotenuse separate it
+			{ "Box beside the hypotenuse", glm::vec3(3.f, 0.f, 3.f), glm::vec3(0.5f), false },
+		};
+
+		{
+			TestUtils::CheckScope check("Box overlaps against a triangle");
+			for (const OverlapCase& overlapCase : overlapCases)
+			{
+				if (!check.Expect(BoxIntersectsTriangle(overlapCase.Center, overlapCase.HalfExtent, tri) == overlapCase.bExpectedOverlap))
+				{
+					LOG_ERROR("%s failed.", overlapCase.Name);
+				}
+			}
+		}
+	}
+}
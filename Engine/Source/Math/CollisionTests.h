@@ -0,0 +1,36 @@
+#pragma once
+#include "glm/glm.hpp"
+#include "Core/EngineUtils.h"
+#include "Math/AABB.h"
+#include "Math/PathTracing.h"
+
+/**
+ * Shape vs triangle tests used by the scene shape queries.
+ * Triangles are double sided here, unlike the ray tests, since shapes can approach from either side.
+ * Sweeps go from inStart along the normalized inDirection and report the distance travelled until first contact,
+ * a shape that already overlaps at the start hits at distance 0 with the normal facing against the motion.
+ */
+namespace CollisionTests
+{
+	glm::vec3 ClosestPointOnTriangle(const glm::vec3& inPoint, const PathTraceTriangle& inTri);
+
+	bool SphereIntersectsTriangle(const glm::vec3& inCenter, const float inRadius, const PathTraceTriangle& inTri);
+	bool SphereIntersectsAABB(const glm::vec3& inCenter, const float inRadius, const AABB& inAABB);
+
+	// Separating axis test over the 13 box/triangle axes
+	bool BoxIntersectsTriangle(const glm::vec3& inCenter, const glm::vec3& inHalfExtent, const PathTraceTriangle& inTri);
+	bool AABBIntersectsAABB(const AABB& inA, const AABB& inB);
+
+	// A sphere starting inside of the triangle hits it at distance 0 only if it moves deeper, the normal then pushes the center
+	// away from the closest point of the triangle
+	bool SweepSphereTriangle(const glm::vec3& inStart, const float inRadius, const glm::vec3& inDirection, const float inMaxDistance, const PathTraceTriangle& inTri,
+		OUT float& outDistance, OUT glm::vec3& outNormal);
+
+	// Continuous separating axis test, each axis gives the time range where the projections overlap
+	bool SweepBoxTriangle(const glm::vec3& inStart, const glm::vec3& inHalfExtent, const glm::vec3& inDirection, const float inMaxDistance, const PathTraceTriangle& inTri,
+		OUT float& outDistance, OUT glm::vec3& outNormal);
+
+	// Asserts the sweeps and box overlap give the known contacts of hand placed shapes against a triangle: face, edge and
+	// vertex hits, shapes starting inside of it and shapes passing just beside it
+	void RunChecks();
+}
@@ -0,0 +1,499 @@
+#include "Math/DynamicAABBTree.h"
+#include "EASTL/algorithm.h"
+#include "EASTL/string.h"
+#include "Utils/PerfUtils.h"
+#include "Utils/TestUtils.h"
+
+// Moving proxies get their bounds stretched this many displacements ahead
+static constexpr float DisplacementMultiplier = 4.f;
+
+static inline AABB Union(const AABB& inA, const AABB& inB)
+{
+	return AABB(glm::min(inA.Min, inB.Min), glm::max(inA.Max, inB.Max));
+}
+
+DynamicAABBTree::DynamicAABBTree(const float inFatMargin)
+	: FatMargin{ inFatMargin }
+{
+}
+
+int32_t DynamicAABBTree::AllocateNode()
+{
+	if (FreeList == NullNode)
+	{
+		Nodes.push_back(Node());
+		return static_cast<int32_t>(Nodes.size()) - 1;
+	}
+
+	const int32_t node = FreeList;
+	FreeList = Nodes[node].Parent;
+	Nodes[node] = Node();
+
+	return node;
+}
+
+void DynamicAABBTree::FreeNode(const int32_t inNode)
+{
+	Nodes[inNode].Parent = FreeList;
+	Nodes[inNode].Height = -1;
+	FreeList = inNode;
+}
+
+int32_t DynamicAABBTree::Insert(const AABB& inBounds, void* inUserData)
+{
+	const int32_t proxy = AllocateNode();
+
+	Node& leaf = Nodes[proxy];
+	leaf.Bounds = AABB(inBounds.Min - glm::vec3(FatMargin), inBounds.Max + glm::vec3(FatMargin));
+	leaf.UserData = inUserData;
+	leaf.Height = 0;
+
+	InsertLeaf(proxy);
+	++NumProxies;
+
+	return proxy;
+}
+
+void DynamicAABBTree::Remove(const int32_t inProxy)
+{
+	ASSERT(Nodes[inProxy].IsLeaf() && Nodes[inProxy].Height == 0);
+
+	RemoveLeaf(inProxy);
+	FreeNode(inProxy);
+	--NumProxies;
+}
+
+bool DynamicAABBTree::Move(const int32_t inProxy, const AABB& inBounds, const glm::vec3& inDisplacement)
+{
+	ASSERT(Nodes[inProxy].IsLeaf() && Nodes[inProxy].Height == 0);
+
+	AABB fatBounds = AABB(inBounds.Min - glm::vec3(FatMargin), inBounds.Max + glm::vec3(FatMargin));
+	const glm::vec3 prediction = inDisplacement * DisplacementMultiplier;
+	fatBounds.Min += glm::min(prediction, glm::vec3(0.f));
+	fatBounds.Max += glm::max(prediction, glm::vec3(0.f));
+
+	const AABB& treeBounds = Nodes[inProxy].Bounds;
+	if (treeBounds.Contains(inBounds))
+	{
+		// Bounds that grew far bigger than needed, after a fast move for instance, are shrunk back
+		const glm::vec3 hugeMargin = glm::vec3(4.f * FatMargin);
+		const AABB hugeBounds = AABB(fatBounds.Min - hugeMargin, fatBounds.Max + hugeMargin);
+		if (hugeBounds.Contains(treeBounds))
+		{
+			return false;
+		}
+	}
+
+	RemoveLeaf(inProxy);
+	Nodes[inProxy].Bounds = fatBounds;
+	InsertLeaf(inProxy);
+
+	return true;
+}
+
+void DynamicAABBTree::InsertLeaf(const int32_t inLeaf)
+{
+	if (Root == NullNode)
+	{
+		Root = inLeaf;
+		Nodes[Root].Parent = NullNode;
+		return;
+	}
+
+	// Walk down towards the sibling that minimizes the surface area added to the tree
+	const AABB leafBounds = Nodes[inLeaf].Bounds;
+	int32_t index = Root;
+	while (!Nodes[index].IsLeaf())
+	{
+		const Node& node = Nodes[index];
+
+		const float area = node.Bounds.GetSurfaceArea();
+		const float combinedArea = Union(node.Bounds, leafBounds).GetSurfaceArea();
+
+		// Cost of making a new parent for this node and the leaf, and the increase pushed on the ancestors if going lower
+		const float cost = 2.f * combinedArea;
+		const float inheritanceCost = 2.f * (combinedArea - area);
+
+		const auto descendCost = [&](const int32_t inChild)
+		{
+			const Node& child = Nodes[inChild];
+			const float newArea = Union(child.Bounds, leafBounds).GetSurfaceArea();
+			return (child.IsLeaf() ? newArea : newArea - child.Bounds.GetSurfaceArea()) + inheritanceCost;
+		};
+
+		const float leftCost = descendCost(node.Left);
+		const float rightCost = descendCost(node.Right);
+
+		if (cost < leftCost && cost < rightCost)
+		{
+			break;
+		}
+
+		index = leftCost < rightCost ? node.Left : node.Right;
+	}
+
+	const int32_t sibling = index;
+	const int32_t oldParent = Nodes[sibling].Parent;
+	const int32_t newParent = AllocateNode();
+
+	Node& parentNode = Nodes[newParent];
+	parentNode.Parent = oldParent;
+	parentNode.Bounds = Union(leafBounds, Nodes[sibling].Bounds);
+	parentNode.Height = Nodes[sibling].Height + 1;
+	parentNode.Left = sibling;
+	parentNode.Right = inLeaf;
+
+	if (oldParent != NullNode)
+	{
+		Node& grandParent = Nodes[oldParent];
+		if (grandParent.Left == sibling)
+		{
+			grandParent.Left = newParent;
+		}
+		else
+		{
+			grandParent.Right = newParent;
+		}
+	}
+	else
+	{
+		Root = newParent;
+	}
+
+	Nodes[sibling].Parent = newParent;
+	Nodes[inLeaf].Parent = newParent;
+
+	RefitAncestors(newParent);
+}
+
+void DynamicAABBTree::RemoveLeaf(const int32_t inLeaf)
+{
+	if (inLeaf == Root)
+	{
+		Root = NullNode;
+		return;
+	}
+
+	const int32_t parent = Nodes[inLeaf].Parent;
+	const int32_t grandParent = Nodes[parent].Parent;
+	const int32_t sibling = Nodes[parent].Left == inLeaf ? Nodes[parent].Right : Nodes[parent].Left;
+
+	// The sibling takes the place of the parent
+	if (grandParent != NullNode)
+	{
+		if (Nodes[grandParent].Left == parent)
+		{
+			Nodes[grandParent].Left = sibling;
+		}
+		else
+		{
+			Nodes[grandParent].Right = sibling;
+		}
+
+		Nodes[sibling].Parent = grandParent;
+		FreeNode(parent);
+
+		RefitAncestors(grandParent);
+	}
+	else
+	{
+		Root = sibling;
+		Nodes[sibling].Parent = NullNode;
+		FreeNode(parent);
+	}
+}
+
+void DynamicAABBTree::RefitAncestors(int32_t inNode)
+{
+	while (inNode != NullNode)
+	{
+		inNode = Balance(inNode);
+
+		Node& node = Nodes[inNode];
+		const Node& left = Nodes[node.Left];
+		const Node& right = Nodes[node.Right];
+
+		node.Height = 1 + glm::max(left.Height, right.Height);
+		node.Bounds = Union(left.Bounds, right.Bounds);
+
+		inNode = node.Parent;
+	}
+}
+
+int32_t DynamicAABBTree::Balance(const int32_t inNode)
+{
+	Node& a = Nodes[inNode];
+	if (a.IsLeaf() || a.Height < 2)
+	{
+		return inNode;
+	}
+
+	// Promotes the taller child, which takes this node as one of its children and hands it its own taller child
+	const auto rotateUp = [&](const int32_t inChild, const bool inChildIsRight)
+	{
+		Node& child = Nodes[inChild];
+		const int32_t childLeft = child.Left;
+		const int32_t childRight = child.Right;
+		const int32_t otherChild = inChildIsRight ? a.Left : a.Right;
+
+		child.Left = inNode;
+		child.Parent = a.Parent;
+		a.Parent = inChild;
+
+		if (child.Parent != NullNode)
+		{
+			Node& parent = Nodes[child.Parent];
+			if (parent.Left == inNode)
+			{
+				parent.Left = inChild;
+			}
+			else
+			{
+				parent.Right = inChild;
+			}
+		}
+		else
+		{
+			Root = inChild;
+		}
+
+		const bool bKeepLeft = Nodes[childLeft].Height > Nodes[childRight].Height;
+		const int32_t kept = bKeepLeft ? childLeft : childRight;
+		const int32_t given = bKeepLeft ? childRight : childLeft;
+
+		child.Right = kept;
+		if (inChildIsRight)
+		{
+			a.Right = given;
+		}
+		else
+		{
+			a.Left = given;
+		}
+		Nodes[given].Parent = inNode;
+
+		const Node& otherNode = Nodes[otherChild];
+		const Node& givenNode = Nodes[given];
+		const Node& keptNode = Nodes[kept];
+
+		a.Bounds = Union(otherNode.Bounds, givenNode.Bounds);
+		a.Height = 1 + glm::max(otherNode.Height, givenNode.Height);
+		child.Bounds = Union(a.Bounds, keptNode.Bounds);
+		child.Height = 1 + glm::max(a.Height, keptNode.Height);
+
+		return inChild;
+	};
+
+	const int32_t balance = Nodes[a.Right].Height - Nodes[a.Left].Height;
+	if (balance > 1)
+	{
+		return rotateUp(a.Right, true);
+	}
+
+	if (balance < -1)
+	{
+		return rotateUp(a.Left, false);
+	}
+
+	return inNode;
+}
+
+void DynamicAABBTree::Validate() const
+{
+	if (Root == NullNode)
+	{
+		ASSERT(NumProxies == 0);
+		return;
+	}
+
+	ASSERT(Nodes[Root].Parent == NullNode);
+
+	uint32_t numLeaves = 0;
+	eastl::vector<int32_t> stack;
+	stack.push_back(Root);
+
+	while (!stack.empty())
+	{
+		const int32_t index = stack.back();
+		stack.pop_back();
+
+		const Node& node = Nodes[index];
+		if (node.IsLeaf())
+		{
+			ASSERT(node.Height == 0);
+			++numLeaves;
+			continue;
+		}
+
+		const Node& left = Nodes[node.Left];
+		const Node& right = Nodes[node.Right];
+
+		ASSERT(left.Parent == index && right.Parent == index);
+		ASSERT(node.Height == 1 + glm::max(left.Height, right.Height));
+		ASSERT(node.Bounds.Contains(left.Bounds) && node.Bounds.Contains(right.Bounds));
+
+		stack.push_back(node.Left);
+		stack.push_back(node.Right);
+	}
+
+	ASSERT(numLeaves == NumProxies);
+}
+
+void DynamicAABBTree::Clear()
+{
+	Nodes.clear();
+	Root = NullNode;
+	FreeList = NullNode;
+	NumProxies = 0;
+}
+
+// Props scattered over a level sized area with a random velocity, the first ones are the ones moved
+static constexpr float BenchmarkWorldSize = 1000.f;
+
+static void CreateRandomProps(TestUtils::TestRandom& ioRandom, const uint32_t inNumProxies, eastl::vector<AABB>& outBounds, eastl::vector<glm::vec3>& outVelocities)
+{
+	outBounds.resize(inNumProxies);
+	outVelocities.resize(inNumProxies);
+	for (uint32_t i = 0; i < inNumProxies; ++i)
+	{
+		const glm::vec3 center = ioRandom.NextVec3() * BenchmarkWorldSize;
+		const glm::vec3 extent = glm::vec3(0.5f + 2.f * ioRandom.Next());
+		outBounds[i] = AABB(center - extent, center + extent);
+		outVelocities[i] = (ioRandom.NextVec3() - 0.5f) * 0.5f;
+	}
+}
+
+static void CreateRandomQueries(TestUtils::TestRandom& ioRandom, const uint32_t inNumQueries, eastl::vector<AABB>& outBoxes)
+{
+	outBoxes.resize(inNumQueries);
+	for (AABB& box : outBoxes)
+	{
+		const glm::vec3 center = ioRandom.NextVec3() * BenchmarkWorldSize;
+		box = AABB(center - glm::vec3(20.f), center + glm::vec3(20.f));
+	}
+}
+
+static void MoveProps(DynamicAABBTree& ioTree, const eastl::vector<int32_t>& inProxies, const uint32_t inNumMoving, eastl::vector<AABB>& ioBounds,
+	const eastl::vector<glm::vec3>& inVelocities, uint32_t& ioNumReinserted)
+{
+	for (uint32_t i = 0; i < inNumMoving; ++i)
+	{
+		ioBounds[i].Min += inVelocities[i];
+		ioBounds[i].Max += inVelocities[i];
+		ioNumReinserted += ioTree.Move(inProxies[i], ioBounds[i], inVelocities[i]) ? 1 : 0;
+	}
+}
+
+void DynamicAABBTree::Benchmark(const uint32_t inNumProxies, const uint32_t inNumFrames)
+{
+	if (inNumProxies == 0 || inNumFrames == 0)
+	{
+		return;
+	}
+
+	TestUtils::TestRandom random;
+
+	// A tenth of the props moving every frame
+	const uint32_t numMoving = glm::max(inNumProxies / 10, 1u);
+	const uint32_t numQueries = 1000;
+
+	eastl::vector<AABB> bounds;
+	eastl::vector<glm::vec3> velocities;
+	CreateRandomProps(random, inNumProxies, bounds, velocities);
+
+	DynamicAABBTree tree;
+	eastl::vector<int32_t> proxies(inNumProxies);
+
+	int64_t insertUs = 0;
+	{
+		Utils::BenchmarkCode bench(&insertUs);
+		for (uint32_t i = 0; i < inNumProxies; ++i)
+		{
+			proxies[i] = tree.Insert(bounds[i], reinterpret_cast<void*>(uintptr_t(i)));
+		}
+	}
+
+	int64_t moveUs = 0;
+	uint32_t numReinserted = 0;
+	{
+		Utils::BenchmarkCode bench(&moveUs);
+		for (uint32_t frame = 0; frame < inNumFrames; ++frame)
+		{
+			MoveProps(tree, proxies, numMoving, bounds, velocities, numReinserted);
+		}
+	}
+
+	eastl::vector<AABB> queryBoxes;
+	CreateRandomQueries(random, numQueries, queryBoxes);
+
+	eastl::vector<uint32_t*> results;
+	int64_t queryUs = 0;
+	{
+		Utils::BenchmarkCode bench(&queryUs);
+		for (const AABB& box : queryBoxes)
+		{
+			tree.QueryAABB(box, results);
+		}
+	}
+
+	const double safeMoveUs = glm::max(double(moveUs), 1.0);
+	LOG_INFO("Dynamic AABB tree(%u proxies, height %d): insert %f ms, %u moves per frame %f ms (%u reinserted), %u box queries %f ms (%u results).",
+		inNumProxies, tree.GetHeight(), insertUs * 1e-3, numMoving, safeMoveUs * 1e-3 / inNumFrames, numReinserted, numQueries, queryUs * 1e-3,
+		static_cast<uint32_t>(results.size()));
+}
+
+void DynamicAABBTree::RunChecks()
+{
+	constexpr uint32_t numProxies = 10000;
+	constexpr uint32_t numMoving = numProxies / 10;
+	constexpr uint32_t numFrames = 30;
+	constexpr uint32_t numQueries = 50;
+
+	TestUtils::TestRandom random;
+
+	eastl::vector<AABB> bounds;
+	eastl::vector<glm::vec3> velocities;
+	CreateRandomProps(random, numProxies, bounds, velocities);
+
+	DynamicAABBTree tree;
+	eastl::vector<int32_t> proxies(numProxies);
+	for (uint32_t i = 0; i < numProxies; ++i)
+	{
+		proxies[i] = tree.Insert(bounds[i], reinterpret_cast<void*>(uintptr_t(i)));
+	}
+
+	uint32_t numReinserted = 0;
+	for (uint32_t frame = 0; frame < numFrames; ++frame)
+	{
+		MoveProps(tree, proxies, numMoving, bounds, velocities, numReinserted);
+	}
+
+	tree.Validate();
+
+	eastl::vector<AABB> queryBoxes;
+	CreateRandomQueries(random, numQueries, queryBoxes);
+
+	// Every overlapping proxy has to be found, the fat bounds only allow extra results
+	TestUtils::CheckScope check("Dynamic AABB tree box queries against a brute force scan");
+	eastl::vector<uint32_t*> results;
+	eastl::vector<uint8_t> found(numProxies);
+	for (const AABB& box : queryBoxes)
+	{
+		results.clear();
+		tree.QueryAABB(box, results);
+
+		eastl::fill(found.begin(), found.end(), uint8_t(0));
+		for (const uint32_t* result : results)
+		{
+			found[uintptr_t(result)] = 1;
+		}
+
+		bool bFoundAll = true;
+		for (uint32_t i = 0; i < numProxies; ++i)
+		{
+			bFoundAll &= found[i] || !CollisionTests::AABBIntersectsAABB(bounds[i], box);
+		}
+
+		check.Expect(bFoundAll);
+	}
+}
@@ -0,0 +1,186 @@
+#pragma once
+#include "EASTL/vector.h"
+#include "Core/EngineUtils.h"
+#include "Math/AABB.h"
+#include "Math/Frustum.h"
+#include "Math/CollisionTests.h"
+#include "Math/BVH.h"
+
+/**
+ * Bounding volume hierarchy over moving objects, kept up to date incrementally instead of being rebuilt.
+ * Each proxy is stored with bounds grown by a margin, and by its last displacement in the direction it moves, so small
+ * moves leave the tree untouched. A proxy leaving its fat bounds is removed and reinserted next to the sibling that
+ * grows the least in surface area, then the path to the root is rebalanced with rotations to keep queries logarithmic.
+ * Nodes live in one array and are referenced by index, queries only read the tree and can run on several workers at once.
+ */
+class DynamicAABBTree
+{
+public:
+	static constexpr int32_t NullNode = -1;
+
+	DynamicAABBTree(const float inFatMargin = 0.1f);
+
+	// Returns the proxy id, stable until the proxy is removed
+	int32_t Insert(const AABB& inBounds, void* inUserData);
+	void Remove(const int32_t inProxy);
+
+	// Returns true if the proxy had to be reinserted, the displacement since the last move predicts where it is heading
+	bool Move(const int32_t inProxy, const AABB& inBounds, const glm::vec3& inDisplacement);
+
+	inline void* GetUserData(const int32_t inProxy) const { return Nodes[inProxy].UserData; }
+	inline const AABB& GetFatBounds(const int32_t inProxy) const { return Nodes[inProxy].Bounds; }
+
+	// Results are the user data of every proxy whose fat bounds pass the test, appended in no particular order
+	template<typename T>
+	void QueryAABB(const AABB& inBounds, eastl::vector<T*>& outResults) const
+	{
+		ForEachInAABB(inBounds, [&outResults](void* inUserData) { outResults.push_back(static_cast<T*>(inUserData)); });
+	}
+
+	template<typename T>
+	void QuerySphere(const glm::vec3& inCenter, const float inRadius, eastl::vector<T*>& outResults) const
+	{
+		ForEachInSphere(inCenter, inRadius, [&outResults](void* inUserData) { outResults.push_back(static_cast<T*>(inUserData)); });
+	}
+
+	template<typename T>
+	void QueryFrustum(const Frustum& inFrustum, eastl::vector<T*>& outResults) const
+	{
+		ForEachInFrustum(inFrustum, [&outResults](void* inUserData) { outResults.push_back(static_cast<T*>(inUserData)); });
+	}
+
+	// Every proxy the ray crosses before its MaxDistance, not sorted by distance
+	template<typename T>
+	void QueryRay(const PathTracingRay& inRay, eastl::vector<T*>& outResults) const
+	{
+		ForEachOnRay(inRay, [&outResults](void* inUserData) { outResults.push_back(static_cast<T*>(inUserData)); });
+	}
+
+	// Same queries handing the user data of each result to a visitor, void(void* inUserData), without gathering them first
+	template<typename Visitor>
+	void ForEachInAABB(const AABB& inBounds, const Visitor& inVisitor) const
+	{
+		Traverse([&inBounds](const AABB& inNodeBounds) { return CollisionTests::AABBIntersectsAABB(inNodeBounds, inBounds); }, inVisitor);
+	}
+
+	template<typename Visitor>
+	void ForEachInSphere(const glm::vec3& inCenter, const float inRadius, const Visitor& inVisitor) const
+	{
+		Traverse([&inCenter, inRadius](const AABB& inNodeBounds) { return CollisionTests::SphereIntersectsAABB(inCenter, inRadius, inNodeBounds); }, inVisitor);
+	}
+
+	template<typename Visitor>
+	void ForEachInFrustum(const Frustum& inFrustum, const Visitor& inVisitor) const
+	{
+		Traverse([&inFrustum](const AABB& inNodeBounds) { return inFrustum.IntersectsAABB(inNodeBounds); }, inVisitor);
+	}
+
+	// The visitor can shrink the MaxDistance of the ray to skip the nodes past the closest hit found so far
+	template<typename Visitor>
+	void ForEachOnRay(const PathTracingRay& inRay, const Visitor& inVisitor) const
+	{
+		Traverse([&inRay](const AABB& inNodeBounds)
+		{
+			float entryDistance = 0.f;
+			return RayIntersectsAABB(inRay, inNodeBounds, entryDistance) && entryDistance <= inRay.MaxDistance;
+		}, inVisitor);
+	}
+
+	// Every proxy a box or sphere moving along the ray touches, the node bounds are grown by the extent of the shape.
+	// The visitor can shrink the MaxDistance of the ray to skip the nodes past the closest contact found so far.
+	template<typename Visitor>
+	void ForEachOnSweep(const PathTracingRay& inRay, const glm::vec3& inShapeExtent, const Visitor& inVisitor) const
+	{
+		Traverse([&inRay, &inShapeExtent](const AABB& inNodeBounds)
+		{
+			AABB inflatedBounds = inNodeBounds;
+			inflatedBounds.Min -= inShapeExtent;
+			inflatedBounds.Max += inShapeExtent;
+
+			float entryDistance = 0.f;
+			return RayIntersectsAABB(inRay, inflatedBounds, entryDistance) && entryDistance <= inRay.MaxDistance;
+		}, inVisitor);
+	}
+
+	// Checks the links, heights and bounds of every node
+	void Validate() const;
+	void Clear();
+
+	inline uint32_t GetNumProxies() const { return NumProxies; }
+	inline int32_t GetHeight() const { return Root == NullNode ? 0 : Nodes[Root].Height; }
+
+	// Fat bounds of every proxy, invalid when the tree is empty
+	inline AABB GetRootBounds() const { return Root == NullNode ? AABB() : Nodes[Root].Bounds; }
+
+	// Times inserts, moves and queries over random boxes and logs their throughput
+	static void Benchmark(const uint32_t inNumProxies, const uint32_t inNumFrames);
+
+	// Asserts the tree stays valid as proxies move and box queries find everything a brute force scan does
+	static void RunChecks();
+
+private:
+	struct Node
+	{
+		AABB Bounds;
+		void* UserData = nullptr;
+
+		// Next free node while the node is unused
+		int32_t Parent = NullNode;
+		int32_t Left = NullNode;
+		int32_t Right = NullNode;
+
+		// Leaves are 0, free nodes -1
+		int32_t Height = -1;
+
+		inline bool IsLeaf() const { return Left == NullNode; }
+	};
+
+	// Deep enough for any tree the rotations keep balanced
+	static constexpr uint32_t MaxTraversalDepth = 128;
+
+	template<typename OverlapTest, typename Visitor>
+	void Traverse(const OverlapTest& inOverlaps, const Visitor& inVisitor) const
+	{
+		if (Root == NullNode)
+		{
+			return;
+		}
+
+		int32_t stack[MaxTraversalDepth];
+		uint32_t stackSize = 0;
+		stack[stackSize++] = Root;
+
+		while (stackSize > 0)
+		{
+			const Node& node = Nodes[stack[--stackSize]];
+			if (!inOverlaps(node.Bounds))
+			{
+				continue;
+			}
+
+			if (node.IsLeaf())
+			{
+				inVisitor(node.UserData);
+				continue;
+			}
+
+			ASSERT(stackSize + 2 <= MaxTraversalDepth);
+			stack[stackSize++] = node.Left;
+			stack[stackSize++] = node.Right;
+		}
+	}
+
+	int32_t AllocateNode();
+	void FreeNode(const int32_t inNode);
+	void InsertLeaf(const int32_t inLeaf);
+	void RemoveLeaf(const int32_t inLeaf);
+	int32_t Balance(const int32_t inNode);
+	void RefitAncestors(int32_t inNode);
+
+private:
+	eastl::vector<Node> Nodes;
+	int32_t Root = NullNode;
+	int32_t FreeList = NullNode;
+	uint32_t NumProxies = 0;
+	float FatMargin = 0.1f;
+};
@@ -0,0 +1,64 @@
+#include "Math/Frustum.h"
+
+Frustum Frustum::FromMatrix(const glm::mat4& inWorldToClip, const bool inIncludeNear)
+{
+	// Gribb and Hartmann, glm matrices are column major so the rows are gathered across the columns
+	const glm::vec4 row0 = glm::vec4(inWorldToClip[0][0], inWorldToClip[1][0], inWorldToClip[2][0], inWorldToClip[3][0]);
+	const glm::vec4 row1 = glm::vec4(inWorldToClip[0][1], inWorldToClip[1][1], inWorldToClip[2][1], inWorldToClip[3][1]);
+	const glm::vec4 row2 = glm::vec4(inWorldToClip[0][2], inWorldToClip[1][2], inWorldToClip[2][2], inWorldToClip[3][2]);
+	const glm::vec4 row3 = glm::vec4(inWorldToClip[0][3], inWorldToClip[1][3], inWorldToClip[2][3], inWorldToClip[3][3]);
+
+	Frustum result;
+	result.Planes[Left] = row3 + row0;
+	result.Planes[Right] = row3 - row0;
+	result.Planes[Bottom] = row3 + row1;
+	result.Planes[Top] = row3 - row1;
+	result.Planes[Near] = row2;
+	result.Planes[Far] = row3 - row2;
+
+	for (glm::vec4& plane : result.Planes)
+	{
+		plane /= glm::length(glm::vec3(plane));
+	}
+
+	if (!inIncludeNear)
+	{
+		result.Planes[Near] = glm::vec4(0.f, 0.f, 0.f, 1.f);
+	}
+
+	return result;
+}
+
+bool Frustum::IntersectsAABB(const AABB& inAABB) const
+{
+	glm::vec3 center, extent;
+	inAABB.GetCenterAndExtent(center, extent);
+
+	for (const glm::vec4& plane : Planes)
+	{
+		// Distance of the center against the box radius projected on the plane normal
+		const glm::vec3 normal = glm::vec3(plane);
+		const float distance = glm::dot(normal, center) + plane.w;
+		const float radius = glm::dot(glm::abs(normal), extent);
+
+		if (distance < -radius)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool Frustum::IntersectsSphere(const glm::vec3& inCenter, const float inRadius) const
+{
+	for (const glm::vec4& plane : Planes)
+	{
+		if (glm::dot(glm::vec3(plane), inCenter) + plane.w < -inRadius)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include "glm/glm.hpp"
+#include "Math/AABB.h"
+
+/**
+ * Convex volume bounded by the 6 clip planes of a projection, used to cull bounds against a view.
+ * Planes are stored with normalized inward facing normals in xyz and the distance in w, so a point is inside
+ * when dot(Plane.xyz, point) + Plane.w >= 0 for every plane.
+ */
+struct Frustum
+{
+	enum EPlane
+	{
+		Left = 0,
+		Right,
+		Bottom,
+		Top,
+		Near,
+		Far,
+		NumPlanes
+	};
+
+	glm::vec4 Planes[NumPlanes];
+
+	// Extracted from a D3D style world to clip matrix with depth in [0, 1]. Without the near plane the volume extends
+	// towards the eye indefinitely, which keeps shadow casters between the light and an orthographic cascade.
+	static Frustum FromMatrix(const glm::mat4& inWorldToClip, const bool inIncludeNear = true);
+
+	// Conservative, boxes near a corner of the frustum can pass while being outside of it
+	bool IntersectsAABB(const AABB& inAABB) const;
+	bool IntersectsSphere(const glm::vec3& inCenter, const float inRadius) const;
+};
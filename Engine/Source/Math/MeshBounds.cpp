@@ -0,0 +1,149 @@
+#include "Math/MeshBounds.h"
+#include <xmmintrin.h>
+
+// Loads 4 packed xyz positions and returns them as x, y and z registers
+static inline void LoadTransposed(const float* inData, __m128& outX, __m128& outY, __m128& outZ)
+{
+	const __m128 a = _mm_loadu_ps(inData);		// x0 y0 z0 x1
+	const __m128 b = _mm_loadu_ps(inData + 4);	// y1 z1 x2 y2
+	const __m128 c = _mm_loadu_ps(inData + 8);	// z2 x3 y3 z3
+
+	const __m128 x23 = _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2));
+	outX = _mm_shuffle_ps(a, x23, _MM_SHUFFLE(2, 0, 3, 0));
+
+	const __m128 y01 = _mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1));
+	const __m128 y23 = _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3));
+	outY = _mm_shuffle_ps(y01, y23, _MM_SHUFFLE(2, 0, 2, 0));
+
+	const __m128 z01 = _mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2));
+	outZ = _mm_shuffle_ps(z01, c, _MM_SHUFFLE(3, 0, 2, 0));
+}
+
+static inline float HorizontalMin(__m128 inValue)
+{
+	inValue = _mm_min_ps(inValue, _mm_shuffle_ps(inValue, inValue, _MM_SHUFFLE(2, 3, 0, 1)));
+	inValue = _mm_min_ps(inValue, _mm_shuffle_ps(inValue, inValue, _MM_SHUFFLE(1, 0, 3, 2)));
+	return _mm_cvtss_f32(inValue);
+}
+
+static inline float HorizontalMax(__m128 inValue)
+{
+	inValue = _mm_max_ps(inValue, _mm_shuffle_ps(inValue, inValue, _MM_SHUFFLE(2, 3, 0, 1)));
+	inValue = _mm_max_ps(inValue, _mm_shuffle_ps(inValue, inValue, _MM_SHUFFLE(1, 0, 3, 2)));
+	return _mm_cvtss_f32(inValue);
+}
+
+namespace MeshBounds
+{
+	AABB ComputeAABB(const glm::vec3* inPositions, const uint32_t inCount)
+	{
+		if (inCount == 0)
+		{
+			return AABB();
+		}
+
+		const float* data = &inPositions[0].x;
+		const uint32_t numGroups = inCount / 4;
+
+		__m128 minX = _mm_set1_ps(inPositions[0].x);
+		__m128 minY = _mm_set1_ps(inPositions[0].y);
+		__m128 minZ = _mm_set1_ps(inPositions[0].z);
+		__m128 maxX = minX;
+		__m128 maxY = minY;
+		__m128 maxZ = minZ;
+
+		for (uint32_t group = 0; group < numGroups; ++group)
+		{
+			__m128 x, y, z;
+			LoadTransposed(data + group * 12, x, y, z);
+
+			minX = _mm_min_ps(minX, x);
+			minY = _mm_min_ps(minY, y);
+			minZ = _mm_min_ps(minZ, z);
+			maxX = _mm_max_ps(maxX, x);
+			maxY = _mm_max_ps(maxY, y);
+			maxZ = _mm_max_ps(maxZ, z);
+		}
+
+		AABB result(glm::vec3(HorizontalMin(minX), HorizontalMin(minY), HorizontalMin(minZ)), glm::vec3(HorizontalMax(maxX), HorizontalMax(maxY), HorizontalMax(maxZ)));
+
+		for (uint32_t i = numGroups * 4; i < inCount; ++i)
+		{
+			result.Min = glm::min(result.Min, inPositions[i]);
+			result.Max = glm::max(result.Max, inPositions[i]);
+		}
+
+		return result;
+	}
+
+	BoundingSphere ComputeSphere(const glm::vec3* inPositions, const uint32_t inCount, const glm::vec3& inCenter)
+	{
+		BoundingSphere result;
+		result.Center = inCenter;
+
+		const float* data = &inPositions[0].x;
+		const uint32_t numGroups = inCount / 4;
+
+		const __m128 centerX = _mm_set1_ps(inCenter.x);
+		const __m128 centerY = _mm_set1_ps(inCenter.y);
+		const __m128 centerZ = _mm_set1_ps(inCenter.z);
+		__m128 maxDistanceSq = _mm_setzero_ps();
+
+		for (uint32_t group = 0; group < numGroups; ++group)
+		{
+			__m128 x, y, z;
+			LoadTransposed(data + group * 12, x, y, z);
+
+			x = _mm_sub_ps(x, centerX);
+			y = _mm_sub_ps(y, centerY);
+			z = _mm_sub_ps(z, centerZ);
+
+			const __m128 distanceSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+			maxDistanceSq = _mm_max_ps(maxDistanceSq, distanceSq);
+		}
+
+		float radiusSq = HorizontalMax(maxDistanceSq);
+		for (uint32_t i = numGroups * 4; i < inCount; ++i)
+		{
+			const glm::vec3 toPosition = inPositions[i] - inCenter;
+			radiusSq = glm::max(radiusSq, glm::dot(toPosition, toPosition));
+		}
+
+		result.Radius = glm::sqrt(radiusSq);
+		return result;
+	}
+
+	AABB ComputeAABBStrided(const float* inVertices, const uint32_t inCount, const uint32_t inStride)
+	{
+		AABB result;
+		for (uint32_t i = 0; i + 3 <= inCount; i += inStride)
+		{
+			result += glm::vec3(inVertices[i], inVertices[i + 1], inVertices[i + 2]);
+		}
+
+		return result;
+	}
+
+	BoundingSphere SphereFromAABB(const AABB& inBounds)
+	{
+		BoundingSphere result;
+
+		glm::vec3 extent;
+		inBounds.GetCenterAndExtent(result.Center, extent);
+		result.Radius = glm::length(extent);
+
+		return result;
+	}
+
+	BoundingSphere TransformSphere(const BoundingSphere& inSphere, const glm::mat4& inMatrix)
+	{
+		const float maxScaleSq = glm::max(glm::max(glm::dot(glm::vec3(inMatrix[0]), glm::vec3(inMatrix[0])), glm::dot(glm::vec3(inMatrix[1]), glm::vec3(inMatrix[1]))),
+			glm::dot(glm::vec3(inMatrix[2]), glm::vec3(inMatrix[2])));
+
+		BoundingSphere result;
+		result.Center = glm::vec3(inMatrix * glm::vec4(inSphere.Center, 1.f));
+		result.Radius = inSphere.Radius * glm::sqrt(maxScaleSq);
+
+		return result;
+	}
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <stdint.h>
+#include "glm/glm.hpp"
+#include "Math/AABB.h"
+
+struct BoundingSphere
+{
+	glm::vec3 Center = glm::vec3(0.f);
+	float Radius = 0.f;
+};
+
+/**
+ * Bounds of vertex positions, computed once when meshes are created.
+ * The packed versions go through the positions 4 at a time with SSE, transposing each group of 4 xyz triplets to
+ * x, y and z registers so every component is handled by the same instructions.
+ */
+namespace MeshBounds
+{
+	AABB ComputeAABB(const glm::vec3* inPositions, const uint32_t inCount);
+
+	// Sphere around the given center reaching the furthest position, the box center gives a tight enough sphere for culling
+	BoundingSphere ComputeSphere(const glm::vec3* inPositions, const uint32_t inCount, const glm::vec3& inCenter);
+
+	// Positions inside interleaved vertices, inStride and inCount being in floats like the basic shapes data
+	AABB ComputeAABBStrided(const float* inVertices, const uint32_t inCount, const uint32_t inStride);
+
+	// Sphere around the box, looser than ComputeSphere but without access to the positions
+	BoundingSphere SphereFromAABB(const AABB& inBounds);
+
+	// Transformed by an affine matrix, the radius growing with the largest axis scale
+	BoundingSphere TransformSphere(const BoundingSphere& inSphere, const glm::mat4& inMatrix);
+}
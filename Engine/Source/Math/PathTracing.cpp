@@ -63,7 +63,7 @@ bool TraceTriangle(const PathTracingRay& inRay, const PathTraceTriangle& inTri,
 	outPayload.Triangle = &inTri;
 	//outPayload.Normal = inTri.WSNormalNormalized;
 
-	return (det >= 1e-6 && outPayload.Distance >= 0.0 && outPayload.U >= 0.0 && outPayload.V >= 0.0 && (outPayload.U + outPayload.V) <= 1.0);
+	return (det >= 1e-6 && outPayload.Distance >= 0.0 && outPayload.Distance <= inRay.MaxDistance && outPayload.U >= 0.0 && outPayload.V >= 0.0 && (outPayload.U + outPayload.V) <= 1.0);
 }
 
 bool IntersectsTriangle(const PathTracingRay& inRay, const PathTraceTriangle& inTri)
@@ -12,6 +12,9 @@ struct PathTracingRay
 {
 	glm::vec3 Origin = glm::vec3(0.f, 0.f, 0.f);
 	glm::vec3 Direction = glm::vec3(0.f, 0.f, 0.f);
+
+	// Hits further away are ignored, used for visibility rays between two points
+	float MaxDistance = INFINITY;
 };
 
 struct PathTracePayload
@@ -34,6 +37,9 @@ struct PathTraceTriangle
 	glm::vec3 WSNormal;
 	glm::vec3 WSNormalNormalized;
 
+	// Index of the object the triangle comes from, set by whoever gathers the triangles
+	uint32_t ObjectIndex = 0;
+
 	void Transform(const glm::mat4& inMatrix);
 	AABB GetBoundingBox() const;
 };
@@ -0,0 +1,75 @@
+#include "Renderer/Baking/AmbientOcclusionBaker.h"
+#include "Renderer/Baking/BakingScene.h"
+#include "Renderer/Baking/BakingUtils.h"
+#include "Renderer/Model/3D/Model3D.h"
+#include "Core/EngineUtils.h"
+#include "Core/TaskSystem.h"
+#include "Math/MathUtils.h"
+#include "EASTL/string.h"
+#include "Utils/PerfUtils.h"
+
+namespace AmbientOcclusionBaker
+{
+	void BakeVertexAO(const BakingScene& inScene, const AmbientOcclusionSettings& inSettings)
+	{
+		BENCH_SCOPE("Vertex AO Bake");
+
+		ASSERT(inScene.IsValid());
+
+		const uint32_t numRays = glm::max(inSettings.NumRays, 1u);
+		uint64_t numVertices = 0;
+
+		for (MeshNode* mesh : inScene.Meshes)
+		{
+			const uint32_t meshVertexCount = static_cast<uint32_t>(mesh->Positions.size());
+			mesh->AmbientOcclusion.resize(meshVertexCount);
+			mesh->BentNormals.resize(meshVertexCount);
+			numVertices += meshVertexCount;
+
+			const glm::mat4 modelMatrix = mesh->GetAbsoluteTransform().GetMatrix();
+			const glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(modelMatrix)));
+			const glm::mat3 worldToLocalNormal = glm::transpose(glm::mat3(modelMatrix));
+
+			TaskSystem::Get().ParallelFor(meshVertexCount, 64, [&](const uint32_t inBegin, const uint32_t inEnd, const uint32_t inWorkerIdx)
+			{
+				for (uint32_t vertexIdx = inBegin; vertexIdx < inEnd; ++vertexIdx)
+				{
+					const glm::vec3 position = glm::vec3(modelMatrix * glm::vec4(mesh->Positions[vertexIdx], 1.f));
+					const glm::vec3 normal = glm::normalize(normalMatrix * mesh->Normals[vertexIdx]);
+
+					// Cranley-Patterson rotation so neighbouring vertices don't share the same ray pattern
+					const uint64_t vertexHash = BakingUtils::HashBytes(&vertexIdx, sizeof(vertexIdx));
+					const glm::vec2 rotation = glm::vec2(float(vertexHash & 0xFFFF), float((vertexHash >> 16) & 0xFFFF)) / 65536.f;
+
+					PathTracingRay ray;
+					ray.Origin = position + normal * inSettings.Bias;
+					ray.MaxDistance = inSettings.MaxDistance;
+
+					uint32_t numUnoccluded = 0;
+					glm::vec3 bentNormal = glm::vec3(0.f);
+
+					for (uint32_t rayIdx = 0; rayIdx < numRays; ++rayIdx)
+					{
+						const glm::vec2 xi = glm::fract(BakingUtils::Hammersley(rayIdx, numRays) + rotation);
+						ray.Direction = BakingUtils::TangentToWorld(BakingUtils::CosineSampleHemisphere(xi), normal);
+
+						if (!inScene.SceneBVH.Intersects(ray))
+						{
+							++numUnoccluded;
+							bentNormal += ray.Direction;
+						}
+					}
+
+					// Cosine distributed rays already weight the visibility by NdotL
+					mesh->AmbientOcclusion[vertexIdx] = float(numUnoccluded) / float(numRays);
+
+					// Bent normals are stored in the local space of the mesh, like the vertex normals
+					const glm::vec3 worldBentNormal = numUnoccluded > 0 ? glm::normalize(bentNormal) : normal;
+					mesh->BentNormals[vertexIdx] = glm::normalize(worldToLocalNormal * worldBentNormal);
+				}
+			});
+		}
+
+		LOG_INFO("Baked ambient occlusion for %llu vertices with %u rays each.", (unsigned long long)numVertices, numRays);
+	}
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include <stdint.h>
+
+struct BakingScene;
+
+struct AmbientOcclusionSettings
+{
+	uint32_t NumRays = 64;
+
+	// Occluders further away than this don't count, in world units
+	float MaxDistance = 1.f;
+
+	// Offset along the normal applied to ray origins
+	float Bias = 0.001f;
+};
+
+/**
+ * Per vertex ambient occlusion and bent normals baked against the BakingScene BVH.
+ * Rays are cosine distributed Hammersley points, rotated per vertex to trade banding for noise, and use any hit queries.
+ * Results are written into MeshNode::AmbientOcclusion and MeshNode::BentNormals, in the same order as the vertices.
+ */
+namespace AmbientOcclusionBaker
+{
+	void BakeVertexAO(const BakingScene& inScene, const AmbientOcclusionSettings& inSettings);
+}
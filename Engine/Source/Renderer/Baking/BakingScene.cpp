@@ -0,0 +1,75 @@
+#include "Renderer/Baking/BakingScene.h"
+#include "Renderer/Model/3D/Model3D.h"
+#include "Scene/Scene.h"
+#include "Utils/PerfUtils.h"
+
+void BakingScene::Build(const Scene& inScene)
+{
+	BuildFromObjects(inScene.GetAllObjects());
+	SceneGeometryVersion = inScene.GetGeometryVersion();
+}
+
+void BakingScene::BuildFromObjects(const eastl::vector<TransformObjPtr>& inObjects)
+{
+	BENCH_SCOPE("Baking Scene Build");
+
+	Meshes.clear();
+	Bounds = AABB();
+	SceneGeometryVersion = 0;
+
+	eastl::vector<PathTraceTriangle> triangles;
+
+	for (const TransformObjPtr& object : inObjects)
+	{
+		object->ForEach_Children_Recursive([&](const TransformObjPtr& inChild)
+		{
+			MeshNode* mesh = dynamic_cast<MeshNode*>(inChild.get());
+			if (mesh && GatherMeshTriangles(*mesh, static_cast<uint32_t>(Meshes.size()), triangles, Bounds))
+			{
+				Meshes.push_back(mesh);
+			}
+		});
+	}
+
+	NumTriangles = static_cast<uint32_t>(triangles.size());
+	LOG_INFO("Baking scene has %u meshes and %u triangles.", static_cast<uint32_t>(Meshes.size()), NumTriangles);
+
+	SceneBVH.Clear();
+	if (NumTriangles > 0)
+	{
+		SceneBVH.Build(triangles);
+	}
+}
+
+bool BakingScene::GatherMeshTriangles(const MeshNode& inMesh, const uint32_t inObjectIndex, eastl::vector<PathTraceTriangle>& outTriangles, AABB& ioBounds)
+{
+	if (inMesh.Indices.empty() || (inMesh.Indices.size() % 3) != 0)
+	{
+		return false;
+	}
+
+	const glm::mat4 modelMatrix = inMesh.GetAbsoluteTransform().GetMatrix();
+
+	for (size_t i = 0; i < inMesh.Indices.size(); i += 3)
+	{
+		glm::vec3 verts[3];
+		for (int32_t j = 0; j < 3; ++j)
+		{
+			verts[j] = glm::vec3(modelMatrix * glm::vec4(inMesh.Positions[inMesh.Indices[i + j]], 1.f));
+			ioBounds += verts[j];
+		}
+
+		// Degenerate triangles would produce NaN normals
+		const glm::vec3 faceNormal = glm::cross(verts[1] - verts[0], verts[2] - verts[0]);
+		if (glm::dot(faceNormal, faceNormal) == 0.f)
+		{
+			continue;
+		}
+
+		PathTraceTriangle triangle(verts);
+		triangle.ObjectIndex = inObjectIndex;
+		outTriangles.push_back(triangle);
+	}
+
+	return true;
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include "EASTL/vector.h"
+#include "Math/AABB.h"
+#include "Math/BVH.h"
+#include "Entity/TransformObject.h"
+
+/**
+ * World space snapshot of the scene geometry used by the CPU bakers.
+ * Every mesh with CPU geometry gets an index, stored in PathTraceTriangle::ObjectIndex,
+ * so ray hits can be traced back to the MeshNode they come from.
+ */
+struct BakingScene
+{
+	void Build(const class Scene& inScene);
+
+	// Only the given objects and their children, eg. a single model at import time
+	void BuildFromObjects(const eastl::vector<TransformObjPtr>& inObjects);
+
+	// Appends the world space triangles of a mesh tagged with the object index, skipping degenerate ones, and grows the bounds
+	// around them. False for meshes without CPU triangles.
+	static bool GatherMeshTriangles(const struct MeshNode& inMesh, const uint32_t inObjectIndex, eastl::vector<PathTraceTriangle>& outTriangles, AABB& ioBounds);
+
+	inline bool IsValid() const { return SceneBVH.IsValid(); }
+
+	// Not const as bakers write their results back into the meshes
+	eastl::vector<struct MeshNode*> Meshes;
+	BVH SceneBVH;
+	AABB Bounds;
+	uint32_t NumTriangles = 0;
+
+	// Scene::GetGeometryVersion at the time of the build, 0 when built from loose objects
+	uint64_t SceneGeometryVersion = 0;
+};
@@ -0,0 +1,139 @@
+#include "Renderer/Baking/BakingUtils.h"
+#include "Math/MathUtils.h"
+
+namespace BakingUtils
+{
+	glm::vec2 Hammersley(const uint32_t inIdx, const uint32_t inNumSamples)
+	{
+		// Radical inverse base 2
+		uint32_t bits = inIdx;
+		bits = (bits << 16u) | (bits >> 16u);
+		bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+		bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+		bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+		bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+
+		const float radicalInverse = float(bits) * 2.3283064365386963e-10f; // / 0x100000000
+
+		return glm::vec2(float(inIdx) / float(inNumSamples), radicalInverse);
+	}
+
+	glm::vec3 ImportanceSampleGGX(const glm::vec2& inXi, const float inAlpha)
+	{
+		// https://cdn2.unrealengine.com/Resources/files/2013SiggraphPresentationsNotes-26915738.pdf
+		const float phi = 2.f * PI * inXi.x;
+		const float cosTheta = glm::sqrt((1.f - inXi.y) / (1.f + (inAlpha * inAlpha - 1.f) * inXi.y));
+		const float sinTheta = glm::sqrt(1.f - cosTheta * cosTheta);
+
+		return glm::vec3(sinTheta * glm::cos(phi), sinTheta * glm::sin(phi), cosTheta);
+	}
+
+	float DistributionGGX(const float inNdotH, const float inAlpha)
+	{
+		const float alpha2 = inAlpha * inAlpha;
+		const float denom = inNdotH * inNdotH * (alpha2 - 1.f) + 1.f;
+
+		return alpha2 / (PI * denom * denom);
+	}
+
+	glm::vec3 CosineSampleHemisphere(const glm::vec2& inXi)
+	{
+		const float phi = 2.f * PI * inXi.x;
+		const float cosTheta = glm::sqrt(1.f - inXi.y);
+		const float sinTheta = glm::sqrt(inXi.y);
+
+		return glm::vec3(sinTheta * glm::cos(phi), sinTheta * glm::sin(phi), cosTheta);
+	}
+
+	glm::vec3 UniformSampleSphere(const glm::vec2& inXi)
+	{
+		const float z = 1.f - 2.f * inXi.x;
+		const float r = glm::sqrt(glm::max(0.f, 1.f - z * z));
+		const float phi = 2.f * PI * inXi.y;
+
+		return glm::vec3(r * glm::cos(phi), r * glm::sin(phi), z);
+	}
+
+	glm::vec3 TangentToWorld(const glm::vec3& inTangentVec, const glm::vec3& inNormal)
+	{
+		const glm::vec3 up = glm::abs(inNormal.y) < 0.999f ? glm::vec3(0.f, 1.f, 0.f) : glm::vec3(1.f, 0.f, 0.f);
+		const glm::vec3 tangent = glm::normalize(glm::cross(up, inNormal));
+		const glm::vec3 bitangent = glm::cross(inNormal, tangent);
+
+		return tangent * inTangentVec.x + bitangent * inTangentVec.y + inNormal * inTangentVec.z;
+	}
+
+	glm::vec3 CubemapTexelToDirection(const uint32_t inX, const uint32_t inY, const uint32_t inFace, const uint32_t inSize)
+	{
+		// Move coordinate to pixel center, remap to 0..1, remap to -1..1
+		const float u = ((inX + 0.5f) / float(inSize)) * 2.0f - 1.0f;
+		// D3D12 v goes top to bottom
+		const float v = -(((inY + 0.5f) / float(inSize)) * 2.0f - 1.0f);
+
+		// https://en.wikipedia.org/wiki/Cube_mapping#/media/File:Cube_map.svg
+		switch (inFace)
+		{
+		case 0:
+			return glm::normalize(glm::vec3(1.0f, v, -u));
+		case 1:
+			return glm::normalize(glm::vec3(-1.0f, v, u));
+		case 2:
+			return glm::normalize(glm::vec3(u, 1.0f, -v));
+		case 3:
+			return glm::normalize(glm::vec3(u, -1.0f, v));
+		case 4:
+			return glm::normalize(glm::vec3(u, v, 1.0f));
+		default:
+			return glm::normalize(glm::vec3(-u, v, -1.0f));
+		}
+	}
+
+	void DirectionToCubemapFaceUV(const glm::vec3& inDir, uint32_t& outFace, glm::vec2& outUV)
+	{
+		const glm::vec3 absDir = glm::abs(inDir);
+		float u = 0.f;
+		float v = 0.f;
+
+		// Pick the major axis and project on its face, inverse of the mapping above
+		if (absDir.x >= absDir.y && absDir.x >= absDir.z)
+		{
+			outFace = inDir.x > 0.f ? 0 : 1;
+			u = inDir.x > 0.f ? -inDir.z / absDir.x : inDir.z / absDir.x;
+			v = inDir.y / absDir.x;
+		}
+		else if (absDir.y >= absDir.z)
+		{
+			outFace = inDir.y > 0.f ? 2 : 3;
+			u = inDir.x / absDir.y;
+			v = inDir.y > 0.f ? -inDir.z / absDir.y : inDir.z / absDir.y;
+		}
+		else
+		{
+			outFace = inDir.z > 0.f ? 4 : 5;
+			u = inDir.z > 0.f ? inDir.x / absDir.z : -inDir.x / absDir.z;
+			v = inDir.y / absDir.z;
+		}
+
+		// Back to 0..1 with v going top to bottom
+		outUV = glm::vec2((u + 1.f) * 0.5f, (1.f - v) * 0.5f);
+	}
+
+	float CubemapTexelSolidAngle(const uint32_t inSize)
+	{
+		return (4.f * PI) / (6.f * float(inSize) * float(inSize));
+	}
+
+	uint64_t HashBytes(const void* inData, const size_t inSize, const uint64_t inSeed)
+	{
+		const uint8_t* bytes = static_cast<const uint8_t*>(inData);
+		uint64_t hash = inSeed;
+
+		for (size_t i = 0; i < inSize; ++i)
+		{
+			hash ^= bytes[i];
+			hash *= 1099511628211ull;
+		}
+
+		return hash;
+	}
+}
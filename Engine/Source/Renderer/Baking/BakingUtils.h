@@ -0,0 +1,37 @@
+#pragma once
+#include <stdint.h>
+#include "glm/glm.hpp"
+
+// Helpers shared by the offline CPU bakers, they have no dependency on the RHI so they can run in headless tools
+namespace BakingUtils
+{
+	// Low discrepancy 2D sequence in [0, 1)
+	glm::vec2 Hammersley(const uint32_t inIdx, const uint32_t inNumSamples);
+
+	// Returns the half vector in tangent space(z up) for a GGX distribution with the given alpha(roughness squared)
+	glm::vec3 ImportanceSampleGGX(const glm::vec2& inXi, const float inAlpha);
+
+	// GGX normal distribution function
+	float DistributionGGX(const float inNdotH, const float inAlpha);
+
+	// Cosine weighted direction in tangent space(z up), pdf is cos(theta) / PI
+	glm::vec3 CosineSampleHemisphere(const glm::vec2& inXi);
+
+	// Uniformly distributed direction on the unit sphere, pdf is 1 / (4 * PI)
+	glm::vec3 UniformSampleSphere(const glm::vec2& inXi);
+
+	// Builds an orthonormal basis around the normal and transforms the tangent space vector into it
+	glm::vec3 TangentToWorld(const glm::vec3& inTangentVec, const glm::vec3& inNormal);
+
+	// Direction through the center of a cubemap texel, faces are in D3D order(+X, -X, +Y, -Y, +Z, -Z)
+	glm::vec3 CubemapTexelToDirection(const uint32_t inX, const uint32_t inY, const uint32_t inFace, const uint32_t inSize);
+
+	// Inverse of CubemapTexelToDirection, outputs the face and its 0..1 UVs with v going top to bottom
+	void DirectionToCubemapFaceUV(const glm::vec3& inDir, uint32_t& outFace, glm::vec2& outUV);
+
+	// Solid angle covered by a texel of the given cubemap face size, approximated as uniform over the face
+	float CubemapTexelSolidAngle(const uint32_t inSize);
+
+	// FNV-1a, used to key cache files by their inputs
+	uint64_t HashBytes(const void* inData, const size_t inSize, const uint64_t inSeed = 14695981039346656037ull);
+}
@@ -0,0 +1,152 @@
+#include "Renderer/Baking/PotentiallyVisibleSet.h"
+#include "Renderer/Baking/BakingScene.h"
+#include "Renderer/Baking/BakingUtils.h"
+#include "Renderer/Model/3D/Model3D.h"
+#include "Core/EngineUtils.h"
+#include "Core/TaskSystem.h"
+#include "EASTL/string.h"
+#include "Utils/PerfUtils.h"
+#include <random>
+#include <bit>
+
+void PotentiallyVisibleSet::Bake(const BakingScene& inScene, const PVSSettings& inSettings)
+{
+	ASSERT(inScene.IsValid());
+
+	int64_t bakeTimeUs = 0;
+	{
+		Utils::BenchmarkCode bench(&bakeTimeUs);
+
+		Bounds = inScene.Bounds;
+		NumMeshes = static_cast<uint32_t>(inScene.Meshes.size());
+		WordsPerCell = (NumMeshes + 63) / 64;
+
+		const glm::vec3 boundsSize = Bounds.Max - Bounds.Min;
+		CellCount = glm::max(glm::uvec3(glm::ceil(boundsSize / glm::max(inSettings.CellSize, glm::vec3(0.01f)))), glm::uvec3(1));
+		CellSize = glm::max(boundsSize / glm::vec3(CellCount), glm::vec3(0.01f));
+
+		const uint32_t numCells = GetNumCells();
+		const uint32_t numSamples = glm::max(inSettings.SamplesPerCell, 8u);
+		const uint32_t numRays = glm::max(inSettings.RaysPerSample, 1u);
+
+		Bits.clear();
+		Bits.resize(size_t(numCells) * WordsPerCell, 0);
+
+		for (uint32_t i = 0; i < NumMeshes; ++i)
+		{
+			inScene.Meshes[i]->PVSIndex = i;
+		}
+
+		TaskSystem::Get().ParallelFor(numCells, 1, [&](const uint32_t inBegin, const uint32_t inEnd, const uint32_t inWorkerIdx)
+		{
+			for (uint32_t cellIdx = inBegin; cellIdx < inEnd; ++cellIdx)
+			{
+				const uint32_t x = cellIdx % CellCount.x;
+				const uint32_t y = (cellIdx / CellCount.x) % CellCount.y;
+				const uint32_t z = cellIdx / (CellCount.x * CellCount.y);
+
+				const glm::vec3 cellMin = Bounds.Min + CellSize * glm::vec3(x, y, z);
+				uint64_t* cellBits = &Bits[size_t(cellIdx) * WordsPerCell];
+
+				// Seeded by cell so bakes are deterministic regardless of scheduling
+				std::mt19937 generator(cellIdx);
+				std::uniform_real_distribution<float> distribution(0.f, 1.f);
+
+				for (uint32_t sampleIdx = 0; sampleIdx < numSamples; ++sampleIdx)
+				{
+					// Corners first, pulled slightly inside the cell so they don't sit exactly on walls aligned with the grid
+					glm::vec3 cellPos;
+					if (sampleIdx < 8)
+					{
+						cellPos = glm::mix(glm::vec3(0.01f), glm::vec3(0.99f), glm::vec3(sampleIdx & 1, (sampleIdx >> 1) & 1, (sampleIdx >> 2) & 1));
+					}
+					else
+					{
+						cellPos = glm::vec3(distribution(generator), distribution(generator), distribution(generator));
+					}
+
+					PathTracingRay ray;
+					ray.Origin = cellMin + CellSize * cellPos;
+
+					// Rotate the direction set per sample so samples don't all shoot the same rays
+					const glm::vec2 rotation = glm::vec2(distribution(generator), distribution(generator));
+
+					for (uint32_t rayIdx = 0; rayIdx < numRays; ++rayIdx)
+					{
+						ray.Direction = BakingUtils::UniformSampleSphere(glm::fract(BakingUtils::Hammersley(rayIdx, numRays) + rotation));
+
+						PathTracePayload payload;
+						if (inScene.SceneBVH.Trace(ray, payload))
+						{
+							const uint32_t meshIdx = payload.Triangle->ObjectIndex;
+							cellBits[meshIdx >> 6] |= 1ull << (meshIdx & 63);
+						}
+					}
+				}
+			}
+		});
+
+		if (inSettings.bDilate)
+		{
+			eastl::vector<uint64_t> dilatedBits(Bits.size(), 0);
+
+			TaskSystem::Get().ParallelFor(numCells, 16, [&](const uint32_t inBegin, const uint32_t inEnd, const uint32_t inWorkerIdx)
+			{
+				for (uint32_t cellIdx = inBegin; cellIdx < inEnd; ++cellIdx)
+				{
+					const glm::ivec3 cell = glm::ivec3(cellIdx % CellCount.x, (cellIdx / CellCount.x) % CellCount.y, cellIdx / (CellCount.x * CellCount.y));
+					const glm::ivec3 minCell = glm::max(cell - glm::ivec3(1), glm::ivec3(0));
+					const glm::ivec3 maxCell = glm::min(cell + glm::ivec3(1), glm::ivec3(CellCount) - glm::ivec3(1));
+
+					uint64_t* dstBits = &dilatedBits[size_t(cellIdx) * WordsPerCell];
+
+					for (int32_t nz = minCell.z; nz <= maxCell.z; ++nz)
+					{
+						for (int32_t ny = minCell.y; ny <= maxCell.y; ++ny)
+						{
+							for (int32_t nx = minCell.x; nx <= maxCell.x; ++nx)
+							{
+								const uint64_t* srcBits = &Bits[size_t(GetCellIndex(nx, ny, nz)) * WordsPerCell];
+								for (uint32_t word = 0; word < WordsPerCell; ++word)
+								{
+									dstBits[word] |= srcBits[word];
+								}
+							}
+						}
+					}
+				}
+			});
+
+			Bits = eastl::move(dilatedBits);
+		}
+
+		uint64_t numVisible = 0;
+		for (const uint64_t word : Bits)
+		{
+			numVisible += std::popcount(word);
+		}
+
+		AverageVisibleFraction = NumMeshes > 0 ? float(double(numVisible) / (double(numCells) * double(NumMeshes))) : 0.f;
+	}
+
+	LastBakeTimeMs = double(bakeTimeUs) * 0.001;
+	LOG_INFO("PVS bake of %u cells for %u meshes took %f ms, %f of the meshes visible per cell on average.", GetNumCells(), NumMeshes, LastBakeTimeMs, AverageVisibleFraction);
+}
+
+const uint64_t* PotentiallyVisibleSet::GetVisibleSet(const glm::vec3& inWorldPos) const
+{
+	if (!IsValid())
+	{
+		return nullptr;
+	}
+
+	const glm::vec3 gridPos = (inWorldPos - Bounds.Min) / CellSize;
+	if (glm::any(glm::lessThan(gridPos, glm::vec3(0.f))) || glm::any(glm::greaterThanEqual(gridPos, glm::vec3(CellCount))))
+	{
+		return nullptr;
+	}
+
+	const glm::uvec3 cell = glm::min(glm::uvec3(gridPos), CellCount - glm::uvec3(1));
+
+	return &Bits[size_t(GetCellIndex(cell.x, cell.y, cell.z)) * WordsPerCell];
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <stdint.h>
+#include "EASTL/vector.h"
+#include "glm/glm.hpp"
+#include "Math/AABB.h"
+
+struct PVSSettings
+{
+	// World size of a visibility cell
+	glm::vec3 CellSize = glm::vec3(2.f);
+
+	// Points inside each cell that rays are cast from, the 8 corners are always included
+	uint32_t SamplesPerCell = 16;
+	uint32_t RaysPerSample = 256;
+
+	// Merges the sets of the 26 neighbour cells into each cell, hides sampling misses and popping when crossing cell borders
+	bool bDilate = true;
+};
+
+/**
+ * Potentially visible set baked offline for enclosed scenes.
+ * The BakingScene bounds are split in a grid of cells and rays are cast from points inside each cell against the BVH,
+ * every mesh hit is marked visible in a per cell bitset. Visibility is sampled so it's not strictly conservative,
+ * dilation covers most of the misses.
+ * Baking assigns MeshNode::PVSIndex, meshes without an index(eg. added after the bake) are always considered visible.
+ */
+class PotentiallyVisibleSet
+{
+public:
+	void Bake(const struct BakingScene& inScene, const PVSSettings& inSettings);
+
+	// Bitset of the cell containing the position, nullptr if the position is outside of the baked cells
+	const uint64_t* GetVisibleSet(const glm::vec3& inWorldPos) const;
+
+	static inline bool IsVisible(const uint64_t* inVisibleSet, const uint32_t inPVSIndex)
+	{
+		return !inVisibleSet || inPVSIndex == uint32_t(-1) || (inVisibleSet[inPVSIndex >> 6] & (1ull << (inPVSIndex & 63))) != 0;
+	}
+
+	inline bool IsValid() const { return !Bits.empty(); }
+	inline uint32_t GetNumMeshes() const { return NumMeshes; }
+	inline uint32_t GetNumCells() const { return CellCount.x * CellCount.y * CellCount.z; }
+	inline float GetAverageVisibleFraction() const { return AverageVisibleFraction; }
+	inline size_t GetMemorySize() const { return Bits.size() * sizeof(uint64_t); }
+	inline double GetLastBakeTimeMs() const { return LastBakeTimeMs; }
+
+private:
+	inline uint32_t GetCellIndex(const uint32_t inX, const uint32_t inY, const uint32_t inZ) const { return inX + (inY * CellCount.x) + (inZ * CellCount.x * CellCount.y); }
+
+private:
+	// Cell major, WordsPerCell 64 bit words for each cell
+	eastl::vector<uint64_t> Bits;
+	AABB Bounds;
+	glm::uvec3 CellCount = glm::uvec3(0);
+	glm::vec3 CellSize = glm::vec3(0.f);
+	uint32_t WordsPerCell = 0;
+	uint32_t NumMeshes = 0;
+	float AverageVisibleFraction = 0.f;
+	double LastBakeTimeMs = 0.0;
+};
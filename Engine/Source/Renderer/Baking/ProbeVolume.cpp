@@ -0,0 +1,288 @@
+#include "Renderer/Baking/ProbeVolume.h"
+#include "Renderer/Baking/BakingScene.h"
+#include "Renderer/Baking/BakingUtils.h"
+#include "Renderer/DrawDebugHelpers.h"
+#include "Core/EngineUtils.h"
+#include "Core/TaskSystem.h"
+#include "Math/MathUtils.h"
+#include "EASTL/string.h"
+#include "Utils/PerfUtils.h"
+#include "Utils/TestUtils.h"
+#include "glm/gtc/packing.hpp"
+
+// Real SH basis constants for the first two bands
+constexpr float SHBasisL0 = 0.282095f;
+constexpr float SHBasisL1 = 0.488603f;
+
+// Max ratio between an L1 coefficient and L0 for a non negative signal
+constexpr float SHMaxL1Ratio = SHBasisL1 / SHBasisL0;
+
+// Offset applied to ray origins on surfaces to avoid hitting the surface itself
+constexpr float RayBias = 0.001f;
+
+// Scene bounds thinner than this along an axis only get one layer of probes along it
+constexpr float MinProbeVolumeSize = 0.001f;
+
+SHL1Color& SHL1Color::operator+=(const SHL1Color& inOther)
+{
+	for (int32_t i = 0; i < 4; ++i)
+	{
+		Coeffs[i] += inOther.Coeffs[i];
+	}
+
+	return *this;
+}
+
+SHL1Color SHL1Color::operator*(const float inScale) const
+{
+	SHL1Color res;
+	for (int32_t i = 0; i < 4; ++i)
+	{
+		res.Coeffs[i] = Coeffs[i] * inScale;
+	}
+
+	return res;
+}
+
+glm::vec3 SHL1Color::EvaluateIrradiance(const glm::vec3& inNormal) const
+{
+	// Convolution with the clamped cosine lobe scales band 0 by PI and band 1 by 2PI/3
+	// https://cseweb.ucsd.edu/~ravir/papers/envmap/envmap.pdf
+	const float A0 = PI;
+	const float A1 = (2.f * PI) / 3.f;
+
+	const glm::vec3 irradiance = Coeffs[0] * (A0 * SHBasisL0)
+		+ Coeffs[1] * (A1 * SHBasisL1 * inNormal.y)
+		+ Coeffs[2] * (A1 * SHBasisL1 * inNormal.z)
+		+ Coeffs[3] * (A1 * SHBasisL1 * inNormal.x);
+
+	return glm::max(irradiance, glm::vec3(0.f));
+}
+
+void QuantizedSHProbe::Encode(const SHL1Color& inSH)
+{
+	for (int32_t channel = 0; channel < 3; ++channel)
+	{
+		const float l0 = glm::max(inSH.Coeffs[0][channel], 0.f);
+		L0[channel] = glm::packHalf1x16(l0);
+
+		// L1 is bounded by L0 for radiance, so it can be stored relative to it with little precision
+		const float invRange = l0 > 0.f ? 1.f / (l0 * SHMaxL1Ratio) : 0.f;
+		for (int32_t band = 0; band < 3; ++band)
+		{
+			const float ratio = glm::clamp(inSH.Coeffs[band + 1][channel] * invRange, -1.f, 1.f);
+			L1[band * 3 + channel] = static_cast<int8_t>(glm::round(ratio * 127.f));
+		}
+	}
+
+	Padding = 0;
+}
+
+SHL1Color QuantizedSHProbe::Decode() const
+{
+	SHL1Color res;
+
+	for (int32_t channel = 0; channel < 3; ++channel)
+	{
+		const float l0 = glm::unpackHalf1x16(L0[channel]);
+		res.Coeffs[0][channel] = l0;
+
+		const float range = l0 * SHMaxL1Ratio / 127.f;
+		for (int32_t band = 0; band < 3; ++band)
+		{
+			res.Coeffs[band + 1][channel] = float(L1[band * 3 + channel]) * range;
+		}
+	}
+
+	return res;
+}
+
+static SHL1Color ProjectRadiance(const glm::vec3& inDir, const glm::vec3& inRadiance)
+{
+	SHL1Color res;
+	res.Coeffs[0] = inRadiance * SHBasisL0;
+	res.Coeffs[1] = inRadiance * (SHBasisL1 * inDir.y);
+	res.Coeffs[2] = inRadiance * (SHBasisL1 * inDir.z);
+	res.Coeffs[3] = inRadiance * (SHBasisL1 * inDir.x);
+
+	return res;
+}
+
+static glm::vec3 ShadeHit(const BakingScene& inScene, const ProbeVolumeSettings& inSettings, const PathTracingRay& inRay, const PathTracePayload& inPayload)
+{
+	const glm::vec3 hitNormal = inPayload.Triangle->WSNormalNormalized;
+	const glm::vec3 hitPos = inRay.Origin + inRay.Direction * inPayload.Distance + hitNormal * RayBias;
+
+	// Single bounce, direct sun with a shadow ray plus unoccluded sky
+	const glm::vec3 toSun = -glm::normalize(inSettings.SunDirection);
+	const float NdotL = glm::dot(hitNormal, toSun);
+
+	glm::vec3 irradiance = inSettings.SkyRadiance * PI;
+	if (NdotL > 0.f)
+	{
+		PathTracingRay shadowRay;
+		shadowRay.Origin = hitPos;
+		shadowRay.Direction = toSun;
+
+		if (!inScene.SceneBVH.Intersects(shadowRay))
+		{
+			irradiance += inSettings.SunIrradiance * NdotL;
+		}
+	}
+
+	return inSettings.SurfaceAlbedo * (1.f / PI) * irradiance;
+}
+
+void ProbeVolume::Bake(const BakingScene& inScene, const ProbeVolumeSettings& inSettings)
+{
+	ASSERT(inScene.IsValid());
+
+	int64_t bakeTimeUs = 0;
+	{
+		Utils::BenchmarkCode bench(&bakeTimeUs);
+
+		ProbeCount = glm::max(inSettings.ProbeCount, glm::uvec3(2));
+		Bounds = inScene.Bounds;
+
+		// Keep probes slightly inside the scene bounds so they don't sit on the outer walls
+		glm::vec3 center, extent;
+		Bounds.GetCenterAndExtent(center, extent);
+		Bounds = AABB();
+		Bounds += center - extent * 0.95f;
+		Bounds += center + extent * 0.95f;
+
+		// Flat axes of the scene get a single layer of probes, with a unit spacing so grid coordinates stay finite
+		const glm::vec3 boundsSize = Bounds.Max - Bounds.Min;
+		for (int32_t axis = 0; axis < 3; ++axis)
+		{
+			if (boundsSize[axis] < MinProbeVolumeSize)
+			{
+				ProbeCount[axis] = 1;
+				ProbeSpacing[axis] = 1.f;
+			}
+			else
+			{
+				ProbeSpacing[axis] = boundsSize[axis] / float(ProbeCount[axis] - 1);
+			}
+		}
+
+		const uint32_t numProbes = ProbeCount.x * ProbeCount.y * ProbeCount.z;
+		const uint32_t numRays = glm::max(inSettings.RaysPerProbe, 1u);
+		const float sampleWeight = (4.f * PI) / float(numRays);
+
+		Probes.resize(numProbes);
+
+		TaskSystem::Get().ParallelFor(numProbes, 4, [&](const uint32_t inBegin, const uint32_t inEnd, const uint32_t inWorkerIdx)
+		{
+			for (uint32_t probeIdx = inBegin; probeIdx < inEnd; ++probeIdx)
+			{
+				const uint32_t x = probeIdx % ProbeCount.x;
+				const uint32_t y = (probeIdx / ProbeCount.x) % ProbeCount.y;
+				const uint32_t z = probeIdx / (ProbeCount.x * ProbeCount.y);
+
+				PathTracingRay ray;
+				ray.Origin = GetProbePosition(x, y, z);
+
+				SHL1Color sh;
+				for (uint32_t rayIdx = 0; rayIdx < numRays; ++rayIdx)
+				{
+					ray.Direction = BakingUtils::UniformSampleSphere(BakingUtils::Hammersley(rayIdx, numRays));
+
+					PathTracePayload payload;
+					const glm::vec3 radiance = inScene.SceneBVH.Trace(ray, payload) ? ShadeHit(inScene, inSettings, ray, payload) : inSettings.SkyRadiance;
+
+					sh += ProjectRadiance(ray.Direction, radiance);
+				}
+
+				Probes[probeIdx].Encode(sh * sampleWeight);
+			}
+		});
+	}
+
+	LastBakeTimeMs = double(bakeTimeUs) * 0.001;
+	LOG_INFO("Probe volume bake of %u probes took %f ms.", static_cast<uint32_t>(Probes.size()), LastBakeTimeMs);
+}
+
+glm::vec3 ProbeVolume::GetProbePosition(const uint32_t inX, const uint32_t inY, const uint32_t inZ) const
+{
+	return Bounds.Min + ProbeSpacing * glm::vec3(inX, inY, inZ);
+}
+
+SHL1Color ProbeVolume::SampleSH(const glm::vec3& inWorldPos) const
+{
+	ASSERT(IsValid());
+
+	// Continuous grid coordinates, the base cell is clamped so the +1 neighbours always exist except along single layer
+	// axes, where the fraction is 0 and the neighbour is clamped back to the layer
+	const glm::uvec3 lastCell = ProbeCount - glm::uvec3(1);
+	const glm::vec3 gridPos = glm::clamp((inWorldPos - Bounds.Min) / ProbeSpacing, glm::vec3(0.f), glm::vec3(lastCell));
+	const glm::uvec3 baseCell = glm::min(glm::uvec3(gridPos), glm::max(ProbeCount, glm::uvec3(2)) - glm::uvec3(2));
+	const glm::vec3 frac = gridPos - glm::vec3(baseCell);
+
+	SHL1Color res;
+	for (uint32_t corner = 0; corner < 8; ++corner)
+	{
+		const glm::uvec3 offset = glm::uvec3(corner & 1, (corner >> 1) & 1, (corner >> 2) & 1);
+		const glm::vec3 weights = glm::mix(glm::vec3(1.f) - frac, frac, glm::vec3(offset));
+		const float weight = weights.x * weights.y * weights.z;
+
+		const glm::uvec3 cell = glm::min(baseCell + offset, lastCell);
+		res += Probes[GetProbeIndex(cell.x, cell.y, cell.z)].Decode() * weight;
+	}
+
+	return res;
+}
+
+double ProbeVolume::BenchmarkLookups(const uint32_t inNumLookups) const
+{
+	if (!IsValid() || inNumLookups == 0)
+	{
+		return 0.0;
+	}
+
+	TestUtils::TestRandom random;
+
+	eastl::vector<glm::vec3> positions(inNumLookups);
+	for (glm::vec3& position : positions)
+	{
+		position = glm::mix(Bounds.Min, Bounds.Max, random.NextVec3());
+	}
+
+	// Accumulated so the lookups can't be optimized away
+	glm::vec3 checksum = glm::vec3(0.f);
+
+	int64_t lookupTimeUs = 0;
+	{
+		Utils::BenchmarkCode bench(&lookupTimeUs);
+
+		for (const glm::vec3& position : positions)
+		{
+			checksum += SampleSH(position).Coeffs[0];
+		}
+	}
+
+	const double nsPerLookup = (double(lookupTimeUs) * 1000.0) / double(inNumLookups);
+	LOG_INFO("Probe volume: %u lookups took %lld us, %f ns per lookup(checksum %f).", inNumLookups, (long long)lookupTimeUs, nsPerLookup, checksum.x + checksum.y + checksum.z);
+
+	return nsPerLookup;
+}
+
+void ProbeVolume::DebugDraw() const
+{
+	const float pointSize = glm::min(ProbeSpacing.x, glm::min(ProbeSpacing.y, ProbeSpacing.z)) * 0.1f;
+
+	for (uint32_t z = 0; z < ProbeCount.z; ++z)
+	{
+		for (uint32_t y = 0; y < ProbeCount.y; ++y)
+		{
+			for (uint32_t x = 0; x < ProbeCount.x; ++x)
+			{
+				const SHL1Color sh = Probes[GetProbeIndex(x, y, z)].Decode();
+
+				// Outgoing radiance of an upwards facing white diffuse surface
+				const glm::vec3 color = glm::clamp(sh.EvaluateIrradiance(glm::vec3(0.f, 1.f, 0.f)) * (1.f / PI), glm::vec3(0.f), glm::vec3(1.f));
+				DrawDebugHelpers::DrawDebugPoint(GetProbePosition(x, y, z), pointSize, color);
+			}
+		}
+	}
+}
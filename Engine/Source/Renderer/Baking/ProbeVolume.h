@@ -0,0 +1,76 @@
+#pragma once
+#include <stdint.h>
+#include "EASTL/vector.h"
+#include "glm/glm.hpp"
+#include "Math/AABB.h"
+
+// L1 spherical harmonics for RGB radiance, coefficients ordered by l * (l + 1) + m
+struct SHL1Color
+{
+	glm::vec3 Coeffs[4] = { glm::vec3(0.f), glm::vec3(0.f), glm::vec3(0.f), glm::vec3(0.f) };
+
+	SHL1Color& operator+=(const SHL1Color& inOther);
+	SHL1Color operator*(const float inScale) const;
+
+	// Cosine convolved lookup, returns irradiance for the given normal
+	glm::vec3 EvaluateIrradiance(const glm::vec3& inNormal) const;
+};
+
+// 16 bytes per probe, half float L0 and the L1 bands stored as signed 8 bit ratios of L0
+struct QuantizedSHProbe
+{
+	uint16_t L0[3];
+	int8_t L1[9];
+	uint8_t Padding;
+
+	void Encode(const SHL1Color& inSH);
+	SHL1Color Decode() const;
+};
+static_assert(sizeof(QuantizedSHProbe) == 16, "Quantized probes are expected to be 16 bytes");
+
+struct ProbeVolumeSettings
+{
+	glm::uvec3 ProbeCount = glm::uvec3(16, 8, 8);
+	uint32_t RaysPerProbe = 256;
+
+	// Lighting used to shade ray hits, a single bounce from the sun plus a constant sky
+	glm::vec3 SunDirection = glm::vec3(1.f, -1.f, 0.f);
+	glm::vec3 SunIrradiance = glm::vec3(3.f);
+	glm::vec3 SkyRadiance = glm::vec3(0.4f, 0.5f, 0.7f);
+	glm::vec3 SurfaceAlbedo = glm::vec3(0.5f);
+};
+
+/**
+ * Grid of irradiance probes baked on the CPU by casting rays against the BakingScene BVH.
+ * Probes are stored quantized and sampled with trilinear interpolation between the 8 closest probes, O(1) per lookup.
+ */
+class ProbeVolume
+{
+public:
+	void Bake(const struct BakingScene& inScene, const ProbeVolumeSettings& inSettings);
+
+	// Interpolated SH at a world position, positions outside of the volume are clamped to it
+	SHL1Color SampleSH(const glm::vec3& inWorldPos) const;
+
+	glm::vec3 GetProbePosition(const uint32_t inX, const uint32_t inY, const uint32_t inZ) const;
+
+	// Times random lookups inside the volume and returns the average cost of one in nanoseconds
+	double BenchmarkLookups(const uint32_t inNumLookups) const;
+
+	void DebugDraw() const;
+
+	inline bool IsValid() const { return !Probes.empty(); }
+	inline const AABB& GetBounds() const { return Bounds; }
+	inline const glm::uvec3& GetProbeCount() const { return ProbeCount; }
+	inline double GetLastBakeTimeMs() const { return LastBakeTimeMs; }
+
+private:
+	inline uint32_t GetProbeIndex(const uint32_t inX, const uint32_t inY, const uint32_t inZ) const { return inX + (inY * ProbeCount.x) + (inZ * ProbeCount.x * ProbeCount.y); }
+
+private:
+	eastl::vector<QuantizedSHProbe> Probes;
+	AABB Bounds;
+	glm::uvec3 ProbeCount = glm::uvec3(0);
+	glm::vec3 ProbeSpacing = glm::vec3(0.f);
+	double LastBakeTimeMs = 0.0;
+};
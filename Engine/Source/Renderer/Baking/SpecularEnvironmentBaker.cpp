@@ -0,0 +1,402 @@
+#include "Renderer/Baking/SpecularEnvironmentBaker.h"
+#include "Renderer/Baking/BakingUtils.h"
+#include "Core/EngineUtils.h"
+#include "Core/TaskSystem.h"
+#include "Math/MathUtils.h"
+#include "Utils/IOUtils.h"
+#include "Utils/PerfUtils.h"
+#include <string.h>
+
+namespace SpecularEnvironmentBaker
+{
+	// Bump when the filtering or the file layout changes, old cache files are then ignored
+	constexpr uint32_t CacheVersion = 1;
+	constexpr uint32_t CacheMagic = 0x45505347; // "GSPE"
+
+	uint32_t GetFullMipCount(const uint32_t inSize)
+	{
+		uint32_t numMips = 1;
+		for (uint32_t size = inSize; size > 1; size /= 2)
+		{
+			++numMips;
+		}
+
+		return numMips;
+	}
+
+	struct CacheHeader
+	{
+		uint32_t Magic;
+		uint32_t Version;
+		uint64_t Hash;
+		uint32_t Size;
+		uint32_t NumMips;
+		uint32_t BRDFLUTSize;
+		uint32_t Padding;
+	};
+
+	// Source cubemap with a box filtered mip chain, sampled with trilinear filtering inside each face
+	struct SourceCubemap
+	{
+		struct Mip
+		{
+			uint32_t Size;
+			eastl::vector<glm::vec4> Texels;
+
+			inline const glm::vec4& Fetch(const uint32_t inFace, const uint32_t inX, const uint32_t inY) const
+			{
+				return Texels[(inFace * Size + inY) * Size + inX];
+			}
+		};
+
+		eastl::vector<Mip> Mips;
+
+		void Init(const glm::vec4* inTexels, const uint32_t inSize)
+		{
+			Mips.resize(GetFullMipCount(inSize));
+
+			Mips[0].Size = inSize;
+			Mips[0].Texels.assign(inTexels, inTexels + (inSize * inSize * 6));
+
+			for (uint32_t mipIdx = 1; mipIdx < Mips.size(); ++mipIdx)
+			{
+				const Mip& prevMip = Mips[mipIdx - 1];
+				Mip& currMip = Mips[mipIdx];
+				currMip.Size = glm::max(prevMip.Size / 2, 1u);
+				currMip.Texels.resize(currMip.Size * currMip.Size * 6);
+
+				for (uint32_t face = 0; face < 6; ++face)
+				{
+					for (uint32_t y = 0; y < currMip.Size; ++y)
+					{
+						for (uint32_t x = 0; x < currMip.Size; ++x)
+						{
+							const uint32_t srcX = glm::min(x * 2, prevMip.Size - 1);
+							const uint32_t srcY = glm::min(y * 2, prevMip.Size - 1);
+							const uint32_t srcX1 = glm::min(srcX + 1, prevMip.Size - 1);
+							const uint32_t srcY1 = glm::min(srcY + 1, prevMip.Size - 1);
+
+							const glm::vec4 sum = prevMip.Fetch(face, srcX, srcY) + prevMip.Fetch(face, srcX1, srcY) + prevMip.Fetch(face, srcX, srcY1) + prevMip.Fetch(face, srcX1, srcY1);
+							currMip.Texels[(face * currMip.Size + y) * currMip.Size + x] = sum * 0.25f;
+						}
+					}
+				}
+			}
+		}
+
+		glm::vec3 SampleBilinear(const uint32_t inMip, const uint32_t inFace, const glm::vec2& inUV) const
+		{
+			const Mip& mip = Mips[inMip];
+
+			// Clamp at face edges, seams are not filtered across faces
+			const float maxCoord = float(mip.Size - 1);
+			const float x = glm::clamp(inUV.x * mip.Size - 0.5f, 0.f, maxCoord);
+			const float y = glm::clamp(inUV.y * mip.Size - 0.5f, 0.f, maxCoord);
+
+			const uint32_t x0 = uint32_t(x);
+			const uint32_t y0 = uint32_t(y);
+			const uint32_t x1 = glm::min(x0 + 1, mip.Size - 1);
+			const uint32_t y1 = glm::min(y0 + 1, mip.Size - 1);
+			const float fracX = x - float(x0);
+			const float fracY = y - float(y0);
+
+			const glm::vec4 top = glm::mix(mip.Fetch(inFace, x0, y0), mip.Fetch(inFace, x1, y0), fracX);
+			const glm::vec4 bottom = glm::mix(mip.Fetch(inFace, x0, y1), mip.Fetch(inFace, x1, y1), fracX);
+
+			return glm::vec3(glm::mix(top, bottom, fracY));
+		}
+
+		glm::vec3 SampleLevel(const glm::vec3& inDir, const float inLod) const
+		{
+			uint32_t face = 0;
+			glm::vec2 uv;
+			BakingUtils::DirectionToCubemapFaceUV(inDir, face, uv);
+
+			const float lod = glm::clamp(inLod, 0.f, float(Mips.size() - 1));
+			const uint32_t lod0 = uint32_t(lod);
+			const uint32_t lod1 = glm::min(lod0 + 1, uint32_t(Mips.size() - 1));
+
+			const glm::vec3 sample0 = SampleBilinear(lod0, face, uv);
+			if (lod0 == lod1)
+			{
+				return sample0;
+			}
+
+			return glm::mix(sample0, SampleBilinear(lod1, face, uv), lod - float(lod0));
+		}
+	};
+
+	// Sample set for one roughness, shared by all texels since N = V = R for the prefiltered lookup
+	struct PrefilterSample
+	{
+		glm::vec3 TangentL;
+		float NdotL;
+		float Lod;
+	};
+
+	void BuildPrefilterSamples(const float inRoughness, const uint32_t inNumSamples, const uint32_t inSourceSize, eastl::vector<PrefilterSample>& outSamples)
+	{
+		outSamples.clear();
+		outSamples.reserve(inNumSamples);
+
+		const float alpha = inRoughness * inRoughness;
+		const float texelSolidAngle = BakingUtils::CubemapTexelSolidAngle(inSourceSize);
+
+		for (uint32_t i = 0; i < inNumSamples; ++i)
+		{
+			const glm::vec3 H = BakingUtils::ImportanceSampleGGX(BakingUtils::Hammersley(i, inNumSamples), alpha);
+
+			// Reflect the view(tangent space z) around H
+			const glm::vec3 L = 2.f * H.z * H - glm::vec3(0.f, 0.f, 1.f);
+			if (L.z <= 0.f)
+			{
+				continue;
+			}
+
+			// https://developer.nvidia.com/gpugems/gpugems3/part-iii-rendering/chapter-20-gpu-based-importance-sampling
+			// With N = V the pdf of L is D * NdotH / (4 * VdotH) = D / 4
+			// Sampling a lower mip with the footprint of the sample removes most of the noise for low sample counts
+			float lod = 0.f;
+			if (inRoughness > 0.f)
+			{
+				const float pdf = BakingUtils::DistributionGGX(H.z, alpha) * 0.25f;
+				const float sampleSolidAngle = 1.f / (float(inNumSamples) * pdf + 0.0001f);
+				lod = glm::max(0.5f * glm::log2(sampleSolidAngle / texelSolidAngle) + 1.f, 0.f);
+			}
+
+			outSamples.push_back({ L, L.z, lod });
+		}
+	}
+
+	float MipToRoughness(const uint32_t inMip, const uint32_t inNumMips)
+	{
+		return inNumMips > 1 ? float(inMip) / float(inNumMips - 1) : 0.f;
+	}
+
+	float GeometrySchlickGGX(const float inNdotV, const float inRoughness)
+	{
+		// k remapping for IBL
+		const float k = (inRoughness * inRoughness) / 2.f;
+
+		return inNdotV / (inNdotV * (1.f - k) + k);
+	}
+
+	void BakeBRDFLUT(const uint32_t inSize, const uint32_t inNumSamples, eastl::vector<glm::vec2>& outLUT)
+	{
+		outLUT.resize(inSize * inSize);
+
+		TaskSystem::Get().ParallelFor(inSize, 4, [&](const uint32_t inBegin, const uint32_t inEnd, const uint32_t inWorkerIdx)
+		{
+			for (uint32_t y = inBegin; y < inEnd; ++y)
+			{
+				const float roughness = (y + 0.5f) / float(inSize);
+				const float alpha = roughness * roughness;
+
+				for (uint32_t x = 0; x < inSize; ++x)
+				{
+					const float NdotV = (x + 0.5f) / float(inSize);
+					const glm::vec3 V = glm::vec3(glm::sqrt(1.f - NdotV * NdotV), 0.f, NdotV);
+
+					float scale = 0.f;
+					float bias = 0.f;
+
+					for (uint32_t i = 0; i < inNumSamples; ++i)
+					{
+						const glm::vec3 H = BakingUtils::ImportanceSampleGGX(BakingUtils::Hammersley(i, inNumSamples), alpha);
+						const float VdotH = glm::dot(V, H);
+						const glm::vec3 L = 2.f * VdotH * H - V;
+
+						const float NdotL = glm::clamp(L.z, 0.f, 1.f);
+						const float NdotH = glm::clamp(H.z, 0.f, 1.f);
+
+						if (NdotL > 0.f)
+						{
+							const float G = GeometrySchlickGGX(NdotV, roughness) * GeometrySchlickGGX(NdotL, roughness);
+							const float GVis = (G * glm::max(VdotH, 0.f)) / (NdotH * NdotV);
+							const float Fc = glm::pow(1.f - glm::max(VdotH, 0.f), 5.f);
+
+							scale += (1.f - Fc) * GVis;
+							bias += Fc * GVis;
+						}
+					}
+
+					outLUT[y * inSize + x] = glm::vec2(scale, bias) / float(inNumSamples);
+				}
+			}
+		});
+	}
+
+	uint64_t ComputeHash(const glm::vec4* inSourceTexels, const uint32_t inSourceSize, const BakeSettings& inSettings)
+	{
+		uint64_t hash = BakingUtils::HashBytes(&CacheVersion, sizeof(CacheVersion));
+		hash = BakingUtils::HashBytes(&inSourceSize, sizeof(inSourceSize), hash);
+		hash = BakingUtils::HashBytes(&inSettings, sizeof(inSettings), hash);
+		hash = BakingUtils::HashBytes(inSourceTexels, sizeof(glm::vec4) * inSourceSize * inSourceSize * 6, hash);
+
+		return hash;
+	}
+
+	void Bake(const glm::vec4* inSourceTexels, const uint32_t inSourceSize, const BakeSettings& inSettings, PrefilteredEnvironment& outEnvironment)
+	{
+		BENCH_SCOPE("Specular Environment Bake");
+
+		ASSERT(inSourceTexels != nullptr && inSourceSize > 0);
+
+		SourceCubemap source;
+		source.Init(inSourceTexels, inSourceSize);
+
+		const uint32_t maxMips = GetFullMipCount(inSettings.OutputSize);
+
+		outEnvironment.Size = inSettings.OutputSize;
+		outEnvironment.NumMips = glm::clamp(inSettings.NumMips, 1u, maxMips);
+		outEnvironment.Hash = ComputeHash(inSourceTexels, inSourceSize, inSettings);
+
+		// Offsets of each mip inside a face, faces are laid out one after the other
+		eastl::vector<uint32_t> mipOffsets(outEnvironment.NumMips);
+		uint32_t faceTexelCount = 0;
+		for (uint32_t mipIdx = 0; mipIdx < outEnvironment.NumMips; ++mipIdx)
+		{
+			const uint32_t mipSize = glm::max(outEnvironment.Size >> mipIdx, 1u);
+			mipOffsets[mipIdx] = faceTexelCount;
+			faceTexelCount += mipSize * mipSize;
+		}
+
+		outEnvironment.Texels.resize(faceTexelCount * 6);
+
+		eastl::vector<PrefilterSample> samples;
+		for (uint32_t mipIdx = 0; mipIdx < outEnvironment.NumMips; ++mipIdx)
+		{
+			const uint32_t mipSize = glm::max(outEnvironment.Size >> mipIdx, 1u);
+			const float roughness = MipToRoughness(mipIdx, outEnvironment.NumMips);
+
+			BuildPrefilterSamples(roughness, roughness > 0.f ? inSettings.NumSamples : 1, inSourceSize, samples);
+
+			// One batch is a handful of rows of one face
+			TaskSystem::Get().ParallelFor(mipSize * 6, 2, [&](const uint32_t inBegin, const uint32_t inEnd, const uint32_t inWorkerIdx)
+			{
+				for (uint32_t row = inBegin; row < inEnd; ++row)
+				{
+					const uint32_t face = row / mipSize;
+					const uint32_t y = row % mipSize;
+					glm::vec4* dstRow = &outEnvironment.Texels[face * faceTexelCount + mipOffsets[mipIdx] + y * mipSize];
+
+					for (uint32_t x = 0; x < mipSize; ++x)
+					{
+						const glm::vec3 N = BakingUtils::CubemapTexelToDirection(x, y, face, mipSize);
+
+						glm::vec3 prefiltered = glm::vec3(0.f);
+						float totalWeight = 0.f;
+
+						for (const PrefilterSample& sample : samples)
+						{
+							const glm::vec3 L = BakingUtils::TangentToWorld(sample.TangentL, N);
+
+							prefiltered += source.SampleLevel(L, sample.Lod) * sample.NdotL;
+							totalWeight += sample.NdotL;
+						}
+
+						dstRow[x] = glm::vec4(prefiltered / glm::max(totalWeight, 0.0001f), 1.f);
+					}
+				}
+			});
+		}
+
+		outEnvironment.BRDFLUTSize = inSettings.BRDFLUTSize;
+		BakeBRDFLUT(inSettings.BRDFLUTSize, inSettings.BRDFLUTSamples, outEnvironment.BRDFLUT);
+	}
+
+	eastl::string GetCachePath(const uint64_t inHash)
+	{
+		eastl::string path;
+		path.sprintf("../Data/Cache/IBL/SpecularEnv_%016llx.bin", (unsigned long long)inHash);
+
+		return path;
+	}
+
+	bool TryLoadFromCache(const eastl::string& inCachePath, const uint64_t inHash, PrefilteredEnvironment& outEnvironment)
+	{
+		eastl::vector<uint8_t> fileData;
+		if (!IOUtils::TryReadBinaryFile(inCachePath, fileData) || fileData.size() < sizeof(CacheHeader))
+		{
+			return false;
+		}
+
+		CacheHeader header;
+		memcpy(&header, fileData.data(), sizeof(header));
+
+		if (header.Magic != CacheMagic || header.Version != CacheVersion || header.Hash != inHash)
+		{
+			LOG_WARNING("Specular environment cache %s is stale, rebaking.", inCachePath.c_str());
+			return false;
+		}
+
+		size_t faceTexelCount = 0;
+		for (uint32_t mipIdx = 0; mipIdx < header.NumMips; ++mipIdx)
+		{
+			const size_t mipSize = glm::max(header.Size >> mipIdx, 1u);
+			faceTexelCount += mipSize * mipSize;
+		}
+
+		const size_t texelsSize = faceTexelCount * 6 * sizeof(glm::vec4);
+		const size_t lutSize = size_t(header.BRDFLUTSize) * header.BRDFLUTSize * sizeof(glm::vec2);
+		if (fileData.size() != sizeof(CacheHeader) + texelsSize + lutSize)
+		{
+			LOG_WARNING("Specular environment cache %s is truncated, rebaking.", inCachePath.c_str());
+			return false;
+		}
+
+		outEnvironment.Size = header.Size;
+		outEnvironment.NumMips = header.NumMips;
+		outEnvironment.BRDFLUTSize = header.BRDFLUTSize;
+		outEnvironment.Hash = header.Hash;
+
+		outEnvironment.Texels.resize(faceTexelCount * 6);
+		memcpy(outEnvironment.Texels.data(), fileData.data() + sizeof(CacheHeader), texelsSize);
+
+		outEnvironment.BRDFLUT.resize(size_t(header.BRDFLUTSize) * header.BRDFLUTSize);
+		memcpy(outEnvironment.BRDFLUT.data(), fileData.data() + sizeof(CacheHeader) + texelsSize, lutSize);
+
+		return true;
+	}
+
+	bool SaveToCache(const eastl::string& inCachePath, const PrefilteredEnvironment& inEnvironment)
+	{
+		CacheHeader header = {};
+		header.Magic = CacheMagic;
+		header.Version = CacheVersion;
+		header.Hash = inEnvironment.Hash;
+		header.Size = inEnvironment.Size;
+		header.NumMips = inEnvironment.NumMips;
+		header.BRDFLUTSize = inEnvironment.BRDFLUTSize;
+
+		const size_t texelsSize = inEnvironment.Texels.size() * sizeof(glm::vec4);
+		const size_t lutSize = inEnvironment.BRDFLUT.size() * sizeof(glm::vec2);
+
+		eastl::vector<uint8_t> fileData(sizeof(CacheHeader) + texelsSize + lutSize);
+		memcpy(fileData.data(), &header, sizeof(header));
+		memcpy(fileData.data() + sizeof(CacheHeader), inEnvironment.Texels.data(), texelsSize);
+		memcpy(fileData.data() + sizeof(CacheHeader) + texelsSize, inEnvironment.BRDFLUT.data(), lutSize);
+
+		return IOUtils::WriteBinaryFile(inCachePath, fileData.data(), fileData.size());
+	}
+
+	bool LoadOrBake(const glm::vec4* inSourceTexels, const uint32_t inSourceSize, const BakeSettings& inSettings, PrefilteredEnvironment& outEnvironment)
+	{
+		const uint64_t hash = ComputeHash(inSourceTexels, inSourceSize, inSettings);
+		const eastl::string cachePath = GetCachePath(hash);
+
+		if (TryLoadFromCache(cachePath, hash, outEnvironment))
+		{
+			return true;
+		}
+
+		Bake(inSourceTexels, inSourceSize, inSettings, outEnvironment);
+
+		if (!SaveToCache(cachePath, outEnvironment))
+		{
+			LOG_WARNING("Failed to write specular environment cache %s.", cachePath.c_str());
+		}
+
+		return false;
+	}
+}
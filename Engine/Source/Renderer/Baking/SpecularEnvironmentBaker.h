@@ -0,0 +1,55 @@
+#pragma once
+#include <stdint.h>
+#include "EASTL/vector.h"
+#include "EASTL/string.h"
+#include "glm/glm.hpp"
+
+/**
+ * CPU baker for the split sum approximation of image based specular lighting.
+ * Takes any HDR cubemap and produces a GGX prefiltered mip chain(roughness increasing linearly with the mip)
+ * together with the environment BRDF LUT. It has no RHI dependency, so it can be run offline by tools,
+ * and results are cached on disk keyed by a hash of the input texels and the settings.
+ */
+namespace SpecularEnvironmentBaker
+{
+	struct BakeSettings
+	{
+		uint32_t OutputSize = 128;
+		uint32_t NumMips = 6;
+		uint32_t NumSamples = 256;
+		uint32_t BRDFLUTSize = 128;
+		uint32_t BRDFLUTSamples = 512;
+	};
+
+	struct PrefilteredEnvironment
+	{
+		uint32_t Size = 0;
+		uint32_t NumMips = 0;
+
+		// RGBA float texels laid out face major, mip minor, matching the D3D12 subresource order
+		eastl::vector<glm::vec4> Texels;
+
+		uint32_t BRDFLUTSize = 0;
+
+		// Scale and bias applied to F0, x is NdotV and y is roughness
+		eastl::vector<glm::vec2> BRDFLUT;
+
+		uint64_t Hash = 0;
+	};
+
+	// Roughness that the given mip was filtered with, mip 0 is a perfect mirror
+	float MipToRoughness(const uint32_t inMip, const uint32_t inNumMips);
+
+	uint64_t ComputeHash(const glm::vec4* inSourceTexels, const uint32_t inSourceSize, const BakeSettings& inSettings);
+
+	// Source texels are RGBA float, 6 faces of inSourceSize squared texels in D3D face order
+	void Bake(const glm::vec4* inSourceTexels, const uint32_t inSourceSize, const BakeSettings& inSettings, PrefilteredEnvironment& outEnvironment);
+
+	bool TryLoadFromCache(const eastl::string& inCachePath, const uint64_t inHash, PrefilteredEnvironment& outEnvironment);
+	bool SaveToCache(const eastl::string& inCachePath, const PrefilteredEnvironment& inEnvironment);
+
+	eastl::string GetCachePath(const uint64_t inHash);
+
+	// Returns true if the result came from the cache
+	bool LoadOrBake(const glm::vec4* inSourceTexels, const uint32_t inSourceSize, const BakeSettings& inSettings, PrefilteredEnvironment& outEnvironment);
+}
@@ -0,0 +1,271 @@
+#include "Renderer/DrawPacket.h"
+#include "Core/TaskSystem.h"
+#include "Renderer/Model/3D/Model3D.h"
+#include "Renderer/Baking/PotentiallyVisibleSet.h"
+#include "Scene/Scene.h"
+#include "Utils/RadixSort.h"
+#include "EASTL/string.h"
+#include "Utils/PerfUtils.h"
+#include "Utils/TestUtils.h"
+
+static constexpr uint32_t PipelineShift = 60;
+static constexpr uint32_t MaterialShift = 44;
+static constexpr uint32_t GeometryShift = 24;
+static constexpr uint64_t MaterialMask = (1ull << 16) - 1;
+static constexpr uint64_t GeometryMask = (1ull << 20) - 1;
+static constexpr uint64_t DepthMask = (1ull << 24) - 1;
+
+// Larger than any valid key as the pipeline never uses all 4 bits, skipped packets end up last and get dropped
+static constexpr uint64_t SkippedKey = ~0ull;
+
+uint64_t DrawPacketList::MakeSortKey(const EDrawPipeline inPipeline, const uint32_t inMaterial, const void* inVertexBuffer, const void* inIndexBuffer, const float inDepth01)
+{
+	// Buffers are heap allocations so their low bits carry no information, the top bits of the product are the best mixed
+	const uint64_t vertexBufferBits = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(inVertexBuffer) >> 4);
+	const uint64_t indexBufferBits = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(inIndexBuffer) >> 4);
+	const uint64_t geometryHash = (vertexBufferBits ^ (indexBufferBits << 21)) * 0x9E3779B97F4A7C15ull;
+	const uint64_t depth = static_cast<uint64_t>(glm::clamp(inDepth01, 0.f, 1.f) * static_cast<float>(DepthMask));
+
+	return (static_cast<uint64_t>(inPipeline) << PipelineShift) | ((inMaterial & MaterialMask) << MaterialShift) |
+		(((geometryHash >> 44) & GeometryMask) << GeometryShift) | (depth & DepthMask);
+}
+
+void DrawPacketList::Build(const eastl::vector<SceneMeshRenderable>& inRenderables, const EDrawPipeline inPipeline, const bool inSortByMaterial, const DrawPacketView& inView,
+	const uint64_t* inVisibleSet)
+{
+	const uint32_t count = static_cast<uint32_t>(inRenderables.size());
+	Packets.resize(count);
+	SortEntries.resize(count);
+
+	if (count == 0)
+	{
+		return;
+	}
+
+	const float invMaxDepth = inView.MaxDepth > 0.f ? 1.f / inView.MaxDepth : 0.f;
+
+	TaskSystem::Get().ParallelFor(count, 256, [&](const uint32_t inBegin, const uint32_t inEnd, const uint32_t inWorkerIdx)
+	{
+		for (uint32_t i = inBegin; i < inEnd; ++i)
+		{
+			const SceneMeshRenderable& renderable = inRenderables[i];
+			const MeshNode* mesh = renderable.Mesh;
+			DrawSortEntry& entry = SortEntries[i];
+			entry.PacketIndex = i;
+
+			if (mesh->MatIndex == uint32_t(-1) || renderable.Materials->size() == 0 || !PotentiallyVisibleSet::IsVisible(inVisibleSet, mesh->PVSIndex))
+			{
+				entry.Key = SkippedKey;
+				continue;
+			}
+
+			DrawPacket& packet = Packets[i];
+			packet.VertexBuffer = mesh->VertexBuffer.get();
+			packet.IndexBuffer = mesh->IndexBuffer.get();
+			packet.Object = mesh;
+			packet.IndexCount = static_cast<uint32_t>(mesh->IndexBuffer->IndexCount);
+			packet.MaterialIndex = mesh->MatIndex;
+			packet.InstanceSlot = renderable.InstanceSlot;
+
+			const float depth = glm::dot(mesh->GetWorldBoundingSphere().Center - inView.Position, inView.Forward) * invMaxDepth;
+			entry.Key = MakeSortKey(inPipeline, inSortByMaterial ? mesh->MatIndex : 0, packet.VertexBuffer, packet.IndexBuffer, depth);
+		}
+	});
+}
+
+void DrawPacketList::Sort()
+{
+	RadixSort::Sort(SortEntries, SortScratch, [](const DrawSortEntry& inEntry) { return inEntry.Key; });
+
+	while (!SortEntries.empty() && SortEntries.back().Key == SkippedKey)
+	{
+		SortEntries.pop_back();
+	}
+}
+
+static inline bool SameBatchState(const DrawPacket& inFirst, const DrawPacket& inOther, const bool inMatchMaterial)
+{
+	return inFirst.VertexBuffer == inOther.VertexBuffer && inFirst.IndexBuffer == inOther.IndexBuffer && inFirst.IndexCount == inOther.IndexCount &&
+		(!inMatchMaterial || inFirst.MaterialIndex == inOther.MaterialIndex);
+}
+
+void DrawPacketList::BuildBatches(const bool inMatchMaterial, const uint32_t inMaxInstances)
+{
+	Batches.clear();
+	NumInstances = glm::min(GetNumPackets(), inMaxInstances);
+
+	for (uint32_t i = 0; i < NumInstances; ++i)
+	{
+		if (!Batches.empty() && SameBatchState(GetSortedPacket(Batches.back().FirstInstance), GetSortedPacket(i), inMatchMaterial))
+		{
+			++Batches.back().NumInstances;
+			continue;
+		}
+
+		DrawBatch batch;
+		batch.FirstInstance = i;
+		batch.NumInstances = 1;
+		Batches.push_back(batch);
+	}
+}
+
+void DrawPacketList::PackInstances(uint32_t* outSlots) const
+{
+	for (uint32_t i = 0; i < NumInstances; ++i)
+	{
+		outSlots[i] = GetSortedPacket(i).InstanceSlot;
+	}
+}
+
+void DrawPacketList::CreateBenchmarkPackets(const uint32_t inNumPackets, eastl::vector<float>& outDepths)
+{
+	TestUtils::TestRandom random;
+
+	// Props repeating a small set of meshes, each with its own material, the buffers being fake addresses
+	const uint32_t numGeometries = glm::max(inNumPackets / 100, 1u);
+	constexpr uint32_t numMaterials = 64;
+
+	Packets.resize(inNumPackets);
+	outDepths.resize(inNumPackets);
+	for (uint32_t i = 0; i < inNumPackets; ++i)
+	{
+		const uint32_t geometryIndex = glm::min(static_cast<uint32_t>(random.Next() * numGeometries), numGeometries - 1);
+		const uintptr_t geometry = 0x10000 + (static_cast<uintptr_t>(geometryIndex) << 8);
+
+		DrawPacket& packet = Packets[i];
+		packet.VertexBuffer = reinterpret_cast<const RHIVertexBuffer*>(geometry);
+		packet.IndexBuffer = reinterpret_cast<const RHIIndexBuffer*>(geometry + 0x80);
+		packet.IndexCount = 36 + 3 * geometryIndex;
+		packet.MaterialIndex = geometryIndex % numMaterials;
+		packet.InstanceSlot = i;
+		outDepths[i] = random.Next();
+	}
+}
+
+void DrawPacketList::BuildBenchmarkKeys(const eastl::vector<float>& inDepths)
+{
+	const uint32_t numPackets = static_cast<uint32_t>(Packets.size());
+	SortEntries.resize(numPackets);
+	TaskSystem::Get().ParallelFor(numPackets, 256, [&](const uint32_t inBegin, const uint32_t inEnd, const uint32_t inWorkerIdx)
+	{
+		for (uint32_t i = inBegin; i < inEnd; ++i)
+		{
+			const DrawPacket& packet = Packets[i];
+			SortEntries[i].Key = MakeSortKey(EDrawPipeline::GBufferMesh, packet.MaterialIndex, packet.VertexBuffer, packet.IndexBuffer, inDepths[i]);
+			SortEntries[i].PacketIndex = i;
+		}
+	});
+}
+
+void DrawPacketList::Benchmark(const uint32_t inNumPackets, const uint32_t inNumFrames)
+{
+	if (inNumPackets == 0 || inNumFrames == 0)
+	{
+		return;
+	}
+
+	DrawPacketList list;
+	eastl::vector<float> depths;
+	list.CreateBenchmarkPackets(inNumPackets, depths);
+
+	const auto countStateChanges = [&list](const bool inSorted)
+	{
+		uint32_t numChanges = 0;
+		const DrawPacket* previous = nullptr;
+		for (uint32_t i = 0; i < list.Packets.size(); ++i)
+		{
+			const DrawPacket& packet = inSorted ? list.GetSortedPacket(i) : list.Packets[i];
+			if (!previous || previous->VertexBuffer != packet.VertexBuffer || previous->IndexBuffer != packet.IndexBuffer || previous->MaterialIndex != packet.MaterialIndex)
+			{
+				++numChanges;
+			}
+
+			previous = &packet;
+		}
+
+		return numChanges;
+	};
+
+	int64_t keysUs = 0;
+	int64_t sortUs = 0;
+	int64_t batchUs = 0;
+	for (uint32_t frame = 0; frame < inNumFrames; ++frame)
+	{
+		int64_t frameKeysUs = 0;
+		{
+			Utils::BenchmarkCode bench(&frameKeysUs);
+			list.BuildBenchmarkKeys(depths);
+		}
+
+		int64_t frameSortUs = 0;
+		{
+			Utils::BenchmarkCode bench(&frameSortUs);
+			list.Sort();
+		}
+
+		int64_t frameBatchUs = 0;
+		{
+			Utils::BenchmarkCode bench(&frameBatchUs);
+			list.BuildBatches(true);
+		}
+
+		keysUs += frameKeysUs;
+		sortUs += frameSortUs;
+		batchUs += frameBatchUs;
+	}
+
+	LOG_INFO("Draw packets(%u packets, %u workers): keys %f ms, radix sort %f ms, batching %f ms per frame, state changes %u unsorted and %u sorted.",
+		inNumPackets, TaskSystem::Get().GetNumWorkers(), keysUs * 1e-3 / inNumFrames, sortUs * 1e-3 / inNumFrames, batchUs * 1e-3 / inNumFrames, countStateChanges(false), countStateChanges(true));
+	LOG_INFO("Draw packets: %u instanced draws for %u packets(%f KB of instance slots).", static_cast<uint32_t>(list.Batches.size()),
+		inNumPackets, GetInstanceDataSize(list.GetNumInstances()) / 1024.0);
+}
+
+void DrawPacketList::RunChecks()
+{
+	constexpr uint32_t numPackets = 10000;
+
+	DrawPacketList list;
+	eastl::vector<float> depths;
+	list.CreateBenchmarkPackets(numPackets, depths);
+	list.BuildBenchmarkKeys(depths);
+	list.Sort();
+	list.BuildBatches(true);
+
+	{
+		TestUtils::CheckScope check("Draw packet keys in sorted order");
+		for (uint32_t i = 1; i < list.SortEntries.size(); ++i)
+		{
+			check.Expect(list.SortEntries[i - 1].Key <= list.SortEntries[i].Key);
+		}
+	}
+
+	// Batches have to cover every packet in order, each only holding packets it can draw as instances of its first one
+	{
+		TestUtils::CheckScope check("Draw batches covering the sorted packets");
+		uint32_t nextInstance = 0;
+		for (const DrawBatch& batch : list.Batches)
+		{
+			bool bValid = batch.FirstInstance == nextInstance && batch.NumInstances > 0;
+			for (uint32_t i = 1; bValid && i < batch.NumInstances; ++i)
+			{
+				bValid = SameBatchState(list.GetSortedPacket(batch.FirstInstance), list.GetSortedPacket(batch.FirstInstance + i), true);
+			}
+
+			check.Expect(bValid);
+			nextInstance = batch.FirstInstance + batch.NumInstances;
+		}
+		check.Expect(nextInstance == list.GetNumInstances() && list.GetNumInstances() == numPackets);
+	}
+
+	// Each packet has the slot of its index, the packed slots have to follow the sorted order
+	{
+		eastl::vector<uint32_t> instanceSlots(list.GetNumInstances());
+		list.PackInstances(instanceSlots.data());
+
+		TestUtils::CheckScope check("Draw packet instance slots in sorted order");
+		for (uint32_t i = 0; i < instanceSlots.size(); ++i)
+		{
+			check.Expect(instanceSlots[i] == list.SortEntries[i].PacketIndex);
+		}
+	}
+}
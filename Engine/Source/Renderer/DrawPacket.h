@@ -0,0 +1,96 @@
+#pragma once
+#include <stdint.h>
+#include "EASTL/vector.h"
+#include "glm/glm.hpp"
+
+struct SceneMeshRenderable;
+
+// Pipelines drawing packets, they go first in the sort key so each one is bound once
+enum class EDrawPipeline : uint8_t
+{
+	GBufferMesh = 0,
+	ShadowDepth,
+	Count
+};
+
+// Everything needed to record a draw, without any API state
+struct DrawPacket
+{
+	const class RHIVertexBuffer* VertexBuffer = nullptr;
+	const class RHIIndexBuffer* IndexBuffer = nullptr;
+	const class DrawableObject* Object = nullptr;
+	uint32_t IndexCount = 0;
+	uint32_t MaterialIndex = 0;
+	uint32_t InstanceSlot = 0;
+};
+
+// Sorting is done on these instead of the packets themselves to move less memory around
+struct DrawSortEntry
+{
+	uint64_t Key = 0;
+	uint32_t PacketIndex = 0;
+};
+
+// Consecutive sorted packets drawing the same geometry with the same material, recorded as a single instanced draw.
+// Instances are packed in sorted order so the batch's instance slots start at its first sorted packet.
+struct DrawBatch
+{
+	uint32_t FirstInstance = 0;
+	uint32_t NumInstances = 0;
+};
+
+// Packets get sorted front to back along Forward inside each state bucket, a MaxDepth of 0 leaves depth out of the key
+struct DrawPacketView
+{
+	glm::vec3 Position = glm::vec3(0.f);
+	glm::vec3 Forward = glm::vec3(0.f, 0.f, 1.f);
+	float MaxDepth = 0.f;
+};
+
+/**
+ * Draws of a pass gathered before any command gets recorded.
+ * Each packet gets a 64 bit key, from the highest bits: pipeline(4), material(16), geometry(20) and depth(24), so sorting
+ * the keys puts the draws sharing state next to each other and the translator only has to record what changes between them.
+ * Geometry is a hash of the vertex and index buffers, collisions only cost an extra state change.
+ * Building and sorting run on the TaskSystem and don't touch the GPU.
+ * After sorting, runs of packets sharing buffers and material are merged into batches, each recorded as one instanced draw
+ * reading its per object data from the scene instance buffer through the slots packed by PackInstances.
+ */
+class DrawPacketList
+{
+public:
+	static uint64_t MakeSortKey(const EDrawPipeline inPipeline, const uint32_t inMaterial, const void* inVertexBuffer, const void* inIndexBuffer, const float inDepth01);
+
+	// Renderables without a material are skipped, along with the ones not in the optional baked potentially visible set
+	void Build(const eastl::vector<SceneMeshRenderable>& inRenderables, const EDrawPipeline inPipeline, const bool inSortByMaterial, const DrawPacketView& inView,
+		const uint64_t* inVisibleSet = nullptr);
+	void Sort();
+
+	// Merges the first inMaxInstances sorted packets into batches, the material is ignored for pipelines reading it per instance
+	void BuildBatches(const bool inMatchMaterial, const uint32_t inMaxInstances = uint32_t(-1));
+
+	// Writes the instance buffer slot of every batched packet, outSlots needs GetInstanceDataSize(GetNumInstances()) bytes
+	void PackInstances(uint32_t* outSlots) const;
+	static inline uint64_t GetInstanceDataSize(const uint32_t inNumInstances) { return static_cast<uint64_t>(inNumInstances) * sizeof(uint32_t); }
+
+	inline uint32_t GetNumPackets() const { return static_cast<uint32_t>(SortEntries.size()); }
+	inline const DrawPacket& GetSortedPacket(const uint32_t inIndex) const { return Packets[SortEntries[inIndex].PacketIndex]; }
+	inline const eastl::vector<DrawBatch>& GetBatches() const { return Batches; }
+	inline uint32_t GetNumInstances() const { return NumInstances; }
+
+	// Times building keys, sorting and batching packets of repeated props and logs the state changes and draws left
+	static void Benchmark(const uint32_t inNumPackets, const uint32_t inNumFrames);
+
+	// Asserts sorted keys are in order, batches cover the sorted packets with compatible state and the packed slots follow them
+	static void RunChecks();
+
+private:
+	void CreateBenchmarkPackets(const uint32_t inNumPackets, eastl::vector<float>& outDepths);
+	void BuildBenchmarkKeys(const eastl::vector<float>& inDepths);
+
+	eastl::vector<DrawPacket> Packets;
+	eastl::vector<DrawSortEntry> SortEntries;
+	eastl::vector<DrawSortEntry> SortScratch;
+	eastl::vector<DrawBatch> Batches;
+	uint32_t NumInstances = 0;
+};
@@ -1,4 +1,5 @@
 #include "Renderer/Drawable/Drawable.h"
+#include "Core/TaskSystem.h"
 
 DrawableObject::DrawableObject(const eastl::string& inDrawableName)
 	: TransformObject(inDrawableName)
@@ -6,3 +7,69 @@ DrawableObject::DrawableObject(const eastl::string& inDrawableName)
 
 }
 DrawableObject::~DrawableObject() = default;
+
+BoundingSphere DrawableObject::GetLocalBoundingSphere() const
+{
+	AABB localBounds;
+	return GetLocalBounds(localBounds) ? MeshBounds::SphereFromAABB(localBounds) : BoundingSphere();
+}
+
+void DrawableObject::ComputeWorldBounds(const glm::mat4& inWorldMatrix, AABB& outBounds, BoundingSphere& outSphere) const
+{
+	AABB localBounds;
+	if (GetLocalBounds(localBounds))
+	{
+		outBounds = localBounds.Transformed(inWorldMatrix);
+		outSphere = MeshBounds::TransformSphere(GetLocalBoundingSphere(), inWorldMatrix);
+	}
+}
+
+bool DrawableObject::UpdateWorldBounds() const
+{
+	// Reading the matrix first brings the world transform, and so its version, up to date
+	const glm::mat4 worldMatrix = GetAbsoluteMatrix();
+	const uint32_t worldVersion = GetWorldVersion();
+	if (worldVersion == WorldBoundsVersion)
+	{
+		return true;
+	}
+
+	// Other workers may be reading the cache
+	if (TaskSystem::IsInsideTask())
+	{
+		return false;
+	}
+
+	ComputeWorldBounds(worldMatrix, WorldBounds, WorldSphere);
+	WorldBoundsVersion = worldVersion;
+
+	return true;
+}
+
+AABB DrawableObject::GetWorldBounds() const
+{
+	if (UpdateWorldBounds())
+	{
+		return WorldBounds;
+	}
+
+	AABB bounds;
+	BoundingSphere sphere;
+	ComputeWorldBounds(GetAbsoluteMatrix(), bounds, sphere);
+
+	return bounds;
+}
+
+BoundingSphere DrawableObject::GetWorldBoundingSphere() const
+{
+	if (UpdateWorldBounds())
+	{
+		return WorldSphere;
+	}
+
+	AABB bounds;
+	BoundingSphere sphere;
+	ComputeWorldBounds(GetAbsoluteMatrix(), bounds, sphere);
+
+	return sphere;
+}
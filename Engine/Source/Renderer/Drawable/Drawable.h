@@ -1,6 +1,8 @@
 #pragma once
 #include "glm/ext/matrix_float4x4.hpp"
 #include "Entity/TransformObject.h"
+#include "Math/AABB.h"
+#include "Math/MeshBounds.h"
 #include "EASTL/unordered_map.h"
 
 class DrawableObject : public TransformObject
@@ -9,11 +11,51 @@ public:
 	DrawableObject(const eastl::string& inDrawableName);
 	virtual ~DrawableObject();
 
-	virtual glm::mat4 GetModelMatrix() const { return GetAbsoluteTransform().GetMatrix(); }
+	virtual glm::mat4 GetModelMatrix() const { return GetAbsoluteMatrix(); }
 
 	inline void SetVisible(const bool inValue) { bIsVisible = inValue; }
 	inline bool IsVisible() const { return bIsVisible; }
 
+	// Bounds in the object's own space, false for objects without any which can then never be culled
+	virtual bool GetLocalBounds(AABB& outBounds) const { return false; }
+	virtual BoundingSphere GetLocalBoundingSphere() const;
+
+	// Cached with the world transform version they were computed from and only recomputed once it moved.
+	// Parallel tasks never write the cache, stale bounds are computed again on each read there. Scene::UpdateSpatialIndex
+	// refreshes the cache of the objects in the scene every frame, before the passes.
+	AABB GetWorldBounds() const;
+	BoundingSphere GetWorldBoundingSphere() const;
+
+private:
+	// False if the cache is stale and can't be refreshed from the calling thread
+	bool UpdateWorldBounds() const;
+	void ComputeWorldBounds(const glm::mat4& inWorldMatrix, AABB& outBounds, BoundingSphere& outSphere) const;
+
 private:
 	bool bIsVisible{ true };
+
+	mutable AABB WorldBounds;
+	mutable BoundingSphere WorldSphere;
+	mutable uint32_t WorldBoundsVersion = uint32_t(-1);
+
+	// Proxy in the scene bounds tree, with the world transform version and bounds center it was last moved with
+	int32_t SpatialProxy = -1;
+	uint32_t SpatialWorldVersion = 0;
+	glm::vec3 SpatialCenter = glm::vec3(0.f);
+
+	friend class Scene;
+};
+
+// Projected on the GBuffer inside its oriented box, the scale being the box size
+class DecalObject : public DrawableObject
+{
+public:
+	DecalObject(const eastl::string& inName)
+		: DrawableObject(inName) {}
+
+	bool GetLocalBounds(AABB& outBounds) const override
+	{
+		outBounds = AABB(glm::vec3(-1.f), glm::vec3(1.f));
+		return true;
+	}
 };
@@ -34,6 +34,8 @@ void CubeShape::Init(ID3D12GraphicsCommandList* inCommandList)
 
 	Materials.push_back(newMat);
 	cubeNode->MatIndex = 0;
+	cubeNode->LocalBounds = MeshBounds::ComputeAABBStrided(BasicShapesData::GetCubeVertices(), BasicShapesData::GetCubeVerticesCount(), 8);
+	cubeNode->LocalSphere = MeshBounds::SphereFromAABB(cubeNode->LocalBounds);
 
 	AddChild(cubeNode);
 }
@@ -72,6 +74,8 @@ void TBNQuadShape::Init(ID3D12GraphicsCommandList* inCommandList)
 
 	Materials.push_back(newMat);
 	quadNode->MatIndex = 0;
+	quadNode->LocalBounds = MeshBounds::ComputeAABBStrided(BasicShapesData::GetTBNQuadVertices(), BasicShapesData::GetTBNQuadVerticesCount(), 14);
+	quadNode->LocalSphere = MeshBounds::SphereFromAABB(quadNode->LocalBounds);
 
 	AddChild(quadNode);
 }
@@ -11,6 +11,8 @@
 #include "Renderer/RHI/D3D12/D3D12Resources.h"
 #include <d3d12.h>
 #include "EASTL/set.h"
+#include "Renderer/Baking/BakingScene.h"
+#include "Renderer/Baking/AmbientOcclusionBaker.h"
 
 static Transform aiMatrixToTransform(const aiMatrix4x4& inMatrix)
 {
@@ -46,6 +48,17 @@ void AssimpModel3D::LoadModelToRoot(const eastl::string inPath, TransformObjPtr
 void AssimpModel3D::Init(ID3D12GraphicsCommandList* inCommandList)
 {
 	LoadModelToRoot(ModelPath, shared_from_this(), inCommandList);
+
+	if (bBakeVertexAO)
+	{
+		BakingScene modelScene;
+		modelScene.BuildFromObjects({ shared_from_this() });
+
+		if (modelScene.IsValid())
+		{
+			AmbientOcclusionBaker::BakeVertexAO(modelScene, AmbientOcclusionSettings());
+		}
+	}
 }
 
 eastl::shared_ptr<MeshNode> AssimpModel3D::LoadData(ID3D12GraphicsCommandList* inCommandList)
@@ -126,10 +139,14 @@ void AssimpModel3D::ProcessMesh(const aiMesh& inMesh, const aiScene& inScene, ea
 
 	eastl::shared_ptr<D3D12IndexBuffer> indexBuffer;
 	eastl::shared_ptr<D3D12VertexBuffer> vertexBuffer;
+	eastl::vector<glm::vec3> positions;
+	eastl::vector<glm::vec3> normals;
+	eastl::vector<uint32_t> indices;
 
 	{
 		eastl::vector<Vertex> vertices;
-		eastl::vector<uint32_t> indices;
+		positions.reserve(inMesh.mNumVertices);
+		normals.reserve(inMesh.mNumVertices);
 
 		for (uint32_t i = 0; i < inMesh.mNumVertices; i++)
 		{
@@ -165,6 +182,8 @@ void AssimpModel3D::ProcessMesh(const aiMesh& inMesh, const aiScene& inScene, ea
 			}
 
 			vertices.push_back(vert);
+			positions.push_back(vert.Position);
+			normals.push_back(vert.Normal);
 		}
 
 		for (uint32_t i = 0; i < inMesh.mNumFaces; i++)
@@ -188,6 +207,11 @@ void AssimpModel3D::ProcessMesh(const aiMesh& inMesh, const aiScene& inScene, ea
 	newMesh->IndexBuffer = indexBuffer;
 	newMesh->VertexBuffer = vertexBuffer;
 	newMesh->MatIndex = inMesh.mMaterialIndex;
+	newMesh->LocalBounds = MeshBounds::ComputeAABB(positions.data(), static_cast<uint32_t>(positions.size()));
+	newMesh->LocalSphere = MeshBounds::ComputeSphere(positions.data(), static_cast<uint32_t>(positions.size()), newMesh->LocalBounds.Min + newMesh->LocalBounds.GetExtent());
+	newMesh->Positions = eastl::move(positions);
+	newMesh->Normals = eastl::move(normals);
+	newMesh->Indices = eastl::move(indices);
 	//newMesh->Textures = textures;
 
 	inCurrentNode->AddChild(newMesh);
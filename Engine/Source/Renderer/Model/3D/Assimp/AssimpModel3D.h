@@ -15,6 +15,9 @@ public:
 
 	void Init(struct ID3D12GraphicsCommandList* inCommandList) override;
 
+	// Bakes per vertex AO against the model's own geometry once it is loaded
+	inline void SetBakeVertexAO(const bool inValue) { bBakeVertexAO = inValue; }
+
 protected:
 	eastl::shared_ptr<MeshNode> LoadData(struct ID3D12GraphicsCommandList* inCommandList);
 	void ProcessMaterials(const struct aiScene& inScene, struct ID3D12GraphicsCommandList* inCommandList);
@@ -28,4 +31,5 @@ private:
 	eastl::string ModelDir;
 	eastl::string ModelPath;
 	glm::vec3 OverrideColor = glm::vec3(0.f, 0.f, 0.f);
+	bool bBakeVertexAO = false;
 };
\ No newline at end of file
@@ -6,6 +6,12 @@ MeshNode::MeshNode(const eastl::string& inName)
 
 }
 
+bool MeshNode::GetLocalBounds(AABB& outBounds) const
+{
+	outBounds = LocalBounds;
+	return LocalBounds.IsValid();
+}
+
 Model3D::Model3D(const eastl::string& inModelName)
 	: TransformObject(inModelName)
 {}
@@ -9,6 +9,9 @@ struct MeshMaterial
 	eastl::shared_ptr<D3D12Texture2D> AlbedoMap;
 	eastl::shared_ptr<D3D12Texture2D> NormalMap;
 	eastl::shared_ptr<D3D12Texture2D> MRMap;
+
+	// Meshes with an alpha masked albedo have holes the depth doesn't see, like foliage or chains
+	inline bool IsAlphaMasked() const { return AlbedoMap && AlbedoMap->bHasZeroAlpha; }
 };
 
 // MeshNodes are stored as TransformObject children to the main Model3D
@@ -18,10 +21,33 @@ struct MeshNode : public DrawableObject
 	MeshNode(const eastl::string& inName);
 	virtual ~MeshNode() = default;
 
+	bool GetLocalBounds(AABB& outBounds) const override;
+	BoundingSphere GetLocalBoundingSphere() const override { return LocalSphere; }
+
 	eastl::shared_ptr<D3D12VertexBuffer> VertexBuffer;
 	eastl::shared_ptr<D3D12IndexBuffer> IndexBuffer;
 	//eastl::vector<eastl::shared_ptr<D3D12Texture2D>> Textures;
 	uint32_t MatIndex = uint32_t(-1);
+
+	// Computed when the mesh is created, invalid if its vertices were never seen on the CPU
+	AABB LocalBounds;
+	BoundingSphere LocalSphere;
+
+	// Local space copy of the geometry kept on the CPU for the offline bakers
+	eastl::vector<glm::vec3> Positions;
+	eastl::vector<glm::vec3> Normals;
+	eastl::vector<uint32_t> Indices;
+
+	// Optional simplified geometry rasterized instead of the mesh for occlusion culling, it has to stay inside of the mesh
+	eastl::vector<glm::vec3> OccluderPositions;
+	eastl::vector<uint32_t> OccluderIndices;
+
+	// Per vertex baked data, empty until a bake ran
+	eastl::vector<float> AmbientOcclusion;
+	eastl::vector<glm::vec3> BentNormals;
+
+	// Bit in the baked potentially visible set, -1 if the mesh was not part of the bake
+	uint32_t PVSIndex = uint32_t(-1);
 };
 
 class Model3D : public TransformObject
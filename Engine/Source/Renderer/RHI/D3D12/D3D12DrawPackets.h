@@ -0,0 +1,60 @@
+#pragma once
+#include <d3d12.h>
+#include "Renderer/DrawPacket.h"
+#include "Renderer/RHI/D3D12/D3D12Resources.h"
+
+struct DrawTranslationStats
+{
+	uint32_t NumDraws = 0;
+	uint32_t NumInstances = 0;
+	uint32_t NumVertexBufferSets = 0;
+	uint32_t NumIndexBufferSets = 0;
+};
+
+/**
+ * Records the batches of sorted draw packets into a command list, one instanced draw per batch.
+ * The vertex and index buffers are only set when they differ from the previous batch, the pass binds everything shared by
+ * its draws beforehand, including the scene instance buffer and the instance slots packed by DrawPacketList::PackInstances.
+ * SV_InstanceID starts at 0 for every draw, so the batch's first instance goes through a root constant.
+ */
+namespace D3D12DrawPackets
+{
+	inline DrawTranslationStats Record(ID3D12GraphicsCommandList* inCmdList, const DrawPacketList& inPackets, const uint32_t inFirstInstanceRootIndex)
+	{
+		DrawTranslationStats stats;
+
+		const RHIVertexBuffer* currentVertexBuffer = nullptr;
+		const RHIIndexBuffer* currentIndexBuffer = nullptr;
+
+		inCmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+
+		for (const DrawBatch& batch : inPackets.GetBatches())
+		{
+			const DrawPacket& packet = inPackets.GetSortedPacket(batch.FirstInstance);
+
+			if (packet.VertexBuffer != currentVertexBuffer)
+			{
+				const D3D12_VERTEX_BUFFER_VIEW vbView = static_cast<const D3D12VertexBuffer*>(packet.VertexBuffer)->VBView();
+				inCmdList->IASetVertexBuffers(0, 1, &vbView);
+				currentVertexBuffer = packet.VertexBuffer;
+				++stats.NumVertexBufferSets;
+			}
+
+			if (packet.IndexBuffer != currentIndexBuffer)
+			{
+				const D3D12_INDEX_BUFFER_VIEW ibView = static_cast<const D3D12IndexBuffer*>(packet.IndexBuffer)->IBView();
+				inCmdList->IASetIndexBuffer(&ibView);
+				currentIndexBuffer = packet.IndexBuffer;
+				++stats.NumIndexBufferSets;
+			}
+
+			inCmdList->SetGraphicsRoot32BitConstant(inFirstInstanceRootIndex, batch.FirstInstance, 0);
+
+			inCmdList->DrawIndexedInstanced(packet.IndexCount, batch.NumInstances, 0, 0, 0);
+			++stats.NumDraws;
+			stats.NumInstances += batch.NumInstances;
+		}
+
+		return stats;
+	}
+}
@@ -96,7 +96,7 @@ public:
 	eastl::shared_ptr<class D3D12VertexBuffer> CreateVertexBuffer(const class VertexInputLayout& inLayout, const float* inVertices, const int32_t inCount, eastl::shared_ptr<class D3D12IndexBuffer> inIndexBuffer = nullptr);
 
 	void UpdateTexture2D(eastl::shared_ptr<D3D12Texture2D>& inTexture, const uint32_t* inData, const uint32_t inWidth, const uint32_t inHeight, ID3D12GraphicsCommandList* inCommandList);
-	eastl::shared_ptr<class D3D12Texture2D> CreateTexture2D(const uint32_t inWidth, const uint32_t inHeight, const DXGI_FORMAT inFormat, ID3D12GraphicsCommandList* inCommandList, const eastl::wstring& inName, const void* inData = nullptr, const bool bIsCubemap = false);
+	eastl::shared_ptr<class D3D12Texture2D> CreateTexture2D(const uint32_t inWidth, const uint32_t inHeight, const DXGI_FORMAT inFormat, ID3D12GraphicsCommandList* inCommandList, const eastl::wstring& inName, const void* inData = nullptr, const bool bIsCubemap = false, const uint32_t inNumMips = 1);
 
 	eastl::shared_ptr<class D3D12Texture2D> CreateAndLoadTexture2D(const eastl::string& inDataPath, const bool inSRGB, const bool bGenerateMipMaps, struct ID3D12GraphicsCommandList* inCommandList);
 
@@ -403,7 +403,7 @@ void D3D12RHI::UpdateTexture2D(eastl::shared_ptr<D3D12Texture2D>& inTexture, con
 	D3D12Upload::ResourceUploadEnd(uploadcontext);
 }
 
-eastl::shared_ptr<D3D12Texture2D> D3D12RHI::CreateTexture2D(const uint32_t inWidth, const uint32_t inHeight, const DXGI_FORMAT inFormat, ID3D12GraphicsCommandList* inCommandList, const eastl::wstring& inName, const void* inData, const bool bIsCubemap)
+eastl::shared_ptr<D3D12Texture2D> D3D12RHI::CreateTexture2D(const uint32_t inWidth, const uint32_t inHeight, const DXGI_FORMAT inFormat, ID3D12GraphicsCommandList* inCommandList, const eastl::wstring& inName, const void* inData, const bool bIsCubemap, const uint32_t inNumMips)
 {
 	eastl::shared_ptr<D3D12Texture2D> newTexture = eastl::make_shared<D3D12Texture2D>();
 
@@ -411,7 +411,7 @@ eastl::shared_ptr<D3D12Texture2D> D3D12RHI::CreateTexture2D(const uint32_t inWid
 
 	// Describe and create the Texture on GPU(Default Heap)
 	D3D12_RESOURCE_DESC textureDesc = {};
-	textureDesc.MipLevels = 1u;
+	textureDesc.MipLevels = (uint16_t)inNumMips;
 	textureDesc.Format = inFormat;
 	textureDesc.Width = inWidth;
 	textureDesc.Height = inHeight;
@@ -436,7 +436,14 @@ eastl::shared_ptr<D3D12Texture2D> D3D12RHI::CreateTexture2D(const uint32_t inWid
 	srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
 	srvDesc.Format = textureDesc.Format;
 	srvDesc.ViewDimension = bIsCubemap ? D3D12_SRV_DIMENSION_TEXTURECUBE : D3D12_SRV_DIMENSION_TEXTURE2D;
-	srvDesc.Texture2D.MipLevels = 1u;
+	if (bIsCubemap)
+	{
+		srvDesc.TextureCube.MipLevels = inNumMips;
+	}
+	else
+	{
+		srvDesc.Texture2D.MipLevels = inNumMips;
+	}
 
 	D3D12DescHeapAllocationDesc descAllocation = D3D12Globals::GlobalSRVHeap.AllocatePersistent();
 	newTexture->SRVIndex = descAllocation.Index;
@@ -447,9 +454,10 @@ eastl::shared_ptr<D3D12Texture2D> D3D12RHI::CreateTexture2D(const uint32_t inWid
 
 	if (inData != nullptr)
 	{
-		// Get required size by device
+		// Get required size by device, for all faces and mips
+		const uint32_t numSubresources = textureDesc.DepthOrArraySize * inNumMips;
 		UINT64 uploadBufferSize = 0;
-		D3D12Globals::Device->GetCopyableFootprints(&textureDesc, 0, 1, 0, nullptr, nullptr, nullptr, &uploadBufferSize);
+		D3D12Globals::Device->GetCopyableFootprints(&textureDesc, 0, numSubresources, 0, nullptr, nullptr, nullptr, &uploadBufferSize);
 		// Same thing
 		//const UINT64 uploadBufferSize = GetRequiredIntermediateSize(textureHandle, 0, 1);
 
@@ -458,7 +466,7 @@ eastl::shared_ptr<D3D12Texture2D> D3D12RHI::CreateTexture2D(const uint32_t inWid
 
 		// Add buffer regions commands to Cmdlist
 		//UploadTextureRaw(texResource, inData, uploadcontext, inWidth, inHeight);
-		UploadTexture(texResource, inWidth, inHeight, inFormat, 1, inData, uploadcontext, bIsCubemap);
+		UploadTexture(texResource, inWidth, inHeight, inFormat, inNumMips, inData, uploadcontext, bIsCubemap);
 
 
 		D3D12Utility::TransitionResource(uploadcontext.CmdList, texResource, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_COMMON);
@@ -470,7 +478,7 @@ eastl::shared_ptr<D3D12Texture2D> D3D12RHI::CreateTexture2D(const uint32_t inWid
 	// Transition from copy dest to shader resource
 	//D3D12Utility::TransitionResource(inCommandList, texResource, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 
-	newTexture->NumMips = 1u;
+	newTexture->NumMips = inNumMips;
 	newTexture->ChannelsType = ERHITextureChannelsType::RGBA;
 	newTexture->NrChannels = 4;
 	newTexture->Height = textureDesc.Height;
@@ -503,6 +511,24 @@ eastl::shared_ptr<D3D12Texture2D> D3D12RHI::CreateAndLoadTexture2D(const eastl::
 
 	ENSURE(success);
 
+	// Alpha is the fourth byte of the 32 bit formats the texture gets uploaded as
+	if (success && DirectX::HasAlpha(dxMetadata.format) && DirectX::BitsPerPixel(dxMetadata.format) == 32)
+	{
+		const DirectX::Image& baseImage = *dxImage.GetImage(0, 0, 0);
+		for (size_t y = 0; y < baseImage.height && !newTexture->bHasZeroAlpha; ++y)
+		{
+			const uint8_t* row = baseImage.pixels + y * baseImage.rowPitch;
+			for (size_t x = 0; x < baseImage.width; ++x)
+			{
+				if (row[x * 4 + 3] == 0)
+				{
+					newTexture->bHasZeroAlpha = true;
+					break;
+				}
+			}
+		}
+	}
+
 	DirectX::ScratchImage* finalImage = &dxImage;
 
 	DirectX::ScratchImage mipMapRes;
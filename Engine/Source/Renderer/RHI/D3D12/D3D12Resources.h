@@ -40,6 +40,9 @@ class D3D12Texture2D : public RHITexture2D
 public:
 	ID3D12Resource* Resource = nullptr;
 	uint32_t SRVIndex = -1;
+
+	// Some texel of the loaded image has zero alpha, which the mesh pass discards
+	bool bHasZeroAlpha = false;
 };
 
 // Texture that can be updated each frame
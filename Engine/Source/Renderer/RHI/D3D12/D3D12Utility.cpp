@@ -164,6 +164,20 @@ D3D12_HEAP_PROPERTIES& D3D12Utility::GetUploadHeapProps()
 	return UploadHeapProps;
 }
 
+D3D12_HEAP_PROPERTIES& D3D12Utility::GetReadbackHeapProps()
+{
+	static D3D12_HEAP_PROPERTIES ReadbackHeapProps
+	{
+		D3D12_HEAP_TYPE_READBACK,
+		D3D12_CPU_PAGE_PROPERTY_UNKNOWN,
+		D3D12_MEMORY_POOL_UNKNOWN,
+		0,
+		0
+	};
+
+	return ReadbackHeapProps;
+}
+
 D3D12_ROOT_SIGNATURE_FLAGS D3D12Utility::GetDefaultRootSignatureFlags()
 {
 	D3D12_ROOT_SIGNATURE_FLAGS rootSignatureFlags =
@@ -66,6 +66,7 @@ namespace D3D12Utility
 
 	D3D12_HEAP_PROPERTIES& GetDefaultHeapProps();
 	D3D12_HEAP_PROPERTIES& GetUploadHeapProps();
+	D3D12_HEAP_PROPERTIES& GetReadbackHeapProps();
 	D3D12_ROOT_SIGNATURE_FLAGS GetDefaultRootSignatureFlags();
 	D3D12_ROOT_SIGNATURE_FLAGS GetBindlessRootSignatureFlags();
 
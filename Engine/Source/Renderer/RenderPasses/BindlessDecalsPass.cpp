@@ -11,17 +11,16 @@
 #include "imgui.h"
 #include <d3d12.h>
 #include "Math/MathUtils.h"
+#include "Renderer/RenderView.h"
+#include "Renderer/Visibility/ClusteredBinning.h"
+#include "Utils/ImGuiUtils.h"
+#include "Utils/PerfUtils.h"
 
 
-class DecalObj : public DrawableObject
+static const eastl::vector<DecalObject*>& GetSceneDecals()
 {
-public:
-	DecalObj(const eastl::string& inName)
-		: DrawableObject(inName) {
-	}
-};
-
-eastl::vector<eastl::shared_ptr<DecalObj>> SceneDecals;
+	return SceneManager::Get().GetCurrentScene().GetDecals();
+}
 
 D3D12StructuredBuffer m_DecalsBuffer;
 D3D12RawBuffer m_DecalsTiledBinningBuffer;
@@ -29,6 +28,18 @@ eastl::shared_ptr<D3D12RenderTarget2D> m_DebugRT;
 
 glm::vec<2, uint32_t> TileComputeGroupCounts;
 
+// CPU reference for the tiled binning, off unless enabled from the UI
+ClusteredBinning m_DecalClusters;
+bool bCPUClusteredBinning = false;
+
+// Copies of the tiled binning buffer and the masks the CPU clusters give each tile, one per frame in flight.
+// Read back once the GPU is done with the frame that wrote them.
+ID3D12Resource* m_DecalsBinningReadback[D3D12Utility::NumFramesInFlight] = {};
+eastl::vector<uint32_t> m_CPUTileDecalMasks[D3D12Utility::NumFramesInFlight];
+bool bBinningReadbackPending[D3D12Utility::NumFramesInFlight] = {};
+uint32_t NumComparedTiles = 0;
+uint32_t NumMismatchedTiles = 0;
+
 // TODO: Send this to the shaders through the compiler defines
 #define TILE_SIZE 16
 
@@ -40,33 +51,24 @@ ID3D12PipelineState* m_DecalPipelineState;
 ID3D12PipelineState* m_TiledBinningPipelineState;
 
 
-struct DecalConstantBuffer
+// Root constants, the camera matrices come from the RenderView
+struct DecalConstants
 {
-	glm::mat4 Projection;
-	glm::mat4 View;
-	glm::mat4 InvViewProj;
 	uint32_t NumDecals;
 	glm::vec<2, uint32_t> NumWorkGroups;
-
-	float Padding[13];
 };
-static_assert((sizeof(DecalConstantBuffer) % 256) == 0, "Constant Buffer size must be 256-byte aligned");
+static_assert(sizeof(DecalConstants) == 3 * sizeof(uint32_t), "Root constants have to match the HLSL packing");
 
 
-struct DecalTilingConstantBuffer
+struct DecalTilingConstants
 {
-	glm::mat4 Projection;
-	glm::mat4 View;
-	glm::mat4 InvViewProj;
 	uint32_t NumDecals;
 	glm::vec<2, uint32_t> NumWorkGroups;
 	uint32_t DebugFlag;
 	glm::vec4 DebugValue;
 	glm::vec4 DebugQuat;
-
-	float Padding[4];
 };
-static_assert((sizeof(DecalTilingConstantBuffer) % 256) == 0, "Constant Buffer size must be 256-byte aligned");
+static_assert(sizeof(DecalTilingConstants) == 12 * sizeof(uint32_t), "Root constants have to match the HLSL packing");
 
 
 struct ShaderDecal
@@ -80,6 +82,26 @@ struct ShaderDecal
 
 static_assert((sizeof(ShaderDecal) % 16) == 0, "Structs in Structured Buffers have to be 16-byte aligned");
 
+// Scene decals as the shaders read them, gathered once per frame
+eastl::vector<ShaderDecal> m_ShaderDecals;
+
+static void GatherShaderDecals()
+{
+	m_ShaderDecals.clear();
+	for (const DecalObject* decal : GetSceneDecals())
+	{
+		const Transform absTrans = decal->GetAbsoluteTransform();
+
+		ShaderDecal& newDecal = m_ShaderDecals.push_back();
+		newDecal.Orientation = glm::vec4(absTrans.Rotation.x, absTrans.Rotation.y, absTrans.Rotation.z, absTrans.Rotation.w);
+		newDecal.Position = absTrans.Translation;
+		newDecal.Size = absTrans.Scale;
+
+		newDecal.AlbedoMapIdx = 13;
+		newDecal.NormalMapIdx = 21;
+	}
+}
+
 BindlessDecalsPass::BindlessDecalsPass() = default;
 BindlessDecalsPass::~BindlessDecalsPass() = default;
 
@@ -87,14 +109,14 @@ void BindlessDecalsPass::Init()
 {
 	// Decal Pass Signature
 	{
-		D3D12_ROOT_PARAMETER1 rootParameters[5];
+		D3D12_ROOT_PARAMETER1 rootParameters[6];
 
-		// 0. Main CBV_SRV_UAV heap
-		// 1. Structured Buffer
+		// 0. Structured Buffer
+		// 1. Binning Buffer
 		// 2. Depth Buffer
-		// 3. Constant Buffer
-		// 4. Root Constant
-		// 5. Output UAV
+		// 3. Root Constants
+		// 4. Output UAV
+		// 5. Render View
 
 		// Main CBV_SRV_UAV heap
 		//rootParameters[0].ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
@@ -140,12 +162,12 @@ void BindlessDecalsPass::Init()
 		rootParameters[2].DescriptorTable.NumDescriptorRanges = _countof(depthBufferRange);
 		rootParameters[2].DescriptorTable.pDescriptorRanges = &depthBufferRange[0];
 
-		// Constant Buffer
-		rootParameters[3].ParameterType = D3D12_ROOT_PARAMETER_TYPE_CBV;
+		// Root Constants
+		rootParameters[3].ParameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;
 		rootParameters[3].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
-		rootParameters[3].Descriptor.Flags = D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC;
-		rootParameters[3].Descriptor.RegisterSpace = 0;
-		rootParameters[3].Descriptor.ShaderRegister = 0;
+		rootParameters[3].Constants.RegisterSpace = 0;
+		rootParameters[3].Constants.ShaderRegister = 0;
+		rootParameters[3].Constants.Num32BitValues = sizeof(DecalConstants) / sizeof(uint32_t);
 
 		// Output UAV
 		D3D12_DESCRIPTOR_RANGE1 uavRangeCS[1] = {};
@@ -160,6 +182,13 @@ void BindlessDecalsPass::Init()
 		rootParameters[4].ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
 		rootParameters[4].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
 
+		// Render View
+		rootParameters[5].ParameterType = D3D12_ROOT_PARAMETER_TYPE_CBV;
+		rootParameters[5].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+		rootParameters[5].Descriptor.Flags = D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC;
+		rootParameters[5].Descriptor.RegisterSpace = 100;
+		rootParameters[5].Descriptor.ShaderRegister = 0;
+
 		//////////////////////////////////////////////////////////////////////////
 
 		D3D12_STATIC_SAMPLER_DESC sampler = {};
@@ -193,13 +222,14 @@ void BindlessDecalsPass::Init()
 
 	// Tiled Binning Root Signature
 	{
-		D3D12_ROOT_PARAMETER1 rootParameters[5];
+		D3D12_ROOT_PARAMETER1 rootParameters[6];
 
 		// 0. Structured Buffer
 		// 1. Depth Buffer
-		// 2. Constant Buffer
+		// 2. Root Constants
 		// 3. Output UAV
 		// 4. Debug UAV
+		// 5. Render View
 
 		// Structured Buffer
 		rootParameters[0].ParameterType = D3D12_ROOT_PARAMETER_TYPE_SRV;
@@ -223,12 +253,12 @@ void BindlessDecalsPass::Init()
 		rootParameters[1].DescriptorTable.NumDescriptorRanges = _countof(depthBufferRange);
 		rootParameters[1].DescriptorTable.pDescriptorRanges = &depthBufferRange[0];
 
-		// Constant Buffer
-		rootParameters[2].ParameterType = D3D12_ROOT_PARAMETER_TYPE_CBV;
+		// Root Constants
+		rootParameters[2].ParameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;
 		rootParameters[2].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
-		rootParameters[2].Descriptor.Flags = D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC;
-		rootParameters[2].Descriptor.RegisterSpace = 0;
-		rootParameters[2].Descriptor.ShaderRegister = 0;
+		rootParameters[2].Constants.RegisterSpace = 0;
+		rootParameters[2].Constants.ShaderRegister = 0;
+		rootParameters[2].Constants.Num32BitValues = sizeof(DecalTilingConstants) / sizeof(uint32_t);
 
 		// Output UAV
 		rootParameters[3].ParameterType = D3D12_ROOT_PARAMETER_TYPE_UAV;
@@ -250,6 +280,13 @@ void BindlessDecalsPass::Init()
 		rootParameters[4].ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
 		rootParameters[4].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
 
+		// Render View
+		rootParameters[5].ParameterType = D3D12_ROOT_PARAMETER_TYPE_CBV;
+		rootParameters[5].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+		rootParameters[5].Descriptor.Flags = D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC;
+		rootParameters[5].Descriptor.RegisterSpace = 100;
+		rootParameters[5].Descriptor.ShaderRegister = 0;
+
 		//////////////////////////////////////////////////////////////////////////
 
 		D3D12_STATIC_SAMPLER_DESC sampler = {};
@@ -368,59 +405,63 @@ void BindlessDecalsPass::Init()
 	Scene& currentScene = sManager.GetCurrentScene();
 
 	{
-		eastl::shared_ptr<DecalObj> decalObj = eastl::make_shared<DecalObj>("Decal");
+		eastl::shared_ptr<DecalObject> decalObj = eastl::make_shared<DecalObject>("Decal");
 		currentScene.AddObject(decalObj);
-		SceneDecals.push_back(decalObj);
 
 		decalObj->SetRelativeLocation(glm::vec3(0.f, -1.f, 0.f));
 		decalObj->SetRotationDegrees(glm::vec3(90.f, 0.f, 0.f));
 	}
 
 	//{
-	//	eastl::shared_ptr<DecalObj> decalObj = eastl::make_shared<DecalObj>("Decal");
+	//	eastl::shared_ptr<DecalObject> decalObj = eastl::make_shared<DecalObject>("Decal");
 	//	currentScene.AddObject(decalObj);
-	//	SceneDecals.push_back(decalObj);
 
 	//	decalObj->SetRelativeLocation(glm::vec3(0.f, -1.f, -5.f));
 	//	decalObj->SetRotationDegrees(glm::vec3(90.f, 0.f, 0.f));
 	//}
 
 
+	GatherShaderDecals();
+	if (!m_ShaderDecals.empty())
 	{
-		eastl::vector<ShaderDecal> shaderDecals;
-		for (uint32_t i = 0; i < SceneDecals.size(); ++i)
-		{
-			ShaderDecal newDecal = {};
-			const Transform& absTrans = SceneDecals[i]->GetAbsoluteTransform();
-
-			newDecal.Orientation = glm::vec4(absTrans.Rotation.x, absTrans.Rotation.y, absTrans.Rotation.z, absTrans.Rotation.w);
-			newDecal.Position = absTrans.Translation;
-			newDecal.Size = absTrans.Scale;
-
-			newDecal.AlbedoMapIdx = 13;
-			newDecal.NormalMapIdx = 21;
+		m_DecalsBuffer.UploadDataAllFrames(m_ShaderDecals.data(), sizeof(ShaderDecal) * m_ShaderDecals.size());
+	}
 
-			shaderDecals.push_back(newDecal);
+	// Readback copies of the tiled binning buffer
+	{
+		D3D12_RESOURCE_DESC readbackDesc = {};
+		readbackDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+		readbackDesc.Width = m_DecalsTiledBinningBuffer.Size;
+		readbackDesc.Height = 1;
+		readbackDesc.DepthOrArraySize = 1;
+		readbackDesc.MipLevels = 1;
+		readbackDesc.Format = DXGI_FORMAT_UNKNOWN;
+		readbackDesc.SampleDesc.Count = 1;
+		readbackDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+		readbackDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
+
+		for (ID3D12Resource*& readback : m_DecalsBinningReadback)
+		{
+			DXAssert(D3D12Globals::Device->CreateCommittedResource(&D3D12Utility::GetReadbackHeapProps(), D3D12_HEAP_FLAG_NONE, &readbackDesc,
+				D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&readback)));
+			readback->SetName(L"DecalsBinningReadback");
 		}
-
-		m_DecalsBuffer.UploadDataAllFrames(&shaderDecals[0], sizeof(ShaderDecal) * shaderDecals.size());
 	}
 }
 
-void BindlessDecalsPass::ComputeTiledBinning(ID3D12GraphicsCommandList* inCmdList, SceneTextures& inSceneTextures)
+void BindlessDecalsPass::ComputeTiledBinning(ID3D12GraphicsCommandList* inCmdList, SceneTextures& inSceneTextures, const RenderView& inView)
 {
 	PIXMarker Marker(inCmdList, "Tiled Binning");
 
 	inCmdList->SetComputeRootSignature(m_TileBinningRootSignature);
 	inCmdList->SetPipelineState(m_TiledBinningPipelineState);
 
-	SceneManager& sManager = SceneManager::Get();
-	const Scene& currentScene = sManager.GetCurrentScene();
-
 	// 0. Structured Buffer
 	// 1. Depth Buffer
-	// 2. Constant Buffer
+	// 2. Root Constants
 	// 3. Output UAV
+	// 4. Debug UAV
+	// 5. Render View
 
 	// Clear decal binning buffer
 	{
@@ -455,11 +496,7 @@ void BindlessDecalsPass::ComputeTiledBinning(ID3D12GraphicsCommandList* inCmdLis
 	// 	MathUtils::DivideAndRoundUp(props.Height, 64));
 
 	{
-		DecalTilingConstantBuffer tilingConstBufferData;
-
-		tilingConstBufferData.Projection = glm::transpose(currentScene.GetMainCameraProj());
-		tilingConstBufferData.View = glm::transpose(currentScene.GetMainCameraLookAt());
-		tilingConstBufferData.InvViewProj = glm::transpose(glm::inverse(currentScene.GetMainCameraProj() * currentScene.GetMainCameraLookAt()));
+		DecalTilingConstants tilingConstBufferData;
 
 		static int32_t debugFlag = 1;
 		static float debugValue = 1.f;
@@ -475,13 +512,10 @@ void BindlessDecalsPass::ComputeTiledBinning(ID3D12GraphicsCommandList* inCmdLis
 
 		tilingConstBufferData.DebugValue = glm::vec4(debugValue, 0.f, 0.f, 0.f);
 		tilingConstBufferData.DebugFlag = uint32_t(debugFlag);
-		tilingConstBufferData.NumDecals = SceneDecals.size();
+		tilingConstBufferData.NumDecals = GetSceneDecals().size();
 		tilingConstBufferData.NumWorkGroups = TileComputeGroupCounts;
 
-		// Use temp buffer in main constant buffer
-		MapResult cBufferMap = D3D12Globals::GlobalConstantsBuffer.ReserveTempBufferMemory(sizeof(tilingConstBufferData));
-		memcpy(cBufferMap.CPUAddress, &tilingConstBufferData, sizeof(tilingConstBufferData));
-		inCmdList->SetComputeRootConstantBufferView(2, cBufferMap.GPUAddress);
+		inCmdList->SetComputeRoot32BitConstants(2, sizeof(tilingConstBufferData) / sizeof(uint32_t), &tilingConstBufferData, 0);
 	}
 
 	inCmdList->SetComputeRootUnorderedAccessView(3, m_DecalsTiledBinningBuffer.GetGPUAddress());
@@ -489,32 +523,22 @@ void BindlessDecalsPass::ComputeTiledBinning(ID3D12GraphicsCommandList* inCmdLis
 	const eastl::vector<D3D12_CPU_DESCRIPTOR_HANDLE> uavHandles = { m_DebugRT->UAV };
 	D3D12Utility::BindTempDescriptorTable(4, inCmdList, uavHandles);
 
+	inCmdList->SetComputeRootConstantBufferView(5, inView.GetConstantsGPUAddress());
+
 	inCmdList->Dispatch(TileComputeGroupCounts.x, TileComputeGroupCounts.y, 1);
 }
 
 
 void BindlessDecalsPass::UpdateBeforeExecute()
 {
-	eastl::vector<ShaderDecal> shaderDecals;
-	for (uint32_t i = 0; i < SceneDecals.size(); ++i)
+	GatherShaderDecals();
+	if (!m_ShaderDecals.empty())
 	{
-		ShaderDecal newDecal = {};
-		const Transform& absTrans = SceneDecals[i]->GetAbsoluteTransform();
-
-		newDecal.Orientation = glm::vec4(absTrans.Rotation.x, absTrans.Rotation.y, absTrans.Rotation.z, absTrans.Rotation.w);
-		newDecal.Position = absTrans.Translation;
-		newDecal.Size = absTrans.Scale;
-
-		newDecal.AlbedoMapIdx = 13;
-		newDecal.NormalMapIdx = 21;
-
-		shaderDecals.push_back(newDecal);
+		m_DecalsBuffer.UploadDataCurrentFrame(m_ShaderDecals.data(), sizeof(ShaderDecal) * m_ShaderDecals.size());
 	}
-
-	m_DecalsBuffer.UploadDataCurrentFrame(&shaderDecals[0], sizeof(ShaderDecal) * shaderDecals.size());
 }
 
-void BindlessDecalsPass::ComputeDecals(ID3D12GraphicsCommandList* inCmdList, SceneTextures& inSceneTextures)
+void BindlessDecalsPass::ComputeDecals(ID3D12GraphicsCommandList* inCmdList, SceneTextures& inSceneTextures, const RenderView& inView)
 {
 	PIXMarker Marker(inCmdList, "Compute Decals");
 
@@ -522,16 +546,12 @@ void BindlessDecalsPass::ComputeDecals(ID3D12GraphicsCommandList* inCmdList, Sce
 	inCmdList->SetComputeRootSignature(m_DecalRootSignature);
 	inCmdList->SetPipelineState(m_DecalPipelineState);
 
-	SceneManager& sManager = SceneManager::Get();
-	const Scene& currentScene = sManager.GetCurrentScene();
-
-	const eastl::shared_ptr<Camera>& currentCamera = currentScene.GetCurrentCamera();
-
-	// 0. Main CBV_SRV_UAV heap
-	// 1. Structured Buffer
+	// 0. Structured Buffer
+	// 1. Binning Buffer
 	// 2. Depth Buffer
-	// 3. Constant Buffer
-	// 5. Output UAV
+	// 3. Root Constants
+	// 4. Output UAV
+	// 5. Render View
 
 	D3D12Utility::UAVBarrier(inCmdList, m_DecalsTiledBinningBuffer.Resource);
 
@@ -541,23 +561,18 @@ void BindlessDecalsPass::ComputeDecals(ID3D12GraphicsCommandList* inCmdList, Sce
 	inCmdList->SetComputeRootDescriptorTable(2, D3D12Globals::GlobalSRVHeap.GetGPUHandle(inSceneTextures.MainDepthBuffer->Texture->SRVIndex, D3D12Utility::CurrentFrameIndex));
 
 	{
-		DecalConstantBuffer decalConstantBufferData;
-
-		decalConstantBufferData.Projection = glm::transpose(currentScene.GetMainCameraProj());
-		decalConstantBufferData.View = glm::transpose(currentScene.GetMainCameraLookAt());
-		decalConstantBufferData.InvViewProj = glm::transpose(glm::inverse(currentScene.GetMainCameraProj() * currentScene.GetMainCameraLookAt()));
-		decalConstantBufferData.NumDecals = SceneDecals.size();
+		DecalConstants decalConstantBufferData;
+		decalConstantBufferData.NumDecals = GetSceneDecals().size();
 		decalConstantBufferData.NumWorkGroups = TileComputeGroupCounts;
 
-		// Use temp buffer in main constant buffer
-		MapResult cBufferMap = D3D12Globals::GlobalConstantsBuffer.ReserveTempBufferMemory(sizeof(decalConstantBufferData));
-		memcpy(cBufferMap.CPUAddress, &decalConstantBufferData, sizeof(decalConstantBufferData));
-		inCmdList->SetComputeRootConstantBufferView(3, cBufferMap.GPUAddress);
+		inCmdList->SetComputeRoot32BitConstants(3, sizeof(decalConstantBufferData) / sizeof(uint32_t), &decalConstantBufferData, 0);
 	}
 
 	const eastl::vector<D3D12_CPU_DESCRIPTOR_HANDLE> uavHandles = { inSceneTextures.GBufferAlbedo->UAV, inSceneTextures.GBufferNormal->UAV, inSceneTextures.GBufferRoughness->UAV };
 	D3D12Utility::BindTempDescriptorTable(4, inCmdList, uavHandles);
 
+	inCmdList->SetComputeRootConstantBufferView(5, inView.GetConstantsGPUAddress());
+
 	const WindowsWindow& mainWindow = GEngine->GetMainWindow();
 	const WindowProperties& props = mainWindow.GetProperties();
 
@@ -572,18 +587,117 @@ void BindlessDecalsPass::ComputeDecals(ID3D12GraphicsCommandList* inCmdList, Sce
 
 
 
-void BindlessDecalsPass::Execute(ID3D12GraphicsCommandList* inCmdList, SceneTextures& inSceneTextures)
+// Tiles whose GPU mask has decals the CPU clusters of the tile column don't, from the frame that last used this frame's readback
+static void CompareTiledBinningReadback(const uint32_t inFrame)
 {
+	if (!bBinningReadbackPending[inFrame])
+	{
+		return;
+	}
+
+	bBinningReadbackPending[inFrame] = false;
+
+	const eastl::vector<uint32_t>& cpuMasks = m_CPUTileDecalMasks[inFrame];
+	const D3D12_RANGE readRange = { 0, cpuMasks.size() * sizeof(uint32_t) };
+	uint32_t* gpuMasks = nullptr;
+	DXAssert(m_DecalsBinningReadback[inFrame]->Map(0, &readRange, reinterpret_cast<void**>(&gpuMasks)));
+
+	NumComparedTiles = static_cast<uint32_t>(cpuMasks.size());
+	NumMismatchedTiles = 0;
+	for (uint32_t tile = 0; tile < NumComparedTiles; ++tile)
+	{
+		NumMismatchedTiles += (gpuMasks[tile] & ~cpuMasks[tile]) != 0 ? 1 : 0;
+	}
+
+	const D3D12_RANGE writeRange = { 0, 0 };
+	m_DecalsBinningReadback[inFrame]->Unmap(0, &writeRange);
+}
+
+static void BinDecalClusters(const RenderView& inView)
+{
+	ImGuiUtils::ImGuiScope ImGuiDecals("Decals");
+
+	ImGui::Checkbox("CPU Clustered Binning", &bCPUClusteredBinning);
+
+	const uint32_t frame = D3D12Utility::CurrentFrameIndex % D3D12Utility::NumFramesInFlight;
+	CompareTiledBinningReadback(frame);
+
+	if (bCPUClusteredBinning)
+	{
+		eastl::vector<ClusterDecal> decals;
+		decals.reserve(m_ShaderDecals.size());
+		for (const ShaderDecal& shaderDecal : m_ShaderDecals)
+		{
+			ClusterDecal& newDecal = decals.push_back();
+			newDecal.Orientation = shaderDecal.Orientation;
+			newDecal.Position = shaderDecal.Position;
+			newDecal.Size = shaderDecal.Size;
+		}
+
+		// Clusters up to the far plane, like the tiles of the GPU binning
+		ClusterGridSettings settings;
+		settings.MaxDistance = inView.Far;
+
+		int64_t binningUs = 0;
+		{
+			Utils::BenchmarkCode bench(&binningUs);
+			m_DecalClusters.Bin(inView, settings, eastl::vector<ClusterLight>(), decals);
+		}
+
+		const glm::uvec3 gridSize = m_DecalClusters.GetGridSize();
+		ImGui::Text("%ux%ux%u clusters, %u decal references, %f ms", gridSize.x, gridSize.y, gridSize.z, uint32_t(m_DecalClusters.GetIndices().size()), float(binningUs) / 1000.f);
+
+		// The GPU tiles are smaller than the cluster tiles and inside of them, their masks only hold the first 32 decals
+		if (decals.size() <= 32 && settings.TileSize % TILE_SIZE == 0)
+		{
+			eastl::vector<uint32_t>& cpuMasks = m_CPUTileDecalMasks[frame];
+			cpuMasks.resize(TileComputeGroupCounts.x * TileComputeGroupCounts.y);
+			for (uint32_t tileY = 0; tileY < TileComputeGroupCounts.y; ++tileY)
+			{
+				for (uint32_t tileX = 0; tileX < TileComputeGroupCounts.x; ++tileX)
+				{
+					cpuMasks[tileY * TileComputeGroupCounts.x + tileX] = m_DecalClusters.GetDecalMaskAt(tileX * TILE_SIZE, tileY * TILE_SIZE);
+				}
+			}
+
+			bBinningReadbackPending[frame] = true;
+			ImGui::Text("%u of %u GPU tiles have decals outside of the CPU clusters", NumMismatchedTiles, NumComparedTiles);
+		}
+		else
+		{
+			ImGui::Text("Comparing to the GPU tiles needs at most 32 decals");
+		}
+	}
+
+	if (ImGui::Button("Benchmark Clustered Binning"))
+	{
+		ClusteredBinning::Benchmark(4096, 4096, 60);
+	}
+}
+
+void BindlessDecalsPass::Execute(ID3D12GraphicsCommandList* inCmdList, SceneTextures& inSceneTextures, const RenderView& inView)
+{
+	BinDecalClusters(inView);
+
 	{
 		D3D12Utility::TransitionResource(inCmdList, m_DecalsTiledBinningBuffer.Resource, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
 		D3D12Utility::TransitionResource(inCmdList, inSceneTextures.MainDepthBuffer->Texture->Resource, D3D12_RESOURCE_STATE_DEPTH_WRITE, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
 
-		ComputeTiledBinning(inCmdList, inSceneTextures);
+		ComputeTiledBinning(inCmdList, inSceneTextures, inView);
 
 		D3D12Utility::TransitionResource(inCmdList, inSceneTextures.MainDepthBuffer->Texture->Resource, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_DEPTH_WRITE);
 		D3D12Utility::TransitionResource(inCmdList, m_DecalsTiledBinningBuffer.Resource, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
 	}
 
+	// Compared to the CPU masks of this frame once the frame is done on the GPU
+	const uint32_t frame = D3D12Utility::CurrentFrameIndex % D3D12Utility::NumFramesInFlight;
+	if (bBinningReadbackPending[frame])
+	{
+		D3D12Utility::TransitionResource(inCmdList, m_DecalsTiledBinningBuffer.Resource, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_COPY_SOURCE);
+		inCmdList->CopyBufferRegion(m_DecalsBinningReadback[frame], 0, m_DecalsTiledBinningBuffer.Resource, 0, m_DecalsTiledBinningBuffer.Size);
+		D3D12Utility::TransitionResource(inCmdList, m_DecalsTiledBinningBuffer.Resource, D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+	}
+
 
 
 	{
@@ -592,7 +706,7 @@ void BindlessDecalsPass::Execute(ID3D12GraphicsCommandList* inCmdList, SceneText
 		D3D12Utility::TransitionResource(inCmdList, inSceneTextures.GBufferRoughness->Texture->Resource, D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
 		D3D12Utility::TransitionResource(inCmdList, inSceneTextures.MainDepthBuffer->Texture->Resource, D3D12_RESOURCE_STATE_DEPTH_WRITE, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
 
-		ComputeDecals(inCmdList, inSceneTextures);
+		ComputeDecals(inCmdList, inSceneTextures, inView);
 	}
 
 
@@ -10,9 +10,9 @@ public:
 	~BindlessDecalsPass();
 
 	void Init();
-	void Execute(struct ID3D12GraphicsCommandList* inCmdList, struct SceneTextures& inSceneTextures);
-	void ComputeTiledBinning(ID3D12GraphicsCommandList* inCmdList, SceneTextures& inSceneTextures);
-	void ComputeDecals(ID3D12GraphicsCommandList* inCmdList, SceneTextures& inSceneTextures);
+	void Execute(struct ID3D12GraphicsCommandList* inCmdList, struct SceneTextures& inSceneTextures, const class RenderView& inView);
+	void ComputeTiledBinning(ID3D12GraphicsCommandList* inCmdList, SceneTextures& inSceneTextures, const RenderView& inView);
+	void ComputeDecals(ID3D12GraphicsCommandList* inCmdList, SceneTextures& inSceneTextures, const RenderView& inView);
 	void UpdateBeforeExecute();
 
 
@@ -14,15 +14,7 @@
 #include "glm/ext/matrix_transform.hpp"
 #include "glm/gtc/quaternion.hpp"
 #include "Renderer/DrawDebugHelpers.h"
-
-// Constant Buffer
-struct DebugConstants
-{
-	glm::mat4 WorldToClip;
-	glm::mat4 CameraToWorld;
-	uint32_t Padding[32];
-};
-static_assert((sizeof(DebugConstants) % 256) == 0, "Constant Buffer size must be 256-byte aligned");
+#include "Renderer/RenderView.h"
 
 struct PackedDebugPointInstanceData
 {
@@ -60,10 +52,11 @@ void DebugPrimitivesPass::Init()
 	{
 		D3D12_ROOT_PARAMETER1 rootParameters[2];
 
+		// Render View
 		rootParameters[0].ParameterType = D3D12_ROOT_PARAMETER_TYPE_CBV;
 		rootParameters[0].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
 		rootParameters[0].Descriptor.Flags = D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC;
-		rootParameters[0].Descriptor.RegisterSpace = 0;
+		rootParameters[0].Descriptor.RegisterSpace = 100;
 		rootParameters[0].Descriptor.ShaderRegister = 0;
 
 		rootParameters[1].ParameterType = D3D12_ROOT_PARAMETER_TYPE_SRV;
@@ -164,7 +157,7 @@ void DebugPrimitivesPass::Init()
 	}
 }
 
-void DebugPrimitivesPass::Execute(struct ID3D12GraphicsCommandList* inCmdList, const class D3D12DepthBuffer& inDepthBuffer, const D3D12RenderTarget2D& inTarget)
+void DebugPrimitivesPass::Execute(struct ID3D12GraphicsCommandList* inCmdList, const class D3D12DepthBuffer& inDepthBuffer, const D3D12RenderTarget2D& inTarget, const RenderView& inView)
 {
 	PIXMarker Marker(inCmdList, "Render Debug Primitives");
 
@@ -173,22 +166,6 @@ void DebugPrimitivesPass::Execute(struct ID3D12GraphicsCommandList* inCmdList, c
 	const eastl::vector<DebugPoint>& debugPoints = manager.GetDebugPoints();
 	ASSERT(debugPoints.size() < MAX_NR_POINTS);
 
-	SceneManager& sManager = SceneManager::Get();
-	const Scene& currentScene = sManager.GetCurrentScene();
-
-	glm::mat4 projection = currentScene.GetMainCameraProj();
-
-	// Convert projection to infinite
-	projection[2][2] = 1.0f;
-	projection[3][2] = -2.0f * currentScene.GetCurrentCamera()->GetNear();
-	// TODO: This messes up the depth occlusion because result is different than standard perspective.
-
-	DebugConstants constData;
-	constData.WorldToClip = glm::transpose(projection * currentScene.GetMainCameraLookAt());
-	constData.CameraToWorld = glm::transpose(glm::inverse(currentScene.GetMainCameraLookAt()));
-
-	MapResult constBuffer{};
-
 	if (debugPoints.size() > 0)
 	{
 		D3D12Utility::TransitionResource(inCmdList, inDepthBuffer.Texture->Resource, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_DEPTH_READ);
@@ -219,11 +196,7 @@ void DebugPrimitivesPass::Execute(struct ID3D12GraphicsCommandList* inCmdList, c
 
 		inCmdList->OMSetRenderTargets(1, renderTargets, false, &inDepthBuffer.DSV);
 
-		// Use temp buffer in main constant buffer
-		constBuffer = D3D12Globals::GlobalConstantsBuffer.ReserveTempBufferMemory(sizeof(constData));
-		memcpy(constBuffer.CPUAddress, &constData, sizeof(constData));
-
-		inCmdList->SetGraphicsRootConstantBufferView(0, constBuffer.GPUAddress);
+		inCmdList->SetGraphicsRootConstantBufferView(0, inView.GetConstantsGPUAddress());
 		inCmdList->SetGraphicsRootShaderResourceView(1, m_PointsBuffer.GetCurrentGPUAddress());
 
 		inCmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
@@ -262,14 +235,7 @@ void DebugPrimitivesPass::Execute(struct ID3D12GraphicsCommandList* inCmdList, c
 
 		inCmdList->OMSetRenderTargets(1, renderTargets, false, &inDepthBuffer.DSV);
 
-		// Use temp buffer in main constant buffer
-		if (!constBuffer.CPUAddress)
-		{
-			constBuffer = D3D12Globals::GlobalConstantsBuffer.ReserveTempBufferMemory(sizeof(constData));
-		}
-		memcpy(constBuffer.CPUAddress, &constData, sizeof(constData));
-
-		inCmdList->SetGraphicsRootConstantBufferView(0, constBuffer.GPUAddress);
+		inCmdList->SetGraphicsRootConstantBufferView(0, inView.GetConstantsGPUAddress());
 		inCmdList->SetGraphicsRootShaderResourceView(1, m_LinesBuffer.GetCurrentGPUAddress());
 
 		inCmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_LINELIST);
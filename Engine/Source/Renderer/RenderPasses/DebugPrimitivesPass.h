@@ -10,7 +10,7 @@ public:
 	~DebugPrimitivesPass() = default;
 
 	void Init();
-	void Execute(struct ID3D12GraphicsCommandList* inCmdList, const class D3D12DepthBuffer& inDepthBuffer, const class D3D12RenderTarget2D& inTarget);
+	void Execute(struct ID3D12GraphicsCommandList* inCmdList, const class D3D12DepthBuffer& inDepthBuffer, const class D3D12RenderTarget2D& inTarget, const class RenderView& inView);
 
 };
 
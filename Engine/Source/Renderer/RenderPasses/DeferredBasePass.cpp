@@ -11,15 +11,16 @@
 #include "Scene/Scene.h"
 #include "Scene/SceneManager.h"
 #include "Renderer/RHI/D3D12/D3D12Utility.h"
-
-// Constant Buffer
-struct MeshConstantBuffer
-{
-	glm::mat4 LocalToClip;
-	glm::mat4 LocalToWorldRotationOnly;
-	uint32_t Padding[32];
-};
-static_assert((sizeof(MeshConstantBuffer) % 256) == 0, "Constant Buffer size must be 256-byte aligned");
+#include "Renderer/Baking/PotentiallyVisibleSet.h"
+#include "Renderer/Visibility/FrustumCuller.h"
+#include "Renderer/Visibility/ViewVisibility.h"
+#include "Renderer/Visibility/OcclusionCuller.h"
+#include "Renderer/DrawPacket.h"
+#include "Renderer/RHI/D3D12/D3D12DrawPackets.h"
+#include "Renderer/RenderPasses/SceneInstancesPass.h"
+#include "Renderer/RenderView.h"
+#include "Utils/ImGuiUtils.h"
+#include "imgui.h"
 
 ID3D12RootSignature* m_GBufferMainMeshRootSignature;
 ID3D12RootSignature* m_GBufferBasicObjectsRootSignature;
@@ -27,6 +28,15 @@ ID3D12RootSignature* m_GBufferBasicObjectsRootSignature;
 ID3D12PipelineState* m_MainMeshPassPipelineState;
 ID3D12PipelineState* m_BasicObjectsPipelineState;
 
+// Width of the software occlusion buffer, the height follows the window aspect
+#define OCCLUSION_BUFFER_WIDTH 320
+#define MAX_OCCLUDERS 64
+
+static OcclusionCuller MainViewOcclusion;
+
+// Turned off on CPUs without AVX
+static bool bOcclusionCulling = true;
+
 void DeferredBasePass::Init()
 {
 	const WindowsWindow& mainWindow = GEngine->GetMainWindow();
@@ -39,13 +49,17 @@ void DeferredBasePass::Init()
 
 	GBufferTextures.MainDepthBuffer = D3D12RHI::Get()->CreateDepthBuffer(props.Width, props.Height, L"Main Depth Buffer", ETextureState::Shader_Resource);
 
+	const uint32_t occlusionBufferHeight = glm::max((OCCLUSION_BUFFER_WIDTH * props.Height / props.Width) & ~3u, 4u);
+	MainViewOcclusion.Init(OCCLUSION_BUFFER_WIDTH, occlusionBufferHeight);
+	bOcclusionCulling = OcclusionCuller::IsSupported();
+
 
 
 	// Root Signatures
 
 	// GBuffer Main Mesh Pass signature
 	{
-		D3D12_ROOT_PARAMETER1 rootParameters[4];
+		D3D12_ROOT_PARAMETER1 rootParameters[6];
 
 		// Main CBV_SRV_UAV heap
 		rootParameters[0].ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
@@ -68,17 +82,33 @@ void DeferredBasePass::Init()
 		rootParameters[1].Descriptor.RegisterSpace = 100;
 		rootParameters[1].Descriptor.ShaderRegister = 0;
 
+		// Render View
 		rootParameters[2].ParameterType = D3D12_ROOT_PARAMETER_TYPE_CBV;
 		rootParameters[2].ShaderVisibility = D3D12_SHADER_VISIBILITY_VERTEX;
 		rootParameters[2].Descriptor.Flags = D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC;
-		rootParameters[2].Descriptor.RegisterSpace = 0;
+		rootParameters[2].Descriptor.RegisterSpace = 100;
 		rootParameters[2].Descriptor.ShaderRegister = 0;
 
-		rootParameters[3].ParameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;
-		rootParameters[3].ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL;
-		rootParameters[3].Constants.RegisterSpace = 0;
-		rootParameters[3].Constants.ShaderRegister = 0;
-		rootParameters[3].Constants.Num32BitValues = 1;
+		// Scene instances, the material index comes from there as well
+		rootParameters[3].ParameterType = D3D12_ROOT_PARAMETER_TYPE_SRV;
+		rootParameters[3].ShaderVisibility = D3D12_SHADER_VISIBILITY_VERTEX;
+		rootParameters[3].Descriptor.Flags = D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC_WHILE_SET_AT_EXECUTE;
+		rootParameters[3].Descriptor.RegisterSpace = 101;
+		rootParameters[3].Descriptor.ShaderRegister = 0;
+
+		// Instance slots
+		rootParameters[4].ParameterType = D3D12_ROOT_PARAMETER_TYPE_SRV;
+		rootParameters[4].ShaderVisibility = D3D12_SHADER_VISIBILITY_VERTEX;
+		rootParameters[4].Descriptor.Flags = D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC;
+		rootParameters[4].Descriptor.RegisterSpace = 101;
+		rootParameters[4].Descriptor.ShaderRegister = 1;
+
+		// First instance of the draw
+		rootParameters[5].ParameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;
+		rootParameters[5].ShaderVisibility = D3D12_SHADER_VISIBILITY_VERTEX;
+		rootParameters[5].Constants.RegisterSpace = 0;
+		rootParameters[5].Constants.ShaderRegister = 1;
+		rootParameters[5].Constants.Num32BitValues = 1;
 
 
 		//////////////////////////////////////////////////////////////////////////
@@ -290,65 +320,65 @@ void DeferredBasePass::Init()
 static uint64_t TestNrMeshesToDraw = uint64_t(-1);
 static uint64_t NrMeshesDrawn = 0;
 
-static void DrawMeshNodesRecursively(ID3D12GraphicsCommandList* inCmdList, const eastl::vector<TransformObjPtr>& inChildNodes, const Scene& inCurrentScene, const eastl::vector<MeshMaterial>& inMaterials)
+static DrawTranslationStats DrawMeshPackets(ID3D12GraphicsCommandList* inCmdList, const DrawPacketList& inPackets, const RenderView& inView, const uint64_t inSceneInstancesAddress)
 {
-	for (const TransformObjPtr& child : inChildNodes)
+	if (inPackets.GetNumInstances() == 0)
 	{
-		const TransformObject* childPtr = child.get();
-
-		DrawMeshNodesRecursively(inCmdList, childPtr->GetChildren(), inCurrentScene, inMaterials);
-
-		if (NrMeshesDrawn >= TestNrMeshesToDraw)
-		{
-			return;
-		}
-
-		if (const MeshNode* modelChild = dynamic_cast<const MeshNode*>(childPtr))
-		{
-			if (modelChild->MatIndex == uint32_t(-1) || inMaterials.size() == 0)
-			{
-				continue;
-			}
-
-			const Transform& absTransform = modelChild->GetAbsoluteTransform();
-			const glm::mat4 modelMatrix = absTransform.GetMatrix();
-
-			//LOG_INFO("Translation for object with index %d : %f    %f    %f", i, modelMatrix[3][0], modelMatrix[3][1], modelMatrix[3][2]);
+		return DrawTranslationStats();
+	}
 
-			{
-				MeshConstantBuffer constantBufferData;
+	// Shared by every draw
+	inCmdList->SetGraphicsRootDescriptorTable(0, D3D12Globals::GlobalSRVHeap.GPUStart[D3D12Utility::CurrentFrameIndex]);
+	inCmdList->SetGraphicsRootShaderResourceView(1, D3D12Globals::GlobalMaterialsBuffer.GetCurrentGPUAddress());
 
-				// All matrices sent to HLSL need to be converted to row-major(what D3D uses) from column-major(what glm uses)
-				constantBufferData.LocalToClip = glm::transpose(inCurrentScene.GetMainCameraProj() * inCurrentScene.GetMainCameraLookAt() * modelMatrix);
-				constantBufferData.LocalToWorldRotationOnly = glm::transpose(absTransform.GetRotationOnlyMatrix());
+	inCmdList->SetGraphicsRootConstantBufferView(2, inView.GetConstantsGPUAddress());
 
-				MapResult cBufferMap = D3D12Globals::GlobalConstantsBuffer.ReserveTempBufferMemory(sizeof(constantBufferData));
-				memcpy(cBufferMap.CPUAddress, &constantBufferData, sizeof(constantBufferData));
+	inCmdList->SetGraphicsRootShaderResourceView(3, inSceneInstancesAddress);
 
-				inCmdList->SetGraphicsRootConstantBufferView(2, cBufferMap.GPUAddress);
-			}
+	// Only the slots of the drawn instances change per frame, they go in the upload memory of the frame
+	MapResult slotsMap = D3D12Globals::GlobalConstantsBuffer.ReserveTempBufferMemory(DrawPacketList::GetInstanceDataSize(inPackets.GetNumInstances()));
+	inPackets.PackInstances(reinterpret_cast<uint32_t*>(slotsMap.CPUAddress));
+	inCmdList->SetGraphicsRootShaderResourceView(4, slotsMap.GPUAddress);
 
-			inCmdList->SetGraphicsRootShaderResourceView(1, D3D12Globals::GlobalMaterialsBuffer.GetCurrentGPUAddress());
+	return D3D12DrawPackets::Record(inCmdList, inPackets, 5);
+}
 
-			inCmdList->SetGraphicsRoot32BitConstant(3, modelChild->MatIndex, 0);
 
-			inCmdList->SetGraphicsRootDescriptorTable(0, D3D12Globals::GlobalSRVHeap.GPUStart[D3D12Utility::CurrentFrameIndex]);
+void DeferredBasePass::AddVisibilityViews(ViewVisibility& ioVisibility, const RenderView& inView)
+{
+	ImGuiUtils::ImGuiScope ImGuiCulling("Culling");
+	if (OcclusionCuller::IsSupported())
+	{
+		ImGui::Checkbox("Occlusion Culling", &bOcclusionCulling);
+	}
+	else
+	{
+		ImGui::Text("Occlusion culling needs a CPU with AVX");
+	}
 
-			inCmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-			const D3D12_VERTEX_BUFFER_VIEW vbView = modelChild->VertexBuffer->VBView();
-			const D3D12_INDEX_BUFFER_VIEW ibView = modelChild->IndexBuffer->IBView();
-			inCmdList->IASetVertexBuffers(0, 1, &vbView);
-			inCmdList->IASetIndexBuffer(&ibView);
+	// Only the meshes whose bounds touch the camera frustum, sorted by geometry and front to back inside each group.
+	// The material is read per instance so it doesn't split draws.
+	VisibilityViewDesc desc;
+	desc.ViewFrustum = inView.ViewFrustum;
+	desc.PacketView = inView.GetDrawPacketView();
+	desc.Pipeline = EDrawPipeline::GBufferMesh;
+	desc.MaxInstances = static_cast<uint32_t>(glm::min<uint64_t>(TestNrMeshesToDraw, uint32_t(-1)));
 
-			inCmdList->DrawIndexedInstanced(modelChild->IndexBuffer->IndexCount, 1, 0, 0, 0);
+	// Null when there is no bake or the camera is outside of it, in which case everything is drawn
+	desc.VisibleSet = VisibilitySet ? VisibilitySet->GetVisibleSet(inView.Position) : nullptr;
 
-			++NrMeshesDrawn;
-		}
+	// The largest meshes in the frustum hide the ones behind them before anything reaches the GPU
+	if (bOcclusionCulling)
+	{
+		desc.Occlusion = &MainViewOcclusion;
+		desc.MaxOccluders = MAX_OCCLUDERS;
+		desc.WorldToClip = inView.WorldToClip;
 	}
-}
 
+	MainViewIndex = ioVisibility.AddView(desc);
+}
 
-void DeferredBasePass::Execute(ID3D12GraphicsCommandList* inCmdList)
+void DeferredBasePass::Execute(ID3D12GraphicsCommandList* inCmdList, const RenderView& inView, const ViewVisibility& inVisibility, const SceneInstancesPass& inSceneInstances)
 {
 	PIXMarker Marker(inCmdList, "Draw GBuffer");
 
@@ -382,22 +412,50 @@ void DeferredBasePass::Execute(ID3D12GraphicsCommandList* inCmdList)
 	// Draw meshes
 	NrMeshesDrawn = 0;
 
-	const eastl::vector<eastl::shared_ptr<TransformObject>>& objects = currentScene.GetAllObjects();
+	const uint32_t numInFrustum = inVisibility.GetNumInFrustum(MainViewIndex);
+	const uint32_t numVisible = static_cast<uint32_t>(inVisibility.GetVisible(MainViewIndex).size());
 
-	for (int32_t i = 0; i < objects.size(); ++i)
+	ImGuiUtils::ImGuiScope ImGuiCulling("Culling");
+	ImGui::Text("Main view: %u visible, %u culled", numInFrustum, inVisibility.GetNumTested() - numInFrustum);
+	if (ImGui::Button("Benchmark Frustum Culling"))
 	{
-		// TODO: Possibly replace with RenderCommand self registration because this way it needs to be recursive and casting
-		const eastl::shared_ptr<TransformObject>& currObj = objects[i];
-		const eastl::shared_ptr<Model3D> currModel = eastl::dynamic_shared_pointer_cast<Model3D>(currObj);
+		FrustumCuller::Benchmark(100000, 60);
+	}
 
-		if (currModel.get() == nullptr)
-		{
-			continue;
-		}
+	if (bOcclusionCulling)
+	{
+		ImGui::Text("Occluders: %u(%u triangles), occluded: %u", inVisibility.GetNumOccluders(MainViewIndex), MainViewOcclusion.GetNumOccluderTriangles(),
+			numInFrustum - numVisible);
+	}
 
-		// Record commands
-		const eastl::vector<TransformObjPtr>& children = currModel->GetChildren();
-		DrawMeshNodesRecursively(inCmdList, children, currentScene, currModel->Materials);
+	if (ImGui::Button("Benchmark Occlusion Culling"))
+	{
+		OcclusionCuller::Benchmark(100000);
+	}
+
+	if (ImGui::Button("Benchmark View Visibility"))
+	{
+		// Cube probes around the camera, like capturing reflection probes in the frame
+		ViewVisibility::Benchmark(currentScene.GetMeshRenderables(), inView.Position, 8, 30);
 	}
 
+	if (ImGui::Button("Check View Visibility"))
+	{
+		ViewVisibility::RunSceneChecks(currentScene.GetMeshRenderables(), inView.Position);
+	}
+
+	const DrawTranslationStats drawStats = DrawMeshPackets(inCmdList, inVisibility.GetPackets(MainViewIndex), inView, inSceneInstances.GetInstancesGPUAddress());
+	NrMeshesDrawn = drawStats.NumInstances;
+
+	ImGui::Text("Draws: %u(%u instances), vertex buffer sets: %u, index buffer sets: %u", drawStats.NumDraws, drawStats.NumInstances, drawStats.NumVertexBufferSets, drawStats.NumIndexBufferSets);
+	if (ImGui::Button("Benchmark Draw Packets"))
+	{
+		DrawPacketList::Benchmark(100000, 60);
+	}
+
+}
+
+uint64_t DeferredBasePass::GetNumMeshesDrawn() const
+{
+	return NrMeshesDrawn;
 }
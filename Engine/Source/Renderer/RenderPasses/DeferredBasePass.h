@@ -19,11 +19,21 @@ public:
 	~DeferredBasePass() = default;
 
 	void Init();
-	void Execute(struct ID3D12GraphicsCommandList* inCmdList);
+
+	// Adds the main camera view, the visibility gets computed for all the passes before any of them executes
+	void AddVisibilityViews(class ViewVisibility& ioVisibility, const class RenderView& inView);
+	void Execute(struct ID3D12GraphicsCommandList* inCmdList, const class RenderView& inView, const class ViewVisibility& inVisibility, const class SceneInstancesPass& inSceneInstances);
+
+	uint64_t GetNumMeshesDrawn() const;
 
 public:
 	SceneTextures GBufferTextures;
 
+	// Optional baked visibility used to skip meshes that can't be seen from the camera cell
+	const class PotentiallyVisibleSet* VisibilitySet = nullptr;
+
+private:
+	uint32_t MainViewIndex = 0;
 };
 
 
@@ -12,18 +12,7 @@
 #include "imgui.h"
 #include "Renderer/Drawable/ShapesUtils/BasicShapesData.h"
 #include "Core/AppCore.h"
-
-struct LightingConstantBuffer
-{
-	glm::mat4 ViewInv;
-	glm::mat4 ProjInv;
-	glm::mat4 Proj;
-	glm::vec4 ViewPos;
-	glm::vec4 LightDir;
-
-	float Padding[8];
-};
-static_assert((sizeof(LightingConstantBuffer) % 256) == 0, "Constant Buffer size must be 256-byte aligned");
+#include "Renderer/RenderView.h"
 
 static ID3D12RootSignature* m_LightingRootSignature;
 static ID3D12PipelineState* m_LightingPipelineState;
@@ -34,11 +23,11 @@ void DeferredLightingPass::Init(SceneTextures& inSceneTextures)
 	{
 		D3D12_ROOT_PARAMETER1 rootParameters[2] = {};
 
-		// Constant Buffer
+		// Render View
 		rootParameters[0].ParameterType = D3D12_ROOT_PARAMETER_TYPE_CBV;
 		rootParameters[0].ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL;
 		rootParameters[0].Descriptor.Flags = D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC;
-		rootParameters[0].Descriptor.RegisterSpace = 0;
+		rootParameters[0].Descriptor.RegisterSpace = 100;
 		rootParameters[0].Descriptor.ShaderRegister = 0;
 
 		// Textures
@@ -137,19 +126,19 @@ void DeferredLightingPass::Init(SceneTextures& inSceneTextures)
 	}
 }
 
-void DeferredLightingPass::Execute(ID3D12GraphicsCommandList* inCmdList, SceneTextures& inSceneTextures, const D3D12RenderTarget2D& inTarget, const glm::vec3& inLightDir)
+void DeferredLightingPass::Execute(ID3D12GraphicsCommandList* inCmdList, SceneTextures& inSceneTextures, const D3D12RenderTarget2D& inTarget, const RenderView& inView)
 {
 	D3D12Utility::TransitionResource(inCmdList, inSceneTextures.GBufferAlbedo->Texture->Resource, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 	D3D12Utility::TransitionResource(inCmdList, inSceneTextures.GBufferNormal->Texture->Resource, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 	D3D12Utility::TransitionResource(inCmdList, inSceneTextures.GBufferRoughness->Texture->Resource, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 	D3D12Utility::TransitionResource(inCmdList, inSceneTextures.MainDepthBuffer->Texture->Resource, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 
-	RenderLighting(inCmdList, inSceneTextures, inTarget, inLightDir);
+	RenderLighting(inCmdList, inSceneTextures, inTarget, inView);
 }
 
 
 // TODO: Convert to compute
-void DeferredLightingPass::RenderLighting(ID3D12GraphicsCommandList* inCmdList, SceneTextures& inSceneTextures, const D3D12RenderTarget2D& inTarget, const glm::vec3& inLightDir)
+void DeferredLightingPass::RenderLighting(ID3D12GraphicsCommandList* inCmdList, SceneTextures& inSceneTextures, const D3D12RenderTarget2D& inTarget, const RenderView& inView)
 {
 	PIXMarker Marker(inCmdList, "Render Deferred Lighting");
 
@@ -165,25 +154,8 @@ void DeferredLightingPass::RenderLighting(ID3D12GraphicsCommandList* inCmdList,
 
 	inCmdList->OMSetRenderTargets(1, renderTargets, FALSE, nullptr);
 
-	SceneManager& sManager = SceneManager::Get();
-	const Scene& currentScene = sManager.GetCurrentScene();
-	const eastl::shared_ptr<Camera>& currentCamera = currentScene.GetCurrentCamera();
-
-	{
-		LightingConstantBuffer lightingConstantBufferData;
-
-		lightingConstantBufferData.ProjInv = glm::transpose(glm::inverse(currentScene.GetMainCameraProj()));
-		lightingConstantBufferData.ViewInv = glm::transpose(glm::inverse(currentScene.GetMainCameraLookAt()));
-		lightingConstantBufferData.Proj = glm::transpose(currentScene.GetMainCameraProj());
-
-		lightingConstantBufferData.LightDir = glm::vec4(inLightDir, 0.f);
-		lightingConstantBufferData.ViewPos = glm::vec4(currentCamera->GetAbsoluteTransform().Translation, 0.f);
-
-		// Use temp buffer in main constant buffer
-		MapResult cBufferMap = D3D12Globals::GlobalConstantsBuffer.ReserveTempBufferMemory(sizeof(lightingConstantBufferData));
-		memcpy(cBufferMap.CPUAddress, &lightingConstantBufferData, sizeof(lightingConstantBufferData));
-		inCmdList->SetGraphicsRootConstantBufferView(0, cBufferMap.GPUAddress);
-	}
+	// Camera and light direction
+	inCmdList->SetGraphicsRootConstantBufferView(0, inView.GetConstantsGPUAddress());
 
 	inCmdList->SetGraphicsRootDescriptorTable(1, D3D12Globals::GlobalSRVHeap.GetGPUHandle(0, D3D12Utility::CurrentFrameIndex));
 	inCmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
@@ -12,10 +12,10 @@ public:
 	~DeferredLightingPass() = default;
 
 	void Init(struct SceneTextures& inSceneTextures);
-	void Execute(struct ID3D12GraphicsCommandList* inCmdList, struct SceneTextures& inSceneTextures, const class D3D12RenderTarget2D& inTarget, const glm::vec3& inLightDir);
+	void Execute(struct ID3D12GraphicsCommandList* inCmdList, struct SceneTextures& inSceneTextures, const class D3D12RenderTarget2D& inTarget, const class RenderView& inView);
 
 private:
-	void RenderLighting(struct ID3D12GraphicsCommandList* inCmdList, SceneTextures& inSceneTextures, const class D3D12RenderTarget2D& inTarget, const glm::vec3& inLightDir);
+	void RenderLighting(struct ID3D12GraphicsCommandList* inCmdList, SceneTextures& inSceneTextures, const class D3D12RenderTarget2D& inTarget, const class RenderView& inView);
 };
 
 
@@ -0,0 +1,154 @@
+#include "SceneInstancesPass.h"
+#include "Renderer/RHI/D3D12/D3D12Resources.h"
+#include "Renderer/RHI/D3D12/D3D12RHI.h"
+#include "Renderer/RHI/D3D12/D3D12GraphicsTypes_Internal.h"
+#include <d3d12.h>
+#include "Scene/Scene.h"
+#include "Scene/SceneManager.h"
+#include "Renderer/RHI/D3D12/D3D12Utility.h"
+#include "Utils/ImGuiUtils.h"
+#include "imgui.h"
+
+ID3D12RootSignature* m_InstancesScatterRootSignature;
+ID3D12PipelineState* m_InstancesScatterPipelineState;
+
+// Not CPU visible so not double buffered, every frame only scatters the slots that changed into it
+D3D12RawBuffer m_SceneInstancesBuffer;
+
+// Slot indices followed by the new instances, enough for all slots to change in the same frame
+D3D12ConstantBuffer m_InstancesUploadBuffer;
+
+#define SCATTER_GROUP_SIZE 64
+
+void SceneInstancesPass::Init()
+{
+	m_SceneInstancesBuffer.Init(MAX_SCENE_INSTANCES * sizeof(GPUSceneInstance) / sizeof(uint32_t));
+	m_InstancesUploadBuffer.Init(MAX_SCENE_INSTANCES * (sizeof(uint32_t) + sizeof(GPUSceneInstance)) + 2 * D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
+
+	// Scatter Root Signature
+	{
+		D3D12_ROOT_PARAMETER1 rootParameters[4];
+
+		// 0. Dirty slots
+		// 1. New instances
+		// 2. Instance buffer
+		// 3. Root Constant
+
+		rootParameters[0].ParameterType = D3D12_ROOT_PARAMETER_TYPE_SRV;
+		rootParameters[0].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+		rootParameters[0].Descriptor.Flags = D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC;
+		rootParameters[0].Descriptor.RegisterSpace = 0;
+		rootParameters[0].Descriptor.ShaderRegister = 0;
+
+		rootParameters[1].ParameterType = D3D12_ROOT_PARAMETER_TYPE_SRV;
+		rootParameters[1].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+		rootParameters[1].Descriptor.Flags = D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC;
+		rootParameters[1].Descriptor.RegisterSpace = 0;
+		rootParameters[1].Descriptor.ShaderRegister = 1;
+
+		rootParameters[2].ParameterType = D3D12_ROOT_PARAMETER_TYPE_UAV;
+		rootParameters[2].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+		rootParameters[2].Descriptor.Flags = D3D12_ROOT_DESCRIPTOR_FLAG_DATA_VOLATILE;
+		rootParameters[2].Descriptor.RegisterSpace = 0;
+		rootParameters[2].Descriptor.ShaderRegister = 0;
+
+		rootParameters[3].ParameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;
+		rootParameters[3].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+		rootParameters[3].Constants.RegisterSpace = 0;
+		rootParameters[3].Constants.ShaderRegister = 0;
+		rootParameters[3].Constants.Num32BitValues = 1;
+
+		//////////////////////////////////////////////////////////////////////////
+
+		D3D12_ROOT_SIGNATURE_DESC1 rootSignatureDesc = {};
+		rootSignatureDesc.NumParameters = _countof(rootParameters);
+		rootSignatureDesc.pParameters = &rootParameters[0];
+		rootSignatureDesc.NumStaticSamplers = 0;
+		rootSignatureDesc.Flags = D3D12Utility::GetDefaultRootSignatureFlags();
+
+		D3D12_VERSIONED_ROOT_SIGNATURE_DESC versionedRootSignatureDesc = {};
+		versionedRootSignatureDesc.Version = D3D_ROOT_SIGNATURE_VERSION_1_1;
+		versionedRootSignatureDesc.Desc_1_1 = rootSignatureDesc;
+
+		m_InstancesScatterRootSignature = D3D12RHI::Get()->CreateRootSignature(versionedRootSignatureDesc);
+	}
+
+	// Scatter PSO
+	{
+		eastl::string fullPath = "../Data/Shaders/D3D12/";
+		fullPath += "SceneInstancesScatter.hlsl";
+
+		const CompiledShaderResult compiledShader = D3D12RHI::Get()->CompileComputeShaderFromFile(fullPath);
+
+		// shader bytecodes
+		D3D12_SHADER_BYTECODE csByteCode;
+		csByteCode.pShaderBytecode = compiledShader.CSByteCode->GetBufferPointer();
+		csByteCode.BytecodeLength = compiledShader.CSByteCode->GetBufferSize();
+
+		D3D12_COMPUTE_PIPELINE_STATE_DESC psoDesc = {};
+		psoDesc.pRootSignature = m_InstancesScatterRootSignature;
+		psoDesc.CS = csByteCode;
+
+		DXAssert(D3D12Globals::Device->CreateComputePipelineState(&psoDesc, IID_PPV_ARGS(&m_InstancesScatterPipelineState)));
+	}
+}
+
+void SceneInstancesPass::Execute(ID3D12GraphicsCommandList* inCmdList)
+{
+	PIXMarker Marker(inCmdList, "Scene Instances Update");
+
+	SceneManager& sManager = SceneManager::Get();
+	const Scene& currentScene = sManager.GetCurrentScene();
+
+	ImGuiUtils::ImGuiScope ImGuiInstances("Scene Instances");
+	if (ImGui::Button("Rewrite All Instances"))
+	{
+		InstanceCache.Reset();
+	}
+
+	const uint32_t numDirty = InstanceCache.Update(currentScene.GetMeshRenderables());
+	ASSERT_MSG(InstanceCache.GetNumSlots() <= MAX_SCENE_INSTANCES, "More scene meshes than instance buffer slots, increase MAX_SCENE_INSTANCES.");
+
+	ImGui::Text("Slots: %u, updated: %u(%u bytes uploaded)", InstanceCache.GetNumSlots(), numDirty,
+		static_cast<uint32_t>(numDirty * (sizeof(uint32_t) + sizeof(GPUSceneInstance))));
+
+	if (numDirty == 0)
+	{
+		return;
+	}
+
+	// Only this pass uses the upload buffer, its memory for the frame is free again
+	m_InstancesUploadBuffer.ClearUsedMemory();
+
+	const eastl::vector<uint32_t>& dirtySlots = InstanceCache.GetDirtySlots();
+	MapResult slotsMap = m_InstancesUploadBuffer.ReserveTempBufferMemory(numDirty * sizeof(uint32_t));
+	MapResult instancesMap = m_InstancesUploadBuffer.ReserveTempBufferMemory(numDirty * sizeof(GPUSceneInstance));
+
+	memcpy(slotsMap.CPUAddress, dirtySlots.data(), numDirty * sizeof(uint32_t));
+
+	GPUSceneInstance* uploadInstances = reinterpret_cast<GPUSceneInstance*>(instancesMap.CPUAddress);
+	for (uint32_t i = 0; i < numDirty; ++i)
+	{
+		uploadInstances[i] = InstanceCache.GetInstance(dirtySlots[i]);
+	}
+
+	// Earlier frames read the buffer on the same queue, the barrier keeps their draws before the writes
+	D3D12Utility::TransitionResource(inCmdList, m_SceneInstancesBuffer.Resource, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+
+	inCmdList->SetComputeRootSignature(m_InstancesScatterRootSignature);
+	inCmdList->SetPipelineState(m_InstancesScatterPipelineState);
+
+	inCmdList->SetComputeRootShaderResourceView(0, slotsMap.GPUAddress);
+	inCmdList->SetComputeRootShaderResourceView(1, instancesMap.GPUAddress);
+	inCmdList->SetComputeRootUnorderedAccessView(2, m_SceneInstancesBuffer.GetGPUAddress());
+	inCmdList->SetComputeRoot32BitConstant(3, numDirty, 0);
+
+	inCmdList->Dispatch((numDirty + SCATTER_GROUP_SIZE - 1) / SCATTER_GROUP_SIZE, 1, 1);
+
+	D3D12Utility::TransitionResource(inCmdList, m_SceneInstancesBuffer.Resource, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+}
+
+uint64_t SceneInstancesPass::GetInstancesGPUAddress() const
+{
+	return m_SceneInstancesBuffer.GPUAddress;
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <utility>
+#include "EASTL/vector.h"
+#include "Renderer/SceneInstances.h"
+
+// Slots of the persistent instance buffer, one per scene mesh
+#define MAX_SCENE_INSTANCES 32768
+
+class SceneInstancesPass
+{
+public:
+	SceneInstancesPass() = default;
+	~SceneInstancesPass() = default;
+
+	void Init();
+
+	// Uploads the slots changed since the last frame and scatters them into the instance buffer with a compute dispatch,
+	// has to run before the passes reading the buffer
+	void Execute(struct ID3D12GraphicsCommandList* inCmdList);
+
+	// Stays the same for the whole run, StructuredBuffer of GPUSceneInstance in the shaders
+	uint64_t GetInstancesGPUAddress() const;
+
+private:
+	SceneInstanceCache InstanceCache;
+};
@@ -16,15 +16,12 @@
 #include "Math/AABB.h"
 #include "Math/MathUtils.h"
 #include "Utils/ImGuiUtils.h"
-
-// Constant Buffer
-struct MeshConstantBuffer
-{
-	glm::mat4 LocalToClip;
-	glm::vec4 Test;
-	float Padding[44];
-};
-static_assert((sizeof(MeshConstantBuffer) % 256) == 0, "Constant Buffer size must be 256-byte aligned");
+#include "Renderer/Visibility/ViewVisibility.h"
+#include "Renderer/ShadowAtlas.h"
+#include "Renderer/DrawPacket.h"
+#include "Renderer/RHI/D3D12/D3D12DrawPackets.h"
+#include "Renderer/RenderPasses/SceneInstancesPass.h"
+#include "Utils/InlineVector.h"
 
 ID3D12RootSignature* m_ShadowPassRootSignature;
 ID3D12PipelineState* m_ShadowPassPSO;
@@ -35,17 +32,40 @@ void ShadowPass::Init()
 {
 	// Textures
 	ShadowDepthBuffer = D3D12RHI::Get()->CreateDepthBuffer(SHADOW_CASCADES_RESOLUTION, SHADOW_CASCADES_RESOLUTION, L"Shadow Depth Buffer", ETextureState::Shader_Resource, MAX_NUM_CASCADES);
+	Cascades.Resolution = SHADOW_CASCADES_RESOLUTION;
 
 	// Root Signature
 	{
-		D3D12_ROOT_PARAMETER1 rootParameters[1];
+		D3D12_ROOT_PARAMETER1 rootParameters[4];
 
+		// Render View, the cascade matrices come from there
 		rootParameters[0].ParameterType = D3D12_ROOT_PARAMETER_TYPE_CBV;
 		rootParameters[0].ShaderVisibility = D3D12_SHADER_VISIBILITY_VERTEX;
 		rootParameters[0].Descriptor.Flags = D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC;
-		rootParameters[0].Descriptor.RegisterSpace = 0;
+		rootParameters[0].Descriptor.RegisterSpace = 100;
 		rootParameters[0].Descriptor.ShaderRegister = 0;
 
+		// Scene instances
+		rootParameters[1].ParameterType = D3D12_ROOT_PARAMETER_TYPE_SRV;
+		rootParameters[1].ShaderVisibility = D3D12_SHADER_VISIBILITY_VERTEX;
+		rootParameters[1].Descriptor.Flags = D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC_WHILE_SET_AT_EXECUTE;
+		rootParameters[1].Descriptor.RegisterSpace = 0;
+		rootParameters[1].Descriptor.ShaderRegister = 0;
+
+		// Instance slots
+		rootParameters[2].ParameterType = D3D12_ROOT_PARAMETER_TYPE_SRV;
+		rootParameters[2].ShaderVisibility = D3D12_SHADER_VISIBILITY_VERTEX;
+		rootParameters[2].Descriptor.Flags = D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC;
+		rootParameters[2].Descriptor.RegisterSpace = 0;
+		rootParameters[2].Descriptor.ShaderRegister = 1;
+
+		// First instance of the draw and cascade index
+		rootParameters[3].ParameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;
+		rootParameters[3].ShaderVisibility = D3D12_SHADER_VISIBILITY_VERTEX;
+		rootParameters[3].Constants.RegisterSpace = 0;
+		rootParameters[3].Constants.ShaderRegister = 1;
+		rootParameters[3].Constants.Num32BitValues = 2;
+
 		//////////////////////////////////////////////////////////////////////////
 
 		D3D12_ROOT_SIGNATURE_DESC1 rootSignatureDesc = {};
@@ -110,167 +130,188 @@ int32_t TestNrMeshesToDraw = 62;
 int32_t NrMeshesDrawn = 0;
 int32_t CurrentCascade = 0;
 
-void DrawMeshNodesRecursively(ID3D12GraphicsCommandList* inCmdList, const eastl::vector<TransformObjPtr>& inChildNodes, const Scene& inCurrentScene, const eastl::vector<MeshMaterial>& inMaterials, const glm::mat4& inToShadowClipMatrix)
+void DrawMeshPackets(ID3D12GraphicsCommandList* inCmdList, const DrawPacketList& inPackets, const int32_t inCascade, const RenderView& inView, const uint64_t inSceneInstancesAddress)
 {
-	for (const TransformObjPtr& child : inChildNodes)
+	if (inPackets.GetNumInstances() == 0)
 	{
-		const TransformObject* childPtr = child.get();
-
-		DrawMeshNodesRecursively(inCmdList, childPtr->GetChildren(), inCurrentScene, inMaterials, inToShadowClipMatrix);
-
-		//if (NrMeshesDrawn >= TestNrMeshesToDraw)
-		//{
-		//	return;
-		//}
-
-		//if (NrMeshesDrawn > 60 && CurrentCascade == 1)
-		//{
-		//	__debugbreak();
-		//}
-
-		if (const MeshNode* modelChild = dynamic_cast<const MeshNode*>(childPtr))
-		{
-			if (modelChild->MatIndex == uint32_t(-1) || inMaterials.size() == 0)
-			{
-				continue;
-			}
-
-			const Transform& absTransform = modelChild->GetAbsoluteTransform();
-			const glm::mat4 modelMatrix = absTransform.GetMatrix();
-
-			{
-				MeshConstantBuffer constantBufferData = {};
-				memset(&constantBufferData, 0, sizeof(constantBufferData));
+		return;
+	}
 
-				constantBufferData.LocalToClip = glm::transpose(inToShadowClipMatrix * modelMatrix);
+	inCmdList->SetGraphicsRootConstantBufferView(0, inView.GetConstantsGPUAddress());
+	inCmdList->SetGraphicsRootShaderResourceView(1, inSceneInstancesAddress);
 
-				static int test = 0;
-				++test;
+	MapResult slotsMap = D3D12Globals::GlobalConstantsBuffer.ReserveTempBufferMemory(DrawPacketList::GetInstanceDataSize(inPackets.GetNumInstances()));
+	inPackets.PackInstances(reinterpret_cast<uint32_t*>(slotsMap.CPUAddress));
+	inCmdList->SetGraphicsRootShaderResourceView(2, slotsMap.GPUAddress);
 
-				constantBufferData.Test.x = 1.f;
-				constantBufferData.Test.y = 2.f;
-				constantBufferData.Test.z = 3.f;
-				constantBufferData.Test.w = 4.f;
+	// Record only sets the first instance, the cascade stays the same for all the draws
+	inCmdList->SetGraphicsRoot32BitConstant(3, static_cast<uint32_t>(inCascade), 1);
 
-				MapResult cBufferMap = D3D12Globals::GlobalConstantsBuffer.ReserveTempBufferMemory(sizeof(constantBufferData));
-				memcpy(cBufferMap.CPUAddress, &constantBufferData, sizeof(constantBufferData));
-				
+	const DrawTranslationStats stats = D3D12DrawPackets::Record(inCmdList, inPackets, 3);
 
-				//MeshConstantBuffer testReadback = {};
-				//memcpy(&testReadback, cBufferMap.CPUAddress, sizeof(constantBufferData));
+	NrMeshesDrawn = static_cast<int32_t>(stats.NumInstances);
+}
 
+// Changes when a caster enters or leaves the cascade, or one of them moves
+static uint64_t HashCasters(const eastl::vector<SceneMeshRenderable>& inCasters)
+{
+	constexpr uint64_t prime = 0x100000001B3ull;
+	uint64_t hash = 0xCBF29CE484222325ull;
 
-				inCmdList->SetGraphicsRootConstantBufferView(0, cBufferMap.GPUAddress);
-			}
+	for (const SceneMeshRenderable& caster : inCasters)
+	{
+		hash = (hash ^ caster.InstanceSlot) * prime;
+		hash = (hash ^ caster.InstanceGeneration) * prime;
+		hash = (hash ^ static_cast<uint64_t>(reinterpret_cast<uintptr_t>(caster.Mesh))) * prime;
+		hash = (hash ^ caster.Mesh->GetWorldVersion()) * prime;
+	}
 
-			
+	return hash;
+}
 
-			inCmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-			const D3D12_VERTEX_BUFFER_VIEW vbView = modelChild->VertexBuffer->VBView();
-			const D3D12_INDEX_BUFFER_VIEW ibView = modelChild->IndexBuffer->IBView();
-			inCmdList->IASetVertexBuffers(0, 1, &vbView);
-			inCmdList->IASetIndexBuffer(&ibView);
+void ShadowPass::ScheduleCascades(RenderView& ioView, const uint64_t inFrameIndex)
+{
+	for (int32_t i = 0; i < MAX_NUM_CASCADES; ++i)
+	{
+		CascadeUpdates[i] = ECascadeUpdate::Rendered;
 
-			inCmdList->DrawIndexedInstanced(modelChild->IndexBuffer->IndexCount, 1, 0, 0, 0);
+		// Cascades that are not drawn lose their contents to the next ones using the slice
+		if (i >= ioView.GetNumCascades() || !bCacheCascades)
+		{
+			CascadeCaches[i].bValid = false;
+			continue;
+		}
 
-			++NrMeshesDrawn;
+		const uint64_t interval = static_cast<uint64_t>(glm::max(StaggeredCascadesInterval, 1));
+		const bool bStaggered = i >= FirstStaggeredCascade && interval > 1;
+		if (bStaggered && CascadeCaches[i].bValid && (inFrameIndex + i) % interval != 0)
+		{
+			CascadeUpdates[i] = ECascadeUpdate::SkippedStaggered;
+			ioView.OverrideCascadeWorldToClip(i, CascadeCaches[i].WorldToClip);
 		}
 	}
 }
 
-glm::mat4 CreateCascadeMatrix(const glm::mat4& inCameraProj, const glm::mat4& inCameraView, const glm::vec3& inLightDir)
+void ShadowPass::AddVisibilityViews(ViewVisibility& ioVisibility, const RenderView& inView)
 {
-	const glm::mat4 worldToCameraClip = inCameraProj * inCameraView;
-	const glm::vec3 cameraProjCenter = RenderUtils::GetProjectionCenter(worldToCameraClip);
-
-	// Create tight shadow projection around camera frustum
-	AABB projBox;
-	vectorInline<glm::vec3, 8> cameraProjPoints = RenderUtils::GenerateSpaceCorners(worldToCameraClip);
-
-	// Point light at light dir relative to center of projection
-	const glm::mat4 lightView = MathUtils::BuildLookAt(inLightDir, cameraProjCenter);
-
-	for (const glm::vec3& point : cameraProjPoints)
+	for (int32_t i = 0; i < inView.GetNumCascades(); ++i)
 	{
-		const glm::vec4 lightSpacePoint = lightView * glm::vec4(point.x, point.y, point.z, 1.f);
-		projBox += glm::vec3(lightSpacePoint.x, lightSpacePoint.y, lightSpacePoint.z);
-	}
+		if (CascadeUpdates[i] == ECascadeUpdate::SkippedStaggered)
+		{
+			continue;
+		}
 
-	const glm::mat4 lightProjection = glm::orthoLH_ZO(projBox.Min.x, projBox.Max.x, projBox.Min.y, projBox.Max.y, projBox.Min.z, projBox.Max.z);
+		// Casters between the light and a cascade still throw shadows in it, so the near plane is left out and the frustum
+		// extends towards the light. Grouped by geometry, depth order matters little for the small depth only draws and every
+		// instance of a mesh goes in the same draw whatever its material.
+		VisibilityViewDesc desc;
+		desc.ViewFrustum = Frustum::FromMatrix(inView.GetCascadeWorldToClip(i), false);
+		desc.Pipeline = EDrawPipeline::ShadowDepth;
 
-	return lightProjection * lightView;
+		CascadeViews[i] = ioVisibility.AddView(desc);
+	}
 }
 
-vectorInline<glm::mat4, MAX_NUM_CASCADES> ShadowPass::CreateCascadesMatrices(const glm::vec3& inLightDir, const Scene& inCurrentScene) const
+void ShadowPass::Execute(ID3D12GraphicsCommandList* inCmdList, const RenderView& inView, const ViewVisibility& inVisibility, const SceneInstancesPass& inSceneInstances)
 {
-	vectorInline<glm::mat4, MAX_NUM_CASCADES> cascades;
-	cascades.reserve(NumCascades);
-
-	const eastl::shared_ptr<Camera>& currentCamera = inCurrentScene.GetCurrentCamera();
+	PIXMarker Marker(inCmdList, "Shadow Depth Passes");
 
-	const float cameraNear = currentCamera->GetNear();
-	const float cameraFar = currentCamera->GetFar();
-	const float cameraFOV = currentCamera->GetFOV();
-	eastl::vector<float> shadowCascadeFarPlanes = { cameraFar / 20.0f , cameraFar / 10.0f, cameraFar / 5.0f, cameraFar / 2.0f, cameraFar };
+	ImGuiUtils::ImGuiScope ImGuiShadow("Shadow");
 
-	const WindowsWindow& mainWindow = GEngine->GetMainWindow();
-	const WindowProperties& props = mainWindow.GetProperties();
+	ImGui::DragInt("Cascade Count", &Cascades.NumCascades, 1, 0, MAX_NUM_CASCADES);
+	ImGui::SliderFloat("Cascade Split Lambda", &Cascades.SplitLambda, 0.f, 1.f);
+	ImGui::DragFloat("Shadow Distance", &Cascades.MaxDistance, 1.f, 1.f, 500.f);
+	ImGui::DragInt("Meshes to draw", &TestNrMeshesToDraw, 1, 0, 500);
+	ImGui::Checkbox("Update Shadow Matrix", &bUpdateShadowValues);
+	Cascades.bFreeze = !bUpdateShadowValues;
+	ImGui::Checkbox("Draw Cascades Projections", &bDrawCascadesProjection);
+	ImGui::Checkbox("Draw Cascades Camera Frustums", &bDrawCascadesCameraFrustums);
+	ImGui::Checkbox("Cache Cascades", &bCacheCascades);
+	ImGui::DragInt("Staggered Cascades Interval", &StaggeredCascadesInterval, 1, 1, 8);
+	ImGui::DragInt("First Staggered Cascade", &FirstStaggeredCascade, 1, 0, MAX_NUM_CASCADES);
 
-	const float windowWidth = static_cast<float>(props.Width);
-	const float windowHeight = static_cast<float>(props.Height);
+	const int32_t numCascades = inView.GetNumCascades();
+	if (numCascades == 0)
+	{
+		return;
+	}
 
-	for (int32_t i = 0; i < NumCascades; ++i)
+	for (int32_t i = 0; i < numCascades; ++i)
 	{
-		const float cascadeNear = i == 0 ? cameraNear : shadowCascadeFarPlanes[i - 1];
-		const float cascadeFar = shadowCascadeFarPlanes[i];
+		if (bDrawCascadesCameraFrustums)
+		{
+			const glm::vec3* corners = inView.GetCascadeCorners(i);
+			vectorInline<glm::vec3, 8> cornersArray;
+			for (int32_t cornerIdx = 0; cornerIdx < 8; ++cornerIdx)
+			{
+				cornersArray.push_back(corners[cornerIdx]);
+				DrawDebugHelpers::DrawDebugPoint(corners[cornerIdx]);
+			}
 
-		const glm::mat4 cameraProj = glm::perspectiveLH_ZO(glm::radians(cameraFOV), windowWidth / windowHeight, cascadeNear, cascadeFar);
+			DrawDebugHelpers::DrawBoxArray(cornersArray, true, glm::vec3(1.f, 0.f, 0.f));
+		}
 
-		if (bUpdateShadowValues)
+		if (bDrawCascadesProjection)
 		{
-			CachedCameraShadowMatrix = inCurrentScene.GetMainCameraLookAt();
+			DrawDebugHelpers::DrawProjection(inView.GetCascadeWorldToClip(i));
+			DrawDebugHelpers::DrawProjectionPoints(inView.GetCascadeWorldToClip(i));
 		}
+	}
 
-		if (bDrawCascadesCameraFrustums)
+	// The shadow maps are kept between frames, a cascade is only redrawn when what it was drawn with changed
+	const glm::vec3& lightDir = inView.GetLightDirection();
+	for (int32_t i = 0; i < numCascades; ++i)
+	{
+		if (CascadeUpdates[i] == ECascadeUpdate::SkippedStaggered)
 		{
-			DrawDebugHelpers::DrawProjection(cameraProj * CachedCameraShadowMatrix);
-			DrawDebugHelpers::DrawProjectionPoints(cameraProj * CachedCameraShadowMatrix);
+			ImGui::Text("Cascade %d: waiting for its turn", i);
+			continue;
 		}
 
-		const glm::mat4 worldToLightClip = CreateCascadeMatrix(cameraProj, CachedCameraShadowMatrix, inLightDir);
+		const uint32_t viewIndex = CascadeViews[i];
+		const uint64_t castersHash = HashCasters(inVisibility.GetVisible(viewIndex));
+		const glm::mat4& worldToClip = inView.GetCascadeWorldToClip(i);
 
-		if (bDrawCascadesProjection)
+		CascadeCache& cache = CascadeCaches[i];
+		if (cache.bValid && cache.WorldToClip == worldToClip && cache.LightDirection == lightDir && cache.CastersHash == castersHash)
+		{
+			CascadeUpdates[i] = ECascadeUpdate::SkippedUnchanged;
+		}
+		else
 		{
-			DrawDebugHelpers::DrawProjection(worldToLightClip);
-			DrawDebugHelpers::DrawProjectionPoints(worldToLightClip);
+			cache.WorldToClip = worldToClip;
+			cache.LightDirection = lightDir;
+			cache.CastersHash = castersHash;
+			cache.bValid = bCacheCascades;
 		}
 
-		cascades.push_back(worldToLightClip);
+		const uint32_t numCasters = inVisibility.GetNumInFrustum(viewIndex);
+		ImGui::Text("Cascade %d: %u casters, %u culled, %u draws%s", i, numCasters, inVisibility.GetNumTested() - numCasters,
+			static_cast<uint32_t>(inVisibility.GetPackets(viewIndex).GetBatches().size()), CascadeUpdates[i] == ECascadeUpdate::SkippedUnchanged ? ", unchanged" : "");
 	}
 
-	return cascades;
-}
-
-
-void ShadowPass::Execute(ID3D12GraphicsCommandList* inCmdList, const glm::vec3& inLightDir)
-{
-	PIXMarker Marker(inCmdList, "Shadow Depth Passes");
-
-	ImGuiUtils::ImGuiScope ImGuiShadow("Shadow");
-
-	ImGui::DragInt("Cascade Count", &NumCascades, 1, 0, MAX_NUM_CASCADES);
-	ImGui::DragInt("Meshes to draw", &TestNrMeshesToDraw, 1, 0, 500);
-	ImGui::Checkbox("Update Shadow Matrix", &bUpdateShadowValues);
-	ImGui::Checkbox("Draw Cascades Projections", &bDrawCascadesProjection);
-	ImGui::Checkbox("Draw Cascades Camera Frustums", &bDrawCascadesCameraFrustums);
+	uint32_t numSkipped = 0;
+	for (int32_t i = 0; i < numCascades; ++i)
+	{
+		numSkipped += CascadeUpdates[i] != ECascadeUpdate::Rendered ? 1 : 0;
+	}
 
-	SceneManager& sManager = SceneManager::Get();
-	const Scene& currentScene = sManager.GetCurrentScene();
+	NumCascadesRendered += numCascades - numSkipped;
+	NumCascadesSkipped += numSkipped;
+	ImGui::Text("Skipped cascades: %u this frame, %llu of %llu since start", numSkipped, (unsigned long long)NumCascadesSkipped,
+		(unsigned long long)(NumCascadesRendered + NumCascadesSkipped));
+	if (ImGui::Button("Reset Skipped Cascades"))
+	{
+		NumCascadesRendered = 0;
+		NumCascadesSkipped = 0;
+	}
 
-	vectorInline<glm::mat4, MAX_NUM_CASCADES> cascadeMatrices = CreateCascadesMatrices(inLightDir, currentScene);
+	if (ImGui::Button("Benchmark Shadow Atlas"))
+	{
+		ShadowAtlas::Benchmark(64, 600);
+	}
 
-	const int32_t numCascades = cascadeMatrices.size();
-	if (numCascades == 0)
+	if (numSkipped == static_cast<uint32_t>(numCascades))
 	{
 		return;
 	}
@@ -286,11 +327,14 @@ void ShadowPass::Execute(ID3D12GraphicsCommandList* inCmdList, const glm::vec3&
 	viewport.MaxDepth = 1.f;
 	D3D12Globals::GraphicsCmdList->RSSetViewports(1, &viewport);
 
-	const eastl::vector<eastl::shared_ptr<TransformObject>>& objects = currentScene.GetAllObjects();
-
 
 	for (int32_t i = 0; i < numCascades; ++i) // TODO
 	{
+		if (CascadeUpdates[i] != ECascadeUpdate::Rendered)
+		{
+			continue;
+		}
+
 		CurrentCascade = i;
 
 		char Temp[12] = { 0 };
@@ -311,21 +355,8 @@ void ShadowPass::Execute(ID3D12GraphicsCommandList* inCmdList, const glm::vec3&
 
 		NrMeshesDrawn = 0;
 
-		for (int32_t j = 0; j < objects.size(); ++j)
-		{
-			// TODO: Possibly replace with RenderCommand self registration because this way it needs to be recursive and casting
-			const eastl::shared_ptr<TransformObject>& currObj = objects[j];
-			const eastl::shared_ptr<Model3D> currModel = eastl::dynamic_shared_pointer_cast<Model3D>(currObj);
-
-			if (currModel.get() == nullptr)
-			{
-				continue;
-			}
-
-			// Record commands
-			const eastl::vector<TransformObjPtr>& children = currModel->GetChildren();
-			DrawMeshNodesRecursively(inCmdList, children, currentScene, currModel->Materials, cascadeMatrices[i]);
-		}
+		// Record commands
+		DrawMeshPackets(inCmdList, inVisibility.GetPackets(CascadeViews[i]), i, inView, inSceneInstances.GetInstancesGPUAddress());
 
 		D3D12Utility::TransitionResource(inCmdList, ShadowDepthBuffer->Texture->Resource, D3D12_RESOURCE_STATE_DEPTH_WRITE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, i);
 	}
@@ -4,9 +4,7 @@
 #include "EASTL/shared_ptr.h"
 #include "glm/fwd.hpp"
 #include "glm/ext/matrix_float4x4.hpp"
-#include "Utils/InlineVector.h"
-
-#define MAX_NUM_CASCADES 3
+#include "Renderer/RenderView.h"
 
 class ShadowPass
 {
@@ -15,19 +13,57 @@ public:
 	~ShadowPass() = default;
 
 	void Init();
-	void Execute(struct ID3D12GraphicsCommandList* inCmdList, const glm::vec3& inLightDir);
+
+	// Picks the cascades that wait for their turn to be updated and makes the view use the matrices they were drawn with,
+	// has to run before the view is uploaded
+	void ScheduleCascades(RenderView& ioView, const uint64_t inFrameIndex);
+
+	// Adds a view for each cascade that can be updated this frame
+	void AddVisibilityViews(class ViewVisibility& ioVisibility, const RenderView& inView);
+
+	// The cascades come from the RenderView, built with the settings below
+	void Execute(struct ID3D12GraphicsCommandList* inCmdList, const RenderView& inView, const class ViewVisibility& inVisibility, const class SceneInstancesPass& inSceneInstances);
+
+	inline const CascadeSettings& GetCascadeSettings() const { return Cascades; }
 
 	eastl::shared_ptr<class D3D12DepthBuffer> ShadowDepthBuffer;
 
 private:
-	vectorInline<glm::mat4, MAX_NUM_CASCADES> CreateCascadesMatrices(const glm::vec3& inLightDir, const class Scene& inCurrentScene) const;
+	enum class ECascadeUpdate : uint8_t
+	{
+		Rendered,
+		// Same matrix, light and casters as when it was last drawn
+		SkippedUnchanged,
+		// Waiting for its turn in the staggered updates
+		SkippedStaggered
+	};
 
-private:
-	int32_t NumCascades = MAX_NUM_CASCADES;
-	mutable glm::mat4 CachedCameraShadowMatrix;
-	mutable bool bUpdateShadowValues = true;
-	mutable bool bDrawCascadesProjection = false;
-	mutable bool bDrawCascadesCameraFrustums = false;
+	// What a cascade's shadow map was last drawn with
+	struct CascadeCache
+	{
+		glm::mat4 WorldToClip = glm::mat4(1.f);
+		glm::vec3 LightDirection = glm::vec3(0.f);
+		uint64_t CastersHash = 0;
+		bool bValid = false;
+	};
+
+	CascadeCache CascadeCaches[MAX_NUM_CASCADES];
+	ECascadeUpdate CascadeUpdates[MAX_NUM_CASCADES] = {};
+	uint32_t CascadeViews[MAX_NUM_CASCADES] = {};
+
+	// Caching redraws a cascade only when its inputs changed. With an interval above 1 the cascades from the first staggered
+	// one are redrawn at most once every interval frames, each on a different frame.
+	bool bCacheCascades = true;
+	int32_t StaggeredCascadesInterval = 1;
+	int32_t FirstStaggeredCascade = 1;
+
+	uint64_t NumCascadesRendered = 0;
+	uint64_t NumCascadesSkipped = 0;
+
+	CascadeSettings Cascades;
+	bool bUpdateShadowValues = true;
+	bool bDrawCascadesProjection = false;
+	bool bDrawCascadesCameraFrustums = false;
 };
 
 
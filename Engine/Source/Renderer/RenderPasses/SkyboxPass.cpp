@@ -13,20 +13,20 @@
 #include "Renderer/Drawable/ShapesUtils/BasicShapesData.h"
 #include "DeferredBasePass.h"
 #include "ArHosekSkyModel.h"
+#include "Renderer/Baking/BakingUtils.h"
+#include "Renderer/Baking/SpecularEnvironmentBaker.h"
+#include "Renderer/RenderView.h"
 //#include "glm/ext/scalar_constants.hpp"
 
 #include <d3d12.h>
 #include <DirectXPackedVector.h>
 
-// Constant Buffer
-struct SkyboxConstantBuffer
+// Root constants, the view comes from the RenderView
+struct SkyboxConstants
 {
-	glm::mat4 Projection;
-	glm::mat4 View;
+	uint32_t CubemapIdx;
 	float SkyOnlyExposure;
-	float padding[31];
 };
-static_assert((sizeof(SkyboxConstantBuffer) % 256) == 0, "Constant Buffer size must be 256-byte aligned");
 
 SkyboxPass::SkyboxPass() = default;
 SkyboxPass::~SkyboxPass() = default;
@@ -38,46 +38,6 @@ eastl::shared_ptr<D3D12IndexBuffer> SkyboxIndexBuffer = nullptr;
 eastl::shared_ptr<D3D12VertexBuffer> SkyboxVertexBuffer = nullptr;
 
 
-glm::vec3 XYZToDirection(const uint64_t inX, const uint64_t inY, const uint64_t inZ, const uint64_t inWidth, const uint64_t inHeight)
-{
-	// Move coordinate to pixel center, remap to 0..1, remap to -1..1
-	const float u = ((inX + 0.5f) / float(inWidth)) * 2.0f - 1.0f;
-	float v = ((inY + 0.5f) / float(inHeight)) * 2.0f - 1.0f;
-	// D3D12 v goes top to bottom
-	v *= -1.0f;
-
-	glm::vec3 dir = glm::vec3(0.0f, 0.0f, 0.0f);
-
-	// https://en.wikipedia.org/wiki/Cube_mapping#/media/File:Cube_map.svg
-	// v is already reversed so it goes exactly like in the illustration
-	switch (inZ)
-	{
-	case 0:
-		dir = glm::normalize(glm::vec3(1.0f, v, -u));
-		break;
-	case 1:
-		dir = glm::normalize(glm::vec3(-1.0f, v, u));
-		break;
-	case 2:
-		dir = glm::normalize(glm::vec3(u, 1.0f, -v));
-		break;
-	case 3:
-		dir = glm::normalize(glm::vec3(u, -1.0f, v));
-		break;
-	case 4:
-		dir = glm::normalize(glm::vec3(u, v, 1.0f));
-		break;
-	case 5:
-		dir = glm::normalize(glm::vec3(-u, v, -1.0f));
-		break;
-	}
-
-
-	return dir;
-
-
-}
-
 float AngleBetween(const glm::vec3& inDir1, const glm::vec3& inDir2)
 {
 	return glm::acos(glm::max<float>(0.00001f, glm::dot(inDir1, inDir2)));
@@ -139,18 +99,18 @@ void SkyboxPass::InitSkyModel(ID3D12GraphicsCommandList* inCmdList)
 	StateG = arhosek_rgb_skymodelstate_alloc_init(Turbidity, GroundAlbedo.y, elevation);
 	StateB = arhosek_rgb_skymodelstate_alloc_init(Turbidity, GroundAlbedo.z, elevation);
 
-	const uint64_t cubemapRes = 128;
+	const uint32_t cubemapRes = 128;
 	const uint64_t numTexels = cubemapRes * cubemapRes * 6;
 
 	eastl::vector<glm::vec4> texels(numTexels);
 
-	for (uint64_t z = 0; z < 6; ++z)
+	for (uint32_t z = 0; z < 6; ++z)
 	{
-		for (uint64_t y = 0; y < cubemapRes; ++y)
+		for (uint32_t y = 0; y < cubemapRes; ++y)
 		{
-			for (uint64_t x = 0; x < cubemapRes; ++x)
+			for (uint32_t x = 0; x < cubemapRes; ++x)
 			{
-				const glm::vec3 dir = XYZToDirection(x, y, z, cubemapRes, cubemapRes);
+				const glm::vec3 dir = BakingUtils::CubemapTexelToDirection(x, y, z, cubemapRes);
 				glm::vec3 radiance;
 
 				//https://cgg.mff.cuni.cz/projects/SkylightModelling/HosekWilkie_SkylightModel_SIGGRAPH2012_Preprint.pdf
@@ -168,7 +128,7 @@ void SkyboxPass::InitSkyModel(ID3D12GraphicsCommandList* inCmdList)
 				// Convert radiometric units to photometric using standard luminous efficacy of 683 lm/W
 				radiance *= 683.f;
 
-				const uint64_t texelIdx = (z * cubemapRes * cubemapRes) + (y * cubemapRes) + x;
+				const uint64_t texelIdx = (uint64_t(z) * cubemapRes * cubemapRes) + (y * cubemapRes) + x;
 				texels[texelIdx] =  glm::vec4(radiance, 1.f);
 
 			}
@@ -176,6 +136,36 @@ void SkyboxPass::InitSkyModel(ID3D12GraphicsCommandList* inCmdList)
 	}
 
 	Cubemap = D3D12RHI::Get()->CreateTexture2D(cubemapRes, cubemapRes, DXGI_FORMAT_R32G32B32A32_FLOAT, inCmdList, L"Skybox Cubemap", texels.data(), true);
+
+	// Prefiltering is too slow to follow every slider change, only redo it when asked after the first bake
+	if (!SpecularEnvironment || bAutoRebakeSpecularEnvironment || bRebakeSpecularEnvironment)
+	{
+		bRebakeSpecularEnvironment = false;
+		BakeSpecularEnvironment(texels.data(), cubemapRes, inCmdList);
+	}
+}
+
+void SkyboxPass::BakeSpecularEnvironment(const glm::vec4* inSkyTexels, const uint32_t inSkyRes, ID3D12GraphicsCommandList* inCmdList)
+{
+	SpecularEnvironmentBaker::BakeSettings settings;
+	SpecularEnvironmentBaker::PrefilteredEnvironment environment;
+
+	const bool bFromCache = SpecularEnvironmentBaker::LoadOrBake(inSkyTexels, inSkyRes, settings, environment);
+	LOG_INFO("Specular environment %s.", bFromCache ? "loaded from cache" : "baked");
+
+	SpecularEnvironment = D3D12RHI::Get()->CreateTexture2D(environment.Size, environment.Size, DXGI_FORMAT_R32G32B32A32_FLOAT, inCmdList, L"Prefiltered Specular Environment", environment.Texels.data(), true, environment.NumMips);
+	EnvironmentBRDFLUT = D3D12RHI::Get()->CreateTexture2D(environment.BRDFLUTSize, environment.BRDFLUTSize, DXGI_FORMAT_R32G32_FLOAT, inCmdList, L"Environment BRDF LUT", environment.BRDFLUT.data());
+	SpecularEnvironmentNumMips = environment.NumMips;
+}
+
+uint32_t SkyboxPass::GetSpecularEnvironmentSRVIndex() const
+{
+	return SpecularEnvironment ? SpecularEnvironment->SRVIndex : 0;
+}
+
+uint32_t SkyboxPass::GetEnvironmentBRDFLUTSRVIndex() const
+{
+	return EnvironmentBRDFLUT ? EnvironmentBRDFLUT->SRVIndex : 0;
 }
 
 
@@ -197,18 +187,18 @@ void SkyboxPass::Init()
 	{
 		D3D12_ROOT_PARAMETER1 rootParameters[2];
 
-		// Constant Buffer
+		// Render View
 		rootParameters[0].ParameterType = D3D12_ROOT_PARAMETER_TYPE_CBV;
 		rootParameters[0].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
 		rootParameters[0].Descriptor.Flags = D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC;
-		rootParameters[0].Descriptor.RegisterSpace = 0;
+		rootParameters[0].Descriptor.RegisterSpace = 100;
 		rootParameters[0].Descriptor.ShaderRegister = 0;
 
 		rootParameters[1].ParameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;
 		rootParameters[1].ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL;
 		rootParameters[1].Constants.RegisterSpace = 1;
 		rootParameters[1].Constants.ShaderRegister = 0;
-		rootParameters[1].Constants.Num32BitValues = 1;
+		rootParameters[1].Constants.Num32BitValues = sizeof(SkyboxConstants) / sizeof(uint32_t);
 
 		//////////////////////////////////////////////////////////////////////////
 
@@ -288,7 +278,7 @@ void SkyboxPass::Init()
 
 }
 
-void SkyboxPass::Execute(ID3D12GraphicsCommandList* inCmdList, D3D12RenderTarget2D& inRT, SceneTextures& inGBuffer)
+void SkyboxPass::Execute(ID3D12GraphicsCommandList* inCmdList, D3D12RenderTarget2D& inRT, SceneTextures& inGBuffer, const RenderView& inView)
 {
 	PIXMarker Marker(inCmdList, "Skybox");
 
@@ -298,6 +288,12 @@ void SkyboxPass::Execute(ID3D12GraphicsCommandList* inCmdList, D3D12RenderTarget
 	ImGui::DragFloat3("Sun Dir", &SunDirection.x, 0.05f, -360.f, 360.f);
 	ImGui::DragFloat3("GroundAlbedo", &GroundAlbedo.x, 0.05f, 0.f, 1.f);
 	ImGui::SliderFloat("Sky Exposure", &SkyExposure, -32.f, 32.f);
+	ImGui::Checkbox("Auto Rebake Specular Environment", &bAutoRebakeSpecularEnvironment);
+	if (ImGui::Button("Rebake Specular Environment"))
+	{
+		bRebakeSpecularEnvironment = true;
+		bInitialized = false;
+	}
 
 	ImGui::End();
 
@@ -317,21 +313,12 @@ void SkyboxPass::Execute(ID3D12GraphicsCommandList* inCmdList, D3D12RenderTarget
 	inCmdList->OMSetRenderTargets(1, renderTargets, false, &inGBuffer.MainDepthBuffer->DSV);
 
 	{
-		SkyboxConstantBuffer constantBufferData;
-
-		SceneManager& sManager = SceneManager::Get();
-		const Scene& currentScene = sManager.GetCurrentScene();
-
-		// All matrices sent to HLSL need to be converted to row-major(what D3D uses) from column-major(what glm uses)
-		constantBufferData.Projection = glm::transpose(currentScene.GetMainCameraProj());
-		constantBufferData.View = glm::transpose(currentScene.GetMainCameraLookAt());
-		constantBufferData.SkyOnlyExposure = SkyExposure;
-
-		MapResult cBufferMap = D3D12Globals::GlobalConstantsBuffer.ReserveTempBufferMemory(sizeof(constantBufferData));
-		memcpy(cBufferMap.CPUAddress, &constantBufferData, sizeof(constantBufferData));
+		SkyboxConstants constants;
+		constants.CubemapIdx = Cubemap->SRVIndex;
+		constants.SkyOnlyExposure = SkyExposure;
 
-		inCmdList->SetGraphicsRootConstantBufferView(0, cBufferMap.GPUAddress);
-		inCmdList->SetGraphicsRoot32BitConstant(1, Cubemap->SRVIndex, 0);
+		inCmdList->SetGraphicsRootConstantBufferView(0, inView.GetConstantsGPUAddress());
+		inCmdList->SetGraphicsRoot32BitConstants(1, sizeof(constants) / sizeof(uint32_t), &constants, 0);
 
 		inCmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
@@ -13,7 +13,15 @@ public:
 
 	void InitSkyModel(struct ID3D12GraphicsCommandList* inCmdList);
 	void Init();
-	void Execute(struct ID3D12GraphicsCommandList* inCmdList, class D3D12RenderTarget2D& inRT, struct SceneTextures& inGBuffer);
+	void Execute(struct ID3D12GraphicsCommandList* inCmdList, class D3D12RenderTarget2D& inRT, struct SceneTextures& inGBuffer, const class RenderView& inView);
+
+	// Split sum inputs for image based specular, 0 if not baked yet
+	uint32_t GetSpecularEnvironmentSRVIndex() const;
+	uint32_t GetEnvironmentBRDFLUTSRVIndex() const;
+	inline uint32_t GetSpecularEnvironmentNumMips() const { return SpecularEnvironmentNumMips; }
+
+private:
+	void BakeSpecularEnvironment(const glm::vec4* inSkyTexels, const uint32_t inSkyRes, struct ID3D12GraphicsCommandList* inCmdList);
 
 private:
 	struct ArHosekSkyModelState* StateR = nullptr;
@@ -21,6 +29,9 @@ private:
 	struct ArHosekSkyModelState* StateB = nullptr;
 
 	eastl::shared_ptr<class D3D12Texture2D> Cubemap;
+	eastl::shared_ptr<class D3D12Texture2D> SpecularEnvironment;
+	eastl::shared_ptr<class D3D12Texture2D> EnvironmentBRDFLUT;
+	uint32_t SpecularEnvironmentNumMips = 0;
 	
 	glm::vec3 SunDirection = glm::vec3(0.25f, 0.95f, -0.15f);
 	glm::vec3 GroundAlbedo = glm::vec3(0.25f, 0.25f, 0.25f);
@@ -32,6 +43,8 @@ private:
 	float SkyExposure = -14.f;
 
 	bool bInitialized = false;
+	bool bAutoRebakeSpecularEnvironment = false;
+	bool bRebakeSpecularEnvironment = false;
 };
 
 
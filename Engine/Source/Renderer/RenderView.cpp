@@ -0,0 +1,207 @@
+#include "Renderer/RenderView.h"
+#include "Renderer/RHI/D3D12/D3D12RHI.h"
+#include "Renderer/RHI/D3D12/D3D12GraphicsTypes_Internal.h"
+#include "Camera/Camera.h"
+#include "Math/AABB.h"
+#include "Math/MathUtils.h"
+#include "glm/ext/matrix_clip_space.hpp"
+#include "glm/gtc/matrix_inverse.hpp"
+
+static float Halton(uint32_t inIndex, const uint32_t inBase)
+{
+	float fraction = 1.f;
+	float result = 0.f;
+	while (inIndex > 0)
+	{
+		fraction /= static_cast<float>(inBase);
+		result += fraction * static_cast<float>(inIndex % inBase);
+		inIndex /= inBase;
+	}
+
+	return result;
+}
+
+glm::vec2 RenderView::GetHaltonJitter(const uint64_t inFrameIndex)
+{
+	// Index 0 of the sequence is 0 in every base, start at 1
+	const uint32_t index = static_cast<uint32_t>(inFrameIndex % 8) + 1;
+	return glm::vec2(Halton(index, 2) - 0.5f, Halton(index, 3) - 0.5f);
+}
+
+void RenderView::Build(Camera& inCamera, const uint32_t inWidth, const uint32_t inHeight, const glm::vec2& inJitter)
+{
+	Width = glm::max(inWidth, 1u);
+	Height = glm::max(inHeight, 1u);
+	Jitter = inJitter;
+	Near = inCamera.GetNear();
+	Far = inCamera.GetFar();
+
+	WorldToView = inCamera.GetLookAt();
+	ViewToClip = inCamera.GetProjectionMat();
+	WorldToClip = ViewToClip * WorldToView;
+
+	// The view is a rigid transform so it inverts without the general inverse
+	ViewToWorld = glm::affineInverse(WorldToView);
+	ClipToView = glm::inverse(ViewToClip);
+	ClipToWorld = ViewToWorld * ClipToView;
+
+	Position = inCamera.GetAbsoluteTransform().Translation;
+	Forward = glm::vec3(WorldToView[0][2], WorldToView[1][2], WorldToView[2][2]);
+
+	ViewFrustum = Frustum::FromMatrix(WorldToClip);
+
+	// Offsetting the z column moves every point by the same amount after the divide, y goes down in pixels and up in clip space
+	JitteredViewToClip = ViewToClip;
+	JitteredViewToClip[2][0] += 2.f * Jitter.x / static_cast<float>(Width);
+	JitteredViewToClip[2][1] -= 2.f * Jitter.y / static_cast<float>(Height);
+
+	const bool bJittered = Jitter != glm::vec2(0.f);
+	JitteredWorldToClip = bJittered ? JitteredViewToClip * WorldToView : WorldToClip;
+	JitteredClipToWorld = bJittered ? ViewToWorld * glm::inverse(JitteredViewToClip) : ClipToWorld;
+}
+
+void RenderView::BuildCascades(const glm::vec3& inLightDir, const CascadeSettings& inSettings, const AABB& inCasterBounds)
+{
+	NumCascades = glm::clamp(inSettings.NumCascades, 0, MAX_NUM_CASCADES);
+	LightDirection = inLightDir;
+
+	if (!inSettings.bFreeze)
+	{
+		CascadeViewToWorld = ViewToWorld;
+	}
+
+	const float shadowDistance = glm::clamp(inSettings.MaxDistance, Near + 0.01f, Far);
+	const float resolution = static_cast<float>(glm::max(inSettings.Resolution, 1u));
+
+	// Half extents of the camera frustum at a depth of 1, the split corners scale from these
+	const float unitHalfWidth = 1.f / ViewToClip[0][0];
+	const float unitHalfHeight = 1.f / ViewToClip[1][1];
+	const float unitRadiusSq = unitHalfWidth * unitHalfWidth + unitHalfHeight * unitHalfHeight;
+
+	// Same order as RenderUtils::GenerateSpaceCorners
+	const glm::vec2 cornerSigns[4] = { glm::vec2(1.f, 1.f), glm::vec2(-1.f, 1.f), glm::vec2(1.f, -1.f), glm::vec2(-1.f, -1.f) };
+
+	// Only rotates, the cascades are placed in it so moving the camera slides them by whole texels
+	const glm::mat4 lightRotation = MathUtils::BuildLookAt(inLightDir, glm::vec3(0.f));
+
+	// Light space depth range of the casters, made of the 8 corners of their bounds
+	float casterMinZ = FLT_MAX;
+	float casterMaxZ = -FLT_MAX;
+	if (inCasterBounds.IsValid())
+	{
+		for (int32_t i = 0; i < 8; ++i)
+		{
+			const glm::vec3 corner = glm::vec3((i & 1) ? inCasterBounds.Max.x : inCasterBounds.Min.x, (i & 2) ? inCasterBounds.Max.y : inCasterBounds.Min.y,
+				(i & 4) ? inCasterBounds.Max.z : inCasterBounds.Min.z);
+			const float z = glm::dot(glm::vec3(lightRotation[0][2], lightRotation[1][2], lightRotation[2][2]), corner);
+
+			casterMinZ = glm::min(casterMinZ, z);
+			casterMaxZ = glm::max(casterMaxZ, z);
+		}
+	}
+
+	float splitNear = Near;
+	for (int32_t i = 0; i < NumCascades; ++i)
+	{
+		// Practical split scheme, logarithmic splits match the perspective texel density but leave the first cascade tiny
+		const float fraction = static_cast<float>(i + 1) / static_cast<float>(NumCascades);
+		const float logSplit = Near * glm::pow(shadowDistance / Near, fraction);
+		const float uniformSplit = Near + (shadowDistance - Near) * fraction;
+		const float splitFar = glm::mix(uniformSplit, logSplit, glm::clamp(inSettings.SplitLambda, 0.f, 1.f));
+
+		const float splitDepths[2] = { splitNear, splitFar };
+		for (int32_t depthIdx = 0; depthIdx < 2; ++depthIdx)
+		{
+			const float depth = splitDepths[depthIdx];
+			for (int32_t cornerIdx = 0; cornerIdx < 4; ++cornerIdx)
+			{
+				const glm::vec4 viewCorner = glm::vec4(cornerSigns[cornerIdx].x * unitHalfWidth * depth, cornerSigns[cornerIdx].y * unitHalfHeight * depth, depth, 1.f);
+				CascadeCorners[i][depthIdx * 4 + cornerIdx] = glm::vec3(CascadeViewToWorld * viewCorner);
+			}
+		}
+
+		// Smallest sphere through the near and far corners of the split, on the view axis so only the camera position and
+		// direction move it. Past the far plane the far corners alone bound it.
+		const float centerDepth = glm::min(0.5f * (splitNear + splitFar) * (1.f + unitRadiusSq), splitFar);
+		const float farOffset = splitFar - centerDepth;
+		float radius = glm::sqrt(farOffset * farOffset + unitRadiusSq * splitFar * splitFar);
+
+		// Rounded up so float noise in the view can't change the size, and with it the texel size
+		radius = glm::ceil(radius * 16.f) / 16.f;
+
+		const glm::vec3 worldCenter = glm::vec3(CascadeViewToWorld * glm::vec4(0.f, 0.f, centerDepth, 1.f));
+		glm::vec3 lightCenter = glm::vec3(lightRotation * glm::vec4(worldCenter, 1.f));
+
+		const float texelSize = 2.f * radius / resolution;
+		lightCenter.x = glm::floor(lightCenter.x / texelSize) * texelSize;
+		lightCenter.y = glm::floor(lightCenter.y / texelSize) * texelSize;
+
+		// Receivers end at the sphere, casters start wherever the closest of them is. Whole units keep small moves of the
+		// casters from changing the matrix.
+		float minZ = lightCenter.z - radius;
+		float maxZ = lightCenter.z + radius;
+		if (casterMinZ <= casterMaxZ)
+		{
+			minZ = casterMinZ;
+			maxZ = glm::min(maxZ, casterMaxZ);
+		}
+		minZ = glm::floor(minZ);
+		maxZ = glm::max(glm::ceil(maxZ), minZ + 1.f);
+
+		const glm::mat4 lightProjection = glm::orthoLH_ZO(lightCenter.x - radius, lightCenter.x + radius, lightCenter.y - radius, lightCenter.y + radius, minZ, maxZ);
+
+		CascadeWorldToClip[i] = lightProjection * lightRotation;
+		CascadeSplits[i] = splitFar;
+
+		splitNear = splitFar;
+	}
+}
+
+void RenderView::Upload()
+{
+	RenderViewConstants constants = {};
+
+	// All matrices sent to HLSL need to be converted to row-major(what D3D uses) from column-major(what glm uses)
+	constants.WorldToView = glm::transpose(WorldToView);
+	constants.ViewToClip = glm::transpose(ViewToClip);
+	constants.WorldToClip = glm::transpose(WorldToClip);
+	constants.ViewToWorld = glm::transpose(ViewToWorld);
+	constants.ClipToView = glm::transpose(ClipToView);
+	constants.ClipToWorld = glm::transpose(ClipToWorld);
+
+	constants.JitteredViewToClip = glm::transpose(JitteredViewToClip);
+	constants.JitteredWorldToClip = glm::transpose(JitteredWorldToClip);
+	constants.JitteredClipToWorld = glm::transpose(JitteredClipToWorld);
+
+	for (int32_t i = 0; i < Frustum::NumPlanes; ++i)
+	{
+		constants.FrustumPlanes[i] = ViewFrustum.Planes[i];
+	}
+
+	const glm::vec2 size = glm::vec2(static_cast<float>(Width), static_cast<float>(Height));
+	constants.CameraPosition = glm::vec4(Position, Near);
+	constants.CameraForward = glm::vec4(Forward, Far);
+	constants.ViewportSize = glm::vec4(size, 1.f / size);
+	constants.Jitter = glm::vec4(2.f * Jitter.x / size.x, -2.f * Jitter.y / size.y, 0.f, 0.f);
+
+	for (int32_t i = 0; i < NumCascades; ++i)
+	{
+		constants.CascadeWorldToClip[i] = glm::transpose(CascadeWorldToClip[i]);
+		constants.CascadeSplits[i] = CascadeSplits[i];
+	}
+	constants.LightDirection = glm::vec4(LightDirection, static_cast<float>(NumCascades));
+
+	MapResult cBufferMap = D3D12Globals::GlobalConstantsBuffer.ReserveTempBufferMemory(sizeof(constants));
+	memcpy(cBufferMap.CPUAddress, &constants, sizeof(constants));
+	ConstantsGPUAddress = cBufferMap.GPUAddress;
+}
+
+DrawPacketView RenderView::GetDrawPacketView() const
+{
+	DrawPacketView packetView;
+	packetView.Position = Position;
+	packetView.Forward = Forward;
+	packetView.MaxDepth = Far;
+
+	return packetView;
+}
@@ -0,0 +1,130 @@
+#pragma once
+#include <stdint.h>
+#include "glm/glm.hpp"
+#include "Math/Frustum.h"
+#include "Renderer/DrawPacket.h"
+
+#define MAX_NUM_CASCADES 3
+
+struct CascadeSettings
+{
+	int32_t NumCascades = MAX_NUM_CASCADES;
+
+	// Blend between uniform(0) and logarithmic(1) split distances
+	float SplitLambda = 0.75f;
+
+	// View depth the last cascade ends at, clamped to the camera far plane
+	float MaxDistance = 100.f;
+
+	// Texels per side of a cascade, the projections snap to them
+	uint32_t Resolution = 1024;
+
+	// Frozen cascades keep being fit around the camera position they were frozen at, to look at them from somewhere else
+	bool bFreeze = false;
+};
+
+// Layout of the view constant block, matrices are transposed to the row-major layout HLSL reads
+struct RenderViewConstants
+{
+	glm::mat4 WorldToView;
+	glm::mat4 ViewToClip;
+	glm::mat4 WorldToClip;
+	glm::mat4 ViewToWorld;
+	glm::mat4 ClipToView;
+	glm::mat4 ClipToWorld;
+
+	// What gets rasterized, equal to the ones above when jitter is off
+	glm::mat4 JitteredViewToClip;
+	glm::mat4 JitteredWorldToClip;
+	glm::mat4 JitteredClipToWorld;
+
+	glm::vec4 FrustumPlanes[Frustum::NumPlanes];
+
+	// Near in w
+	glm::vec4 CameraPosition;
+	// Far in w
+	glm::vec4 CameraForward;
+	// Size in xy, inverse size in zw
+	glm::vec4 ViewportSize;
+	// Clip space offset of the jittered projection in xy
+	glm::vec4 Jitter;
+
+	glm::mat4 CascadeWorldToClip[MAX_NUM_CASCADES];
+	// View depth each cascade ends at
+	glm::vec4 CascadeSplits;
+	// Number of cascades in w
+	glm::vec4 LightDirection;
+
+	float Padding[16];
+};
+static_assert((sizeof(RenderViewConstants) % 256) == 0, "Constant Buffer size must be 256-byte aligned");
+
+/**
+ * Everything the passes need to know about the camera for a frame, computed once before any of them runs.
+ * The camera matrices, their inverses, the culling frustum and the shadow cascades are built here and uploaded as a single
+ * constant block that every pass binds, at b0 space100 in the shaders, instead of each pass deriving and uploading its own.
+ * Culling uses the unjittered frustum so visibility doesn't flicker with the sub pixel offsets.
+ */
+class RenderView
+{
+public:
+	// The jitter is a sub pixel offset in pixels applied to the projection
+	void Build(class Camera& inCamera, const uint32_t inWidth, const uint32_t inHeight, const glm::vec2& inJitter = glm::vec2(0.f));
+
+	// Fits an orthographic light projection around the bounding sphere of each split of the camera frustum. The sphere keeps the
+	// same size when the camera turns and its center is snapped to whole texels, so shadow edges don't shimmer and a still
+	// cascade keeps the exact same matrix. Depth is tightened to the caster bounds, keeping the casters between the light and the cascade.
+	void BuildCascades(const glm::vec3& inLightDir, const CascadeSettings& inSettings, const AABB& inCasterBounds);
+
+	// Reserves the constant block in the frame's constant memory, the address stays valid until the frame ends
+	void Upload();
+
+	// Offset in pixels in [-0.5, 0.5] from the Halton(2, 3) sequence, repeating every 8 frames
+	static glm::vec2 GetHaltonJitter(const uint64_t inFrameIndex);
+
+	inline uint64_t GetConstantsGPUAddress() const { return ConstantsGPUAddress; }
+	DrawPacketView GetDrawPacketView() const;
+
+	inline int32_t GetNumCascades() const { return NumCascades; }
+	inline const glm::mat4& GetCascadeWorldToClip(const int32_t inCascade) const { return CascadeWorldToClip[inCascade]; }
+	inline const glm::vec3& GetLightDirection() const { return LightDirection; }
+
+	// For a cascade whose shadow map is kept from an earlier frame, the shaders have to sample it with the matrix it was drawn with
+	inline void OverrideCascadeWorldToClip(const int32_t inCascade, const glm::mat4& inWorldToClip) { CascadeWorldToClip[inCascade] = inWorldToClip; }
+	// World space corners of the part of the camera frustum a cascade covers, in the order of RenderUtils::GenerateSpaceCorners
+	inline const glm::vec3* GetCascadeCorners(const int32_t inCascade) const { return CascadeCorners[inCascade]; }
+
+public:
+	glm::mat4 WorldToView = glm::mat4(1.f);
+	glm::mat4 ViewToClip = glm::mat4(1.f);
+	glm::mat4 WorldToClip = glm::mat4(1.f);
+	glm::mat4 ViewToWorld = glm::mat4(1.f);
+	glm::mat4 ClipToView = glm::mat4(1.f);
+	glm::mat4 ClipToWorld = glm::mat4(1.f);
+
+	glm::mat4 JitteredViewToClip = glm::mat4(1.f);
+	glm::mat4 JitteredWorldToClip = glm::mat4(1.f);
+	glm::mat4 JitteredClipToWorld = glm::mat4(1.f);
+
+	Frustum ViewFrustum;
+
+	glm::vec3 Position = glm::vec3(0.f);
+	glm::vec3 Forward = glm::vec3(0.f, 0.f, 1.f);
+	glm::vec2 Jitter = glm::vec2(0.f);
+	float Near = 0.f;
+	float Far = 0.f;
+	uint32_t Width = 0;
+	uint32_t Height = 0;
+
+private:
+	int32_t NumCascades = 0;
+	glm::vec3 LightDirection = glm::vec3(0.f, -1.f, 0.f);
+	glm::mat4 CascadeWorldToClip[MAX_NUM_CASCADES];
+	glm::vec3 CascadeCorners[MAX_NUM_CASCADES][8];
+	float CascadeSplits[MAX_NUM_CASCADES] = {};
+
+	// Camera the cascades were last fit around
+	glm::mat4 CascadeViewToWorld = glm::mat4(1.f);
+
+	uint64_t ConstantsGPUAddress = 0;
+};
@@ -0,0 +1,85 @@
+#include "Renderer/SceneInstances.h"
+#include "EASTL/algorithm.h"
+#include "Core/TaskSystem.h"
+#include "Renderer/Model/3D/Model3D.h"
+#include "Scene/Scene.h"
+#include "glm/gtc/matrix_inverse.hpp"
+
+uint32_t SceneInstanceCache::Update(const eastl::vector<SceneMeshRenderable>& inRenderables)
+{
+	DirtySlots.clear();
+
+	uint32_t numSlots = GetNumSlots();
+	for (const SceneMeshRenderable& renderable : inRenderables)
+	{
+		numSlots = glm::max(numSlots, renderable.InstanceSlot + 1);
+	}
+
+	Instances.resize(numSlots);
+	SlotGenerations.resize(numSlots, NeverWritten);
+	SlotWorldVersions.resize(numSlots, 0);
+
+	TaskSystem& tasks = TaskSystem::Get();
+	WorkerDirtySlots.resize(tasks.GetNumWorkers());
+	for (eastl::vector<uint32_t>& workerSlots : WorkerDirtySlots)
+	{
+		workerSlots.clear();
+	}
+
+	// Every renderable owns its slot, so the workers never write to the same one
+	tasks.ParallelFor(static_cast<uint32_t>(inRenderables.size()), 256, [&](const uint32_t inBegin, const uint32_t inEnd, const uint32_t inWorkerIdx)
+	{
+		eastl::vector<uint32_t>& workerSlots = WorkerDirtySlots[inWorkerIdx];
+
+		for (uint32_t i = inBegin; i < inEnd; ++i)
+		{
+			const SceneMeshRenderable& renderable = inRenderables[i];
+			const MeshNode* mesh = renderable.Mesh;
+			const uint32_t slot = renderable.InstanceSlot;
+			const uint32_t worldVersion = mesh->GetWorldVersion();
+
+			if (SlotGenerations[slot] == renderable.InstanceGeneration && SlotWorldVersions[slot] == worldVersion && Instances[slot].MaterialIndex == mesh->MatIndex)
+			{
+				continue;
+			}
+
+			WriteInstance(mesh->GetAbsoluteMatrix(), mesh->MatIndex, Instances[slot]);
+			SlotGenerations[slot] = renderable.InstanceGeneration;
+			SlotWorldVersions[slot] = worldVersion;
+
+			workerSlots.push_back(slot);
+		}
+	});
+
+	for (const eastl::vector<uint32_t>& workerSlots : WorkerDirtySlots)
+	{
+		DirtySlots.insert(DirtySlots.end(), workerSlots.begin(), workerSlots.end());
+	}
+
+	return static_cast<uint32_t>(DirtySlots.size());
+}
+
+void SceneInstanceCache::Reset()
+{
+	eastl::fill(SlotGenerations.begin(), SlotGenerations.end(), NeverWritten);
+}
+
+void SceneInstanceCache::WriteInstance(const glm::mat4& inLocalToWorld, const uint32_t inMaterialIndex, GPUSceneInstance& outInstance)
+{
+	// Columns of the transposed glm matrix are the rows
+	const glm::mat4 localToWorldRows = glm::transpose(inLocalToWorld);
+	outInstance.LocalToWorld[0] = localToWorldRows[0];
+	outInstance.LocalToWorld[1] = localToWorldRows[1];
+	outInstance.LocalToWorld[2] = localToWorldRows[2];
+
+	// A zero scale has no inverse, the normals of such a flattened object don't matter much
+	const glm::mat3 localToWorld3x3 = glm::mat3(inLocalToWorld);
+	const glm::mat3 normalToWorld = glm::abs(glm::determinant(localToWorld3x3)) > 1e-12f ? glm::inverseTranspose(localToWorld3x3) : localToWorld3x3;
+
+	const glm::mat3 normalToWorldRows = glm::transpose(normalToWorld);
+	outInstance.NormalToWorld0 = normalToWorldRows[0];
+	outInstance.NormalToWorld1 = normalToWorldRows[1];
+	outInstance.NormalToWorld2 = normalToWorldRows[2];
+
+	outInstance.MaterialIndex = inMaterialIndex;
+}
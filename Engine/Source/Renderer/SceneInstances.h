@@ -0,0 +1,60 @@
+#pragma once
+#include <stdint.h>
+#include "EASTL/vector.h"
+#include "glm/glm.hpp"
+
+struct SceneMeshRenderable;
+
+// Per renderable data the vertex shaders read from the persistent instance buffer
+struct GPUSceneInstance
+{
+	// Rows of the local to world affine transform
+	glm::vec4 LocalToWorld[3];
+
+	// Rows of the inverse transpose of its upper 3x3, normals stay perpendicular to the surface under non uniform scale
+	glm::vec3 NormalToWorld0;
+	uint32_t MaterialIndex = 0;
+	glm::vec3 NormalToWorld1;
+	uint32_t Padding0 = 0;
+	glm::vec3 NormalToWorld2;
+	uint32_t Padding1 = 0;
+};
+
+static_assert((sizeof(GPUSceneInstance) % 16) == 0, "Structs in Structured Buffers have to be 16-byte aligned");
+
+/**
+ * CPU side of the persistent instance buffer, which holds one slot per scene renderable for as long as it stays in the scene.
+ * Slots are the slot map indices the scene gives its renderables, so they don't move when other meshes get removed and
+ * freed ones are reused by the next registered mesh.
+ * Update compares the slot generation, world transform version and material of every renderable against the ones its slot
+ * was last written with and only rewrites the slots that changed, the upload that follows then scales with what moved instead
+ * of the scene size. World versions restart for every new transform, so the generation is what tells a mesh added back into
+ * a reused slot apart from the one that was removed, even at the same address.
+ */
+class SceneInstanceCache
+{
+public:
+	// World transforms have to be up to date, returns the number of slots rewritten
+	uint32_t Update(const eastl::vector<SceneMeshRenderable>& inRenderables);
+
+	// Forgets what every slot holds, the next Update rewrites all of them
+	void Reset();
+
+	static void WriteInstance(const glm::mat4& inLocalToWorld, const uint32_t inMaterialIndex, GPUSceneInstance& outInstance);
+
+	// Slots rewritten by the last Update, in no particular order
+	inline const eastl::vector<uint32_t>& GetDirtySlots() const { return DirtySlots; }
+	inline const GPUSceneInstance& GetInstance(const uint32_t inSlot) const { return Instances[inSlot]; }
+	inline uint32_t GetNumSlots() const { return static_cast<uint32_t>(Instances.size()); }
+
+private:
+	eastl::vector<GPUSceneInstance> Instances;
+
+	// Slot generation and world transform version each slot was last written with, NeverWritten until the first write
+	static constexpr uint32_t NeverWritten = uint32_t(-1);
+	eastl::vector<uint32_t> SlotGenerations;
+	eastl::vector<uint32_t> SlotWorldVersions;
+
+	eastl::vector<uint32_t> DirtySlots;
+	eastl::vector<eastl::vector<uint32_t>> WorkerDirtySlots;
+};
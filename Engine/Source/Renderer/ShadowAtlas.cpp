@@ -0,0 +1,539 @@
+#include "Renderer/ShadowAtlas.h"
+#include "Renderer/RenderView.h"
+#include "Core/EngineUtils.h"
+#include "EASTL/algorithm.h"
+#include "EASTL/sort.h"
+#include "EASTL/string.h"
+#include "Utils/PerfUtils.h"
+#include "Utils/TestUtils.h"
+#include "glm/ext/matrix_clip_space.hpp"
+
+// How far past the current size, in powers of two, the coverage has to get before a light's tile size changes
+static constexpr float TileSizeHysteresis = 0.75f;
+
+static inline uint32_t PackPosition(const uint32_t inX, const uint32_t inY)
+{
+	return inX | (inY << 16);
+}
+
+static inline bool RemoveFreeTile(eastl::vector<uint32_t>& ioTiles, const uint32_t inPosition)
+{
+	for (uint32_t i = 0; i < ioTiles.size(); ++i)
+	{
+		if (ioTiles[i] == inPosition)
+		{
+			ioTiles[i] = ioTiles.back();
+			ioTiles.pop_back();
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void ShadowAtlas::Init(const uint32_t inAtlasSize, const uint32_t inMinTileSize, const uint32_t inMaxTileSize)
+{
+	ASSERT(glm::bitCount(inAtlasSize) == 1 && glm::bitCount(inMinTileSize) == 1 && glm::bitCount(inMaxTileSize) == 1);
+	ASSERT(inMinTileSize <= inMaxTileSize && inMaxTileSize <= inAtlasSize && inAtlasSize <= 0xFFFF);
+
+	AtlasSize = inAtlasSize;
+	MinTileSize = inMinTileSize;
+	MaxTileSize = inMaxTileSize;
+	NumLevels = GetLevel(MinTileSize) + 1;
+
+	Lights.clear();
+	NumRepacks = 0;
+	ResetFreeTiles();
+}
+
+void ShadowAtlas::ResetFreeTiles()
+{
+	FreeTiles.clear();
+	FreeTiles.resize(NumLevels);
+	FreeTiles[0].push_back(PackPosition(0, 0));
+	AllocatedArea = 0;
+}
+
+uint32_t ShadowAtlas::GetLevel(const uint32_t inSize) const
+{
+	return static_cast<uint32_t>(glm::findMSB(AtlasSize) - glm::findMSB(inSize));
+}
+
+bool ShadowAtlas::AllocateTile(const uint32_t inSize, ShadowAtlasTile& outTile)
+{
+	const uint32_t level = GetLevel(inSize);
+
+	// Smallest free square that can hold the tile
+	int32_t sourceLevel = static_cast<int32_t>(level);
+	while (sourceLevel >= 0 && FreeTiles[sourceLevel].empty())
+	{
+		--sourceLevel;
+	}
+
+	if (sourceLevel < 0)
+	{
+		return false;
+	}
+
+	const uint32_t position = FreeTiles[sourceLevel].back();
+	FreeTiles[sourceLevel].pop_back();
+
+	uint32_t x = position & 0xFFFF;
+	uint32_t y = position >> 16;
+
+	// Keep the top left quarter on the way down, the other three become free squares of the level below
+	for (uint32_t splitLevel = static_cast<uint32_t>(sourceLevel) + 1; splitLevel <= level; ++splitLevel)
+	{
+		const uint32_t half = AtlasSize >> splitLevel;
+		FreeTiles[splitLevel].push_back(PackPosition(x + half, y));
+		FreeTiles[splitLevel].push_back(PackPosition(x, y + half));
+		FreeTiles[splitLevel].push_back(PackPosition(x + half, y + half));
+	}
+
+	outTile.X = x;
+	outTile.Y = y;
+	outTile.Size = inSize;
+	AllocatedArea += static_cast<uint64_t>(inSize) * inSize;
+
+	return true;
+}
+
+void ShadowAtlas::FreeTile(const ShadowAtlasTile& inTile)
+{
+	uint32_t level = GetLevel(inTile.Size);
+	uint32_t x = inTile.X;
+	uint32_t y = inTile.Y;
+	AllocatedArea -= static_cast<uint64_t>(inTile.Size) * inTile.Size;
+
+	// Merges with the other quarters of the parent square as long as they are all free
+	while (level > 0)
+	{
+		const uint32_t size = AtlasSize >> level;
+		const uint32_t parentX = x & ~(2 * size - 1);
+		const uint32_t parentY = y & ~(2 * size - 1);
+		const uint32_t quarters[4] = { PackPosition(parentX, parentY), PackPosition(parentX + size, parentY), PackPosition(parentX, parentY + size),
+			PackPosition(parentX + size, parentY + size) };
+
+		eastl::vector<uint32_t>& freeTiles = FreeTiles[level];
+		const uint32_t self = PackPosition(x, y);
+
+		bool bSiblingsFree = true;
+		for (uint32_t quarter : quarters)
+		{
+			if (quarter == self)
+			{
+				continue;
+			}
+
+			bool bFree = false;
+			for (uint32_t freePosition : freeTiles)
+			{
+				bFree |= freePosition == quarter;
+			}
+
+			bSiblingsFree &= bFree;
+		}
+
+		if (!bSiblingsFree)
+		{
+			break;
+		}
+
+		for (uint32_t quarter : quarters)
+		{
+			if (quarter != self)
+			{
+				RemoveFreeTile(freeTiles, quarter);
+			}
+		}
+
+		x = parentX;
+		y = parentY;
+		--level;
+	}
+
+	FreeTiles[level].push_back(PackPosition(x, y));
+}
+
+void ShadowAtlas::FreeLight(LightTiles& ioLight)
+{
+	for (uint32_t i = 0; i < ioLight.NumFaces; ++i)
+	{
+		if (ioLight.Faces[i].Size > 0)
+		{
+			FreeTile(ioLight.Faces[i]);
+		}
+
+		ioLight.Faces[i] = ShadowAtlasTile();
+	}
+
+	ioLight.bContentsValid = false;
+}
+
+bool ShadowAtlas::AllocateLight(LightTiles& ioLight)
+{
+	for (uint32_t i = 0; i < ioLight.NumFaces; ++i)
+	{
+		if (!AllocateTile(ioLight.TileSize, ioLight.Faces[i]))
+		{
+			FreeLight(ioLight);
+			return false;
+		}
+	}
+
+	ioLight.bContentsValid = false;
+	return true;
+}
+
+void ShadowAtlas::AssignTileSizes(const eastl::vector<ShadowAtlasRequest>& inRequests)
+{
+	const uint32_t numRequests = static_cast<uint32_t>(inRequests.size());
+	TileSizes.resize(numRequests);
+
+	const float minLog = static_cast<float>(glm::findMSB(MinTileSize));
+	const float maxLog = static_cast<float>(glm::findMSB(MaxTileSize));
+
+	uint64_t totalArea = 0;
+	for (uint32_t i = 0; i < numRequests; ++i)
+	{
+		const ShadowAtlasRequest& request = inRequests[i];
+		const float desiredLog = glm::clamp(glm::log2(glm::max(request.ScreenCoverage * static_cast<float>(MaxTileSize), 1.f)), minLog, maxLog);
+		float sizeLog = glm::round(desiredLog);
+
+		const auto existing = Lights.find(request.LightId);
+		if (existing != Lights.end() && existing->second.TileSize > 0)
+		{
+			const float currentLog = static_cast<float>(glm::findMSB(existing->second.TileSize));
+			if (glm::abs(desiredLog - currentLog) < TileSizeHysteresis)
+			{
+				sizeLog = currentLog;
+			}
+		}
+
+		const uint32_t numFaces = request.Type == ELocalLightShadow::Point ? 6 : 1;
+		TileSizes[i] = 1u << static_cast<uint32_t>(sizeLog);
+		totalArea += static_cast<uint64_t>(TileSizes[i]) * TileSizes[i] * numFaces;
+	}
+
+	// Most important first
+	RequestOrder.resize(numRequests);
+	for (uint32_t i = 0; i < numRequests; ++i)
+	{
+		RequestOrder[i] = i;
+	}
+	eastl::sort(RequestOrder.begin(), RequestOrder.end(), [&inRequests](const uint32_t inA, const uint32_t inB)
+	{
+		return inRequests[inA].ScreenCoverage > inRequests[inB].ScreenCoverage || (inRequests[inA].ScreenCoverage == inRequests[inB].ScreenCoverage && inA < inB);
+	});
+
+	// Over budget, the largest tiles get halved first and the least important of them before the others
+	const uint64_t budget = static_cast<uint64_t>(AtlasSize) * AtlasSize;
+	for (uint32_t size = MaxTileSize; size > MinTileSize && totalArea > budget; size /= 2)
+	{
+		for (uint32_t orderIdx = numRequests; orderIdx-- > 0 && totalArea > budget;)
+		{
+			const uint32_t requestIdx = RequestOrder[orderIdx];
+			if (TileSizes[requestIdx] != size)
+			{
+				continue;
+			}
+
+			const uint64_t numFaces = inRequests[requestIdx].Type == ELocalLightShadow::Point ? 6 : 1;
+			TileSizes[requestIdx] = size / 2;
+			totalArea -= (static_cast<uint64_t>(size) * size - static_cast<uint64_t>(size / 2) * (size / 2)) * numFaces;
+		}
+	}
+
+	// Everything at the smallest size and still too many, the least important lights go without shadows
+	for (uint32_t orderIdx = numRequests; orderIdx-- > 0 && totalArea > budget;)
+	{
+		const uint32_t requestIdx = RequestOrder[orderIdx];
+		const uint64_t numFaces = inRequests[requestIdx].Type == ELocalLightShadow::Point ? 6 : 1;
+		totalArea -= static_cast<uint64_t>(TileSizes[requestIdx]) * TileSizes[requestIdx] * numFaces;
+		TileSizes[requestIdx] = 0;
+	}
+}
+
+void ShadowAtlas::Update(const eastl::vector<ShadowAtlasRequest>& inRequests)
+{
+	ASSERT(AtlasSize > 0);
+
+	++UpdateIndex;
+	AssignTileSizes(inRequests);
+
+	const uint32_t numRequests = static_cast<uint32_t>(inRequests.size());
+
+	// Lights whose tiles don't fit anymore give them back before anything gets allocated
+	for (uint32_t i = 0; i < numRequests; ++i)
+	{
+		const ShadowAtlasRequest& request = inRequests[i];
+		LightTiles& light = Lights[request.LightId];
+		light.LastSeenUpdate = UpdateIndex;
+
+		const uint32_t numFaces = request.Type == ELocalLightShadow::Point ? 6 : 1;
+		if (light.TileSize != TileSizes[i] || light.NumFaces != numFaces)
+		{
+			FreeLight(light);
+			light.TileSize = TileSizes[i];
+			light.NumFaces = numFaces;
+		}
+	}
+
+	for (auto it = Lights.begin(); it != Lights.end();)
+	{
+		if (it->second.LastSeenUpdate != UpdateIndex)
+		{
+			FreeLight(it->second);
+			it = Lights.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+
+	// Largest first leaves the small free squares for the small tiles
+	eastl::sort(RequestOrder.begin(), RequestOrder.end(), [this](const uint32_t inA, const uint32_t inB)
+	{
+		return TileSizes[inA] > TileSizes[inB] || (TileSizes[inA] == TileSizes[inB] && inA < inB);
+	});
+
+	bool bRepack = false;
+	for (const uint32_t requestIdx : RequestOrder)
+	{
+		LightTiles& light = Lights[inRequests[requestIdx].LightId];
+		if (light.TileSize == 0 || light.Faces[0].Size != 0)
+		{
+			continue;
+		}
+
+		if (!AllocateLight(light))
+		{
+			bRepack = true;
+			break;
+		}
+	}
+
+	// Power of two squares placed largest first always fit when their area does
+	if (bRepack)
+	{
+		++NumRepacks;
+		ResetFreeTiles();
+
+		for (auto& entry : Lights)
+		{
+			for (ShadowAtlasTile& face : entry.second.Faces)
+			{
+				face = ShadowAtlasTile();
+			}
+			entry.second.bContentsValid = false;
+		}
+
+		for (const uint32_t requestIdx : RequestOrder)
+		{
+			LightTiles& light = Lights[inRequests[requestIdx].LightId];
+			if (light.TileSize > 0)
+			{
+				const bool bAllocated = AllocateLight(light);
+				ASSERT(bAllocated);
+			}
+		}
+	}
+
+	Allocations.resize(numRequests);
+	for (uint32_t i = 0; i < numRequests; ++i)
+	{
+		const ShadowAtlasRequest& request = inRequests[i];
+		LightTiles& light = Lights[request.LightId];
+		ShadowAtlasAllocation& allocation = Allocations[i];
+
+		allocation.NumFaces = light.NumFaces;
+		for (uint32_t face = 0; face < light.NumFaces; ++face)
+		{
+			allocation.Faces[face] = light.Faces[face];
+		}
+
+		allocation.bNeedsRender = light.TileSize > 0 && (!request.bStatic || !light.bContentsValid || request.bCastersChanged);
+
+		// Drawn this frame if it wasn't already
+		light.bContentsValid = light.TileSize > 0;
+	}
+}
+
+float ShadowAtlas::GetOccupancy() const
+{
+	return AtlasSize > 0 ? static_cast<float>(static_cast<double>(AllocatedArea) / (static_cast<double>(AtlasSize) * AtlasSize)) : 0.f;
+}
+
+float ShadowAtlas::ComputeScreenCoverage(const glm::vec3& inCenter, const float inRadius, const RenderView& inView)
+{
+	const float distanceSq = glm::dot(inCenter - inView.Position, inCenter - inView.Position);
+	if (distanceSq <= inRadius * inRadius)
+	{
+		return 1.f;
+	}
+
+	// Tangent of the angle the sphere spans from the camera, scaled the same way the projection scales view space heights.
+	// Clip space height is 2, so the projected radius is also the fraction of the screen height the diameter covers.
+	const float projectedRadius = inRadius / glm::sqrt(distanceSq - inRadius * inRadius) * inView.ViewToClip[1][1];
+	return glm::min(projectedRadius, 1.f);
+}
+
+// Lights spread over a level the camera walks through, a fifth of them point lights and most of them static
+class BenchmarkLights
+{
+public:
+	BenchmarkLights(const uint32_t inNumLights)
+		: Positions(inNumLights), Radii(inNumLights), Requests(inNumLights)
+	{
+		for (uint32_t i = 0; i < inNumLights; ++i)
+		{
+			const glm::vec3 offset = Random.NextVec3();
+			Positions[i] = glm::vec3(offset.x - 0.5f, 0.05f * offset.y, offset.z - 0.5f) * LevelSize;
+			Radii[i] = 5.f + 15.f * Random.Next();
+
+			Requests[i].LightId = i;
+			Requests[i].Type = i % 5 == 0 ? ELocalLightShadow::Point : ELocalLightShadow::Spot;
+			Requests[i].bStatic = Random.Next() < 0.7f;
+		}
+
+		View.ViewToClip = glm::perspectiveLH_ZO(glm::radians(70.f), 16.f / 9.f, 0.1f, 500.f);
+	}
+
+	// Walking in a circle through the level, the dynamic lights wander around
+	void Update(const uint32_t inFrame)
+	{
+		const float angle = static_cast<float>(inFrame) * 0.01f;
+		View.Position = glm::vec3(glm::cos(angle), 0.f, glm::sin(angle)) * LevelSize * 0.3f + glm::vec3(0.f, 2.f, 0.f);
+
+		for (uint32_t i = 0; i < Requests.size(); ++i)
+		{
+			ShadowAtlasRequest& request = Requests[i];
+			if (!request.bStatic)
+			{
+				const float x = Random.Next();
+				const float z = Random.Next();
+				Positions[i] += (glm::vec3(x, 0.f, z) - 0.5f) * 0.5f;
+			}
+
+			request.bCastersChanged = request.bStatic && Random.Next() < 0.02f;
+			request.ScreenCoverage = ShadowAtlas::ComputeScreenCoverage(Positions[i], Radii[i], View);
+		}
+	}
+
+	inline const eastl::vector<ShadowAtlasRequest>& GetRequests() const { return Requests; }
+
+private:
+	static constexpr float LevelSize = 200.f;
+
+	TestUtils::TestRandom Random;
+	eastl::vector<glm::vec3> Positions;
+	eastl::vector<float> Radii;
+	eastl::vector<ShadowAtlasRequest> Requests;
+	RenderView View;
+};
+
+void ShadowAtlas::Benchmark(const uint32_t inNumLights, const uint32_t inNumFrames)
+{
+	if (inNumLights == 0 || inNumFrames == 0)
+	{
+		return;
+	}
+
+	// 32 MB of 16 bit depth, tiles from 64 to 1024 texels
+	ShadowAtlas atlas;
+	atlas.Init(4096, 64, 1024);
+
+	BenchmarkLights lights(inNumLights);
+
+	int64_t totalUs = 0;
+	int64_t maxUs = 0;
+	double occupancy = 0.0;
+	uint64_t numTiles = 0;
+	uint64_t numTilesDrawn = 0;
+	uint64_t numUnshadowed = 0;
+	for (uint32_t frame = 0; frame < inNumFrames; ++frame)
+	{
+		lights.Update(frame);
+
+		int64_t frameUs = 0;
+		{
+			Utils::BenchmarkCode bench(&frameUs);
+			atlas.Update(lights.GetRequests());
+		}
+
+		totalUs += frameUs;
+		maxUs = glm::max(maxUs, frameUs);
+		occupancy += atlas.GetOccupancy();
+
+		for (const ShadowAtlasAllocation& allocation : atlas.GetAllocations())
+		{
+			numUnshadowed += allocation.Faces[0].Size == 0 ? 1 : 0;
+			for (uint32_t face = 0; face < allocation.NumFaces; ++face)
+			{
+				const bool bAllocated = allocation.Faces[face].Size != 0;
+				numTiles += bAllocated ? 1 : 0;
+				numTilesDrawn += bAllocated && allocation.bNeedsRender ? 1 : 0;
+			}
+		}
+	}
+
+	LOG_INFO("Shadow atlas(%u lights, %u texels): update %f ms average, %f ms worst, %f%% occupied, %f lights without shadows and %f of %f tiles drawn per frame, %u repacks.",
+		inNumLights, atlas.GetAtlasSize(), totalUs * 1e-3 / inNumFrames, maxUs * 1e-3, occupancy * 100.0 / inNumFrames, static_cast<double>(numUnshadowed) / inNumFrames,
+		static_cast<double>(numTilesDrawn) / inNumFrames, static_cast<double>(numTiles) / inNumFrames, atlas.GetNumRepacks());
+}
+
+void ShadowAtlas::RunChecks()
+{
+	constexpr uint32_t numLights = 256;
+	constexpr uint32_t numFrames = 300;
+
+	ShadowAtlas atlas;
+	atlas.Init(4096, 64, 1024);
+
+	BenchmarkLights lights(numLights);
+
+	const uint32_t numCells = atlas.GetAtlasSize() / atlas.MinTileSize;
+	eastl::vector<uint8_t> cells(numCells * numCells);
+
+	// Every allocated tile has to lie inside the atlas without covering a cell of another tile
+	TestUtils::CheckScope check("Shadow atlas tiles without overlaps");
+	for (uint32_t frame = 0; frame < numFrames; ++frame)
+	{
+		lights.Update(frame);
+		atlas.Update(lights.GetRequests());
+
+		eastl::fill(cells.begin(), cells.end(), uint8_t(0));
+		for (const ShadowAtlasAllocation& allocation : atlas.GetAllocations())
+		{
+			for (uint32_t face = 0; face < allocation.NumFaces; ++face)
+			{
+				const ShadowAtlasTile& tile = allocation.Faces[face];
+				if (tile.Size == 0)
+				{
+					continue;
+				}
+
+				const uint32_t cellX = tile.X / atlas.MinTileSize;
+				const uint32_t cellY = tile.Y / atlas.MinTileSize;
+				const uint32_t cellSize = tile.Size / atlas.MinTileSize;
+				if (!check.Expect(cellX + cellSize <= numCells && cellY + cellSize <= numCells))
+				{
+					continue;
+				}
+
+				bool bOverlaps = false;
+				for (uint32_t y = cellY; y < cellY + cellSize; ++y)
+				{
+					for (uint32_t x = cellX; x < cellX + cellSize; ++x)
+					{
+						bOverlaps |= cells[y * numCells + x] != 0;
+						cells[y * numCells + x] = 1;
+					}
+				}
+
+				check.Expect(!bOverlaps);
+			}
+		}
+	}
+}
@@ -0,0 +1,121 @@
+#pragma once
+#include <stdint.h>
+#include "EASTL/vector.h"
+#include "EASTL/unordered_map.h"
+#include "glm/glm.hpp"
+
+// Spot lights draw one shadow map, point lights one per cube face
+enum class ELocalLightShadow : uint8_t
+{
+	Spot = 0,
+	Point
+};
+
+struct ShadowAtlasRequest
+{
+	// Stable across frames, the tiles of a light are kept under it
+	uint32_t LightId = 0;
+	ELocalLightShadow Type = ELocalLightShadow::Spot;
+
+	// Fraction of the screen height the light's influence covers, see ComputeScreenCoverage
+	float ScreenCoverage = 0.f;
+
+	// Static lights keep the contents of their tiles for as long as the tiles don't move and none of their casters change
+	bool bStatic = false;
+	bool bCastersChanged = false;
+};
+
+struct ShadowAtlasTile
+{
+	uint32_t X = 0;
+	uint32_t Y = 0;
+	uint32_t Size = 0;
+};
+
+struct ShadowAtlasAllocation
+{
+	// Size 0 when the light didn't fit in the budget and gets no shadows this frame
+	ShadowAtlasTile Faces[6];
+	uint32_t NumFaces = 0;
+
+	// The tiles have to be drawn this frame, their contents are stale or they just moved
+	bool bNeedsRender = false;
+};
+
+/**
+ * Packs the shadow maps of the local lights into a single square depth texture, so dozens of shadowed lights fit in a
+ * fixed amount of memory.
+ * Tile sizes are powers of two picked from how much of the screen a light covers, then halved starting with the largest
+ * and least important tiles until they all fit in the atlas. Sizes only change once the coverage moved well past a power
+ * of two, so lights hovering around one don't move back and forth.
+ * Tiles come from a quad tree: a free square of the next size up is split in 4 and the parts get merged again once all
+ * of them are free. Each Update only frees and allocates the tiles of lights that changed size, appeared or went away,
+ * everything else stays in place. When fragmentation leaves no room for a tile that fits in the free area, the atlas is
+ * packed again from scratch, largest tiles first, which moves every tile.
+ * Tiles of static lights that stayed in place don't get drawn again.
+ */
+class ShadowAtlas
+{
+public:
+	// Sizes are in texels and powers of two
+	void Init(const uint32_t inAtlasSize, const uint32_t inMinTileSize, const uint32_t inMaxTileSize);
+
+	// Allocations are in the order of the requests and valid until the next Update
+	void Update(const eastl::vector<ShadowAtlasRequest>& inRequests);
+
+	inline const eastl::vector<ShadowAtlasAllocation>& GetAllocations() const { return Allocations; }
+
+	// Projected diameter of the light's sphere of influence over the viewport height, 1 when the camera is inside of it
+	static float ComputeScreenCoverage(const glm::vec3& inCenter, const float inRadius, const class RenderView& inView);
+
+	inline uint32_t GetAtlasSize() const { return AtlasSize; }
+	inline uint32_t GetNumRepacks() const { return NumRepacks; }
+
+	// Area of the allocated tiles over the atlas area
+	float GetOccupancy() const;
+
+	// Updates the atlas over frames of lights moving around the camera, some static, and logs the update cost, the occupancy,
+	// the resolution given against the one asked for, the tiles drawn each frame and the number of repacks.
+	static void Benchmark(const uint32_t inNumLights, const uint32_t inNumFrames);
+
+	// Asserts the tiles stay inside the atlas and no two of them overlap over frames of moving lights
+	static void RunChecks();
+
+private:
+	struct LightTiles
+	{
+		ShadowAtlasTile Faces[6];
+		uint32_t NumFaces = 0;
+		uint32_t TileSize = 0;
+		uint64_t LastSeenUpdate = 0;
+		bool bContentsValid = false;
+	};
+
+	uint32_t GetLevel(const uint32_t inSize) const;
+	bool AllocateTile(const uint32_t inSize, ShadowAtlasTile& outTile);
+	void FreeTile(const ShadowAtlasTile& inTile);
+	void FreeLight(LightTiles& ioLight);
+	bool AllocateLight(LightTiles& ioLight);
+	void ResetFreeTiles();
+
+	// Picks the tile size of each request, within the budget of the atlas area
+	void AssignTileSizes(const eastl::vector<ShadowAtlasRequest>& inRequests);
+
+private:
+	uint32_t AtlasSize = 0;
+	uint32_t MinTileSize = 0;
+	uint32_t MaxTileSize = 0;
+	uint32_t NumLevels = 0;
+
+	// Free squares of each level, level 0 being the whole atlas, positions packed as X | Y << 16
+	eastl::vector<eastl::vector<uint32_t>> FreeTiles;
+	uint64_t AllocatedArea = 0;
+
+	eastl::unordered_map<uint32_t, LightTiles> Lights;
+	eastl::vector<ShadowAtlasAllocation> Allocations;
+	eastl::vector<uint32_t> TileSizes;
+	eastl::vector<uint32_t> RequestOrder;
+
+	uint64_t UpdateIndex = 0;
+	uint32_t NumRepacks = 0;
+};
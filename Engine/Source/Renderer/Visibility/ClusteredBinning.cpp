@@ -0,0 +1,703 @@
+#include "Renderer/Visibility/ClusteredBinning.h"
+#include "Renderer/RenderView.h"
+#include "Core/TaskSystem.h"
+#include "Math/MathUtils.h"
+#include "EASTL/algorithm.h"
+#include "EASTL/string.h"
+#include "Utils/PerfUtils.h"
+#include "Utils/TestUtils.h"
+#include "glm/gtc/quaternion.hpp"
+#include "glm/ext/matrix_clip_space.hpp"
+#include "glm/ext/matrix_transform.hpp"
+#include <xmmintrin.h>
+
+// Lanes of the given tiles that are in [inFirst, inEnd), without branches as the first and last tiles of every row need some
+// lanes masked
+static int32_t GetLaneMask(const uint32_t inTile, const uint32_t inFirst, const uint32_t inEnd)
+{
+	const uint32_t firstLane = inFirst - glm::min(inFirst, inTile);
+	const uint32_t endLane = glm::min(inEnd - inTile, 4u);
+
+	return (0xF << firstLane) & ((1 << endLane) - 1);
+}
+
+// Number of leading values the predicate holds for, it has to hold for a prefix of them. Items land anywhere in the grid so
+// the steps of a regular binary search would mostly be mispredicted, this one picks the half with a conditional move.
+template<typename Pred>
+static uint32_t PartitionPoint(const float* inValues, const uint32_t inCount, Pred&& inPred)
+{
+	if (inCount == 0)
+	{
+		return 0;
+	}
+
+	const float* base = inValues;
+	uint32_t count = inCount;
+	while (count > 1)
+	{
+		const uint32_t half = count / 2;
+		base = inPred(base[half]) ? base + half : base;
+		count -= half;
+	}
+
+	return static_cast<uint32_t>(base - inValues) + (inPred(*base) ? 1 : 0);
+}
+
+// Room for the hits of every tile in the given ranges, x rounded out to groups of 4 tiles
+static uint32_t* ReserveHits(const uint32_t inFirstX, const uint32_t inEndX, const uint32_t inFirstY, const uint32_t inEndY, const uint32_t inNumHits, eastl::vector<uint32_t>& ioHits)
+{
+	const size_t numNeeded = inNumHits + static_cast<size_t>(((inEndX + 3) & ~3u) - (inFirstX & ~3u)) * (inEndY - inFirstY);
+	if (ioHits.size() < numNeeded)
+	{
+		ioHits.resize(glm::max<size_t>(ioHits.size() * 2, numNeeded));
+	}
+
+	return ioHits.data();
+}
+
+// Hits are the tile in the high 16 bits and the item in the low ones. All 4 lanes are written and only the ones that
+// passed are kept, so there is no branch on the test results. The count goes by value as the stores could alias a reference.
+static uint32_t AddLaneHits(const int32_t inLanes, const uint32_t inTile, const uint32_t inItem, uint32_t* outHits, uint32_t inNumHits)
+{
+	for (uint32_t lane = 0; lane < 4; ++lane)
+	{
+		outHits[inNumHits] = (inTile + lane) << 16 | inItem;
+		inNumHits += (inLanes >> lane) & 1;
+	}
+
+	return inNumHits;
+}
+
+void ClusteredBinning::BuildGrid(const RenderView& inView, const ClusterGridSettings& inSettings)
+{
+	TileSize = glm::max(inSettings.TileSize, 1u);
+	NumTilesX = MathUtils::DivideAndRoundUp(inView.Width, TileSize);
+	NumTilesY = MathUtils::DivideAndRoundUp(inView.Height, TileSize);
+	PaddedTilesX = (NumTilesX + 3) & ~3u;
+	NumSlices = glm::max(inSettings.NumSlices, 1u);
+
+	// Exponential slices keep the clusters about as deep as they are wide on screen
+	const float nearZ = inView.Near;
+	const float farZ = glm::max(glm::min(inSettings.MaxDistance, inView.Far), nearZ + 0.01f);
+
+	SliceMinZ.resize(NumSlices);
+	SliceMaxZ.resize(NumSlices);
+	for (uint32_t slice = 0; slice < NumSlices; ++slice)
+	{
+		SliceMinZ[slice] = slice == 0 ? nearZ : SliceMaxZ[slice - 1];
+		SliceMaxZ[slice] = slice == NumSlices - 1 ? farZ : nearZ * glm::pow(farZ / nearZ, static_cast<float>(slice + 1) / static_cast<float>(NumSlices));
+	}
+
+	TileMinX.resize(static_cast<size_t>(PaddedTilesX) * NumSlices);
+	TileMaxX.resize(static_cast<size_t>(PaddedTilesX) * NumSlices);
+	TileMinY.resize(static_cast<size_t>(NumTilesY) * NumSlices);
+	TileMaxY.resize(static_cast<size_t>(NumTilesY) * NumSlices);
+
+	// The side planes of a tile go through the camera, so its bounds are the edges at depth 1 scaled by the near or far depth of
+	// the slice, whichever is further from the center of the screen. Pixel rows go down while view space y goes up.
+	const float pixelToNDCX = 2.f * static_cast<float>(TileSize) / static_cast<float>(glm::max(inView.Width, 1u));
+	const float pixelToNDCY = 2.f * static_cast<float>(TileSize) / static_cast<float>(glm::max(inView.Height, 1u));
+
+	for (uint32_t slice = 0; slice < NumSlices; ++slice)
+	{
+		const float sliceNear = SliceMinZ[slice];
+		const float sliceFar = SliceMaxZ[slice];
+
+		float* minX = &TileMinX[slice * PaddedTilesX];
+		float* maxX = &TileMaxX[slice * PaddedTilesX];
+		for (uint32_t tile = 0; tile < PaddedTilesX; ++tile)
+		{
+			if (tile >= NumTilesX)
+			{
+				minX[tile] = FLT_MAX;
+				maxX[tile] = -FLT_MAX;
+				continue;
+			}
+
+			const float left = (static_cast<float>(tile) * pixelToNDCX - 1.f) / inView.ViewToClip[0][0];
+			const float right = (static_cast<float>(tile + 1) * pixelToNDCX - 1.f) / inView.ViewToClip[0][0];
+
+			minX[tile] = left * (left < 0.f ? sliceFar : sliceNear);
+			maxX[tile] = right * (right > 0.f ? sliceFar : sliceNear);
+		}
+
+		float* minY = &TileMinY[slice * NumTilesY];
+		float* maxY = &TileMaxY[slice * NumTilesY];
+		for (uint32_t tile = 0; tile < NumTilesY; ++tile)
+		{
+			const float top = (1.f - static_cast<float>(tile) * pixelToNDCY) / inView.ViewToClip[1][1];
+			const float bottom = (1.f - static_cast<float>(tile + 1) * pixelToNDCY) / inView.ViewToClip[1][1];
+
+			minY[tile] = bottom * (bottom < 0.f ? sliceFar : sliceNear);
+			maxY[tile] = top * (top > 0.f ? sliceFar : sliceNear);
+		}
+	}
+}
+
+void ClusteredBinning::PrepareItems(const RenderView& inView, const eastl::vector<ClusterLight>& inLights, const eastl::vector<ClusterDecal>& inDecals)
+{
+	Lights.resize(inLights.size());
+	Decals.resize(inDecals.size());
+
+	const glm::mat3 viewRotation = glm::mat3(inView.WorldToView);
+
+	LightSlices.resize(inLights.size());
+	DecalSlices.resize(inDecals.size());
+
+	const auto findSlices = [&](const BinnedItem& inItem)
+	{
+		const uint32_t firstSlice = PartitionPoint(SliceMaxZ.data(), NumSlices, [&](const float inZ) { return inZ < inItem.Min.z; });
+		const uint32_t endSlice = PartitionPoint(SliceMinZ.data(), NumSlices, [&](const float inZ) { return inZ <= inItem.Max.z; });
+		if (firstSlice >= endSlice)
+		{
+			return 0u;
+		}
+
+		// Items off the sides of the grid are in no cluster. The grid widens with depth, so the outer tiles of the last slice
+		// bound the ones of every slice before.
+		const uint32_t lastSlice = endSlice - 1;
+		if (inItem.Max.x < GetTileMinX(lastSlice)[0] || inItem.Min.x > GetTileMaxX(lastSlice)[NumTilesX - 1] ||
+			inItem.Max.y < GetTileMinY(lastSlice)[NumTilesY - 1] || inItem.Min.y > GetTileMaxY(lastSlice)[0])
+		{
+			return 0u;
+		}
+
+		return firstSlice | endSlice << 16;
+	};
+
+	TaskSystem::Get().ParallelFor(static_cast<uint32_t>(inLights.size()), 256, [&](const uint32_t inBegin, const uint32_t inEnd, const uint32_t inWorkerIdx)
+	{
+		for (uint32_t i = inBegin; i < inEnd; ++i)
+		{
+			BinnedItem& light = Lights[i];
+			const float radius = glm::abs(inLights[i].Radius);
+
+			light.Center = glm::vec3(inView.WorldToView * glm::vec4(inLights[i].Position, 1.f));
+			light.Min = light.Center - radius;
+			light.Max = light.Center + radius;
+			light.HalfSize = glm::vec3(radius);
+			LightSlices[i] = findSlices(light);
+		}
+	});
+
+	TaskSystem::Get().ParallelFor(static_cast<uint32_t>(inDecals.size()), 256, [&](const uint32_t inBegin, const uint32_t inEnd, const uint32_t inWorkerIdx)
+	{
+		for (uint32_t i = inBegin; i < inEnd; ++i)
+		{
+			const ClusterDecal& source = inDecals[i];
+			BinnedItem& decal = Decals[i];
+
+			// Same rotation as QuatTo3x3 in the shaders, the quaternion isn't normalized there either
+			const glm::quat orientation = glm::quat(source.Orientation.w, source.Orientation.x, source.Orientation.y, source.Orientation.z);
+			const glm::mat3 rotation = viewRotation * glm::mat3_cast(orientation);
+
+			decal.Center = glm::vec3(inView.WorldToView * glm::vec4(source.Position, 1.f));
+			decal.HalfSize = glm::abs(source.Size);
+
+			glm::vec3 extent = glm::vec3(0.f);
+			for (int32_t axis = 0; axis < 3; ++axis)
+			{
+				decal.Axes[axis] = rotation[axis];
+				extent += glm::abs(rotation[axis]) * decal.HalfSize[axis];
+			}
+
+			decal.Min = decal.Center - extent;
+			decal.Max = decal.Center + extent;
+			DecalSlices[i] = findSlices(decal);
+		}
+	});
+}
+
+bool ClusteredBinning::TestLightScalar(const BinnedItem& inLight, const glm::vec3& inMin, const glm::vec3& inMax)
+{
+	if (glm::any(glm::greaterThan(inLight.Min, inMax)) || glm::any(glm::lessThan(inLight.Max, inMin)))
+	{
+		return false;
+	}
+
+	const glm::vec3 distance = glm::max(glm::max(inMin - inLight.Center, inLight.Center - inMax), glm::vec3(0.f));
+	const float radius = inLight.HalfSize.x;
+
+	return distance.x * distance.x + (distance.y * distance.y + distance.z * distance.z) <= radius * radius;
+}
+
+bool ClusteredBinning::TestDecalScalar(const BinnedItem& inDecal, const glm::vec3& inMin, const glm::vec3& inMax)
+{
+	// The axes of the cluster box, then the axes of the decal box
+	if (glm::any(glm::greaterThan(inDecal.Min, inMax)) || glm::any(glm::lessThan(inDecal.Max, inMin)))
+	{
+		return false;
+	}
+
+	const glm::vec3 center = (inMin + inMax) * 0.5f;
+	const glm::vec3 extent = (inMax - inMin) * 0.5f;
+	const glm::vec3 offset = center - inDecal.Center;
+
+	for (int32_t i = 0; i < 3; ++i)
+	{
+		const glm::vec3& axis = inDecal.Axes[i];
+		const float distance = glm::abs(axis.x * offset.x + (axis.y * offset.y + axis.z * offset.z));
+		const float radius = glm::abs(axis.x) * extent.x + (inDecal.HalfSize[i] + glm::abs(axis.y) * extent.y + glm::abs(axis.z) * extent.z);
+
+		if (distance > radius)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// Counting sort of the items by slice. Items span few slices, so this is much less work than each slice going through
+// every item.
+void ClusteredBinning::BucketItems(const eastl::vector<uint32_t>& inItemSlices, eastl::vector<uint32_t>& outStarts, eastl::vector<uint32_t>& outItems) const
+{
+	outStarts.assign(NumSlices + 1, 0);
+	for (const uint32_t slices : inItemSlices)
+	{
+		for (uint32_t slice = slices & 0xFFFF; slice < (slices >> 16); ++slice)
+		{
+			++outStarts[slice + 1];
+		}
+	}
+
+	for (uint32_t slice = 0; slice < NumSlices; ++slice)
+	{
+		outStarts[slice + 1] += outStarts[slice];
+	}
+
+	// Each start is moved to the end of its slice as the items are written, which is the start of the next one
+	outItems.resize(outStarts[NumSlices]);
+
+	const uint32_t count = static_cast<uint32_t>(inItemSlices.size());
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		for (uint32_t slice = inItemSlices[i] & 0xFFFF; slice < (inItemSlices[i] >> 16); ++slice)
+		{
+			outItems[outStarts[slice]++] = i;
+		}
+	}
+
+	for (uint32_t slice = NumSlices; slice > 0; --slice)
+	{
+		outStarts[slice] = outStarts[slice - 1];
+	}
+	outStarts[0] = 0;
+}
+
+void ClusteredBinning::BinSlice(const uint32_t inSlice)
+{
+	SliceData& data = Slices[inSlice];
+
+	const uint32_t numTiles = NumTilesX * NumTilesY;
+	const float sliceMinZ = SliceMinZ[inSlice];
+	const float sliceMaxZ = SliceMaxZ[inSlice];
+	const float* minX = GetTileMinX(inSlice);
+	const float* maxX = GetTileMaxX(inSlice);
+	const float* minY = GetTileMinY(inSlice);
+	const float* maxY = GetTileMaxY(inSlice);
+
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128 signMask = _mm_set1_ps(-0.f);
+
+	// Tiles whose bounds overlap the item bounds, the bounds grow with the tile index in x and shrink with it in y
+	const auto findTiles = [&](const BinnedItem& inItem, uint32_t& outFirstX, uint32_t& outEndX, uint32_t& outFirstY, uint32_t& outEndY)
+	{
+		outFirstX = PartitionPoint(maxX, NumTilesX, [&](const float inX) { return inX < inItem.Min.x; });
+		outEndX = PartitionPoint(minX, NumTilesX, [&](const float inX) { return inX <= inItem.Max.x; });
+		outFirstY = PartitionPoint(minY, NumTilesY, [&](const float inY) { return inY > inItem.Max.y; });
+		outEndY = PartitionPoint(maxY, NumTilesY, [&](const float inY) { return inY >= inItem.Min.y; });
+
+		return outFirstX < outEndX && outFirstY < outEndY;
+	};
+
+	// Lights, the distance from the center to the cluster box against the radius
+	uint32_t numLightHits = 0;
+	for (uint32_t candidate = SliceLightStarts[inSlice]; candidate < SliceLightStarts[inSlice + 1]; ++candidate)
+	{
+		const uint32_t i = SliceLights[candidate];
+		const BinnedItem& light = Lights[i];
+
+		uint32_t firstX, endX, firstY, endY;
+		if (!findTiles(light, firstX, endX, firstY, endY))
+		{
+			continue;
+		}
+
+		uint32_t* lightHits = ReserveHits(firstX, endX, firstY, endY, numLightHits, data.LightHits);
+		const float radiusSq = light.HalfSize.x * light.HalfSize.x;
+		const float distanceZ = glm::max(glm::max(sliceMinZ - light.Center.z, light.Center.z - sliceMaxZ), 0.f);
+
+		const __m128 centerX = _mm_set1_ps(light.Center.x);
+		const __m128 radiusSqSIMD = _mm_set1_ps(radiusSq);
+
+		for (uint32_t tileY = firstY; tileY < endY; ++tileY)
+		{
+			const float distanceY = glm::max(glm::max(minY[tileY] - light.Center.y, light.Center.y - maxY[tileY]), 0.f);
+			const float distanceYZSq = distanceY * distanceY + distanceZ * distanceZ;
+			if (distanceYZSq > radiusSq)
+			{
+				continue;
+			}
+
+			const __m128 distanceYZSqSIMD = _mm_set1_ps(distanceYZSq);
+			for (uint32_t tileX = firstX & ~3u; tileX < endX; tileX += 4)
+			{
+				const __m128 distanceX = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(minX + tileX), centerX), _mm_sub_ps(centerX, _mm_loadu_ps(maxX + tileX))), zero);
+				const __m128 distanceSq = _mm_add_ps(_mm_mul_ps(distanceX, distanceX), distanceYZSqSIMD);
+
+				const int32_t lanes = _mm_movemask_ps(_mm_cmple_ps(distanceSq, radiusSqSIMD)) & GetLaneMask(tileX, firstX, endX);
+				numLightHits = AddLaneHits(lanes, tileY * NumTilesX + tileX, i, lightHits, numLightHits);
+			}
+		}
+	}
+
+	// Decals, the separating axes of the decal box, the ones of the cluster box are covered by the overlap of the bounds
+	const float clusterCenterZ = (sliceMinZ + sliceMaxZ) * 0.5f;
+	const float clusterExtentZ = (sliceMaxZ - sliceMinZ) * 0.5f;
+
+	uint32_t numDecalHits = 0;
+	for (uint32_t candidate = SliceDecalStarts[inSlice]; candidate < SliceDecalStarts[inSlice + 1]; ++candidate)
+	{
+		const uint32_t i = SliceDecals[candidate];
+		const BinnedItem& decal = Decals[i];
+
+		uint32_t firstX, endX, firstY, endY;
+		if (!findTiles(decal, firstX, endX, firstY, endY))
+		{
+			continue;
+		}
+
+		uint32_t* decalHits = ReserveHits(firstX, endX, firstY, endY, numDecalHits, data.DecalHits);
+		const __m128 centerX = _mm_set1_ps(decal.Center.x);
+		__m128 axisX[3];
+		__m128 absAxisX[3];
+		for (int32_t axis = 0; axis < 3; ++axis)
+		{
+			axisX[axis] = _mm_set1_ps(decal.Axes[axis].x);
+			absAxisX[axis] = _mm_set1_ps(glm::abs(decal.Axes[axis].x));
+		}
+
+		for (uint32_t tileY = firstY; tileY < endY; ++tileY)
+		{
+			const float clusterCenterY = (minY[tileY] + maxY[tileY]) * 0.5f;
+			const float clusterExtentY = (maxY[tileY] - minY[tileY]) * 0.5f;
+
+			// What the y and z components add to the projections is the same for the whole row
+			__m128 rowDistance[3];
+			__m128 rowRadius[3];
+			for (int32_t axis = 0; axis < 3; ++axis)
+			{
+				const glm::vec3& axisDir = decal.Axes[axis];
+				rowDistance[axis] = _mm_set1_ps(axisDir.y * (clusterCenterY - decal.Center.y) + axisDir.z * (clusterCenterZ - decal.Center.z));
+				rowRadius[axis] = _mm_set1_ps(decal.HalfSize[axis] + glm::abs(axisDir.y) * clusterExtentY + glm::abs(axisDir.z) * clusterExtentZ);
+			}
+
+			for (uint32_t tileX = firstX & ~3u; tileX < endX; tileX += 4)
+			{
+				const __m128 tileMinX = _mm_loadu_ps(minX + tileX);
+				const __m128 tileMaxX = _mm_loadu_ps(maxX + tileX);
+				const __m128 offsetX = _mm_sub_ps(_mm_mul_ps(_mm_add_ps(tileMinX, tileMaxX), half), centerX);
+				const __m128 extentX = _mm_mul_ps(_mm_sub_ps(tileMaxX, tileMinX), half);
+
+				__m128 separated = _mm_setzero_ps();
+				for (int32_t axis = 0; axis < 3; ++axis)
+				{
+					const __m128 distance = _mm_andnot_ps(signMask, _mm_add_ps(_mm_mul_ps(axisX[axis], offsetX), rowDistance[axis]));
+					const __m128 radius = _mm_add_ps(_mm_mul_ps(absAxisX[axis], extentX), rowRadius[axis]);
+
+					separated = _mm_or_ps(separated, _mm_cmpgt_ps(distance, radius));
+				}
+
+				const int32_t lanes = ~_mm_movemask_ps(separated) & GetLaneMask(tileX, firstX, endX);
+				numDecalHits = AddLaneHits(lanes, tileY * NumTilesX + tileX, i, decalHits, numDecalHits);
+			}
+		}
+	}
+
+	// Counting sort of the hits by tile, the items were visited in order so each list stays sorted
+	ClusterRange* ranges = &Clusters[static_cast<size_t>(inSlice) * numTiles];
+	for (uint32_t tile = 0; tile < numTiles; ++tile)
+	{
+		ranges[tile] = ClusterRange();
+	}
+
+	for (uint32_t i = 0; i < numLightHits; ++i)
+	{
+		++ranges[data.LightHits[i] >> 16].NumLights;
+	}
+	for (uint32_t i = 0; i < numDecalHits; ++i)
+	{
+		++ranges[data.DecalHits[i] >> 16].NumDecals;
+	}
+
+	uint32_t offset = 0;
+	for (uint32_t tile = 0; tile < numTiles; ++tile)
+	{
+		ranges[tile].Offset = offset;
+		offset += ranges[tile].NumLights + ranges[tile].NumDecals;
+	}
+
+	data.Indices.resize(offset);
+	data.Cursors.resize(numTiles);
+
+	for (uint32_t tile = 0; tile < numTiles; ++tile)
+	{
+		data.Cursors[tile] = ranges[tile].Offset;
+	}
+	for (uint32_t i = 0; i < numLightHits; ++i)
+	{
+		const uint32_t hit = data.LightHits[i];
+		data.Indices[data.Cursors[hit >> 16]++] = hit & 0xFFFF;
+	}
+	for (uint32_t i = 0; i < numDecalHits; ++i)
+	{
+		const uint32_t hit = data.DecalHits[i];
+		data.Indices[data.Cursors[hit >> 16]++] = hit & 0xFFFF;
+	}
+}
+
+void ClusteredBinning::Bin(const RenderView& inView, const ClusterGridSettings& inSettings, const eastl::vector<ClusterLight>& inLights, const eastl::vector<ClusterDecal>& inDecals)
+{
+	ASSERT(inLights.size() <= UINT16_MAX && inDecals.size() <= UINT16_MAX);
+
+	BuildGrid(inView, inSettings);
+	ASSERT(NumTilesX * NumTilesY <= UINT16_MAX + 1);
+	PrepareItems(inView, inLights, inDecals);
+
+	TaskSystem::Get().ParallelFor(2, 1, [&](const uint32_t inBegin, const uint32_t inEnd, const uint32_t inWorkerIdx)
+	{
+		for (uint32_t kind = inBegin; kind < inEnd; ++kind)
+		{
+			if (kind == 0)
+			{
+				BucketItems(LightSlices, SliceLightStarts, SliceLights);
+			}
+			else
+			{
+				BucketItems(DecalSlices, SliceDecalStarts, SliceDecals);
+			}
+		}
+	});
+
+	const uint32_t numTiles = NumTilesX * NumTilesY;
+	Clusters.resize(static_cast<size_t>(numTiles) * NumSlices);
+	if (Slices.size() < NumSlices)
+	{
+		Slices.resize(NumSlices);
+	}
+
+	// Slices get deeper and wider with the distance, so the far ones hold the most items. Binning them first leaves the short
+	// near ones to fill in at the end, the batches are pulled in order.
+	TaskSystem::Get().ParallelFor(NumSlices, 1, [&](const uint32_t inBegin, const uint32_t inEnd, const uint32_t inWorkerIdx)
+	{
+		for (uint32_t slice = inBegin; slice < inEnd; ++slice)
+		{
+			BinSlice(NumSlices - 1 - slice);
+		}
+	});
+
+	uint32_t numIndices = 0;
+	for (uint32_t slice = 0; slice < NumSlices; ++slice)
+	{
+		Slices[slice].Offset = numIndices;
+		numIndices += static_cast<uint32_t>(Slices[slice].Indices.size());
+	}
+
+	Indices.resize(numIndices);
+
+	TaskSystem::Get().ParallelFor(NumSlices, 1, [&](const uint32_t inBegin, const uint32_t inEnd, const uint32_t inWorkerIdx)
+	{
+		for (uint32_t slice = inBegin; slice < inEnd; ++slice)
+		{
+			const SliceData& data = Slices[slice];
+			eastl::copy(data.Indices.begin(), data.Indices.end(), Indices.begin() + data.Offset);
+
+			ClusterRange* ranges = &Clusters[static_cast<size_t>(slice) * numTiles];
+			for (uint32_t tile = 0; tile < numTiles; ++tile)
+			{
+				ranges[tile].Offset += data.Offset;
+			}
+		}
+	});
+}
+
+uint32_t ClusteredBinning::GetDecalMaskAt(const uint32_t inPixelX, const uint32_t inPixelY) const
+{
+	if (Clusters.empty())
+	{
+		return 0;
+	}
+
+	const uint32_t tileX = glm::min(inPixelX / TileSize, NumTilesX - 1);
+	const uint32_t tileY = glm::min(inPixelY / TileSize, NumTilesY - 1);
+
+	uint32_t mask = 0;
+	for (uint32_t slice = 0; slice < NumSlices; ++slice)
+	{
+		const ClusterRange& range = Clusters[GetClusterIndex(tileX, tileY, slice)];
+		const uint32_t* decals = &Indices[range.Offset + range.NumLights];
+
+		// Indices are sorted, the first one past 31 ends the cluster
+		for (uint32_t i = 0; i < range.NumDecals && decals[i] < 32; ++i)
+		{
+			mask |= 1u << decals[i];
+		}
+	}
+
+	return mask;
+}
+
+// Lights and decals scattered over a level around the camera, the decals turned every which way
+static void CreateBenchmarkItems(const uint32_t inNumLights, const uint32_t inNumDecals, eastl::vector<ClusterLight>& outLights, eastl::vector<ClusterDecal>& outDecals)
+{
+	constexpr float levelSize = 200.f;
+	TestUtils::TestRandom random;
+
+	outLights.resize(inNumLights);
+	for (ClusterLight& light : outLights)
+	{
+		const glm::vec3 offset = random.NextVec3();
+		light.Position = glm::vec3(offset.x - 0.5f, 0.1f * offset.y, offset.z - 0.5f) * levelSize;
+		light.Radius = 1.f + 9.f * random.Next();
+	}
+
+	outDecals.resize(inNumDecals);
+	for (ClusterDecal& decal : outDecals)
+	{
+		const glm::vec3 axis = random.NextVec3() - 0.5f;
+		const glm::quat orientation = glm::normalize(glm::quat(random.Next() - 0.5f, axis.x, axis.y, axis.z));
+		decal.Orientation = glm::vec4(orientation.x, orientation.y, orientation.z, orientation.w);
+		decal.Size = glm::vec3(0.5f) + random.NextVec3() * 2.5f;
+
+		const glm::vec3 offset = random.NextVec3();
+		decal.Position = glm::vec3(offset.x - 0.5f, 0.1f * offset.y, offset.z - 0.5f) * levelSize;
+	}
+}
+
+static RenderView CreateBenchmarkView()
+{
+	RenderView view;
+	view.Width = 1920;
+	view.Height = 1080;
+	view.Near = 0.1f;
+	view.Far = 500.f;
+	view.ViewToClip = glm::perspectiveLH_ZO(glm::radians(60.f), 16.f / 9.f, view.Near, view.Far);
+
+	return view;
+}
+
+// Turning around in the middle of the level
+static void UpdateBenchmarkView(const uint32_t inFrame, RenderView& ioView)
+{
+	const float angle = static_cast<float>(inFrame) * 0.02f;
+	ioView.Position = glm::vec3(0.f, 2.f, 0.f);
+	ioView.WorldToView = glm::lookAtLH(ioView.Position, ioView.Position + glm::vec3(glm::cos(angle), -0.1f, glm::sin(angle)), glm::vec3(0.f, 1.f, 0.f));
+}
+
+void ClusteredBinning::Benchmark(const uint32_t inNumLights, const uint32_t inNumDecals, const uint32_t inNumFrames)
+{
+	if (inNumFrames == 0)
+	{
+		return;
+	}
+
+	eastl::vector<ClusterLight> lights;
+	eastl::vector<ClusterDecal> decals;
+	CreateBenchmarkItems(inNumLights, inNumDecals, lights, decals);
+
+	RenderView view = CreateBenchmarkView();
+	const ClusterGridSettings settings;
+	ClusteredBinning binning;
+
+	int64_t totalUs = 0;
+	int64_t maxUs = 0;
+	for (uint32_t frame = 0; frame < inNumFrames; ++frame)
+	{
+		UpdateBenchmarkView(frame, view);
+
+		int64_t frameUs = 0;
+		{
+			Utils::BenchmarkCode bench(&frameUs);
+			binning.Bin(view, settings, lights, decals);
+		}
+
+		totalUs += frameUs;
+		maxUs = glm::max(maxUs, frameUs);
+	}
+
+	uint32_t numOccupied = 0;
+	uint32_t maxItems = 0;
+	for (const ClusterRange& range : binning.GetClusters())
+	{
+		const uint32_t numItems = range.NumLights + range.NumDecals;
+		numOccupied += numItems > 0 ? 1 : 0;
+		maxItems = glm::max(maxItems, numItems);
+	}
+
+	const glm::uvec3 gridSize = binning.GetGridSize();
+	const uint32_t numIndices = static_cast<uint32_t>(binning.GetIndices().size());
+	LOG_INFO("Clustered binning(%u lights, %u decals, %ux%ux%u clusters, %u workers): %f ms per frame, %f ms at most, %u items in %u clusters(%f per cluster, %u at most).",
+		inNumLights, inNumDecals, gridSize.x, gridSize.y, gridSize.z, TaskSystem::Get().GetNumWorkers(), totalUs * 1e-3 / inNumFrames, maxUs * 1e-3,
+		numIndices, numOccupied, numOccupied > 0 ? static_cast<float>(numIndices) / static_cast<float>(numOccupied) : 0.f, maxItems);
+}
+
+void ClusteredBinning::RunChecks()
+{
+	constexpr uint32_t numLights = 1024;
+	constexpr uint32_t numDecals = 256;
+	constexpr uint32_t numFrames = 4;
+
+	eastl::vector<ClusterLight> lights;
+	eastl::vector<ClusterDecal> decals;
+	CreateBenchmarkItems(numLights, numDecals, lights, decals);
+
+	RenderView view = CreateBenchmarkView();
+	const ClusterGridSettings settings;
+	ClusteredBinning binning;
+
+	// Every item against every cluster, without the range search or SIMD, for views a quarter turn apart
+	TestUtils::CheckScope check("Clustered binning against the scalar tests");
+	eastl::vector<uint32_t> expected;
+	for (uint32_t frame = 0; frame < numFrames; ++frame)
+	{
+		UpdateBenchmarkView(frame * 79, view);
+		binning.Bin(view, settings, lights, decals);
+
+		const glm::uvec3 gridSize = binning.GetGridSize();
+		for (uint32_t slice = 0; slice < gridSize.z; ++slice)
+		{
+			for (uint32_t tileY = 0; tileY < gridSize.y; ++tileY)
+			{
+				for (uint32_t tileX = 0; tileX < gridSize.x; ++tileX)
+				{
+					const glm::vec3 clusterMin = glm::vec3(binning.GetTileMinX(slice)[tileX], binning.GetTileMinY(slice)[tileY], binning.SliceMinZ[slice]);
+					const glm::vec3 clusterMax = glm::vec3(binning.GetTileMaxX(slice)[tileX], binning.GetTileMaxY(slice)[tileY], binning.SliceMaxZ[slice]);
+
+					expected.clear();
+					for (uint32_t i = 0; i < numLights; ++i)
+					{
+						if (TestLightScalar(binning.Lights[i], clusterMin, clusterMax))
+						{
+							expected.push_back(i);
+						}
+					}
+
+					const uint32_t numExpectedLights = static_cast<uint32_t>(expected.size());
+					for (uint32_t i = 0; i < numDecals; ++i)
+					{
+						if (TestDecalScalar(binning.Decals[i], clusterMin, clusterMax))
+						{
+							expected.push_back(i);
+						}
+					}
+
+					const ClusterRange& range = binning.GetClusters()[binning.GetClusterIndex(tileX, tileY, slice)];
+					check.Expect(range.NumLights == numExpectedLights && range.NumLights + range.NumDecals == expected.size() &&
+						eastl::equal(expected.begin(), expected.end(), binning.GetIndices().begin() + range.Offset));
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,147 @@
+#pragma once
+#include <stdint.h>
+#include "EASTL/vector.h"
+#include "glm/glm.hpp"
+
+// Sphere of influence of a local light
+struct ClusterLight
+{
+	glm::vec3 Position = glm::vec3(0.f);
+	float Radius = 0.f;
+};
+
+// Placed like the ShaderDecal the decal passes read: a box rotated by Orientation(quaternion, xyzw) with half extents Size
+struct ClusterDecal
+{
+	glm::vec4 Orientation = glm::vec4(0.f, 0.f, 0.f, 1.f);
+	glm::vec3 Size = glm::vec3(1.f);
+	glm::vec3 Position = glm::vec3(0.f);
+};
+
+struct ClusterGridSettings
+{
+	// Pixels per side of a cluster on screen
+	uint32_t TileSize = 64;
+
+	// Depth slices, exponentially spaced from the camera near plane
+	uint32_t NumSlices = 24;
+
+	// View depth the last slice ends at, clamped to the camera far plane. Anything further isn't binned.
+	float MaxDistance = 200.f;
+};
+
+// Items of a cluster in the index list, the lights first then the decals
+struct ClusterRange
+{
+	uint32_t Offset = 0;
+	uint16_t NumLights = 0;
+	uint16_t NumDecals = 0;
+};
+static_assert(sizeof(ClusterRange) == 2 * sizeof(uint32_t), "Uploaded as a uint2 per cluster");
+
+/**
+ * Assigns lights and decals to the clusters of a froxel grid: screen tiles split in exponential depth slices.
+ * Each item gets its view space bounds, which pick the range of slices and tiles whose bounds it overlaps with a binary
+ * search, then the clusters of that range are tested 4 tiles at a time with SSE against the exact shape: the light sphere
+ * or the decal box, with the separating axes of the box. Items are sorted by slice once, then slices are binned in parallel,
+ * each sorting its hits by cluster into index lists in item order, so the lists don't depend on the number of workers.
+ * The result is a range per cluster into a single index list, ready to be uploaded as two buffers.
+ * Clusters are tested through their view space bounding boxes, slightly larger than the froxels, which errs on the side of
+ * items being in more clusters.
+ */
+class ClusteredBinning
+{
+public:
+	// Items past 65535 of either kind don't fit in a cluster range, neither do more than 65536 tiles per slice
+	void Bin(const class RenderView& inView, const ClusterGridSettings& inSettings, const eastl::vector<ClusterLight>& inLights, const eastl::vector<ClusterDecal>& inDecals);
+
+	inline const eastl::vector<ClusterRange>& GetClusters() const { return Clusters; }
+	inline const eastl::vector<uint32_t>& GetIndices() const { return Indices; }
+
+	// Tiles in x and y, slices in z
+	inline glm::uvec3 GetGridSize() const { return glm::uvec3(NumTilesX, NumTilesY, NumSlices); }
+	inline uint32_t GetClusterIndex(const uint32_t inTileX, const uint32_t inTileY, const uint32_t inSlice) const { return (inSlice * NumTilesY + inTileY) * NumTilesX + inTileX; }
+
+	// Mask of the first 32 decals in any cluster of the tile column over the pixel, the same layout as the tiled binning pass
+	// writes. Decals past MaxDistance aren't in any cluster, so only with MaxDistance at the camera far plane does the column
+	// hold every decal the GPU can find in a tile inside of it.
+	uint32_t GetDecalMaskAt(const uint32_t inPixelX, const uint32_t inPixelY) const;
+
+	// Bins random lights and decals in front of a turning camera and logs the time taken and the number of items per cluster
+	static void Benchmark(const uint32_t inNumLights, const uint32_t inNumDecals, const uint32_t inNumFrames);
+
+	// Asserts the lists of every cluster match testing every item against every cluster without SIMD
+	static void RunChecks();
+
+private:
+	// View space shape and bounds of a light or decal
+	struct BinnedItem
+	{
+		glm::vec3 Center;
+		glm::vec3 Min;
+		glm::vec3 Max;
+
+		// Decal axes and half extents, the light radius in HalfSize.x
+		glm::vec3 Axes[3];
+		glm::vec3 HalfSize;
+	};
+
+	struct SliceData
+	{
+		// The tile and item of each test that passed, then the items sorted by tile
+		eastl::vector<uint32_t> LightHits;
+		eastl::vector<uint32_t> DecalHits;
+		eastl::vector<uint32_t> Cursors;
+		eastl::vector<uint32_t> Indices;
+
+		// Where the indices of the slice start in the index list
+		uint32_t Offset = 0;
+	};
+
+	void BuildGrid(const class RenderView& inView, const ClusterGridSettings& inSettings);
+	void PrepareItems(const class RenderView& inView, const eastl::vector<ClusterLight>& inLights, const eastl::vector<ClusterDecal>& inDecals);
+	void BucketItems(const eastl::vector<uint32_t>& inItemSlices, eastl::vector<uint32_t>& outStarts, eastl::vector<uint32_t>& outItems) const;
+	void BinSlice(const uint32_t inSlice);
+
+	// Bounds of a cluster, tiles of a slice in x and y, x padded to a multiple of 4 tiles
+	inline const float* GetTileMinX(const uint32_t inSlice) const { return &TileMinX[inSlice * PaddedTilesX]; }
+	inline const float* GetTileMaxX(const uint32_t inSlice) const { return &TileMaxX[inSlice * PaddedTilesX]; }
+	inline const float* GetTileMinY(const uint32_t inSlice) const { return &TileMinY[inSlice * NumTilesY]; }
+	inline const float* GetTileMaxY(const uint32_t inSlice) const { return &TileMaxY[inSlice * NumTilesY]; }
+
+	// Same tests as the SIMD path one cluster at a time
+	static bool TestLightScalar(const BinnedItem& inLight, const glm::vec3& inMin, const glm::vec3& inMax);
+	static bool TestDecalScalar(const BinnedItem& inDecal, const glm::vec3& inMin, const glm::vec3& inMax);
+
+private:
+	uint32_t TileSize = 0;
+	uint32_t NumTilesX = 0;
+	uint32_t NumTilesY = 0;
+	uint32_t PaddedTilesX = 0;
+	uint32_t NumSlices = 0;
+
+	eastl::vector<float> SliceMinZ;
+	eastl::vector<float> SliceMaxZ;
+	eastl::vector<float> TileMinX;
+	eastl::vector<float> TileMaxX;
+	eastl::vector<float> TileMinY;
+	eastl::vector<float> TileMaxY;
+
+	eastl::vector<BinnedItem> Lights;
+	eastl::vector<BinnedItem> Decals;
+
+	// Slices overlapping the bounds of each item, the first one in the low 16 bits and the end in the high ones
+	eastl::vector<uint32_t> LightSlices;
+	eastl::vector<uint32_t> DecalSlices;
+
+	// Items overlapping each slice in item order, the ones of a slice start at its entry in the starts
+	eastl::vector<uint32_t> SliceLightStarts;
+	eastl::vector<uint32_t> SliceLights;
+	eastl::vector<uint32_t> SliceDecalStarts;
+	eastl::vector<uint32_t> SliceDecals;
+
+	eastl::vector<SliceData> Slices;
+
+	eastl::vector<ClusterRange> Clusters;
+	eastl::vector<uint32_t> Indices;
+};
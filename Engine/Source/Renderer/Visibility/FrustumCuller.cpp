@@ -0,0 +1,287 @@
+#include "Renderer/Visibility/FrustumCuller.h"
+#include "Core/TaskSystem.h"
+#include "Renderer/Model/3D/Model3D.h"
+#include "EASTL/string.h"
+#include "Utils/PerfUtils.h"
+#include "Utils/TestUtils.h"
+#include "glm/ext/matrix_clip_space.hpp"
+#include "glm/ext/matrix_transform.hpp"
+#include <xmmintrin.h>
+
+// Renderables per task, enough to hide the dispatch cost behind the tests
+static constexpr uint32_t CullingBatchSize = 256;
+
+// Plane components broadcast to all lanes
+struct PlaneSIMD
+{
+	__m128 NormalX;
+	__m128 NormalY;
+	__m128 NormalZ;
+	__m128 Distance;
+	__m128 AbsNormalX;
+	__m128 AbsNormalY;
+	__m128 AbsNormalZ;
+};
+
+void FrustumCuller::CullBounds(const AABB* inBounds, const uint32_t inCount, const Frustum* inViews, const uint32_t inNumViews, uint8_t* outMasks)
+{
+	ASSERT(inNumViews <= MaxViews);
+
+	PlaneSIMD planes[MaxViews][Frustum::NumPlanes];
+	for (uint32_t view = 0; view < inNumViews; ++view)
+	{
+		for (uint32_t i = 0; i < Frustum::NumPlanes; ++i)
+		{
+			const glm::vec4& plane = inViews[view].Planes[i];
+			PlaneSIMD& planeSIMD = planes[view][i];
+
+			planeSIMD.NormalX = _mm_set1_ps(plane.x);
+			planeSIMD.NormalY = _mm_set1_ps(plane.y);
+			planeSIMD.NormalZ = _mm_set1_ps(plane.z);
+			planeSIMD.Distance = _mm_set1_ps(plane.w);
+			planeSIMD.AbsNormalX = _mm_set1_ps(glm::abs(plane.x));
+			planeSIMD.AbsNormalY = _mm_set1_ps(glm::abs(plane.y));
+			planeSIMD.AbsNormalZ = _mm_set1_ps(glm::abs(plane.z));
+		}
+	}
+
+	const __m128 zero = _mm_setzero_ps();
+	const uint32_t numGroups = inCount / 4;
+
+	for (uint32_t group = 0; group < numGroups; ++group)
+	{
+		const AABB* boxes = inBounds + group * 4;
+
+		alignas(16) float centerX[4], centerY[4], centerZ[4];
+		alignas(16) float extentX[4], extentY[4], extentZ[4];
+		int32_t invalidLanes = 0;
+
+		for (uint32_t lane = 0; lane < 4; ++lane)
+		{
+			glm::vec3 center = glm::vec3(0.f);
+			glm::vec3 extent = glm::vec3(0.f);
+			if (boxes[lane].IsValid())
+			{
+				boxes[lane].GetCenterAndExtent(center, extent);
+			}
+			else
+			{
+				invalidLanes |= 1 << lane;
+			}
+
+			centerX[lane] = center.x;
+			centerY[lane] = center.y;
+			centerZ[lane] = center.z;
+			extentX[lane] = extent.x;
+			extentY[lane] = extent.y;
+			extentZ[lane] = extent.z;
+		}
+
+		const __m128 cx = _mm_load_ps(centerX);
+		const __m128 cy = _mm_load_ps(centerY);
+		const __m128 cz = _mm_load_ps(centerZ);
+		const __m128 ex = _mm_load_ps(extentX);
+		const __m128 ey = _mm_load_ps(extentY);
+		const __m128 ez = _mm_load_ps(extentZ);
+
+		uint8_t laneMasks[4] = { 0, 0, 0, 0 };
+
+		for (uint32_t view = 0; view < inNumViews; ++view)
+		{
+			__m128 outside = zero;
+
+			// Same test as Frustum::IntersectsAABB, the center distance against the box radius projected on the normal
+			for (const PlaneSIMD& plane : planes[view])
+			{
+				const __m128 distance = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(plane.NormalX, cx), _mm_mul_ps(plane.NormalY, cy)), _mm_mul_ps(plane.NormalZ, cz)), plane.Distance);
+				const __m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(plane.AbsNormalX, ex), _mm_mul_ps(plane.AbsNormalY, ey)), _mm_mul_ps(plane.AbsNormalZ, ez));
+
+				outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, _mm_sub_ps(zero, radius)));
+			}
+
+			const int32_t visibleLanes = (~_mm_movemask_ps(outside) | invalidLanes) & 0xF;
+			for (uint32_t lane = 0; lane < 4; ++lane)
+			{
+				laneMasks[lane] |= ((visibleLanes >> lane) & 1) << view;
+			}
+		}
+
+		for (uint32_t lane = 0; lane < 4; ++lane)
+		{
+			outMasks[group * 4 + lane] = laneMasks[lane];
+		}
+	}
+
+	for (uint32_t i = numGroups * 4; i < inCount; ++i)
+	{
+		uint8_t mask = 0;
+		for (uint32_t view = 0; view < inNumViews; ++view)
+		{
+			if (!inBounds[i].IsValid() || inViews[view].IntersectsAABB(inBounds[i]))
+			{
+				mask |= 1 << view;
+			}
+		}
+
+		outMasks[i] = mask;
+	}
+}
+
+void FrustumCuller::CullRenderables(const eastl::vector<SceneMeshRenderable>& inRenderables, const Frustum* inViews, const uint32_t inNumViews)
+{
+	ASSERT(inNumViews <= MaxViews);
+
+	const uint32_t count = static_cast<uint32_t>(inRenderables.size());
+	Bounds.resize(count);
+	Masks.resize(count);
+
+	if (count > 0)
+	{
+		TaskSystem::Get().ParallelFor(count, CullingBatchSize, [&](const uint32_t inBegin, const uint32_t inEnd, const uint32_t inWorkerIdx)
+		{
+			// Meshes without bounds keep an invalid box and are drawn in every view
+			for (uint32_t i = inBegin; i < inEnd; ++i)
+			{
+				Bounds[i] = inRenderables[i].Mesh->GetWorldBounds();
+			}
+
+			CullBounds(&Bounds[inBegin], inEnd - inBegin, inViews, inNumViews, &Masks[inBegin]);
+		});
+	}
+
+	for (uint32_t view = 0; view < MaxViews; ++view)
+	{
+		eastl::vector<SceneMeshRenderable>& visible = VisibleLists[view];
+		visible.clear();
+
+		if (view >= inNumViews)
+		{
+			continue;
+		}
+
+		const uint8_t viewBit = uint8_t(1 << view);
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			if (Masks[i] & viewBit)
+			{
+				visible.push_back(inRenderables[i]);
+			}
+		}
+	}
+}
+
+// Props scattered around the cameras, a few of them without bounds
+static void CreateRandomBounds(const uint32_t inNumBoxes, eastl::vector<AABB>& outBounds)
+{
+	constexpr float worldSize = 1000.f;
+	TestUtils::TestRandom random;
+
+	outBounds.clear();
+	outBounds.resize(inNumBoxes);
+	for (uint32_t i = 0; i < inNumBoxes; ++i)
+	{
+		if (i % 97 == 0)
+		{
+			continue;
+		}
+
+		const glm::vec3 center = (random.NextVec3() - 0.5f) * worldSize;
+		const glm::vec3 extent = glm::vec3(0.5f + 2.f * random.Next());
+		outBounds[i] = AABB(center - extent, center + extent);
+	}
+}
+
+// Cameras at the origin looking down the horizontal axes and a cascade like orthographic light view without near plane
+static constexpr uint32_t NumBenchmarkViews = 5;
+
+static void CreateBenchmarkViews(Frustum* outViews)
+{
+	const glm::mat4 projection = glm::perspectiveLH_ZO(glm::radians(60.f), 16.f / 9.f, 0.1f, 300.f);
+	const glm::vec3 up = glm::vec3(0.f, 1.f, 0.f);
+	const glm::mat4 lightView = glm::lookAtLH(glm::vec3(0.f, 200.f, 0.f), glm::vec3(0.f), glm::vec3(0.f, 0.f, 1.f));
+	const glm::mat4 lightProjection = glm::orthoLH_ZO(-100.f, 100.f, -100.f, 100.f, 0.f, 250.f);
+
+	outViews[0] = Frustum::FromMatrix(projection * glm::lookAtLH(glm::vec3(0.f), glm::vec3(1.f, 0.f, 0.f), up));
+	outViews[1] = Frustum::FromMatrix(projection * glm::lookAtLH(glm::vec3(0.f), glm::vec3(-1.f, 0.f, 0.f), up));
+	outViews[2] = Frustum::FromMatrix(projection * glm::lookAtLH(glm::vec3(0.f), glm::vec3(0.f, 0.f, 1.f), up));
+	outViews[3] = Frustum::FromMatrix(projection * glm::lookAtLH(glm::vec3(0.f), glm::vec3(0.f, 0.f, -1.f), up));
+	outViews[4] = Frustum::FromMatrix(lightProjection * lightView, false);
+}
+
+static inline bool IsVisibleScalar(const AABB& inBounds, const Frustum& inView)
+{
+	return !inBounds.IsValid() || inView.IntersectsAABB(inBounds);
+}
+
+void FrustumCuller::Benchmark(const uint32_t inNumBoxes, const uint32_t inNumFrames)
+{
+	if (inNumBoxes == 0 || inNumFrames == 0)
+	{
+		return;
+	}
+
+	eastl::vector<AABB> bounds;
+	CreateRandomBounds(inNumBoxes, bounds);
+
+	Frustum views[NumBenchmarkViews];
+	CreateBenchmarkViews(views);
+
+	eastl::vector<uint8_t> masks(inNumBoxes);
+	int64_t simdUs = 0;
+	for (uint32_t frame = 0; frame < inNumFrames; ++frame)
+	{
+		int64_t frameUs = 0;
+		{
+			Utils::BenchmarkCode bench(&frameUs);
+			TaskSystem::Get().ParallelFor(inNumBoxes, CullingBatchSize, [&](const uint32_t inBegin, const uint32_t inEnd, const uint32_t inWorkerIdx)
+			{
+				CullBounds(&bounds[inBegin], inEnd - inBegin, views, NumBenchmarkViews, &masks[inBegin]);
+			});
+		}
+
+		simdUs += frameUs;
+	}
+
+	uint32_t numVisible[NumBenchmarkViews] = {};
+	int64_t scalarUs = 0;
+	{
+		Utils::BenchmarkCode bench(&scalarUs);
+		for (uint32_t i = 0; i < inNumBoxes; ++i)
+		{
+			for (uint32_t view = 0; view < NumBenchmarkViews; ++view)
+			{
+				numVisible[view] += IsVisibleScalar(bounds[i], views[view]) ? 1 : 0;
+			}
+		}
+	}
+
+	LOG_INFO("Frustum culling(%u boxes, %u views, %u workers): %f ms per frame, scalar single threaded %f ms, visible per view %u %u %u %u %u.",
+		inNumBoxes, NumBenchmarkViews, TaskSystem::Get().GetNumWorkers(), simdUs * 1e-3 / inNumFrames, scalarUs * 1e-3,
+		numVisible[0], numVisible[1], numVisible[2], numVisible[3], numVisible[4]);
+}
+
+void FrustumCuller::RunChecks()
+{
+	constexpr uint32_t numBoxes = 10000;
+
+	eastl::vector<AABB> bounds;
+	CreateRandomBounds(numBoxes, bounds);
+
+	Frustum views[NumBenchmarkViews];
+	CreateBenchmarkViews(views);
+
+	eastl::vector<uint8_t> masks(numBoxes);
+	TaskSystem::Get().ParallelFor(numBoxes, CullingBatchSize, [&](const uint32_t inBegin, const uint32_t inEnd, const uint32_t inWorkerIdx)
+	{
+		CullBounds(&bounds[inBegin], inEnd - inBegin, views, NumBenchmarkViews, &masks[inBegin]);
+	});
+
+	TestUtils::CheckScope check("Frustum culling against the scalar frustum test");
+	for (uint32_t i = 0; i < numBoxes; ++i)
+	{
+		for (uint32_t view = 0; view < NumBenchmarkViews; ++view)
+		{
+			check.Expect(IsVisibleScalar(bounds[i], views[view]) == (((masks[i] >> view) & 1) != 0));
+		}
+	}
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <stdint.h>
+#include "EASTL/vector.h"
+#include "Math/AABB.h"
+#include "Math/Frustum.h"
+#include "Scene/Scene.h"
+
+/**
+ * Builds the lists of renderables to draw for up to MaxViews views in a single sweep over the scene.
+ * Boxes are tested 4 at a time with SSE against the planes of every view, each box getting a mask with one bit per view
+ * it touches. The sweep is split in batches over the TaskSystem workers, then the masks are compacted into one list per
+ * view keeping the scene order, so the draw order doesn't depend on the number of workers.
+ */
+class FrustumCuller
+{
+public:
+	static constexpr uint32_t MaxViews = 8;
+
+	// Bit i of each mask is set when the box touches view i, invalid boxes are visible in every view
+	static void CullBounds(const AABB* inBounds, const uint32_t inCount, const Frustum* inViews, const uint32_t inNumViews, uint8_t* outMasks);
+
+	// World bounds of the meshes have to be up to date, which Scene::UpdateSpatialIndex ensures each frame
+	void CullRenderables(const eastl::vector<SceneMeshRenderable>& inRenderables, const Frustum* inViews, const uint32_t inNumViews);
+
+	inline const eastl::vector<SceneMeshRenderable>& GetVisible(const uint32_t inView) const { return VisibleLists[inView]; }
+	inline uint32_t GetNumTested() const { return static_cast<uint32_t>(Masks.size()); }
+
+	// Times CullBounds and the scalar Frustum test over random boxes seen by fixed cameras and logs the time taken
+	static void Benchmark(const uint32_t inNumBoxes, const uint32_t inNumFrames);
+
+	// Asserts CullBounds gives the same visibility as the scalar Frustum test for random boxes and fixed cameras
+	static void RunChecks();
+
+private:
+	eastl::vector<AABB> Bounds;
+	eastl::vector<uint8_t> Masks;
+	eastl::vector<SceneMeshRenderable> VisibleLists[MaxViews];
+};
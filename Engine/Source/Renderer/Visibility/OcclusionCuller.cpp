@@ -0,0 +1,568 @@
+#include "Renderer/Visibility/OcclusionCuller.h"
+#include "Core/TaskSystem.h"
+#include "Renderer/Model/3D/Model3D.h"
+#include "EASTL/sort.h"
+#include "EASTL/utility.h"
+#include "EASTL/string.h"
+#include "Utils/PerfUtils.h"
+#include "Utils/TestUtils.h"
+#include "glm/ext/matrix_clip_space.hpp"
+#include "glm/ext/matrix_transform.hpp"
+#include <immintrin.h>
+#include <intrin.h>
+#include <atomic>
+
+static constexpr uint32_t TileWidth = 8;
+static constexpr uint32_t TileHeight = 4;
+static constexpr uint32_t NumBins = 16;
+
+// Vertices closer than this to the eye plane are treated as crossing the near plane
+static constexpr float MinClipW = 1e-4f;
+
+// Triangles reaching further out of the screen are skipped to keep the edge functions precise
+static constexpr float GuardBandNDC = 16.f;
+
+static constexpr uint32_t MaxOccluderTriangles = 4096;
+
+// Bounding sphere radius over distance to the view, smaller meshes hide too little to be worth rasterizing
+static constexpr float MinOccluderScreenSize = 0.05f;
+
+static inline void UpdateTile(float& ioZMax0, float& ioZMax1, uint32_t& ioMask, const uint32_t inCoverage, const float inTriangleZMax)
+{
+	// Drop the working layer when it is further from the triangle than from the reference layer, it would only push the
+	// merged depth back
+	const float distanceToTriangle = ioZMax1 - inTriangleZMax;
+	const float distanceToReference = ioZMax0 - ioZMax1;
+	if (distanceToTriangle > distanceToReference)
+	{
+		ioZMax1 = 0.f;
+		ioMask = 0;
+	}
+
+	ioZMax1 = glm::max(ioZMax1, inTriangleZMax);
+	ioMask |= inCoverage;
+
+	// The whole tile is covered by triangles that are all in front of ZMax1
+	if (ioMask == ~0u)
+	{
+		ioZMax0 = glm::min(ioZMax0, ioZMax1);
+		ioZMax1 = 0.f;
+		ioMask = 0;
+	}
+}
+
+bool OcclusionCuller::IsSupported()
+{
+	// AVX has to be reported by the CPU and its registers saved by the OS
+	static const bool bSupported = []()
+	{
+		int32_t cpuInfo[4] = {};
+		__cpuid(cpuInfo, 1);
+
+		const bool bOSXSave = (cpuInfo[2] & (1 << 27)) != 0;
+		const bool bAVX = (cpuInfo[2] & (1 << 28)) != 0;
+
+		return bOSXSave && bAVX && (_xgetbv(0) & 0x6) == 0x6;
+	}();
+
+	return bSupported;
+}
+
+void OcclusionCuller::Init(const uint32_t inWidth, const uint32_t inHeight)
+{
+	ASSERT(inWidth % TileWidth == 0 && inHeight % TileHeight == 0);
+
+	Width = inWidth;
+	Height = inHeight;
+	NumTilesX = inWidth / TileWidth;
+	NumTilesY = inHeight / TileHeight;
+	TileRowsPerBin = (NumTilesY + NumBins - 1) / NumBins;
+
+	Tiles.clear();
+	Tiles.resize(NumTilesX * NumTilesY);
+}
+
+uint32_t OcclusionCuller::BinOccluder(const OccluderMesh& inOccluder, const uint32_t inWorkerIdx)
+{
+	const glm::mat4 localToClip = WorldToClip * inOccluder.LocalToWorld;
+
+	eastl::vector<glm::vec4>& clipPositions = ClipPositions[inWorkerIdx];
+	clipPositions.resize(inOccluder.NumPositions);
+	for (uint32_t i = 0; i < inOccluder.NumPositions; ++i)
+	{
+		clipPositions[i] = localToClip * glm::vec4(inOccluder.Positions[i], 1.f);
+	}
+
+	eastl::vector<ScreenTriangle>* bins = &BinnedTriangles[inWorkerIdx * NumBins];
+	const glm::vec2 screenScale = glm::vec2(0.5f * Width, -0.5f * Height);
+	const glm::vec2 screenOffset = glm::vec2(0.5f * Width, 0.5f * Height);
+
+	uint32_t numBinned = 0;
+	for (uint32_t i = 0; i + 2 < inOccluder.NumIndices; i += 3)
+	{
+		ScreenTriangle triangle;
+		float minDepth = 1.f;
+		bool bSkip = false;
+
+		for (uint32_t vertex = 0; vertex < 3; ++vertex)
+		{
+			const glm::vec4& clip = clipPositions[inOccluder.Indices[i + vertex]];
+			if (clip.w <= MinClipW)
+			{
+				bSkip = true;
+				break;
+			}
+
+			const glm::vec3 ndc = glm::vec3(clip) / clip.w;
+			if (glm::abs(ndc.x) > GuardBandNDC || glm::abs(ndc.y) > GuardBandNDC)
+			{
+				bSkip = true;
+				break;
+			}
+
+			// Y goes down the buffer rows
+			triangle.Vertices[vertex] = glm::vec2(ndc) * screenScale + screenOffset;
+			triangle.ZMax = vertex == 0 ? ndc.z : glm::max(triangle.ZMax, ndc.z);
+			minDepth = glm::min(minDepth, ndc.z);
+		}
+
+		if (bSkip || minDepth < 0.f)
+		{
+			continue;
+		}
+
+		// Front faces are clockwise in NDC like the base pass, which turns into a positive area once y is flipped
+		const glm::vec2 edge01 = triangle.Vertices[1] - triangle.Vertices[0];
+		const glm::vec2 edge02 = triangle.Vertices[2] - triangle.Vertices[0];
+		if (edge01.x * edge02.y - edge01.y * edge02.x <= 0.f)
+		{
+			continue;
+		}
+
+		const glm::vec2 minPos = glm::min(glm::min(triangle.Vertices[0], triangle.Vertices[1]), triangle.Vertices[2]);
+		const glm::vec2 maxPos = glm::max(glm::max(triangle.Vertices[0], triangle.Vertices[1]), triangle.Vertices[2]);
+
+		triangle.MinTileX = glm::max(static_cast<int32_t>(glm::floor(minPos.x / TileWidth)), 0);
+		triangle.MaxTileX = glm::min(static_cast<int32_t>(glm::floor(maxPos.x / TileWidth)), static_cast<int32_t>(NumTilesX) - 1);
+		triangle.MinTileY = glm::max(static_cast<int32_t>(glm::floor(minPos.y / TileHeight)), 0);
+		triangle.MaxTileY = glm::min(static_cast<int32_t>(glm::floor(maxPos.y / TileHeight)), static_cast<int32_t>(NumTilesY) - 1);
+
+		if (triangle.MinTileX > triangle.MaxTileX || triangle.MinTileY > triangle.MaxTileY)
+		{
+			continue;
+		}
+
+		const uint32_t firstBin = triangle.MinTileY / TileRowsPerBin;
+		const uint32_t lastBin = triangle.MaxTileY / TileRowsPerBin;
+		for (uint32_t bin = firstBin; bin <= lastBin; ++bin)
+		{
+			bins[bin].push_back(triangle);
+		}
+
+		++numBinned;
+	}
+
+	return numBinned;
+}
+
+void OcclusionCuller::RasterizeTriangle(const ScreenTriangle& inTriangle, const int32_t inMinTileY, const int32_t inMaxTileY)
+{
+	// Edge functions, positive inside the triangle. Pixel centers exactly on an edge only belong to the triangle when it is
+	// a top or left edge like on the GPU, so occluders are never larger than what gets drawn.
+	// Each edge is set up from its lowest vertex and negated when walked the other way, which gives triangles sharing the
+	// edge exactly opposite values and leaves no gaps between them.
+	float edgeA[3], edgeB[3], edgeC[3];
+	__m256 edgeTopLeft[3];
+	for (uint32_t edge = 0; edge < 3; ++edge)
+	{
+		glm::vec2 start = inTriangle.Vertices[edge];
+		glm::vec2 end = inTriangle.Vertices[(edge + 1) % 3];
+
+		const bool bSwapped = end.y < start.y || (end.y == start.y && end.x < start.x);
+		if (bSwapped)
+		{
+			eastl::swap(start, end);
+		}
+
+		const float sign = bSwapped ? -1.f : 1.f;
+		edgeA[edge] = sign * (start.y - end.y);
+		edgeB[edge] = sign * (end.x - start.x);
+		edgeC[edge] = sign * ((end.y - start.y) * start.x - (end.x - start.x) * start.y);
+
+		const bool bTopLeft = edgeA[edge] > 0.f || (edgeA[edge] == 0.f && edgeB[edge] > 0.f);
+		edgeTopLeft[edge] = bTopLeft ? _mm256_castsi256_ps(_mm256_set1_epi32(-1)) : _mm256_setzero_ps();
+	}
+
+	const __m256 pixelCenters = _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f);
+	const __m256 edgeStepX0 = _mm256_mul_ps(_mm256_set1_ps(edgeA[0]), pixelCenters);
+	const __m256 edgeStepX1 = _mm256_mul_ps(_mm256_set1_ps(edgeA[1]), pixelCenters);
+	const __m256 edgeStepX2 = _mm256_mul_ps(_mm256_set1_ps(edgeA[2]), pixelCenters);
+	const __m256 zero = _mm256_setzero_ps();
+
+	const int32_t minTileY = glm::max(inTriangle.MinTileY, inMinTileY);
+	const int32_t maxTileY = glm::min(inTriangle.MaxTileY, inMaxTileY);
+
+	for (int32_t tileY = minTileY; tileY <= maxTileY; ++tileY)
+	{
+		for (int32_t tileX = inTriangle.MinTileX; tileX <= inTriangle.MaxTileX; ++tileX)
+		{
+			Tile& tile = Tiles[tileY * NumTilesX + tileX];
+			if (inTriangle.ZMax >= tile.ZMax0)
+			{
+				continue;
+			}
+
+			const float pixelX = static_cast<float>(tileX * TileWidth);
+			uint32_t coverage = 0;
+
+			for (uint32_t row = 0; row < TileHeight; ++row)
+			{
+				const float pixelY = static_cast<float>(tileY * TileHeight + row) + 0.5f;
+
+				const __m256 edge0 = _mm256_add_ps(_mm256_set1_ps(edgeA[0] * pixelX + edgeB[0] * pixelY + edgeC[0]), edgeStepX0);
+				const __m256 edge1 = _mm256_add_ps(_mm256_set1_ps(edgeA[1] * pixelX + edgeB[1] * pixelY + edgeC[1]), edgeStepX1);
+				const __m256 edge2 = _mm256_add_ps(_mm256_set1_ps(edgeA[2] * pixelX + edgeB[2] * pixelY + edgeC[2]), edgeStepX2);
+
+				const __m256 inside0 = _mm256_or_ps(_mm256_cmp_ps(edge0, zero, _CMP_GT_OQ), _mm256_and_ps(_mm256_cmp_ps(edge0, zero, _CMP_EQ_OQ), edgeTopLeft[0]));
+				const __m256 inside1 = _mm256_or_ps(_mm256_cmp_ps(edge1, zero, _CMP_GT_OQ), _mm256_and_ps(_mm256_cmp_ps(edge1, zero, _CMP_EQ_OQ), edgeTopLeft[1]));
+				const __m256 inside2 = _mm256_or_ps(_mm256_cmp_ps(edge2, zero, _CMP_GT_OQ), _mm256_and_ps(_mm256_cmp_ps(edge2, zero, _CMP_EQ_OQ), edgeTopLeft[2]));
+				const __m256 inside = _mm256_and_ps(_mm256_and_ps(inside0, inside1), inside2);
+
+				coverage |= static_cast<uint32_t>(_mm256_movemask_ps(inside)) << (row * TileWidth);
+			}
+
+			if (coverage != 0)
+			{
+				UpdateTile(tile.ZMax0, tile.ZMax1, tile.Mask, coverage, inTriangle.ZMax);
+			}
+		}
+	}
+}
+
+void OcclusionCuller::RenderOccluders(const eastl::vector<OccluderMesh>& inOccluders, const glm::mat4& inWorldToClip)
+{
+	WorldToClip = inWorldToClip;
+
+	for (Tile& tile : Tiles)
+	{
+		tile = Tile();
+	}
+
+	TaskSystem& tasks = TaskSystem::Get();
+	const uint32_t numWorkers = tasks.GetNumWorkers();
+	BinnedTriangles.resize(numWorkers * NumBins);
+	ClipPositions.resize(numWorkers);
+	for (eastl::vector<ScreenTriangle>& bin : BinnedTriangles)
+	{
+		bin.clear();
+	}
+
+	std::atomic<uint32_t> numTriangles = 0;
+	if (!inOccluders.empty())
+	{
+		tasks.ParallelFor(static_cast<uint32_t>(inOccluders.size()), 1, [&](const uint32_t inBegin, const uint32_t inEnd, const uint32_t inWorkerIdx)
+		{
+			uint32_t numBinned = 0;
+			for (uint32_t i = inBegin; i < inEnd; ++i)
+			{
+				numBinned += BinOccluder(inOccluders[i], inWorkerIdx);
+			}
+
+			numTriangles += numBinned;
+		});
+	}
+
+	NumOccluderTriangles = numTriangles;
+
+	// Each bin owns its rows of tiles, so they can be rasterized without synchronization
+	tasks.ParallelFor(NumBins, 1, [&](const uint32_t inBegin, const uint32_t inEnd, const uint32_t inWorkerIdx)
+	{
+		for (uint32_t bin = inBegin; bin < inEnd; ++bin)
+		{
+			const int32_t minTileY = static_cast<int32_t>(bin * TileRowsPerBin);
+			const int32_t maxTileY = glm::min(minTileY + static_cast<int32_t>(TileRowsPerBin), static_cast<int32_t>(NumTilesY)) - 1;
+
+			for (uint32_t worker = 0; worker < numWorkers; ++worker)
+			{
+				for (const ScreenTriangle& triangle : BinnedTriangles[worker * NumBins + bin])
+				{
+					RasterizeTriangle(triangle, minTileY, maxTileY);
+				}
+			}
+		}
+	});
+}
+
+bool OcclusionCuller::IsVisible(const AABB& inWorldBounds) const
+{
+	if (!inWorldBounds.IsValid() || Tiles.empty())
+	{
+		return true;
+	}
+
+	const glm::vec2 screenScale = glm::vec2(0.5f * Width, -0.5f * Height);
+	const glm::vec2 screenOffset = glm::vec2(0.5f * Width, 0.5f * Height);
+
+	glm::vec2 minPos = glm::vec2(FLT_MAX);
+	glm::vec2 maxPos = glm::vec2(-FLT_MAX);
+	float minDepth = FLT_MAX;
+
+	for (uint32_t corner = 0; corner < 8; ++corner)
+	{
+		const glm::vec3 position = glm::vec3(corner & 1 ? inWorldBounds.Max.x : inWorldBounds.Min.x, corner & 2 ? inWorldBounds.Max.y : inWorldBounds.Min.y,
+			corner & 4 ? inWorldBounds.Max.z : inWorldBounds.Min.z);
+
+		const glm::vec4 clip = WorldToClip * glm::vec4(position, 1.f);
+
+		// Boxes reaching the eye plane can't be hidden
+		if (clip.w <= MinClipW)
+		{
+			return true;
+		}
+
+		const glm::vec3 ndc = glm::vec3(clip) / clip.w;
+		const glm::vec2 screenPos = glm::vec2(ndc) * screenScale + screenOffset;
+
+		minPos = glm::min(minPos, screenPos);
+		maxPos = glm::max(maxPos, screenPos);
+		minDepth = glm::min(minDepth, ndc.z);
+	}
+
+	if (maxPos.x < 0.f || maxPos.y < 0.f || minPos.x >= Width || minPos.y >= Height)
+	{
+		return true;
+	}
+
+	const int32_t minTileX = glm::max(static_cast<int32_t>(glm::floor(minPos.x / TileWidth)), 0);
+	const int32_t maxTileX = glm::min(static_cast<int32_t>(glm::floor(maxPos.x / TileWidth)), static_cast<int32_t>(NumTilesX) - 1);
+	const int32_t minTileY = glm::max(static_cast<int32_t>(glm::floor(minPos.y / TileHeight)), 0);
+	const int32_t maxTileY = glm::min(static_cast<int32_t>(glm::floor(maxPos.y / TileHeight)), static_cast<int32_t>(NumTilesY) - 1);
+
+	for (int32_t tileY = minTileY; tileY <= maxTileY; ++tileY)
+	{
+		for (int32_t tileX = minTileX; tileX <= maxTileX; ++tileX)
+		{
+			if (minDepth <= Tiles[tileY * NumTilesX + tileX].ZMax0)
+			{
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+void OcclusionCuller::CullRenderables(const eastl::vector<SceneMeshRenderable>& inRenderables, eastl::vector<SceneMeshRenderable>& outVisible)
+{
+	const uint32_t count = static_cast<uint32_t>(inRenderables.size());
+	VisibleFlags.resize(count);
+
+	if (count > 0)
+	{
+		TaskSystem::Get().ParallelFor(count, 256, [&](const uint32_t inBegin, const uint32_t inEnd, const uint32_t inWorkerIdx)
+		{
+			for (uint32_t i = inBegin; i < inEnd; ++i)
+			{
+				VisibleFlags[i] = IsVisible(inRenderables[i].Mesh->GetWorldBounds()) ? 1 : 0;
+			}
+		});
+	}
+
+	outVisible.clear();
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		if (VisibleFlags[i])
+		{
+			outVisible.push_back(inRenderables[i]);
+		}
+	}
+}
+
+void OcclusionCuller::SelectOccluders(const eastl::vector<SceneMeshRenderable>& inRenderables, const glm::vec3& inViewPos, const uint32_t inMaxOccluders,
+	eastl::vector<OccluderMesh>& outOccluders)
+{
+	eastl::vector<eastl::pair<float, const MeshNode*>> candidates;
+
+	for (const SceneMeshRenderable& renderable : inRenderables)
+	{
+		const MeshNode* mesh = renderable.Mesh;
+
+		// Only opaque meshes the base pass draws hide what is behind them, same material checks as the draw packets
+		if (mesh->MatIndex == uint32_t(-1) || mesh->MatIndex >= renderable.Materials->size() ||
+			(*renderable.Materials)[mesh->MatIndex].IsAlphaMasked())
+		{
+			continue;
+		}
+
+		const bool bHasProxy = !mesh->OccluderIndices.empty();
+		const size_t numIndices = bHasProxy ? mesh->OccluderIndices.size() : mesh->Indices.size();
+		const size_t numPositions = bHasProxy ? mesh->OccluderPositions.size() : mesh->Positions.size();
+
+		if (numIndices == 0 || numPositions == 0 || numIndices / 3 > MaxOccluderTriangles)
+		{
+			continue;
+		}
+
+		const BoundingSphere sphere = mesh->GetWorldBoundingSphere();
+		const float screenSize = sphere.Radius / glm::max(glm::length(sphere.Center - inViewPos), 0.001f);
+		if (screenSize >= MinOccluderScreenSize)
+		{
+			candidates.push_back({ screenSize, mesh });
+		}
+	}
+
+	eastl::sort(candidates.begin(), candidates.end(), [](const eastl::pair<float, const MeshNode*>& inA, const eastl::pair<float, const MeshNode*>& inB)
+	{
+		return inA.first > inB.first;
+	});
+
+	const uint32_t numOccluders = glm::min(static_cast<uint32_t>(candidates.size()), inMaxOccluders);
+	for (uint32_t i = 0; i < numOccluders; ++i)
+	{
+		const MeshNode* mesh = candidates[i].second;
+		const bool bHasProxy = !mesh->OccluderIndices.empty();
+
+		OccluderMesh occluder;
+		occluder.Positions = bHasProxy ? mesh->OccluderPositions.data() : mesh->Positions.data();
+		occluder.NumPositions = static_cast<uint32_t>(bHasProxy ? mesh->OccluderPositions.size() : mesh->Positions.size());
+		occluder.Indices = bHasProxy ? mesh->OccluderIndices.data() : mesh->Indices.data();
+		occluder.NumIndices = static_cast<uint32_t>(bHasProxy ? mesh->OccluderIndices.size() : mesh->Indices.size());
+		occluder.LocalToWorld = mesh->GetAbsoluteMatrix();
+
+		outOccluders.push_back(occluder);
+	}
+}
+
+// Two front facing triangles in the XY plane, clockwise as seen from -Z
+static const glm::vec3 WallPositions[] = { glm::vec3(-1.f, -1.f, 0.f), glm::vec3(-1.f, 1.f, 0.f), glm::vec3(1.f, 1.f, 0.f), glm::vec3(1.f, -1.f, 0.f) };
+static const uint32_t WallIndices[] = { 0, 1, 2, 0, 2, 3 };
+static const uint32_t WallIndicesBackFacing[] = { 0, 2, 1, 0, 3, 2 };
+
+static OccluderMesh CreateWall(const glm::vec3& inCenter, const glm::vec2& inHalfSize, const bool inBackFacing = false)
+{
+	OccluderMesh wall;
+	wall.Positions = WallPositions;
+	wall.NumPositions = 4;
+	wall.Indices = inBackFacing ? WallIndicesBackFacing : WallIndices;
+	wall.NumIndices = 6;
+	wall.LocalToWorld = glm::scale(glm::translate(glm::mat4(1.f), inCenter), glm::vec3(inHalfSize, 1.f));
+
+	return wall;
+}
+
+static AABB CreateBox(const glm::vec3& inCenter, const glm::vec3& inExtent)
+{
+	return AABB(inCenter - inExtent, inCenter + inExtent);
+}
+
+// Camera at the origin looking down +Z
+static glm::mat4 CreateBenchmarkWorldToClip()
+{
+	return glm::perspectiveLH_ZO(glm::radians(90.f), 16.f / 9.f, 0.1f, 1000.f) *
+		glm::lookAtLH(glm::vec3(0.f), glm::vec3(0.f, 0.f, 1.f), glm::vec3(0.f, 1.f, 0.f));
+}
+
+void OcclusionCuller::Benchmark(const uint32_t inNumBoxes)
+{
+	if (!IsSupported())
+	{
+		LOG_WARNING("Occlusion culling benchmark skipped, the CPU doesn't support AVX.");
+		return;
+	}
+
+	const glm::mat4 worldToClip = CreateBenchmarkWorldToClip();
+
+	OcclusionCuller culler;
+	culler.Init(320, 180);
+
+	// A grid of walls in front of random boxes, the gaps between the walls are thinner than a pixel of the buffer
+	eastl::vector<OccluderMesh> walls;
+	for (int32_t y = -8; y <= 8; ++y)
+	{
+		for (int32_t x = -8; x <= 8; ++x)
+		{
+			walls.push_back(CreateWall(glm::vec3(x * 4.f, y * 4.f, 30.f), glm::vec2(1.9f)));
+		}
+	}
+
+	TestUtils::TestRandom random;
+
+	eastl::vector<AABB> boxes(inNumBoxes);
+	for (AABB& box : boxes)
+	{
+		const glm::vec3 offset = random.NextVec3();
+		const glm::vec3 center = glm::vec3((offset.x - 0.5f) * 60.f, (offset.y - 0.5f) * 60.f, 40.f + offset.z * 100.f);
+		box = CreateBox(center, glm::vec3(0.1f + 0.5f * random.Next()));
+	}
+
+	int64_t renderUs = 0;
+	{
+		Utils::BenchmarkCode bench(&renderUs);
+		culler.RenderOccluders(walls, worldToClip);
+	}
+
+	std::atomic<uint32_t> numVisible = 0;
+	int64_t testUs = 0;
+	{
+		Utils::BenchmarkCode bench(&testUs);
+		TaskSystem::Get().ParallelFor(inNumBoxes, 256, [&](const uint32_t inBegin, const uint32_t inEnd, const uint32_t inWorkerIdx)
+		{
+			uint32_t batchVisible = 0;
+			for (uint32_t i = inBegin; i < inEnd; ++i)
+			{
+				batchVisible += culler.IsVisible(boxes[i]) ? 1 : 0;
+			}
+
+			numVisible += batchVisible;
+		});
+	}
+
+	LOG_INFO("Occlusion culling: %u occluder triangles rendered in %f ms, %u boxes tested in %f ms, %u visible.",
+		culler.GetNumOccluderTriangles(), renderUs * 1e-3, inNumBoxes, testUs * 1e-3, static_cast<uint32_t>(numVisible));
+}
+
+void OcclusionCuller::RunChecks()
+{
+	if (!IsSupported())
+	{
+		LOG_WARNING("Occlusion culling checks skipped, the CPU doesn't support AVX.");
+		return;
+	}
+
+	const glm::mat4 worldToClip = CreateBenchmarkWorldToClip();
+
+	struct Layout
+	{
+		const char* Name;
+		eastl::vector<OccluderMesh> Occluders;
+		AABB Box;
+		bool bExpectedVisible;
+	};
+
+	const Layout layouts[] =
+	{
+		{ "Box behind a wall", { CreateWall(glm::vec3(0.f, 0.f, 10.f), glm::vec2(5.f)) }, CreateBox(glm::vec3(0.f, 0.f, 20.f), glm::vec3(2.f)), false },
+		{ "Box in front of a wall", { CreateWall(glm::vec3(0.f, 0.f, 10.f), glm::vec2(5.f)) }, CreateBox(glm::vec3(0.f, 0.f, 6.f), glm::vec3(1.f)), true },
+		{ "Box crossing the wall edge", { CreateWall(glm::vec3(0.f, 0.f, 10.f), glm::vec2(5.f)) }, CreateBox(glm::vec3(10.f, 0.f, 20.f), glm::vec3(2.f)), true },
+		{ "Box beside a wall", { CreateWall(glm::vec3(0.f, 0.f, 10.f), glm::vec2(5.f)) }, CreateBox(glm::vec3(16.f, 0.f, 20.f), glm::vec3(1.f)), true },
+		{ "Box behind a back facing wall", { CreateWall(glm::vec3(0.f, 0.f, 10.f), glm::vec2(5.f), true) }, CreateBox(glm::vec3(0.f, 0.f, 20.f), glm::vec3(2.f)), true },
+		{ "Box behind a gap between walls", { CreateWall(glm::vec3(-6.f, 0.f, 10.f), glm::vec2(5.f)), CreateWall(glm::vec3(6.f, 0.f, 10.f), glm::vec2(5.f)) },
+			CreateBox(glm::vec3(0.f, 0.f, 30.f), glm::vec3(0.5f)), true },
+		{ "Box behind two adjacent walls", { CreateWall(glm::vec3(-4.f, 0.f, 10.f), glm::vec2(4.f, 5.f)), CreateWall(glm::vec3(4.f, 0.f, 10.f), glm::vec2(4.f, 5.f)) },
+			CreateBox(glm::vec3(0.f, 0.f, 30.f), glm::vec3(2.f)), false },
+		{ "Box around the camera", { CreateWall(glm::vec3(0.f, 0.f, 10.f), glm::vec2(5.f)) }, CreateBox(glm::vec3(0.f, 0.f, 0.f), glm::vec3(1.f)), true },
+	};
+
+	OcclusionCuller culler;
+	culler.Init(320, 180);
+
+	TestUtils::CheckScope check("Occlusion culling layouts");
+	for (const Layout& layout : layouts)
+	{
+		culler.RenderOccluders(layout.Occluders, worldToClip);
+		if (!check.Expect(culler.IsVisible(layout.Box) == layout.bExpectedVisible))
+		{
+			LOG_ERROR("Occlusion culling layout failed: %s", layout.Name);
+		}
+	}
+}
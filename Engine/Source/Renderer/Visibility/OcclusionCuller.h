@@ -0,0 +1,99 @@
+#pragma once
+#include <stdint.h>
+#include "EASTL/vector.h"
+#include "glm/glm.hpp"
+#include "Math/AABB.h"
+#include "Scene/Scene.h"
+
+// Triangles rasterized into the occlusion buffer, either a mesh or a simplified proxy that stays inside of it
+struct OccluderMesh
+{
+	const glm::vec3* Positions = nullptr;
+	uint32_t NumPositions = 0;
+	const uint32_t* Indices = nullptr;
+	uint32_t NumIndices = 0;
+	glm::mat4 LocalToWorld = glm::mat4(1.f);
+};
+
+/**
+ * Masked software occlusion culling, after Hasselgren et al.
+ * Occluders are rasterized on the CPU into a low resolution buffer of 8x4 pixel tiles. Pixels are never stored, each tile
+ * keeps a coverage mask with the farthest depth of the triangles covering it so far, and a conservative depth for the whole
+ * tile which only gets closer once the mask is full. Coverage of a tile is computed with AVX, one row of 8 pixels per register.
+ * Rendering the occluders happens in two parallel steps: the occluders are transformed and their triangles binned in bands
+ * of tile rows, then each band is rasterized by a single worker so tiles are never shared.
+ * Bounds are occluded when their nearest depth is behind the tile depth of every tile they cover, without waiting on the GPU.
+ * Occluders are drawn with the same back face culling as the base pass and triangles crossing the near plane are skipped,
+ * which can only make fewer objects occluded. Requires an AVX capable CPU, callers have to check IsSupported first.
+ */
+class OcclusionCuller
+{
+public:
+	// Whether the CPU and OS support AVX, the culler can't be used otherwise
+	static bool IsSupported();
+
+	// Width has to be a multiple of 8 and height of 4
+	void Init(const uint32_t inWidth, const uint32_t inHeight);
+
+	void RenderOccluders(const eastl::vector<OccluderMesh>& inOccluders, const glm::mat4& inWorldToClip);
+
+	// Against the occluders of the last RenderOccluders, can be called from several workers at once
+	bool IsVisible(const AABB& inWorldBounds) const;
+
+	// Keeps the renderables not hidden by the occluders, meshes without bounds are always kept
+	void CullRenderables(const eastl::vector<SceneMeshRenderable>& inRenderables, eastl::vector<SceneMeshRenderable>& outVisible);
+
+	// Largest meshes on screen that have CPU geometry under the triangle budget, their occluder proxy being used when they have one.
+	// Meshes without a material or with an alpha masked one are skipped, the base pass doesn't write depth for all of their triangles.
+	static void SelectOccluders(const eastl::vector<SceneMeshRenderable>& inRenderables, const glm::vec3& inViewPos, const uint32_t inMaxOccluders,
+		eastl::vector<OccluderMesh>& outOccluders);
+
+	inline uint32_t GetNumOccluderTriangles() const { return NumOccluderTriangles; }
+
+	// Times rendering a grid of walls and testing random boxes behind it, skipped without AVX
+	static void Benchmark(const uint32_t inNumBoxes);
+
+	// Asserts known occluder layouts give their expected results, skipped without AVX
+	static void RunChecks();
+
+private:
+	struct Tile
+	{
+		// Conservative depth of the whole tile
+		float ZMax0 = 1.f;
+
+		// Farthest depth of the triangles in the coverage mask
+		float ZMax1 = 0.f;
+		uint32_t Mask = 0;
+	};
+
+	struct ScreenTriangle
+	{
+		glm::vec2 Vertices[3];
+		float ZMax = 0.f;
+		int32_t MinTileX = 0;
+		int32_t MaxTileX = 0;
+		int32_t MinTileY = 0;
+		int32_t MaxTileY = 0;
+	};
+
+	// Returns the number of triangles binned
+	uint32_t BinOccluder(const OccluderMesh& inOccluder, const uint32_t inWorkerIdx);
+	void RasterizeTriangle(const ScreenTriangle& inTriangle, const int32_t inMinTileY, const int32_t inMaxTileY);
+
+private:
+	eastl::vector<Tile> Tiles;
+	uint32_t Width = 0;
+	uint32_t Height = 0;
+	uint32_t NumTilesX = 0;
+	uint32_t NumTilesY = 0;
+	uint32_t TileRowsPerBin = 1;
+	glm::mat4 WorldToClip = glm::mat4(1.f);
+
+	// NumBins lists per worker
+	eastl::vector<eastl::vector<ScreenTriangle>> BinnedTriangles;
+	eastl::vector<eastl::vector<glm::vec4>> ClipPositions;
+	uint32_t NumOccluderTriangles = 0;
+
+	eastl::vector<uint8_t> VisibleFlags;
+};
@@ -0,0 +1,322 @@
+#include "Renderer/Visibility/ViewVisibility.h"
+#include "Core/TaskSystem.h"
+#include "Renderer/Model/3D/Model3D.h"
+#include "Math/MathUtils.h"
+#include "EASTL/algorithm.h"
+#include "EASTL/string.h"
+#include "Utils/PerfUtils.h"
+#include "Utils/TestUtils.h"
+#include "glm/ext/matrix_clip_space.hpp"
+#include "glm/ext/matrix_transform.hpp"
+
+// Renderables per task of the culling sweep, same as the FrustumCuller
+static constexpr uint32_t CullingBatchSize = 256;
+
+void ViewVisibility::Reset()
+{
+	NumViews = 0;
+}
+
+uint32_t ViewVisibility::AddView(const VisibilityViewDesc& inDesc)
+{
+	if (NumViews == Views.size())
+	{
+		Views.emplace_back();
+	}
+
+	ViewData& view = Views[NumViews];
+	view.Desc = inDesc;
+
+	return NumViews++;
+}
+
+void ViewVisibility::PrepareCulling(const uint32_t inCount)
+{
+	const uint32_t numGroups = MathUtils::DivideAndRoundUp(NumViews, FrustumCuller::MaxViews);
+
+	Frustums.resize(NumViews);
+	for (uint32_t i = 0; i < NumViews; ++i)
+	{
+		Frustums[i] = Views[i].Desc.ViewFrustum;
+	}
+
+	Bounds.resize(inCount);
+	Masks.resize(static_cast<size_t>(inCount) * numGroups);
+	NumTested = inCount;
+}
+
+void ViewVisibility::CullBoundsRange(const uint32_t inBegin, const uint32_t inEnd)
+{
+	const uint32_t numGroups = MathUtils::DivideAndRoundUp(NumViews, FrustumCuller::MaxViews);
+	for (uint32_t group = 0; group < numGroups; ++group)
+	{
+		const uint32_t firstView = group * FrustumCuller::MaxViews;
+		const uint32_t numGroupViews = glm::min(NumViews - firstView, FrustumCuller::MaxViews);
+
+		FrustumCuller::CullBounds(&Bounds[inBegin], inEnd - inBegin, &Frustums[firstView], numGroupViews, &Masks[static_cast<size_t>(group) * NumTested + inBegin]);
+	}
+}
+
+void ViewVisibility::CullViews(const eastl::vector<SceneMeshRenderable>& inRenderables)
+{
+	const uint32_t count = static_cast<uint32_t>(inRenderables.size());
+	PrepareCulling(count);
+
+	// Each box is loaded once and tested against every view, meshes without bounds keep an invalid box and are in every view
+	TaskSystem::Get().ParallelFor(count, CullingBatchSize, [&](const uint32_t inBegin, const uint32_t inEnd, const uint32_t inWorkerIdx)
+	{
+		for (uint32_t i = inBegin; i < inEnd; ++i)
+		{
+			Bounds[i] = inRenderables[i].Mesh->GetWorldBounds();
+		}
+
+		CullBoundsRange(inBegin, inEnd);
+	});
+}
+
+void ViewVisibility::BuildView(const eastl::vector<SceneMeshRenderable>& inRenderables, const uint32_t inView)
+{
+	ViewData& view = Views[inView];
+	const VisibilityViewDesc& desc = view.Desc;
+
+	const uint32_t count = static_cast<uint32_t>(inRenderables.size());
+
+	// Scene order is kept so the lists don't depend on how the work was split
+	eastl::vector<SceneMeshRenderable>& inFrustum = desc.Occlusion ? view.InFrustum : view.Visible;
+	inFrustum.clear();
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		if (IsInView(inView, i))
+		{
+			inFrustum.push_back(inRenderables[i]);
+		}
+	}
+
+	view.NumInFrustum = static_cast<uint32_t>(inFrustum.size());
+	view.Occluders.clear();
+
+	if (desc.Occlusion)
+	{
+		OcclusionCuller::SelectOccluders(view.InFrustum, desc.PacketView.Position, desc.MaxOccluders, view.Occluders);
+		desc.Occlusion->RenderOccluders(view.Occluders, desc.WorldToClip);
+		desc.Occlusion->CullRenderables(view.InFrustum, view.Visible);
+	}
+
+	view.Packets.Build(view.Visible, desc.Pipeline, desc.bSortByMaterial, desc.PacketView, desc.VisibleSet);
+	view.Packets.Sort();
+	view.Packets.BuildBatches(desc.bMatchMaterial, desc.MaxInstances);
+}
+
+void ViewVisibility::ComputeInternal(const eastl::vector<SceneMeshRenderable>& inRenderables, const bool inParallelViews)
+{
+	if (NumViews == 0)
+	{
+		return;
+	}
+
+	CullViews(inRenderables);
+
+	if (inParallelViews)
+	{
+		// The parallel loops inside of a view run serially on the worker building it
+		TaskSystem::Get().ParallelFor(NumViews, 1, [&](const uint32_t inBegin, const uint32_t inEnd, const uint32_t inWorkerIdx)
+		{
+			for (uint32_t i = inBegin; i < inEnd; ++i)
+			{
+				BuildView(inRenderables, i);
+			}
+		});
+	}
+	else
+	{
+		for (uint32_t i = 0; i < NumViews; ++i)
+		{
+			BuildView(inRenderables, i);
+		}
+	}
+}
+
+void ViewVisibility::Compute(const eastl::vector<SceneMeshRenderable>& inRenderables)
+{
+	// Fewer views than workers would leave cores idle if each view ran on a single one
+	ComputeInternal(inRenderables, NumViews >= TaskSystem::Get().GetNumWorkers());
+}
+
+// Cube probes on a square grid centered on inCenter, 6 views each
+static void AddBenchmarkProbes(const glm::vec3& inCenter, const uint32_t inNumProbes, ViewVisibility& ioVisibility)
+{
+	// Cube faces looking down each axis, with a 90 degrees field of view they cover every direction around the probe
+	const glm::vec3 faceDirections[6] = { glm::vec3(1.f, 0.f, 0.f), glm::vec3(-1.f, 0.f, 0.f), glm::vec3(0.f, 1.f, 0.f), glm::vec3(0.f, -1.f, 0.f),
+		glm::vec3(0.f, 0.f, 1.f), glm::vec3(0.f, 0.f, -1.f) };
+	const glm::vec3 faceUps[6] = { glm::vec3(0.f, 1.f, 0.f), glm::vec3(0.f, 1.f, 0.f), glm::vec3(0.f, 0.f, -1.f), glm::vec3(0.f, 0.f, 1.f),
+		glm::vec3(0.f, 1.f, 0.f), glm::vec3(0.f, 1.f, 0.f) };
+
+	constexpr float probeFar = 200.f;
+	constexpr float probeSpacing = 20.f;
+	const glm::mat4 probeProjection = glm::perspectiveLH_ZO(glm::radians(90.f), 1.f, 0.1f, probeFar);
+
+	const uint32_t gridSize = static_cast<uint32_t>(glm::ceil(glm::sqrt(static_cast<float>(inNumProbes))));
+	for (uint32_t probe = 0; probe < inNumProbes; ++probe)
+	{
+		const glm::vec2 gridPos = glm::vec2(static_cast<float>(probe % gridSize), static_cast<float>(probe / gridSize)) - static_cast<float>(gridSize - 1) * 0.5f;
+		const glm::vec3 probePosition = inCenter + glm::vec3(gridPos.x, 0.f, gridPos.y) * probeSpacing;
+
+		for (uint32_t face = 0; face < 6; ++face)
+		{
+			VisibilityViewDesc desc;
+			desc.WorldToClip = probeProjection * glm::lookAtLH(probePosition, probePosition + faceDirections[face], faceUps[face]);
+			desc.ViewFrustum = Frustum::FromMatrix(desc.WorldToClip);
+			desc.PacketView.Position = probePosition;
+			desc.PacketView.Forward = faceDirections[face];
+			desc.PacketView.MaxDepth = probeFar;
+
+			ioVisibility.AddView(desc);
+		}
+	}
+}
+
+void ViewVisibility::Benchmark(const eastl::vector<SceneMeshRenderable>& inRenderables, const glm::vec3& inCenter, const uint32_t inNumProbes, const uint32_t inNumFrames)
+{
+	if (inRenderables.empty() || inNumProbes == 0 || inNumFrames == 0)
+	{
+		return;
+	}
+
+	ViewVisibility visibility;
+	AddBenchmarkProbes(inCenter, inNumProbes, visibility);
+
+	const uint32_t numViews = visibility.GetNumViews();
+
+	const auto timeFrames = [&](const bool inParallelViews)
+	{
+		int64_t totalUs = 0;
+		for (uint32_t frame = 0; frame < inNumFrames; ++frame)
+		{
+			int64_t frameUs = 0;
+			{
+				Utils::BenchmarkCode bench(&frameUs);
+				visibility.ComputeInternal(inRenderables, inParallelViews);
+			}
+
+			totalUs += frameUs;
+		}
+
+		return totalUs * 1e-3 / inNumFrames;
+	};
+
+	const double serialMs = timeFrames(false);
+	const double parallelMs = timeFrames(true);
+
+	uint32_t numInstances = 0;
+	uint32_t numDraws = 0;
+	for (uint32_t i = 0; i < numViews; ++i)
+	{
+		const DrawPacketList& packets = visibility.GetPackets(i);
+		numInstances += packets.GetNumInstances();
+		numDraws += static_cast<uint32_t>(packets.GetBatches().size());
+	}
+
+	LOG_INFO("View visibility(%u renderables, %u views, %u workers): %f ms per frame building views one after the other, %f ms building them in parallel, %u draws of %u instances.",
+		static_cast<uint32_t>(inRenderables.size()), numViews, TaskSystem::Get().GetNumWorkers(), serialMs, parallelMs, numDraws, numInstances);
+}
+
+void ViewVisibility::RunSceneChecks(const eastl::vector<SceneMeshRenderable>& inRenderables, const glm::vec3& inCenter)
+{
+	if (inRenderables.empty())
+	{
+		return;
+	}
+
+	ViewVisibility visibility;
+	AddBenchmarkProbes(inCenter, 8, visibility);
+
+	const uint32_t numViews = visibility.GetNumViews();
+
+	// Instance slots of each view in draw order, from the views built one after the other
+	visibility.ComputeInternal(inRenderables, false);
+
+	eastl::vector<eastl::vector<uint32_t>> serialSlots(numViews);
+	for (uint32_t i = 0; i < numViews; ++i)
+	{
+		const DrawPacketList& packets = visibility.GetPackets(i);
+		serialSlots[i].resize(packets.GetNumInstances());
+		packets.PackInstances(serialSlots[i].data());
+	}
+
+	visibility.ComputeInternal(inRenderables, true);
+
+	TestUtils::CheckScope check("View visibility built in parallel against one view after the other");
+	eastl::vector<uint32_t> slots;
+	for (uint32_t i = 0; i < numViews; ++i)
+	{
+		const DrawPacketList& packets = visibility.GetPackets(i);
+		slots.resize(packets.GetNumInstances());
+		packets.PackInstances(slots.data());
+
+		check.Expect(slots == serialSlots[i]);
+	}
+}
+
+void ViewVisibility::RunChecks()
+{
+	// Boxes placed around two cube probes, the second one far enough along +X to see the first group from its -X face
+	const glm::vec3 boxCenters[] =
+	{
+		glm::vec3(10.f, 0.f, 0.f), glm::vec3(-10.f, 0.f, 0.f), glm::vec3(0.f, 10.f, 0.f), glm::vec3(0.f, -10.f, 0.f), glm::vec3(0.f, 0.f, 10.f),
+		glm::vec3(0.f, 0.f, -10.f),
+
+		// Past the far plane of every view
+		glm::vec3(400.f, 0.f, 0.f),
+
+		// Around the first probe, in all of its faces
+		glm::vec3(0.f),
+
+		// Unbounded, invalid bounds are in every view
+		glm::vec3(0.f),
+
+		// Below the far plane of the cascade, outside of the cascade width and above the light
+		glm::vec3(0.f, -260.f, 0.f), glm::vec3(30.f, 0.f, 0.f), glm::vec3(0.f, 150.f, 0.f),
+	};
+	constexpr uint32_t numBoxes = _countof(boxCenters);
+	constexpr uint32_t unboundedBox = 8;
+
+	ViewVisibility visibility;
+	AddBenchmarkProbes(glm::vec3(0.f), 1, visibility);
+	AddBenchmarkProbes(glm::vec3(100.f, 0.f, 0.f), 1, visibility);
+
+	// Cascade looking down from above the boxes, without near plane so casters above the light are kept
+	VisibilityViewDesc cascade;
+	cascade.WorldToClip = glm::orthoLH_ZO(-20.f, 20.f, -20.f, 20.f, 0.f, 250.f) *
+		glm::lookAtLH(glm::vec3(0.f, 100.f, 0.f), glm::vec3(0.f), glm::vec3(0.f, 0.f, 1.f));
+	cascade.ViewFrustum = Frustum::FromMatrix(cascade.WorldToClip, false);
+	visibility.AddView(cascade);
+
+	// Boxes expected in each view, the probe faces being +X, -X, +Y, -Y, +Z and -Z
+	const eastl::vector<uint32_t> expectedBoxes[] =
+	{
+		{ 0, 7, 8, 10 }, { 1, 7, 8 }, { 2, 7, 8, 11 }, { 3, 7, 8 }, { 4, 7, 8 }, { 5, 7, 8 },
+		{ 8 }, { 0, 1, 2, 3, 4, 5, 7, 8, 10 }, { 8, 11 }, { 8 }, { 8 }, { 8 },
+		{ 0, 1, 2, 3, 4, 5, 7, 8, 11 },
+	};
+	ASSERT(_countof(expectedBoxes) == visibility.GetNumViews());
+
+	visibility.PrepareCulling(numBoxes);
+	for (uint32_t i = 0; i < numBoxes; ++i)
+	{
+		visibility.Bounds[i] = i == unboundedBox ? AABB() : AABB(boxCenters[i] - 0.5f, boxCenters[i] + 0.5f);
+	}
+	visibility.CullBoundsRange(0, numBoxes);
+
+	TestUtils::CheckScope check("View visibility of hand placed boxes");
+	for (uint32_t view = 0; view < visibility.GetNumViews(); ++view)
+	{
+		for (uint32_t i = 0; i < numBoxes; ++i)
+		{
+			const bool bExpected = eastl::find(expectedBoxes[view].begin(), expectedBoxes[view].end(), i) != expectedBoxes[view].end();
+			if (!check.Expect(visibility.IsInView(view, i) == bExpected))
+			{
+				LOG_ERROR("View %u: box %u expected %s.", view, i, bExpected ? "visible" : "culled");
+			}
+		}
+	}
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include <stdint.h>
+#include "EASTL/vector.h"
+#include "glm/glm.hpp"
+#include "Math/Frustum.h"
+#include "Renderer/DrawPacket.h"
+#include "Renderer/Visibility/FrustumCuller.h"
+#include "Renderer/Visibility/OcclusionCuller.h"
+#include "Scene/Scene.h"
+
+// What a view culls against and how its draw packets get built
+struct VisibilityViewDesc
+{
+	Frustum ViewFrustum;
+	DrawPacketView PacketView;
+	EDrawPipeline Pipeline = EDrawPipeline::GBufferMesh;
+	bool bSortByMaterial = false;
+	bool bMatchMaterial = false;
+	uint32_t MaxInstances = uint32_t(-1);
+
+	// Optional baked potentially visible set the packets are filtered with
+	const uint64_t* VisibleSet = nullptr;
+
+	// Optional occlusion culling after the frustum test, the culler is owned by the caller and only used by this view
+	OcclusionCuller* Occlusion = nullptr;
+	uint32_t MaxOccluders = 0;
+	glm::mat4 WorldToClip = glm::mat4(1.f);
+};
+
+/**
+ * Visibility of every view rendered in a frame: the main camera, the shadow cascades and any other camera like reflection
+ * probe faces, each one getting its own culled, sorted and batched draw packet list.
+ * Passes add their views before any of them executes, then Compute tests the scene bounds against all the frustums in one
+ * parallel sweep, FrustumCuller::MaxViews views at a time per box, and builds the lists of the views.
+ * With at least as many views as workers the lists are built in parallel, one view per batch, otherwise they are built one
+ * after the other with each view spreading its own work over the workers. Either way all cores are busy and the lists are
+ * the same as building them one at a time.
+ */
+class ViewVisibility
+{
+public:
+	void Reset();
+
+	// Returns the index of the view, valid until the next Reset
+	uint32_t AddView(const VisibilityViewDesc& inDesc);
+
+	// World bounds of the meshes have to be up to date, which Scene::UpdateSpatialIndex ensures each frame
+	void Compute(const eastl::vector<SceneMeshRenderable>& inRenderables);
+
+	inline uint32_t GetNumViews() const { return NumViews; }
+	inline uint32_t GetNumTested() const { return NumTested; }
+	inline uint32_t GetNumInFrustum(const uint32_t inView) const { return Views[inView].NumInFrustum; }
+	inline uint32_t GetNumOccluders(const uint32_t inView) const { return static_cast<uint32_t>(Views[inView].Occluders.size()); }
+	inline const eastl::vector<SceneMeshRenderable>& GetVisible(const uint32_t inView) const { return Views[inView].Visible; }
+	inline const DrawPacketList& GetPackets(const uint32_t inView) const { return Views[inView].Packets; }
+
+	// Captures cube probes spread around inCenter, 6 views each, with the views built one after the other and in parallel,
+	// and logs the timings of both
+	static void Benchmark(const eastl::vector<SceneMeshRenderable>& inRenderables, const glm::vec3& inCenter, const uint32_t inNumProbes, const uint32_t inNumFrames);
+
+	// Asserts views built in parallel give the same packets as views built one after the other, for cube probes around inCenter
+	static void RunSceneChecks(const eastl::vector<SceneMeshRenderable>& inRenderables, const glm::vec3& inCenter);
+
+	// Asserts hand placed boxes are in the expected faces of two cube probes and in a cascade, more views than one culling group
+	static void RunChecks();
+
+private:
+	struct ViewData
+	{
+		VisibilityViewDesc Desc;
+		uint32_t NumInFrustum = 0;
+		eastl::vector<SceneMeshRenderable> InFrustum;
+		eastl::vector<SceneMeshRenderable> Visible;
+		eastl::vector<OccluderMesh> Occluders;
+		DrawPacketList Packets;
+	};
+
+	// Sizes the bounds and masks for inCount boxes, then the bounds of [inBegin, inEnd) are tested against every view
+	void PrepareCulling(const uint32_t inCount);
+	void CullBoundsRange(const uint32_t inBegin, const uint32_t inEnd);
+	void CullViews(const eastl::vector<SceneMeshRenderable>& inRenderables);
+
+	inline bool IsInView(const uint32_t inView, const uint32_t inIndex) const
+	{
+		return (Masks[static_cast<size_t>(inView / FrustumCuller::MaxViews) * NumTested + inIndex] >> (inView % FrustumCuller::MaxViews)) & 1;
+	}
+
+	void BuildView(const eastl::vector<SceneMeshRenderable>& inRenderables, const uint32_t inView);
+	void ComputeInternal(const eastl::vector<SceneMeshRenderable>& inRenderables, const bool inParallelViews);
+
+private:
+	// Grows with the most views added in a frame, the lists keep their memory between frames
+	eastl::vector<ViewData> Views;
+	uint32_t NumViews = 0;
+	uint32_t NumTested = 0;
+
+	eastl::vector<Frustum> Frustums;
+	eastl::vector<AABB> Bounds;
+
+	// One mask per renderable for each group of FrustumCuller::MaxViews views, group after group
+	eastl::vector<uint8_t> Masks;
+};
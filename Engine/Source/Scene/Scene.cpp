@@ -2,6 +2,7 @@
 #include "Entity/Entity.h"
 #include "imgui.h"
 #include "Camera/Camera.h"
+#include "EASTL/algorithm.h"
 
 Scene::Scene()
 {
@@ -17,55 +18,349 @@ Scene::~Scene() = default;
 
 void Scene::TickObjects(float inDeltaT)
 {
-	RecursivelyTickObjects(inDeltaT, Objects);
+	// Entities first, so registry data they write this frame is seen by the systems
+	TickEntityObjects(inDeltaT);
+	Systems.Run(EntityRegistry::Get(), inDeltaT);
 }
 
 void Scene::InitObjects()
 {
-	RecursivelyInitObjects(Objects);
+	for (Entity* entity : Entities.GetDense())
+	{
+		entity->Init();
+	}
+}
+
+void Scene::TickEntityObjects(const float inDeltaT)
+{
+	if (bEntityTickOrderDirty)
+	{
+		EntityTickOrder.clear();
+		for (const TransformObjPtr& root : Objects)
+		{
+			GatherEntitiesRecursive(*root);
+		}
+
+		bEntityTickOrderDirty = false;
+	}
+
+	// Objects added or removed by a Tick only join or leave the scene once every entity ticked, which keeps the list
+	// and the entities in it alive until then
+	bTickingEntities = true;
+	for (Entity* entity : EntityTickOrder)
+	{
+		entity->Tick(inDeltaT);
+	}
+	bTickingEntities = false;
+
+	for (uint32_t i = 0; i < PendingObjectChanges.size(); ++i)
+	{
+		const eastl::pair<TransformObjPtr, bool>& change = PendingObjectChanges[i];
+		if (change.second)
+		{
+			AddObject(change.first);
+		}
+		else
+		{
+			RemoveObject(change.first);
+		}
+	}
+
+	PendingObjectChanges.clear();
+}
+
+void Scene::GatherEntitiesRecursive(TransformObject& inObject)
+{
+	// Parents tick before their children
+	if (Entity* entity = dynamic_cast<Entity*>(&inObject))
+	{
+		EntityTickOrder.push_back(entity);
+	}
+
+	for (const TransformObjPtr& child : inObject.GetChildren())
+	{
+		GatherEntitiesRecursive(*child);
+	}
 }
 
 void Scene::AddObject(TransformObjPtr inObj)
 {
+	if (bTickingEntities)
+	{
+		PendingObjectChanges.push_back(eastl::make_pair(inObj, true));
+		return;
+	}
+
 	Objects.push_back(inObj);
+	RegisterObjectRecursive(*inObj, nullptr);
+	bEntityTickOrderDirty = true;
+	++GeometryVersion;
+	++MeshListVersion;
+}
+
+void Scene::RemoveObject(const TransformObjPtr& inObj)
+{
+	if (bTickingEntities)
+	{
+		PendingObjectChanges.push_back(eastl::make_pair(inObj, false));
+		return;
+	}
+
+	const TransformObjPtr* rootIter = eastl::find(Objects.begin(), Objects.end(), inObj);
+	if (rootIter == Objects.end())
+	{
+		return;
+	}
+
+	UnregisterObjectRecursive(*inObj);
+	Objects.erase(rootIter);
+	bEntityTickOrderDirty = true;
+	++GeometryVersion;
+	++MeshListVersion;
+}
+
+SceneQueries& Scene::GetQueries()
+{
+	// Moved meshes are only seen once UpdateSpatialIndex ran, queries made earlier in the frame see last frame's geometry
+	if (bQueriesDirty || Queries.GetMeshListVersion() != MeshListVersion)
+	{
+		Queries.Build(*this);
+		bQueriesDirty = false;
+	}
+	else if (Queries.GetGeometryVersion() != GeometryVersion)
+	{
+		Queries.UpdateMovedMeshes(*this);
+	}
+
+	return Queries;
 }
 
 void Scene::ImGuiDisplaySceneTree()
 {
 	ImGui::Begin("Scene");
 
+	TransformSystem& transforms = TransformSystem::Get();
+	ImGui::Text("Transforms: %u, updated last frame: %u", transforms.GetNumNodes(), transforms.GetLastNumUpdated());
+	if (ImGui::Button("Benchmark Transforms"))
+	{
+		transforms.BenchmarkWorldTransforms(10);
+	}
+
+	ImGui::Text("Mesh bounds tree: %u proxies, height %d, unbounded meshes: %u", MeshBoundsTree.GetNumProxies(), MeshBoundsTree.GetHeight(), static_cast<uint32_t>(UnboundedMeshes.size()));
+	if (ImGui::Button("Benchmark Bounds Tree"))
+	{
+		DynamicAABBTree::Benchmark(100000, 60);
+	}
+
 	ImGuiRecursivelyDisplaySceneTree(Objects, true);
 
 	ImGui::End();
 }
 
-void Scene::RecursivelyTickObjects(float inDeltaT, eastl::vector<TransformObjPtr>& inObjects)
+void Scene::RegisterObjectRecursive(TransformObject& inObject, const eastl::vector<MeshMaterial>* inMaterials)
 {
-	for (TransformObjPtr& obj : inObjects)
+	// Only done once per object when it's added, the passes then walk the lists without casting
+	if (const Model3D* model = dynamic_cast<const Model3D*>(&inObject))
 	{
-		RecursivelyTickObjects(inDeltaT, obj->Children);
-
-		// TODO: Place different objects in different lists, waste of cycles to do dynamic cast on all each frame
-		if (Entity* entt = dynamic_cast<Entity*>(obj.get()))
+		inMaterials = &model->Materials;
+	}
+	else if (MeshNode* mesh = dynamic_cast<MeshNode*>(&inObject))
+	{
+		if (inMaterials)
 		{
-			entt->Tick(inDeltaT);
+			inObject.SceneHandle = MeshRenderables.Add({ mesh, inMaterials });
+
+			SceneMeshRenderable* renderable = MeshRenderables.Get(inObject.SceneHandle);
+			renderable->InstanceSlot = inObject.SceneHandle.Index;
+			renderable->InstanceGeneration = inObject.SceneHandle.Generation;
+
+			AddBoundsProxy(MeshBoundsTree, *mesh, mesh);
+			if (mesh->SpatialProxy == DynamicAABBTree::NullNode)
+			{
+				UnboundedMeshes.push_back(mesh);
+			}
 		}
 	}
+	else if (DecalObject* decal = dynamic_cast<DecalObject*>(&inObject))
+	{
+		inObject.SceneHandle = Decals.Add(decal);
+		AddBoundsProxy(DecalBoundsTree, *decal, decal);
+	}
+	else if (Entity* entity = dynamic_cast<Entity*>(&inObject))
+	{
+		inObject.SceneHandle = Entities.Add(entity);
+	}
+
+	for (const TransformObjPtr& child : inObject.GetChildren())
+	{
+		RegisterObjectRecursive(*child, inMaterials);
+	}
 }
 
-void Scene::RecursivelyInitObjects(eastl::vector<TransformObjPtr>& inObjects)
+void Scene::UnregisterObjectRecursive(TransformObject& inObject)
 {
-	for (TransformObjPtr& obj : inObjects)
+	// Handles are only valid in the list of their object kind, a stale handle makes the removal a no-op
+	if (inObject.SceneHandle.IsValid())
 	{
-		if (Entity* entt = dynamic_cast<Entity*>(obj.get()))
+		if (MeshNode* mesh = dynamic_cast<MeshNode*>(&inObject))
 		{
-			entt->Init();
+			MeshRenderables.Remove(inObject.SceneHandle);
+
+			if (mesh->SpatialProxy == DynamicAABBTree::NullNode)
+			{
+				UnboundedMeshes.erase(eastl::find(UnboundedMeshes.begin(), UnboundedMeshes.end(), mesh));
+			}
+			RemoveBoundsProxy(MeshBoundsTree, *mesh);
 		}
+		else if (DecalObject* decal = dynamic_cast<DecalObject*>(&inObject))
+		{
+			Decals.Remove(inObject.SceneHandle);
+			RemoveBoundsProxy(DecalBoundsTree, *decal);
+		}
+		else if (dynamic_cast<const Entity*>(&inObject))
+		{
+			Entities.Remove(inObject.SceneHandle);
+		}
+
+		inObject.SceneHandle = SlotHandle();
+	}
 
-		RecursivelyInitObjects(obj->Children);
+	for (const TransformObjPtr& child : inObject.GetChildren())
+	{
+		UnregisterObjectRecursive(*child);
 	}
 }
 
+void Scene::AddBoundsProxy(DynamicAABBTree& inTree, DrawableObject& inObject, void* inUserData)
+{
+	// Tracked for objects without bounds too, so moving them still counts as a change
+	inObject.SpatialWorldVersion = inObject.GetWorldVersion();
+
+	AABB localBounds;
+	if (!inObject.GetLocalBounds(localBounds))
+	{
+		return;
+	}
+
+	const AABB worldBounds = inObject.GetWorldBounds();
+	glm::vec3 center, extent;
+	worldBounds.GetCenterAndExtent(center, extent);
+
+	inObject.SpatialProxy = inTree.Insert(worldBounds, inUserData);
+	inObject.SpatialCenter = center;
+}
+
+void Scene::RemoveBoundsProxy(DynamicAABBTree& inTree, DrawableObject& inObject)
+{
+	if (inObject.SpatialProxy != DynamicAABBTree::NullNode)
+	{
+		inTree.Remove(inObject.SpatialProxy);
+		inObject.SpatialProxy = DynamicAABBTree::NullNode;
+	}
+}
+
+bool Scene::MoveBoundsProxy(DynamicAABBTree& inTree, DrawableObject& inObject)
+{
+	const uint32_t worldVersion = inObject.GetWorldVersion();
+	if (inObject.SpatialWorldVersion == worldVersion)
+	{
+		return false;
+	}
+
+	inObject.SpatialWorldVersion = worldVersion;
+	if (inObject.SpatialProxy == DynamicAABBTree::NullNode)
+	{
+		return true;
+	}
+
+	const AABB worldBounds = inObject.GetWorldBounds();
+	glm::vec3 center, extent;
+	worldBounds.GetCenterAndExtent(center, extent);
+
+	inTree.Move(inObject.SpatialProxy, worldBounds, center - inObject.SpatialCenter);
+	inObject.SpatialCenter = center;
+
+	return true;
+}
+
+void Scene::UpdateSpatialIndex()
+{
+	// Most objects did not move, for those this only compares their world transform version
+	bool bMeshesMoved = false;
+	for (const SceneMeshRenderable& renderable : MeshRenderables.GetDense())
+	{
+		bMeshesMoved |= MoveBoundsProxy(MeshBoundsTree, const_cast<MeshNode&>(*renderable.Mesh));
+	}
+
+	if (bMeshesMoved)
+	{
+		++GeometryVersion;
+	}
+
+	for (DecalObject* decal : Decals.GetDense())
+	{
+		MoveBoundsProxy(DecalBoundsTree, *decal);
+	}
+}
+
+void Scene::QueryMeshRenderables(const Frustum& inFrustum, eastl::vector<SceneMeshRenderable>& outRenderables) const
+{
+	MeshBoundsTree.ForEachInFrustum(inFrustum, [&](void* inUserData)
+	{
+		outRenderables.push_back(*MeshRenderables.Get(static_cast<const MeshNode*>(inUserData)->SceneHandle));
+	});
+
+	for (const MeshNode* mesh : UnboundedMeshes)
+	{
+		outRenderables.push_back(*MeshRenderables.Get(mesh->SceneHandle));
+	}
+}
+
+void Scene::QueryDecals(const AABB& inBounds, eastl::vector<DecalObject*>& outDecals) const
+{
+	DecalBoundsTree.ForEachInAABB(inBounds, [&outDecals](void* inUserData)
+	{
+		outDecals.push_back(static_cast<DecalObject*>(inUserData));
+	});
+}
+
+bool Scene::RaycastDecals(const PathTracingRay& inRay, DecalObject*& outDecal, float& outDistance) const
+{
+	outDecal = nullptr;
+	outDistance = inRay.MaxDistance;
+
+	DecalBoundsTree.ForEachOnRay(inRay, [&](void* inUserData)
+	{
+		DecalObject* decal = static_cast<DecalObject*>(inUserData);
+
+		// The tree only holds the world bounds, test the box of the decal itself in its local space
+		const glm::mat4 localToWorld = decal->GetAbsoluteMatrix();
+		if (glm::abs(glm::determinant(localToWorld)) < 1e-12f)
+		{
+			return;
+		}
+
+		AABB localBounds;
+		decal->GetLocalBounds(localBounds);
+
+		// Direction isn't normalized so the distance along the local ray is the world one
+		const glm::mat4 worldToLocal = glm::inverse(localToWorld);
+		PathTracingRay localRay;
+		localRay.Origin = glm::vec3(worldToLocal * glm::vec4(inRay.Origin, 1.f));
+		localRay.Direction = glm::vec3(worldToLocal * glm::vec4(inRay.Direction, 0.f));
+		localRay.MaxDistance = outDistance;
+
+		float distance = 0.f;
+		if (RayIntersectsAABB(localRay, localBounds, distance))
+		{
+			outDecal = decal;
+			outDistance = distance;
+		}
+	});
+
+	return outDecal != nullptr;
+}
+
 void Scene::ImGuiRecursivelyDisplaySceneTree(eastl::vector<TransformObjPtr>& inObjects, const bool inDisplayNode)
 {
 	for (TransformObjPtr& obj : inObjects)
@@ -77,16 +372,25 @@ void Scene::ImGuiRecursivelyDisplaySceneTree(eastl::vector<TransformObjPtr>& inO
 
 			if (displayChildNodes)
 			{
-				bool dirty = false;
 				constexpr float dragSpeed = 0.05f;
 
-				dirty |= ImGui::DragFloat3("Position", &obj->Location.x, dragSpeed);
-				dirty |= ImGui::DragFloat3("Rotation", &obj->Rotation.x, dragSpeed);
-				dirty |= ImGui::DragFloat3("Scale", &obj->Scale.x, dragSpeed);
+				glm::vec3 location = obj->GetLocation();
+				glm::vec3 rotation = obj->GetRelRotationDegrees();
+				glm::vec3 scale = obj->GetRelScale();
+
+				if (ImGui::DragFloat3("Position", &location.x, dragSpeed))
+				{
+					obj->SetRelativeLocation(location);
+				}
+
+				if (ImGui::DragFloat3("Rotation", &rotation.x, dragSpeed))
+				{
+					obj->SetRotationDegrees(rotation);
+				}
 
-				if (dirty)
+				if (ImGui::DragFloat3("Scale", &scale.x, dragSpeed))
 				{
-					obj->MakeTransfDirty();
+					obj->SetScale(scale);
 				}
 			}
 		}
@@ -1,14 +1,38 @@
 #pragma once
 #include "EASTL/vector.h"
 #include "EASTL/shared_ptr.h"
+#include "EASTL/utility.h"
 #include "Entity/TransformObject.h"
 #include "Renderer/Drawable/ShapesUtils/BasicShapes.h"
 #include "Renderer/RenderUtils.h"
 #include "Camera/Camera.h"
+#include "Scene/SceneQueries.h"
+#include "Entity/SystemScheduler.h"
+#include "Utils/SlotMap.h"
+#include "Math/DynamicAABBTree.h"
+#include "Math/Frustum.h"
+
+// A mesh to draw along with the materials of the model owning it
+struct SceneMeshRenderable
+{
+	const MeshNode* Mesh = nullptr;
+	const eastl::vector<MeshMaterial>* Materials = nullptr;
+
+	// Slot of the mesh in the scene instance buffer, stays the same while the mesh is part of the scene
+	uint32_t InstanceSlot = uint32_t(-1);
+
+	// Changes each time the slot is given to a newly added mesh, even if it's the same object added back
+	uint32_t InstanceGeneration = 0;
+};
 
 /**
  * Scene graph
- * 
+ * Besides the tree, the scene keeps flat lists of the objects the passes and systems look for, filled when objects are added.
+ * Children have to be attached before their root is added to the scene to be part of them.
+ * Each object keeps the handle of its list entry, so removing a subtree drops its entries without searching the lists.
+ * Meshes and decals with bounds are also kept in dynamic AABB trees, so spatial and gameplay queries only visit the
+ * objects near the queried volume.
+ * Only the entities of the scene tick with it, in tree order.
  */
 
 class Scene
@@ -19,7 +43,10 @@ public:
 
 	void TickObjects(float inDeltaT);
 	void InitObjects();
+
+	// Called from an entity Tick, the change is applied once every entity of the scene ticked
 	void AddObject(TransformObjPtr inObj);
+	void RemoveObject(const TransformObjPtr& inObj);
 	
 	void ImGuiDisplaySceneTree();
 
@@ -33,15 +60,81 @@ public:
 
 
 	inline const eastl::vector<TransformObjPtr>& GetAllObjects() const { return Objects; }
+	inline const eastl::vector<SceneMeshRenderable>& GetMeshRenderables() const { return MeshRenderables.GetDense(); }
+	inline const eastl::vector<DecalObject*>& GetDecals() const { return Decals.GetDense(); }
+	inline const eastl::vector<Entity*>& GetEntities() const { return Entities.GetDense(); }
+	inline const SceneMeshRenderable* GetMeshRenderable(const SlotHandle inHandle) const { return MeshRenderables.Get(inHandle); }
+
+	// Ray queries over the scene meshes, rebuilt lazily if meshes were added or removed since the last query, only the meshes
+	// that moved are updated otherwise
+	SceneQueries& GetQueries();
+
+	// Forces the next query to rebuild, for changes the geometry version doesn't see like edited vertices
+	inline void MarkQueriesDirty() { bQueriesDirty = true; }
+
+	// Moves the bounds of the meshes and decals whose world transform changed, after the world transforms were updated
+	void UpdateSpatialIndex();
+
+	// Changes whenever meshes are added, removed or moved, snapshots of the scene geometry are stale once it differs
+	inline uint64_t GetGeometryVersion() const { return GeometryVersion; }
+
+	// Changes whenever objects are added or removed, not when they move
+	inline uint64_t GetMeshListVersion() const { return MeshListVersion; }
+
+	// Appends the renderables whose bounds touch the frustum, along with the ones without bounds
+	void QueryMeshRenderables(const Frustum& inFrustum, eastl::vector<SceneMeshRenderable>& outRenderables) const;
+
+	// Appends the decals whose world bounds touch inBounds
+	void QueryDecals(const AABB& inBounds, eastl::vector<DecalObject*>& outDecals) const;
+
+	// Closest decal box the ray enters within its max distance, 0 if it starts inside one
+	bool RaycastDecals(const PathTracingRay& inRay, DecalObject*& outDecal, float& outDistance) const;
+
+	// User data of the proxies are the MeshNode and DecalObject pointers
+	inline const DynamicAABBTree& GetMeshBoundsTree() const { return MeshBoundsTree; }
+	inline const DynamicAABBTree& GetDecalBoundsTree() const { return DecalBoundsTree; }
+
+	// Systems updating the data only entities of the EntityRegistry, run on tick after the Entity objects of this scene
+	inline SystemScheduler& GetSystems() { return Systems; }
 
 private:
-	void RecursivelyTickObjects(float inDeltaT, eastl::vector<TransformObjPtr>& inObjects);
-	void RecursivelyInitObjects(eastl::vector<TransformObjPtr>& inObjects);
+	void TickEntityObjects(const float inDeltaT);
+	void GatherEntitiesRecursive(TransformObject& inObject);
+	void RegisterObjectRecursive(TransformObject& inObject, const eastl::vector<MeshMaterial>* inMaterials);
+	void UnregisterObjectRecursive(TransformObject& inObject);
+	void AddBoundsProxy(DynamicAABBTree& inTree, DrawableObject& inObject, void* inUserData);
+	void RemoveBoundsProxy(DynamicAABBTree& inTree, DrawableObject& inObject);
+	bool MoveBoundsProxy(DynamicAABBTree& inTree, DrawableObject& inObject);
 	void ImGuiRecursivelyDisplaySceneTree(eastl::vector<TransformObjPtr>& inObjects, const bool inDisplayNode);
 
 private:
 	eastl::vector<TransformObjPtr> Objects;
+
+	// Pre order like the tree until objects get removed
+	SlotMap<SceneMeshRenderable> MeshRenderables;
+	SlotMap<DecalObject*> Decals;
+	SlotMap<Entity*> Entities;
+
+	DynamicAABBTree MeshBoundsTree;
+	DynamicAABBTree DecalBoundsTree;
+
+	// Renderables of meshes that have no bounds, added to every visibility query
+	eastl::vector<const MeshNode*> UnboundedMeshes;
+
 	eastl::shared_ptr<Camera> CurrentCamera;
+	SceneQueries Queries;
+	SystemScheduler Systems;
+	bool bQueriesDirty = true;
+	uint64_t GeometryVersion = 0;
+	uint64_t MeshListVersion = 0;
+
+	// Entities in tree order, gathered again after objects were added or removed
+	eastl::vector<Entity*> EntityTickOrder;
+	bool bEntityTickOrderDirty = true;
+
+	// Objects added(true) or removed(false) while the entities tick
+	eastl::vector<eastl::pair<TransformObjPtr, bool>> PendingObjectChanges;
+	bool bTickingEntities = false;
 	//eastl::vector<eastl::shared_ptr<LightSource>> Lights;
 };
 
@@ -0,0 +1,570 @@
+#include "Scene/SceneQueries.h"
+#include "Scene/Scene.h"
+#include "Camera/Camera.h"
+#include "Core/TaskSystem.h"
+#include "Math/CollisionTests.h"
+#include "Renderer/Baking/BakingScene.h"
+#include "Renderer/Baking/BakingUtils.h"
+#include "Renderer/Model/3D/Model3D.h"
+#include "EASTL/algorithm.h"
+#include "EASTL/string.h"
+#include "EASTL/utility.h"
+#include "Utils/PerfUtils.h"
+#include "Utils/TestUtils.h"
+
+void SceneQueries::Build(const Scene& inScene)
+{
+	BENCH_SCOPE("Scene Queries Build");
+
+	Meshes.clear();
+	MeshTree.Clear();
+	Bounds = AABB();
+
+	// Same meshes as the baking scene, the ones under the scene roots
+	for (const TransformObjPtr& object : inScene.GetAllObjects())
+	{
+		object->ForEach_Children_Recursive([&](const TransformObjPtr& inChild)
+		{
+			if (MeshNode* node = dynamic_cast<MeshNode*>(inChild.get()))
+			{
+				Meshes.push_back(eastl::make_unique<SceneQueryMesh>());
+				Meshes.back()->Node = node;
+			}
+		});
+	}
+
+	TaskSystem::Get().ParallelFor(static_cast<uint32_t>(Meshes.size()), 4, [&](const uint32_t inBegin, const uint32_t inEnd, const uint32_t inWorkerIdx)
+	{
+		for (uint32_t i = inBegin; i < inEnd; ++i)
+		{
+			BuildMesh(*Meshes[i]);
+		}
+	});
+
+	for (const eastl::unique_ptr<SceneQueryMesh>& mesh : Meshes)
+	{
+		UpdateProxy(*mesh, glm::vec3(0.f));
+		if (mesh->Triangles.IsValid())
+		{
+			Bounds += mesh->Bounds;
+		}
+	}
+
+	GeometryVersion = inScene.GetGeometryVersion();
+	MeshListVersion = inScene.GetMeshListVersion();
+}
+
+void SceneQueries::UpdateMovedMeshes(const Scene& inScene)
+{
+	// Comparing the world versions is all the work for the meshes that didn't move
+	eastl::vector<eastl::pair<SceneQueryMesh*, glm::vec3>> movedMeshes;
+	for (const eastl::unique_ptr<SceneQueryMesh>& mesh : Meshes)
+	{
+		if (mesh->Node->GetWorldVersion() != mesh->WorldVersion)
+		{
+			glm::vec3 center, extent;
+			mesh->Bounds.GetCenterAndExtent(center, extent);
+			movedMeshes.push_back(eastl::make_pair(mesh.get(), center));
+		}
+	}
+
+	TaskSystem::Get().ParallelFor(static_cast<uint32_t>(movedMeshes.size()), 1, [&](const uint32_t inBegin, const uint32_t inEnd, const uint32_t inWorkerIdx)
+	{
+		for (uint32_t i = inBegin; i < inEnd; ++i)
+		{
+			BuildMesh(*movedMeshes[i].first);
+		}
+	});
+
+	for (const eastl::pair<SceneQueryMesh*, glm::vec3>& moved : movedMeshes)
+	{
+		UpdateProxy(*moved.first, moved.second);
+	}
+
+	Bounds = AABB();
+	for (const eastl::unique_ptr<SceneQueryMesh>& mesh : Meshes)
+	{
+		if (mesh->Triangles.IsValid())
+		{
+			Bounds += mesh->Bounds;
+		}
+	}
+
+	GeometryVersion = inScene.GetGeometryVersion();
+}
+
+void SceneQueries::BuildMesh(SceneQueryMesh& ioMesh)
+{
+	ioMesh.WorldVersion = ioMesh.Node->GetWorldVersion();
+	ioMesh.Bounds = AABB();
+	ioMesh.Triangles.Clear();
+
+	// Hits know their mesh from the BVH they were found in, so the object index isn't used
+	eastl::vector<PathTraceTriangle> triangles;
+	if (BakingScene::GatherMeshTriangles(*ioMesh.Node, 0, triangles, ioMesh.Bounds) && !triangles.empty())
+	{
+		ioMesh.Triangles.Build(triangles);
+	}
+}
+
+void SceneQueries::UpdateProxy(SceneQueryMesh& ioMesh, const glm::vec3& inPreviousCenter)
+{
+	if (!ioMesh.Triangles.IsValid())
+	{
+		if (ioMesh.Proxy != DynamicAABBTree::NullNode)
+		{
+			MeshTree.Remove(ioMesh.Proxy);
+			ioMesh.Proxy = DynamicAABBTree::NullNode;
+		}
+
+		return;
+	}
+
+	if (ioMesh.Proxy == DynamicAABBTree::NullNode)
+	{
+		ioMesh.Proxy = MeshTree.Insert(ioMesh.Bounds, &ioMesh);
+		return;
+	}
+
+	glm::vec3 center, extent;
+	ioMesh.Bounds.GetCenterAndExtent(center, extent);
+	MeshTree.Move(ioMesh.Proxy, ioMesh.Bounds, center - inPreviousCenter);
+}
+
+bool SceneQueries::Raycast(const PathTracingRay& inRay, SceneRaycastHit& outHit) const
+{
+	// The ray is cut at the closest hit so far, so meshes further away are skipped
+	PathTracingRay ray = inRay;
+	PathTracePayload payload;
+	const SceneQueryMesh* hitMesh = nullptr;
+
+	MeshTree.ForEachOnRay(ray, [&](void* inUserData)
+	{
+		const SceneQueryMesh& mesh = *static_cast<const SceneQueryMesh*>(inUserData);
+		if (mesh.Triangles.Trace(ray, payload))
+		{
+			hitMesh = &mesh;
+			ray.MaxDistance = payload.Distance;
+		}
+	});
+
+	if (!hitMesh)
+	{
+		return false;
+	}
+
+	const PathTraceTriangle& triangle = *payload.Triangle;
+
+	outHit.Mesh = hitMesh->Node;
+	outHit.Distance = payload.Distance;
+	outHit.Barycentrics = glm::vec3(1.f - payload.U - payload.V, payload.U, payload.V);
+	outHit.Position = inRay.Origin + inRay.Direction * payload.Distance;
+	outHit.Normal = triangle.WSNormalNormalized;
+
+	return true;
+}
+
+bool SceneQueries::RaycastAny(const PathTracingRay& inRay) const
+{
+	PathTracingRay ray = inRay;
+	bool bHit = false;
+
+	MeshTree.ForEachOnRay(ray, [&](void* inUserData)
+	{
+		// A negative max distance fails every node test left, the traversal has no early out
+		if (static_cast<const SceneQueryMesh*>(inUserData)->Triangles.Intersects(inRay))
+		{
+			bHit = true;
+			ray.MaxDistance = -1.f;
+		}
+	});
+
+	return bHit;
+}
+
+bool SceneQueries::RaycastFromScreen(Camera& inCamera, const glm::vec2& inScreenPos, const glm::vec2& inViewportSize, SceneRaycastHit& outHit) const
+{
+	PathTracingRay ray = inCamera.ScreenPointToRay(inScreenPos, inViewportSize);
+	ray.MaxDistance = inCamera.GetFar();
+
+	return Raycast(ray, outHit);
+}
+
+// Shared closest first traversal for the sweeps, the shape is reduced to a ray and each node box is grown by the shape extent
+template<typename SweepTriangleFunc>
+static bool SweepNode(const BVHNode& inNode, const glm::vec3& inShapeExtent, PathTracingRay& ioRay, const SweepTriangleFunc& inSweepTriangle,
+	const PathTraceTriangle*& outTriangle, glm::vec3& outNormal)
+{
+	AABB inflatedBox = inNode.BoundingBox;
+	inflatedBox.Min -= inShapeExtent;
+	inflatedBox.Max += inShapeExtent;
+
+	// The ray max distance is shrunk to the closest contact found so far
+	float entryDistance = 0.f;
+	if (!RayIntersectsAABB(ioRay, inflatedBox, entryDistance))
+	{
+		return false;
+	}
+
+	if (inNode.LeftNode)
+	{
+		const glm::vec3 leftCenter = (inNode.LeftNode->BoundingBox.Min + inNode.LeftNode->BoundingBox.Max) * 0.5f;
+		const glm::vec3 rightCenter = (inNode.RightNode->BoundingBox.Min + inNode.RightNode->BoundingBox.Max) * 0.5f;
+		const bool bLeftFirst = glm::dot(leftCenter - rightCenter, ioRay.Direction) <= 0.f;
+
+		const BVHNode& firstNode = bLeftFirst ? *inNode.LeftNode : *inNode.RightNode;
+		const BVHNode& secondNode = bLeftFirst ? *inNode.RightNode : *inNode.LeftNode;
+
+		const bool bFirstHit = SweepNode(firstNode, inShapeExtent, ioRay, inSweepTriangle, outTriangle, outNormal);
+		const bool bSecondHit = SweepNode(secondNode, inShapeExtent, ioRay, inSweepTriangle, outTriangle, outNormal);
+
+		return bFirstHit || bSecondHit;
+	}
+
+	bool bHit = false;
+	for (const PathTraceTriangle& triangle : inNode.Triangles)
+	{
+		float distance = 0.f;
+		glm::vec3 normal;
+		if (inSweepTriangle(triangle, ioRay.MaxDistance, distance, normal))
+		{
+			ioRay.MaxDistance = distance;
+			outTriangle = &triangle;
+			outNormal = normal;
+			bHit = true;
+		}
+	}
+
+	return bHit;
+}
+
+// True at the first triangle of the mesh touching the shape
+template<typename OverlapTriangleFunc>
+static bool OverlapNode(const BVHNode& inNode, const AABB& inQueryBounds, const OverlapTriangleFunc& inOverlapTriangle)
+{
+	if (!CollisionTests::AABBIntersectsAABB(inNode.BoundingBox, inQueryBounds))
+	{
+		return false;
+	}
+
+	if (inNode.LeftNode)
+	{
+		return OverlapNode(*inNode.LeftNode, inQueryBounds, inOverlapTriangle) || OverlapNode(*inNode.RightNode, inQueryBounds, inOverlapTriangle);
+	}
+
+	for (const PathTraceTriangle& triangle : inNode.Triangles)
+	{
+		if (inOverlapTriangle(triangle))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+template<typename OverlapTriangleFunc>
+static bool OverlapMeshes(const DynamicAABBTree& inMeshTree, const AABB& inQueryBounds, const OverlapTriangleFunc& inOverlapTriangle, eastl::vector<MeshNode*>* outMeshes)
+{
+	// Without output the meshes visited after the first one touching the shape are skipped
+	bool bHit = false;
+	inMeshTree.ForEachInAABB(inQueryBounds, [&](void* inUserData)
+	{
+		if (bHit && !outMeshes)
+		{
+			return;
+		}
+
+		const SceneQueryMesh& mesh = *static_cast<const SceneQueryMesh*>(inUserData);
+		if (OverlapNode(*mesh.Triangles.Root, inQueryBounds, inOverlapTriangle))
+		{
+			bHit = true;
+			if (outMeshes)
+			{
+				outMeshes->push_back(mesh.Node);
+			}
+		}
+	});
+
+	return bHit;
+}
+
+template<typename SweepType, typename SweepTriangleFunc>
+static bool SweepShape(const DynamicAABBTree& inMeshTree, const SweepType& inSweep, const glm::vec3& inShapeExtent, const SweepTriangleFunc& inSweepTriangle, SceneSweepHit& outHit)
+{
+	PathTracingRay ray;
+	ray.Origin = inSweep.Start;
+	ray.Direction = inSweep.Direction;
+	ray.MaxDistance = inSweep.MaxDistance;
+
+	// Each contact shrinks the ray, which the mesh tree traversal tests too
+	const SceneQueryMesh* hitMesh = nullptr;
+	glm::vec3 hitNormal;
+	inMeshTree.ForEachOnSweep(ray, inShapeExtent, [&](void* inUserData)
+	{
+		const SceneQueryMesh& mesh = *static_cast<const SceneQueryMesh*>(inUserData);
+
+		const PathTraceTriangle* hitTriangle = nullptr;
+		if (SweepNode(*mesh.Triangles.Root, inShapeExtent, ray, inSweepTriangle, hitTriangle, hitNormal))
+		{
+			hitMesh = &mesh;
+		}
+	});
+
+	if (!hitMesh)
+	{
+		return false;
+	}
+
+	outHit.Mesh = hitMesh->Node;
+	outHit.Distance = ray.MaxDistance;
+	outHit.Position = inSweep.Start + inSweep.Direction * ray.MaxDistance;
+	outHit.Normal = hitNormal;
+
+	return true;
+}
+
+bool SceneQueries::SweepSphere(const SphereSweep& inSweep, SceneSweepHit& outHit) const
+{
+	return SweepShape(MeshTree, inSweep, glm::vec3(inSweep.Radius), [&inSweep](const PathTraceTriangle& inTri, const float inMaxDistance, float& outDistance, glm::vec3& outNormal)
+	{
+		return CollisionTests::SweepSphereTriangle(inSweep.Start, inSweep.Radius, inSweep.Direction, inMaxDistance, inTri, outDistance, outNormal);
+	}, outHit);
+}
+
+bool SceneQueries::SweepBox(const BoxSweep& inSweep, SceneSweepHit& outHit) const
+{
+	return SweepShape(MeshTree, inSweep, inSweep.HalfExtent, [&inSweep](const PathTraceTriangle& inTri, const float inMaxDistance, float& outDistance, glm::vec3& outNormal)
+	{
+		return CollisionTests::SweepBoxTriangle(inSweep.Start, inSweep.HalfExtent, inSweep.Direction, inMaxDistance, inTri, outDistance, outNormal);
+	}, outHit);
+}
+
+bool SceneQueries::OverlapSphere(const glm::vec3& inCenter, const float inRadius, eastl::vector<MeshNode*>* outMeshes) const
+{
+	AABB sphereBounds;
+	sphereBounds += inCenter - glm::vec3(inRadius);
+	sphereBounds += inCenter + glm::vec3(inRadius);
+
+	return OverlapMeshes(MeshTree, sphereBounds, [&](const PathTraceTriangle& inTri)
+	{
+		return CollisionTests::SphereIntersectsTriangle(inCenter, inRadius, inTri);
+	}, outMeshes);
+}
+
+bool SceneQueries::OverlapBox(const AABB& inBox, eastl::vector<MeshNode*>* outMeshes) const
+{
+	glm::vec3 center, extent;
+	inBox.GetCenterAndExtent(center, extent);
+
+	return OverlapMeshes(MeshTree, inBox, [&](const PathTraceTriangle& inTri)
+	{
+		return CollisionTests::BoxIntersectsTriangle(center, extent, inTri);
+	}, outMeshes);
+}
+
+void SceneQueries::SweepSphereBatch(const eastl::vector<SphereSweep>& inSweeps, eastl::vector<SceneSweepHit>& outHits) const
+{
+	outHits.clear();
+	outHits.resize(inSweeps.size());
+
+	TaskSystem::Get().ParallelFor(static_cast<uint32_t>(inSweeps.size()), 16, [&](const uint32_t inBegin, const uint32_t inEnd, const uint32_t inWorkerIdx)
+	{
+		for (uint32_t i = inBegin; i < inEnd; ++i)
+		{
+			SweepSphere(inSweeps[i], outHits[i]);
+		}
+	});
+}
+
+void SceneQueries::SweepBoxBatch(const eastl::vector<BoxSweep>& inSweeps, eastl::vector<SceneSweepHit>& outHits) const
+{
+	outHits.clear();
+	outHits.resize(inSweeps.size());
+
+	TaskSystem::Get().ParallelFor(static_cast<uint32_t>(inSweeps.size()), 16, [&](const uint32_t inBegin, const uint32_t inEnd, const uint32_t inWorkerIdx)
+	{
+		for (uint32_t i = inBegin; i < inEnd; ++i)
+		{
+			SweepBox(inSweeps[i], outHits[i]);
+		}
+	});
+}
+
+void SceneQueries::OverlapSphereBatch(const eastl::vector<glm::vec4>& inSpheres, eastl::vector<uint8_t>& outResults) const
+{
+	outResults.clear();
+	outResults.resize(inSpheres.size(), 0);
+
+	TaskSystem::Get().ParallelFor(static_cast<uint32_t>(inSpheres.size()), 32, [&](const uint32_t inBegin, const uint32_t inEnd, const uint32_t inWorkerIdx)
+	{
+		for (uint32_t i = inBegin; i < inEnd; ++i)
+		{
+			outResults[i] = OverlapSphere(glm::vec3(inSpheres[i]), inSpheres[i].w) ? 1 : 0;
+		}
+	});
+}
+
+void SceneQueries::CreateRandomQueries(const uint32_t inNumQueries, eastl::vector<SphereSweep>& outSphereSweeps, eastl::vector<BoxSweep>& outBoxSweeps,
+	eastl::vector<glm::vec4>& outSpheres) const
+{
+	TestUtils::TestRandom random;
+
+	const AABB& bounds = Bounds;
+	const float sceneSize = glm::length(bounds.Max - bounds.Min);
+
+	outSphereSweeps.resize(inNumQueries);
+	outBoxSweeps.resize(inNumQueries);
+	outSpheres.resize(inNumQueries);
+
+	for (uint32_t i = 0; i < inNumQueries; ++i)
+	{
+		const glm::vec3 start = glm::mix(bounds.Min, bounds.Max, random.NextVec3());
+		const float u = random.Next();
+		const float v = random.Next();
+		const glm::vec3 direction = BakingUtils::UniformSampleSphere(glm::vec2(u, v));
+
+		// Camera and character sized shapes moving a few percent of the scene per query
+		const float size = sceneSize * 0.005f;
+		const float distance = sceneSize * 0.05f;
+
+		outSphereSweeps[i] = { start, direction, distance, size };
+		outBoxSweeps[i] = { start, direction, distance, glm::vec3(size) };
+		outSpheres[i] = glm::vec4(start, size);
+	}
+}
+
+void SceneQueries::BenchmarkShapeQueries(const uint32_t inNumQueries) const
+{
+	if (!IsValid() || inNumQueries == 0)
+	{
+		return;
+	}
+
+	eastl::vector<SphereSweep> sphereSweeps;
+	eastl::vector<BoxSweep> boxSweeps;
+	eastl::vector<glm::vec4> spheres;
+	CreateRandomQueries(inNumQueries, sphereSweeps, boxSweeps, spheres);
+
+	SceneSweepHit hit;
+	uint32_t numHits = 0;
+
+	int64_t sphereSweepUs = 0;
+	{
+		Utils::BenchmarkCode bench(&sphereSweepUs);
+		for (const SphereSweep& sweep : sphereSweeps)
+		{
+			numHits += SweepSphere(sweep, hit) ? 1 : 0;
+		}
+	}
+
+	int64_t boxSweepUs = 0;
+	{
+		Utils::BenchmarkCode bench(&boxSweepUs);
+		for (const BoxSweep& sweep : boxSweeps)
+		{
+			numHits += SweepBox(sweep, hit) ? 1 : 0;
+		}
+	}
+
+	int64_t sphereOverlapUs = 0;
+	{
+		Utils::BenchmarkCode bench(&sphereOverlapUs);
+		for (const glm::vec4& sphere : spheres)
+		{
+			numHits += OverlapSphere(glm::vec3(sphere), sphere.w) ? 1 : 0;
+		}
+	}
+
+	eastl::vector<SceneSweepHit> batchHits;
+	int64_t batchSweepUs = 0;
+	{
+		Utils::BenchmarkCode bench(&batchSweepUs);
+		SweepSphereBatch(sphereSweeps, batchHits);
+	}
+
+	const double toNsPerQuery = 1000.0 / double(inNumQueries);
+	LOG_INFO("Shape queries(%u each, %u hits): sphere sweep %f ns, box sweep %f ns, sphere overlap %f ns, batched sphere sweep %f ns per query.", inNumQueries, numHits,
+		double(sphereSweepUs) * toNsPerQuery, double(boxSweepUs) * toNsPerQuery, double(sphereOverlapUs) * toNsPerQuery, double(batchSweepUs) * toNsPerQuery);
+}
+
+void SceneQueries::RunChecks(const Scene& inScene, const uint32_t inNumQueries) const
+{
+	if (!IsValid() || inNumQueries == 0)
+	{
+		return;
+	}
+
+	eastl::vector<SphereSweep> sphereSweeps;
+	eastl::vector<BoxSweep> boxSweeps;
+	eastl::vector<glm::vec4> spheres;
+	CreateRandomQueries(inNumQueries, sphereSweeps, boxSweeps, spheres);
+
+	// Batches run the same traversal on the workers, so they have to give the exact same hits
+	const auto isSameHit = [](const bool inHit, const SceneSweepHit& inSingle, const SceneSweepHit& inBatched)
+	{
+		return inHit ? inBatched.Mesh == inSingle.Mesh && inBatched.Distance == inSingle.Distance : inBatched.Mesh == nullptr;
+	};
+
+	eastl::vector<SceneSweepHit> batchHits;
+	SceneSweepHit hit;
+	{
+		SweepSphereBatch(sphereSweeps, batchHits);
+
+		TestUtils::CheckScope check("Batched sphere sweeps against single ones");
+		for (uint32_t i = 0; i < inNumQueries; ++i)
+		{
+			const bool bHit = SweepSphere(sphereSweeps[i], hit);
+			check.Expect(isSameHit(bHit, hit, batchHits[i]));
+		}
+	}
+
+	{
+		SweepBoxBatch(boxSweeps, batchHits);
+
+		TestUtils::CheckScope check("Batched box sweeps against single ones");
+		for (uint32_t i = 0; i < inNumQueries; ++i)
+		{
+			const bool bHit = SweepBox(boxSweeps[i], hit);
+			check.Expect(isSameHit(bHit, hit, batchHits[i]));
+		}
+	}
+
+	{
+		eastl::vector<uint8_t> overlaps;
+		OverlapSphereBatch(spheres, overlaps);
+
+		TestUtils::CheckScope check("Batched sphere overlaps against single ones");
+		for (uint32_t i = 0; i < inNumQueries; ++i)
+		{
+			check.Expect(OverlapSphere(glm::vec3(spheres[i]), spheres[i].w) == (overlaps[i] != 0));
+		}
+	}
+
+	// Meshes that moved since the last build had their own BVH built again, which has to find the same contacts as building
+	// everything. Meshes touching at the same distance can come in either order, so sweeps compare distances only and
+	// overlaps the sets of meshes.
+	SceneQueries rebuilt;
+	rebuilt.Build(inScene);
+
+	{
+		TestUtils::CheckScope check("Scene queries updated as meshes moved against a full build");
+		SceneSweepHit rebuiltHit;
+		eastl::vector<MeshNode*> meshes;
+		eastl::vector<MeshNode*> rebuiltMeshes;
+		for (uint32_t i = 0; i < inNumQueries; ++i)
+		{
+			const bool bHit = SweepSphere(sphereSweeps[i], hit);
+			const bool bRebuiltHit = rebuilt.SweepSphere(sphereSweeps[i], rebuiltHit);
+			check.Expect(bHit == bRebuiltHit && (!bHit || hit.Distance == rebuiltHit.Distance));
+
+			meshes.clear();
+			rebuiltMeshes.clear();
+			OverlapSphere(glm::vec3(spheres[i]), spheres[i].w, &meshes);
+			rebuilt.OverlapSphere(glm::vec3(spheres[i]), spheres[i].w, &rebuiltMeshes);
+			eastl::sort(meshes.begin(), meshes.end());
+			eastl::sort(rebuiltMeshes.begin(), rebuiltMeshes.end());
+			check.Expect(meshes == rebuiltMeshes);
+		}
+	}
+}
@@ -0,0 +1,131 @@
+#pragma once
+#include "glm/glm.hpp"
+#include "EASTL/unique_ptr.h"
+#include "Math/PathTracing.h"
+#include "Math/BVH.h"
+#include "Math/DynamicAABBTree.h"
+
+struct SceneRaycastHit
+{
+	struct MeshNode* Mesh = nullptr;
+	float Distance = 0.f;
+
+	// Weights of the triangle's 3 vertices at the hit point
+	glm::vec3 Barycentrics = glm::vec3(0.f);
+	glm::vec3 Position = glm::vec3(0.f);
+	glm::vec3 Normal = glm::vec3(0.f);
+};
+
+struct SceneSweepHit
+{
+	struct MeshNode* Mesh = nullptr;
+
+	// Distance travelled before the first contact, 0 if the shape overlapped at the start
+	float Distance = 0.f;
+
+	// Center of the shape at the contact and the surface normal pushing it back
+	glm::vec3 Position = glm::vec3(0.f);
+	glm::vec3 Normal = glm::vec3(0.f);
+};
+
+struct SphereSweep
+{
+	glm::vec3 Start = glm::vec3(0.f);
+	glm::vec3 Direction = glm::vec3(0.f, 0.f, 1.f);
+	float MaxDistance = 0.f;
+	float Radius = 0.f;
+};
+
+struct BoxSweep
+{
+	glm::vec3 Start = glm::vec3(0.f);
+	glm::vec3 Direction = glm::vec3(0.f, 0.f, 1.f);
+	float MaxDistance = 0.f;
+	glm::vec3 HalfExtent = glm::vec3(0.f);
+};
+
+// A mesh with CPU triangles, proxies of the query tree point to these
+struct SceneQueryMesh
+{
+	struct MeshNode* Node = nullptr;
+
+	// World space snapshot of the triangles, empty when they are all degenerate
+	BVH Triangles;
+	AABB Bounds;
+	uint32_t WorldVersion = 0;
+	int32_t Proxy = DynamicAABBTree::NullNode;
+};
+
+/**
+ * Ray and shape queries against the scene's meshes, for editor picking and gameplay.
+ * Each mesh gets a snapshot of its triangles in a world space BVH, under a dynamic AABB tree over the mesh bounds.
+ * Scene::GetQueries builds everything again once meshes were added or removed. Moved meshes only get their own BVH built
+ * again and their proxy moved, so a moving object costs as much as its own triangles instead of the whole scene.
+ * Triangles are single sided for rays, like the base pass rasterization, and double sided for shapes.
+ */
+class SceneQueries
+{
+public:
+	void Build(const class Scene& inScene);
+
+	// Builds the BVH of the meshes whose world transform changed since they were snapshot
+	void UpdateMovedMeshes(const class Scene& inScene);
+
+	// Closest hit
+	bool Raycast(const PathTracingRay& inRay, SceneRaycastHit& outHit) const;
+
+	// Any hit, cheaper when only occlusion matters
+	bool RaycastAny(const PathTracingRay& inRay) const;
+
+	// Closest hit along the ray going through a pixel of the camera viewport
+	bool RaycastFromScreen(class Camera& inCamera, const glm::vec2& inScreenPos, const glm::vec2& inViewportSize, SceneRaycastHit& outHit) const;
+
+	// Closest contact of a shape moving along a direction, BVH nodes are inflated by the shape extent so traversal stays conservative.
+	// Spheres starting inside of surfaces only hit the ones they move deeper into, at distance 0.
+	bool SweepSphere(const SphereSweep& inSweep, SceneSweepHit& outHit) const;
+	bool SweepBox(const BoxSweep& inSweep, SceneSweepHit& outHit) const;
+
+	// Optionally gathers every mesh touching the shape, without output the query stops at the first triangle found
+	bool OverlapSphere(const glm::vec3& inCenter, const float inRadius, eastl::vector<struct MeshNode*>* outMeshes = nullptr) const;
+	bool OverlapBox(const AABB& inBox, eastl::vector<struct MeshNode*>* outMeshes = nullptr) const;
+
+	// Many queries at once spread over the task system workers, misses have a null mesh
+	void SweepSphereBatch(const eastl::vector<SphereSweep>& inSweeps, eastl::vector<SceneSweepHit>& outHits) const;
+	void SweepBoxBatch(const eastl::vector<BoxSweep>& inSweeps, eastl::vector<SceneSweepHit>& outHits) const;
+
+	// Spheres packed as center and radius in w
+	void OverlapSphereBatch(const eastl::vector<glm::vec4>& inSpheres, eastl::vector<uint8_t>& outResults) const;
+
+	// Times random sweeps and overlaps inside the scene bounds and logs the average cost of each, serial and batched
+	void BenchmarkShapeQueries(const uint32_t inNumQueries) const;
+
+	// Asserts batched sweeps and overlaps give the same results as single ones, and that the meshes updated as they moved give
+	// the same results as building the queries of the scene again, for random queries inside the scene bounds
+	void RunChecks(const class Scene& inScene, const uint32_t inNumQueries) const;
+
+	inline bool IsValid() const { return MeshTree.GetNumProxies() > 0; }
+
+	// Scene versions at the last build or update
+	inline uint64_t GetGeometryVersion() const { return GeometryVersion; }
+	inline uint64_t GetMeshListVersion() const { return MeshListVersion; }
+
+private:
+	// Snapshots the triangles and bounds of the mesh at its current world transform
+	static void BuildMesh(SceneQueryMesh& ioMesh);
+
+	// Adds, moves or removes the proxy of a mesh whose triangles were built again
+	void UpdateProxy(SceneQueryMesh& ioMesh, const glm::vec3& inPreviousCenter);
+
+	void CreateRandomQueries(const uint32_t inNumQueries, eastl::vector<SphereSweep>& outSphereSweeps, eastl::vector<BoxSweep>& outBoxSweeps,
+		eastl::vector<glm::vec4>& outSpheres) const;
+
+	// Kept behind pointers as the tree proxies point to them
+	eastl::vector<eastl::unique_ptr<SceneQueryMesh>> Meshes;
+	DynamicAABBTree MeshTree;
+
+	// Triangles of every mesh
+	AABB Bounds;
+
+	uint64_t GeometryVersion = 0;
+	uint64_t MeshListVersion = 0;
+};
@@ -12,30 +12,53 @@ void TimersManager::Init()
 
 void TimersManager::Terminate()
 {
-	Get().Timers.clear();
+	Get().Timers.Clear();
 }
 
-void TimersManager::AddTimer(eastl::shared_ptr<TimerBase> inTimer)
+TimerHandle TimersManager::AddTimer(eastl::unique_ptr<TimerBase> inTimer)
 {
-	Timers.push_back(inTimer);
-
 	inTimer->Start();
+
+	return Timers.Add(eastl::move(inTimer));
+}
+
+void TimersManager::RemoveTimer(const TimerHandle inTimer)
+{
+	// Timers removed from a timer callback only go away once the walk is over, removing them right away would swap
+	// another timer in under the index being walked
+	if (bTickingTimers)
+	{
+		MarkFinished(inTimer);
+		return;
+	}
+
+	Timers.Remove(inTimer);
 }
 
 void TimersManager::TickTimers(float inDeltaT)
 {
-	using timerIterator = eastl::shared_ptr<TimerBase>*;
-	eastl::vector<timerIterator> toRemove;
+	// Removing swaps timers around, so finished ones are only collected during the walk.
+	// Timers added by the callbacks are appended and start ticking next frame.
+	bTickingTimers = true;
 
-	for (timerIterator timerIter = Timers.begin(); timerIter != Timers.end(); ++timerIter)
+	const eastl::vector<eastl::unique_ptr<TimerBase>>& timers = Timers.GetDense();
+	const uint32_t numTimers = static_cast<uint32_t>(timers.size());
+	for (uint32_t i = 0; i < numTimers; ++i)
 	{
-		eastl::shared_ptr<TimerBase> timer = *timerIter;
+		TimerBase* timer = timers[i].get();
+		const TimerHandle handle = Timers.GetHandle(i);
+
+		// Removed by an earlier callback of this walk
+		if (IsFinished(handle))
+		{
+			continue;
+		}
 
 		if (timer->GetTimeLeft() < 0.f)
 		{
 			timer->End();
 
-			toRemove.push_back(timerIter);
+			MarkFinished(handle);
 
 			continue;
 		}
@@ -43,8 +66,30 @@ void TimersManager::TickTimers(float inDeltaT)
 		timer->Tick(inDeltaT);
 	}
 
-	for (timerIterator iter : toRemove)
+	bTickingTimers = false;
+
+	for (const TimerHandle handle : FinishedTimers)
 	{
-		Timers.erase(iter);
+		FinishedSlots[handle.Index] = 0;
+		Timers.Remove(handle);
 	}
+
+	FinishedTimers.clear();
+}
+
+void TimersManager::MarkFinished(const TimerHandle inTimer)
+{
+	// Stale handles and timers removed twice in the same walk are ignored
+	if (!Timers.IsValid(inTimer) || IsFinished(inTimer))
+	{
+		return;
+	}
+
+	if (inTimer.Index >= FinishedSlots.size())
+	{
+		FinishedSlots.resize(inTimer.Index + 1, 0);
+	}
+
+	FinishedSlots[inTimer.Index] = 1;
+	FinishedTimers.push_back(inTimer);
 }
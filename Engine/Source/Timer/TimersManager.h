@@ -1,8 +1,10 @@
 #pragma once
-#include "EASTL/vector.h"
-#include "EASTL/shared_ptr.h"
+#include "EASTL/unique_ptr.h"
 #include "TimerBase.h"
 #include "Core/EngineUtils.h"
+#include "Utils/SlotMap.h"
+
+using TimerHandle = SlotHandle;
 
 class TimersManager
 {
@@ -12,14 +14,27 @@ public:
 	static inline TimersManager& Get() { ASSERT(Instance); return *Instance; }
 
 public:
-	void AddTimer(eastl::shared_ptr<TimerBase> inTimer);
+	// The manager owns the timer until it ends or is removed, the handle goes stale then
+	TimerHandle AddTimer(eastl::unique_ptr<TimerBase> inTimer);
+	// Safe to call from a timer callback, the timer is removed once TickTimers is done with all of them
+	void RemoveTimer(const TimerHandle inTimer);
+	inline bool IsTimerActive(const TimerHandle inTimer) const { return Timers.IsValid(inTimer); }
 	void TickTimers(float inDeltaT);
 
 private:
 	TimersManager();
 	~TimersManager();
 
+	// Only valid while the timers are ticking, finished timers are removed once the walk is over
+	void MarkFinished(const TimerHandle inTimer);
+	inline bool IsFinished(const TimerHandle inTimer) const { return inTimer.Index < FinishedSlots.size() && FinishedSlots[inTimer.Index] != 0; }
+
 private:
 	static TimersManager* Instance;
-	eastl::vector<eastl::shared_ptr<TimerBase>> Timers;
-};
\ No newline at end of file
+	SlotMap<eastl::unique_ptr<TimerBase>> Timers;
+	eastl::vector<TimerHandle> FinishedTimers;
+
+	// Indexed by slot, set for the slots in FinishedTimers
+	eastl::vector<uint8_t> FinishedSlots;
+	bool bTickingTimers = false;
+};
@@ -27,4 +27,57 @@ namespace IOUtils
 
 		return true;
 	}
+
+	bool TryReadBinaryFile(const eastl::string& inFilePath, eastl::vector<uint8_t>& outData)
+	{
+		std::error_code errorCode;
+		if (!std::filesystem::exists(inFilePath.data(), errorCode))
+		{
+			return false;
+		}
+
+		std::ifstream fileStream(inFilePath.data(), std::ios::binary);
+
+		if (!fileStream.is_open())
+		{
+			LOG_ERROR("Failed to open file %s.", inFilePath.data());
+
+			return false;
+		}
+
+		const uintmax_t size = std::filesystem::file_size(inFilePath.data(), errorCode);
+		if (errorCode)
+		{
+			return false;
+		}
+
+		outData.resize(size);
+		fileStream.read(reinterpret_cast<char*>(outData.data()), size);
+
+		return fileStream.good() || fileStream.eof();
+	}
+
+	bool WriteBinaryFile(const eastl::string& inFilePath, const void* inData, const size_t inSize)
+	{
+		const std::filesystem::path filePath(inFilePath.data());
+
+		std::error_code errorCode;
+		if (filePath.has_parent_path())
+		{
+			std::filesystem::create_directories(filePath.parent_path(), errorCode);
+		}
+
+		std::ofstream fileStream(filePath, std::ios::binary | std::ios::trunc);
+
+		if (!fileStream.is_open())
+		{
+			LOG_ERROR("Failed to open file %s for writing.", inFilePath.data());
+
+			return false;
+		}
+
+		fileStream.write(reinterpret_cast<const char*>(inData), inSize);
+
+		return fileStream.good();
+	}
 }
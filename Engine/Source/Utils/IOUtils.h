@@ -1,7 +1,14 @@
 #pragma once
 #include "EASTL/string.h"
+#include "EASTL/vector.h"
 
 namespace IOUtils
 {
 	bool TryFastReadFile(const eastl::string& inFilePath, eastl::string& outData);
+
+	// Missing files are not treated as errors, used for caches that are allowed to not exist yet
+	bool TryReadBinaryFile(const eastl::string& inFilePath, eastl::vector<uint8_t>& outData);
+
+	// Creates the parent directories if needed
+	bool WriteBinaryFile(const eastl::string& inFilePath, const void* inData, const size_t inSize);
 }
@@ -0,0 +1,103 @@
+#pragma once
+#include <stdint.h>
+#include "EASTL/vector.h"
+#include "EASTL/algorithm.h"
+#include "Core/TaskSystem.h"
+
+/**
+ * Parallel least significant digit radix sort over 64 bit keys, 8 bits per pass.
+ * Every pass histograms chunks of the array on the workers, turns the histograms into per chunk offsets and scatters the
+ * chunks in parallel. Passes where all keys share the same digit are skipped, which is common for the high bits of sort keys.
+ * The sort is stable, elements with equal keys keep their order.
+ */
+namespace RadixSort
+{
+	// GetKey signature: uint64_t(const T& inElement)
+	template<typename T, typename GetKey>
+	void Sort(eastl::vector<T>& ioData, eastl::vector<T>& ioScratch, const GetKey& inGetKey)
+	{
+		constexpr uint32_t NumBuckets = 256;
+		constexpr uint32_t MinChunkSize = 2048;
+
+		const uint32_t count = static_cast<uint32_t>(ioData.size());
+		if (count < 2)
+		{
+			return;
+		}
+
+		ioScratch.resize(count);
+
+		TaskSystem& tasks = TaskSystem::Get();
+		const uint32_t numChunks = eastl::max(eastl::min(count / MinChunkSize, tasks.GetNumWorkers()), 1u);
+		const uint32_t chunkSize = (count + numChunks - 1) / numChunks;
+
+		// Bucket counts per chunk, turned into the write offsets of each chunk in place
+		eastl::vector<uint32_t> offsets(numChunks * NumBuckets);
+
+		T* source = ioData.data();
+		T* dest = ioScratch.data();
+
+		for (uint32_t shift = 0; shift < 64; shift += 8)
+		{
+			eastl::fill(offsets.begin(), offsets.end(), 0u);
+
+			tasks.ParallelFor(numChunks, 1, [&](const uint32_t inBegin, const uint32_t inEnd, const uint32_t inWorkerIdx)
+			{
+				for (uint32_t chunk = inBegin; chunk < inEnd; ++chunk)
+				{
+					uint32_t* chunkCounts = &offsets[chunk * NumBuckets];
+					const uint32_t end = eastl::min((chunk + 1) * chunkSize, count);
+					for (uint32_t i = chunk * chunkSize; i < end; ++i)
+					{
+						++chunkCounts[(inGetKey(source[i]) >> shift) & (NumBuckets - 1)];
+					}
+				}
+			});
+
+			const uint32_t firstBucket = static_cast<uint32_t>((inGetKey(source[0]) >> shift) & (NumBuckets - 1));
+			uint32_t firstBucketCount = 0;
+			for (uint32_t chunk = 0; chunk < numChunks; ++chunk)
+			{
+				firstBucketCount += offsets[chunk * NumBuckets + firstBucket];
+			}
+
+			if (firstBucketCount == count)
+			{
+				continue;
+			}
+
+			// Buckets in order, and chunks in order inside each bucket, which keeps the sort stable
+			uint32_t offset = 0;
+			for (uint32_t bucket = 0; bucket < NumBuckets; ++bucket)
+			{
+				for (uint32_t chunk = 0; chunk < numChunks; ++chunk)
+				{
+					uint32_t& chunkOffset = offsets[chunk * NumBuckets + bucket];
+					const uint32_t bucketCount = chunkOffset;
+					chunkOffset = offset;
+					offset += bucketCount;
+				}
+			}
+
+			tasks.ParallelFor(numChunks, 1, [&](const uint32_t inBegin, const uint32_t inEnd, const uint32_t inWorkerIdx)
+			{
+				for (uint32_t chunk = inBegin; chunk < inEnd; ++chunk)
+				{
+					uint32_t* chunkOffsets = &offsets[chunk * NumBuckets];
+					const uint32_t end = eastl::min((chunk + 1) * chunkSize, count);
+					for (uint32_t i = chunk * chunkSize; i < end; ++i)
+					{
+						dest[chunkOffsets[(inGetKey(source[i]) >> shift) & (NumBuckets - 1)]++] = source[i];
+					}
+				}
+			});
+
+			eastl::swap(source, dest);
+		}
+
+		if (source != ioData.data())
+		{
+			ioData.swap(ioScratch);
+		}
+	}
+}
@@ -0,0 +1,79 @@
+#include "Utils/SlotMap.h"
+#include "Utils/TestUtils.h"
+
+void RunSlotMapChecks()
+{
+	constexpr uint32_t numValues = 1000;
+
+	SlotMap<uint32_t> map;
+	eastl::vector<SlotHandle> handles(numValues);
+	for (uint32_t i = 0; i < numValues; ++i)
+	{
+		handles[i] = map.Add(i);
+	}
+
+	// Every third value removed, the others swapped into their dense positions have to stay reachable
+	eastl::vector<SlotHandle> staleHandles;
+	eastl::vector<SlotHandle> liveHandles;
+	eastl::vector<uint32_t> liveValues;
+	{
+		TestUtils::CheckScope check("Slot map swap removes");
+		for (uint32_t i = 0; i < numValues; i += 3)
+		{
+			check.Expect(map.Remove(handles[i]));
+			check.Expect(!map.Remove(handles[i]));
+			staleHandles.push_back(handles[i]);
+		}
+
+		for (uint32_t i = 0; i < numValues; ++i)
+		{
+			if (i % 3 != 0)
+			{
+				const uint32_t* value = map.Get(handles[i]);
+				check.Expect(value && *value == i);
+				liveHandles.push_back(handles[i]);
+				liveValues.push_back(i);
+			}
+		}
+
+		check.Expect(map.GetSize() == liveHandles.size());
+		for (uint32_t denseIndex = 0; denseIndex < map.GetSize(); ++denseIndex)
+		{
+			check.Expect(map.Get(map.GetHandle(denseIndex)) == &map.GetDense()[denseIndex]);
+		}
+	}
+
+	// The freed slots get reused with a new generation, the old handles must not reach the new values
+	{
+		TestUtils::CheckScope check("Slot map stale handles after reuse");
+		eastl::vector<SlotHandle> reusedHandles;
+		for (uint32_t i = 0; i < staleHandles.size(); ++i)
+		{
+			reusedHandles.push_back(map.Add(numValues + i));
+		}
+
+		for (const SlotHandle& handle : staleHandles)
+		{
+			check.Expect(!map.IsValid(handle) && map.Get(handle) == nullptr && !map.Remove(handle));
+		}
+
+		for (uint32_t i = 0; i < reusedHandles.size(); ++i)
+		{
+			const uint32_t* value = map.Get(reusedHandles[i]);
+			check.Expect(value && *value == numValues + i && reusedHandles[i].Index < numValues);
+		}
+
+		for (uint32_t i = 0; i < liveHandles.size(); ++i)
+		{
+			const uint32_t* value = map.Get(liveHandles[i]);
+			check.Expect(value && *value == liveValues[i]);
+		}
+
+		map.Clear();
+		check.Expect(map.GetSize() == 0);
+		for (const SlotHandle& handle : liveHandles)
+		{
+			check.Expect(!map.IsValid(handle));
+		}
+	}
+}
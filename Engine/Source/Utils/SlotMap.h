@@ -0,0 +1,138 @@
+#pragma once
+#include <stdint.h>
+#include "EASTL/vector.h"
+#include "EASTL/utility.h"
+#include "Core/EngineUtils.h"
+
+// Index into the slots of a SlotMap plus the generation the slot had when the handle was given out
+struct SlotHandle
+{
+	uint32_t Index = uint32_t(-1);
+	uint32_t Generation = 0;
+
+	inline bool IsValid() const { return Index != uint32_t(-1); }
+	inline bool operator==(const SlotHandle& inOther) const { return Index == inOther.Index && Generation == inOther.Generation; }
+	inline bool operator!=(const SlotHandle& inOther) const { return !(*this == inOther); }
+};
+
+/**
+ * Owns values in a dense array and hands out handles that stay the same while the values move.
+ * Lookups go through a slot table, so they are one indirection and a generation compare. Removing a value bumps its slot
+ * generation, handles to it then fail lookups instead of reaching whatever reused the slot.
+ * Values are swap removed, iterating GetDense() walks them contiguously in no particular order.
+ */
+template<typename T>
+class SlotMap
+{
+public:
+	template<typename... Args>
+	SlotHandle Emplace(Args&&... inArgs)
+	{
+		SlotHandle handle;
+		if (FreeHead != uint32_t(-1))
+		{
+			handle.Index = FreeHead;
+			FreeHead = Slots[FreeHead].DenseIndex;
+		}
+		else
+		{
+			handle.Index = static_cast<uint32_t>(Slots.size());
+			Slots.push_back(Slot());
+		}
+
+		Slot& slot = Slots[handle.Index];
+		slot.DenseIndex = static_cast<uint32_t>(Dense.size());
+		handle.Generation = slot.Generation;
+
+		Dense.emplace_back(eastl::forward<Args>(inArgs)...);
+		DenseToSlot.push_back(handle.Index);
+
+		return handle;
+	}
+
+	inline SlotHandle Add(T inValue) { return Emplace(eastl::move(inValue)); }
+
+	// Returns false if the handle was already stale
+	bool Remove(const SlotHandle inHandle)
+	{
+		if (!IsValid(inHandle))
+		{
+			return false;
+		}
+
+		Slot& slot = Slots[inHandle.Index];
+		const uint32_t denseIndex = slot.DenseIndex;
+		const uint32_t lastIndex = static_cast<uint32_t>(Dense.size()) - 1;
+
+		if (denseIndex != lastIndex)
+		{
+			Dense[denseIndex] = eastl::move(Dense[lastIndex]);
+			DenseToSlot[denseIndex] = DenseToSlot[lastIndex];
+			Slots[DenseToSlot[denseIndex]].DenseIndex = denseIndex;
+		}
+
+		Dense.pop_back();
+		DenseToSlot.pop_back();
+
+		++slot.Generation;
+		slot.DenseIndex = FreeHead;
+		FreeHead = inHandle.Index;
+
+		return true;
+	}
+
+	inline bool IsValid(const SlotHandle inHandle) const
+	{
+		return inHandle.Index < Slots.size() && Slots[inHandle.Index].Generation == inHandle.Generation;
+	}
+
+	// Null for stale handles, pointers stay valid until the next Emplace or Remove
+	inline T* Get(const SlotHandle inHandle)
+	{
+		return IsValid(inHandle) ? &Dense[Slots[inHandle.Index].DenseIndex] : nullptr;
+	}
+
+	inline const T* Get(const SlotHandle inHandle) const
+	{
+		return IsValid(inHandle) ? &Dense[Slots[inHandle.Index].DenseIndex] : nullptr;
+	}
+
+	// Handle of the value at a dense index, for removing while iterating
+	inline SlotHandle GetHandle(const uint32_t inDenseIndex) const
+	{
+		ASSERT(inDenseIndex < Dense.size());
+
+		SlotHandle handle;
+		handle.Index = DenseToSlot[inDenseIndex];
+		handle.Generation = Slots[handle.Index].Generation;
+
+		return handle;
+	}
+
+	void Clear()
+	{
+		for (uint32_t denseIndex = static_cast<uint32_t>(Dense.size()); denseIndex-- > 0;)
+		{
+			Remove(GetHandle(denseIndex));
+		}
+	}
+
+	inline const eastl::vector<T>& GetDense() const { return Dense; }
+	inline uint32_t GetSize() const { return static_cast<uint32_t>(Dense.size()); }
+
+private:
+	struct Slot
+	{
+		// Position of the value in Dense, or the next free slot while the slot is unused
+		uint32_t DenseIndex = uint32_t(-1);
+		uint32_t Generation = 0;
+	};
+
+	eastl::vector<T> Dense;
+	eastl::vector<uint32_t> DenseToSlot;
+	eastl::vector<Slot> Slots;
+	uint32_t FreeHead = uint32_t(-1);
+};
+
+// Asserts handles find their values through swap removes, go stale once removed and stay stale after their slot is reused
+void RunSlotMapChecks();
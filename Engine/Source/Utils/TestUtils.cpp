@@ -0,0 +1,36 @@
+#include "Utils/TestUtils.h"
+#include "Core/EngineUtils.h"
+
+static bool bBreakOnFailure = true;
+static uint32_t NumFailedCases = 0;
+
+void TestUtils::SetBreakOnFailure(const bool inBreakOnFailure)
+{
+	bBreakOnFailure = inBreakOnFailure;
+}
+
+uint32_t TestUtils::GetNumFailedCases()
+{
+	return NumFailedCases;
+}
+
+TestUtils::CheckScope::CheckScope(const char* inName)
+	: Name(inName)
+{}
+
+TestUtils::CheckScope::~CheckScope()
+{
+	NumFailedCases += NumFailed;
+	if (NumFailed == 0)
+	{
+		LOG_INFO("%s: %u of %u cases passed.", Name, NumCases, NumCases);
+	}
+	else if (bBreakOnFailure)
+	{
+		ASSERT_MSG(false, "%s: %u of %u cases failed.", Name, NumFailed, NumCases);
+	}
+	else
+	{
+		LOG_ERROR("%s: %u of %u cases failed.", Name, NumFailed, NumCases);
+	}
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <stdint.h>
+#include <random>
+#include "glm/glm.hpp"
+
+// Helpers of the correctness checks the engine systems have next to their benchmarks. The checks only compare results and
+// assert on mismatches, the timings stay in the benchmarks, so they can run without the renderer or the UI.
+namespace TestUtils
+{
+	// Seeded the same on every run so a failing case can be reproduced
+	class TestRandom
+	{
+	public:
+		// In [0, 1)
+		inline float Next() { return Distribution(Generator); }
+
+		inline glm::vec3 NextVec3()
+		{
+			const float x = Next();
+			const float y = Next();
+			const float z = Next();
+
+			return glm::vec3(x, y, z);
+		}
+
+	private:
+		std::mt19937 Generator = std::mt19937(1337);
+		std::uniform_real_distribution<float> Distribution = std::uniform_real_distribution<float>(0.f, 1.f);
+	};
+
+	// Checks assert on failures by default, headless runs only log them and exit with an error
+	void SetBreakOnFailure(const bool inBreakOnFailure);
+
+	// Failed cases of every check run so far
+	uint32_t GetNumFailedCases();
+
+	// Counts the cases of a check and the ones that failed, logs them when going out of scope and asserts if any failed
+	class CheckScope
+	{
+	public:
+		CheckScope(const char* inName);
+		~CheckScope();
+
+		CheckScope(const CheckScope&) = delete;
+		CheckScope& operator=(const CheckScope&) = delete;
+
+		// Returns inPassed, for callers logging more about the failed case
+		inline bool Expect(const bool inPassed)
+		{
+			++NumCases;
+			NumFailed += inPassed ? 0 : 1;
+
+			return inPassed;
+		}
+
+		inline uint32_t GetNumFailed() const { return NumFailed; }
+
+	private:
+		const char* Name = nullptr;
+		uint32_t NumCases = 0;
+		uint32_t NumFailed = 0;
+	};
+}